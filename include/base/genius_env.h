@@ -39,6 +39,8 @@ namespace Genius {
 
   /**
    *  Initialize Petsc
+   *  when command line option -ensemble n is given, the processors are split into n groups
+   *  and PETSC_COMM_WORLD is set to the group communicator before Petsc initialization.
    *  @returns true on success.
    */
   bool init_processors(int *argc, char *** args);
@@ -79,6 +81,23 @@ namespace Genius {
    */
   bool is_last_processor();
 
+  /**
+   * @return the number of ensemble groups, each group runs an independent copy of the simulation.
+   * default is 1
+   */
+  unsigned int n_ensembles();
+
+  /**
+   * @return the index of ensemble group this processor belongs to
+   */
+  unsigned int ensemble_id();
+
+  /**
+   * @return true if we are in the first ensemble group,
+   * which owns the console and the shared output files
+   */
+  bool is_ensemble_master();
+
 #ifdef HAVE_MPI
   /**
    * @return MPI_Comm global communicator
@@ -89,6 +108,11 @@ namespace Genius {
    * @return MPI_Comm self communicator
    */
   const MPI_Comm & comm_self();
+
+  /**
+   * @return MPI_Comm communicator contains all the processors of all the ensemble groups
+   */
+  const MPI_Comm & comm_ensemble();
 #endif
 
 
@@ -146,6 +170,21 @@ namespace Genius {
      */
     static int  _processor_id;
 
+    /**
+     * Total number of ensemble groups.
+     */
+    static int  _n_ensembles;
+
+    /**
+     * The ensemble group id of local processor.
+     */
+    static int  _ensemble_id;
+
+    /**
+     * MPI is initialized by genius (not by petsc) for ensemble run
+     */
+    static bool _mpi_init_by_genius;
+
 #ifdef HAVE_MPI
     /**
      * MPI_Comm global communicator
@@ -157,6 +196,11 @@ namespace Genius {
      */
     static MPI_Comm _comm_self;
 
+    /**
+     * MPI_Comm communicator of all the ensemble groups
+     */
+    static MPI_Comm _comm_ensemble;
+
 #endif
 
     /**
@@ -217,6 +261,24 @@ inline bool Genius::is_last_processor()
 }
 
 
+inline unsigned int Genius::n_ensembles()
+{
+  return static_cast<unsigned int>(GeniusPrivateData::_n_ensembles);
+}
+
+
+inline unsigned int Genius::ensemble_id()
+{
+  return static_cast<unsigned int>(GeniusPrivateData::_ensemble_id);
+}
+
+
+inline bool Genius::is_ensemble_master()
+{
+  return GeniusPrivateData::_ensemble_id == 0;
+}
+
+
 #ifdef HAVE_MPI
 inline  const MPI_Comm & Genius::comm_world()
 {
@@ -227,6 +289,11 @@ inline  const MPI_Comm & Genius::comm_self()
 {
   return (GeniusPrivateData::_comm_self);
 }
+
+inline  const MPI_Comm & Genius::comm_ensemble()
+{
+  return (GeniusPrivateData::_comm_ensemble);
+}
 #endif
 
 
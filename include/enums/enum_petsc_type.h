@@ -106,6 +106,9 @@ namespace SolverSpecify
                            ILUT_PRECOND,
                            LU_PRECOND,
                            PARMS_PRECOND,
+                           FIELDSPLIT_PRECOND,
+                           FIELDSPLIT_SCHUR_PRECOND,
+                           FIELDSPLIT_REGION_PRECOND,
                            USER_PRECOND,
                            SHELL_PRECOND,
                            INVALID_PRECONDITIONER};
@@ -94,6 +94,7 @@ namespace SolverSpecify
     TRANSIENT,
     ACSWEEP,
     TRACE,
+    PSS,
     INVALID_SolutionType
   };
 
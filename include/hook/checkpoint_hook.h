@@ -0,0 +1,71 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __checkpoint_hook_h__
+#define __checkpoint_hook_h__
+
+
+#include "hook.h"
+#include <string>
+
+
+/**
+ * write solver checkpoint periodically, the file is overwritten each time.
+ * a killed job can be continued by IMPORT checkpoint=<file> and the same SOLVE card.
+ */
+class CheckpointHook : public Hook
+{
+
+public:
+  CheckpointHook(SolverBase & solver, const std::string & name, void *);
+
+  virtual ~CheckpointHook();
+
+  /**
+   *   This is executed previously to each solution step.
+   */
+  virtual void pre_solve();
+
+  /**
+   * This is executed after the finalization of the solver
+   */
+  virtual void on_close();
+
+private:
+
+  /**
+   * the checkpoint file name
+   */
+  std::string     _file_name;
+
+  /**
+   * write checkpoint every _interval steps
+   */
+  unsigned int    _interval;
+
+  /**
+   * steps since last checkpoint
+   */
+  unsigned int    _count;
+};
+
+#endif
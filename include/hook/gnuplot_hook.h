@@ -26,8 +26,11 @@
 #define __gnuplot_hook_h__
 
 
+#include <vector>
+
 #include "hook.h"
 
+class AsyncWriter;
 
 /**
  * write electrode IV into file which can be plotted by gnuplot
@@ -89,8 +92,39 @@ private:
 
  /**
   * write the head of file
+  * @return the number of columns
+  */
+ unsigned int _write_gnuplot_head(std::ostream & out);
+
+ /**
+  * @return the number of columns in the head of existing text file
+  */
+ unsigned int _read_text_head();
+
+ /**
+  * stop with error when the existing file has different columns than this solution records
+  */
+ void  _check_append_columns(unsigned int n_file_columns);
+
+ /**
+  * open the file for binary records, append to it if possible
+  */
+ void  _open_binary_file(bool append);
+
+ /**
+  * read the head of an existing binary file
+  */
+ bool  _read_binary_head();
+
+ /**
+  * write one row as text
   */
- void  _write_gnuplot_head();
+ void  _write_text_row(const std::vector<double> & row, bool lead);
+
+ /**
+  * write one row as binary record
+  */
+ void  _write_binary_row(std::vector<double> & row);
 
  /**
   * if we are in ddm solver
@@ -101,6 +135,46 @@ private:
   * if we are in mixA mode
   */
  bool            _mixA;
+
+ /**
+  * the ensemble branch being recorded
+  */
+ int             _ensemble_branch;
+
+ /**
+  * background writer on root processor, NULL for synchronous output
+  */
+ AsyncWriter *   _writer;
+
+ /**
+  * write binary records instead of text
+  */
+ bool            _binary;
+
+ /**
+  * columns of each binary record
+  */
+ unsigned int    _n_columns;
+
+ /**
+  * binary records written
+  */
+ unsigned int    _n_rows;
+
+ /**
+  * stream position of the rows field in binary file head
+  */
+ std::streampos  _n_rows_pos;
+
+ /**
+  * stream position of the first binary record
+  */
+ std::streampos  _data_pos;
+
+ /**
+  * width of the number fields in binary file head
+  */
+ static const int _head_field_width = 12;
 };
 
 #endif
@@ -0,0 +1,172 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __hdf5_hook_h__
+#define __hdf5_hook_h__
+
+
+#include <map>
+#include <vector>
+#include <string>
+
+#include "config.h"
+#include "hook.h"
+
+#ifdef HAVE_HDF5
+#include "hdf5.h"
+#endif
+
+
+/**
+ * write transient (or sweep) field data as HDF5 time series.
+ * the mesh is stored once, each step appends one row to the chunked and
+ * compressed dataset /region/<name>/<variable> of shape [step, node(cell)].
+ * optional delta encoding (against the last stored step, with periodic keyframe)
+ * and mantissa truncation make the data much more compressible.
+ */
+class HDF5Hook : public Hook
+{
+
+public:
+  HDF5Hook(SolverBase & solver, const std::string & name, void *);
+
+  virtual ~HDF5Hook();
+
+  /**
+   *   This is executed before the initialization of the solver
+   */
+  virtual void on_init();
+
+  /**
+   *   This is executed previously to each solution step.
+   */
+  virtual void pre_solve();
+
+  /**
+   *  This is executed after each solution step.
+   */
+  virtual void post_solve();
+
+  /**
+   *  This is executed after each (nonlinear) iteration
+   */
+  virtual void post_iteration();
+
+  /**
+   * This is executed after the finalization of the solver
+   */
+  virtual void on_close();
+
+private:
+
+  /**
+   * the output file name
+   */
+  std::string     _file_name;
+
+  /**
+   * node based variables to record
+   */
+  std::vector<std::string>  _node_variables;
+
+  /**
+   * cell based variables to record
+   */
+  std::vector<std::string>  _cell_variables;
+
+  /**
+   * store field as double precision, default is float
+   */
+  bool            _double;
+
+  /**
+   * mantissa bits kept, 0 for no truncation
+   */
+  unsigned int    _bits;
+
+  /**
+   * store difference to the previous step
+   */
+  bool            _delta;
+
+  /**
+   * full step is stored every _keyframe steps in delta mode
+   */
+  unsigned int    _keyframe;
+
+  /**
+   * deflate level, 0 for no compression
+   */
+  unsigned int    _compress;
+
+  /**
+   * max chunk length along node/cell dimension
+   */
+  unsigned int    _chunk;
+
+  /**
+   * number of steps written
+   */
+  unsigned int    _step;
+
+  /**
+   * only save in this interval, and not more often than _t_step
+   */
+  double _t_start;
+  double _t_stop;
+  double _t_step;
+  double _t_last;
+
+  /**
+   * the reconstructed value of last step, by dataset path. only used in delta mode
+   */
+  std::map<std::string, std::vector<double> > _last_value;
+
+#ifdef HAVE_HDF5
+  /**
+   * HDF5 file, only opened on first processor
+   */
+  hid_t           _file;
+
+  /**
+   * append one step of variable to dataset group/variable, create it at first time
+   */
+  void _append(const std::string &group, const std::string &variable, const std::string &unit, const std::vector<double> &value);
+
+  /**
+   * append the step axis value
+   */
+  void _append_axis(double value);
+#endif
+
+  /**
+   * write mesh and region info, must executed in parallel
+   */
+  void _write_mesh();
+
+  /**
+   * write all the variables of current step, must executed in parallel
+   */
+  void _write_step(double axis);
+};
+
+#endif
@@ -37,7 +37,7 @@ class HookList
 {
 public:
 
-  HookList() {}
+  HookList():_muted(false) {}
 
   /**
    * destructor, free all the hooks
@@ -53,6 +53,19 @@ public:
   void   add_hook(Hook * hook)
   { _hook_list.push_back(hook); }
 
+  /**
+   * when muted, pre_solve and post_solve are not passed to the hooks,
+   * used by solvers which do trial solutions
+   */
+  void   mute(bool m)
+  { _muted = m; }
+
+  /**
+   * @return true when hooks are muted
+   */
+  bool   muted() const
+  { return _muted; }
+
   /**
    *   This is executed before the initialization of the solver
    */
@@ -68,6 +81,7 @@ public:
    */
   void pre_solve()
   {
+    if(_muted) return;
     std::deque<Hook *>::iterator it;
     for (it=_hook_list.begin(); it!=_hook_list.end(); ++it)
       (*it)->pre_solve();
@@ -78,6 +92,7 @@ public:
    */
   void post_solve()
   {
+    if(_muted) return;
     std::deque<Hook *>::iterator it;
     for (it=_hook_list.begin(); it!=_hook_list.end(); ++it)
       (*it)->post_solve();
@@ -144,6 +159,8 @@ private:
 
   std::deque<Hook *>  _hook_list;
 
+  bool _muted;
+
 };
 
 
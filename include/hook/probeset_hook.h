@@ -0,0 +1,136 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __probeset_hook_h__
+#define __probeset_hook_h__
+
+
+#include <vector>
+#include <string>
+#include <fstream>
+
+#include "genius_common.h"
+#include "point.h"
+#include "hook.h"
+#include "enum_solution.h"
+
+class Elem;
+class AsyncWriter;
+
+/**
+ * monitor solution variables at a set of probe points.
+ * points are given by x/y/z pairs, a point file or a sample line.
+ * the owner element and its interpolation weights of each point are
+ * located once, each step gathers all the probe values by a single
+ * reduction and appends one row to a columnar ascii or binary file.
+ *
+ * binary layout: "GENIUSPB", int version, int n_probe, int n_var,
+ * n_probe*3 double coordinates in um, n_var '\0' terminated "name [unit]" strings,
+ * then for each step one double abscissa followed by n_probe*n_var doubles (probe major).
+ */
+class ProbeSetHook : public Hook
+{
+
+public:
+  ProbeSetHook(SolverBase & solver, const std::string & name, void * file);
+
+  virtual ~ProbeSetHook();
+
+  /**
+   *   This is executed before the initialization of the solver
+   */
+  virtual void on_init();
+
+  /**
+   *  This is executed after each solution step.
+   */
+  virtual void post_solve();
+
+  /**
+   * This is executed after the finalization of the solver
+   */
+  virtual void on_close();
+
+private:
+
+  /**
+   * probe points
+   */
+  std::vector<Point>  _points;
+
+  /**
+   * variables to be monitored
+   */
+  std::vector<SolutionVariable> _variables;
+
+  /**
+   * name of the variables
+   */
+  std::vector<std::string> _variable_names;
+
+  /**
+   * the element which contains the probe point, NULL if the point is outside the mesh
+   */
+  std::vector<const Elem *> _elems;
+
+  /**
+   * interpolation weights of element nodes, only valid for on processor elements
+   */
+  std::vector< std::vector<Real> > _weights;
+
+  /**
+   * read probe points from file, each line contains x y [z] in um
+   */
+  void _read_point_file(const std::string &file);
+
+  /**
+   * @return the abscissa of current step, i.e. time or sweep value
+   */
+  double _abscissa(std::string &label) const;
+
+  /**
+   * the output file name
+   */
+  std::string     _probe_file;
+
+  /**
+   * binary output
+   */
+  bool            _binary;
+
+  /**
+   * file stream
+   */
+  std::ofstream   _out;
+
+  /**
+   * background writer
+   */
+  AsyncWriter *   _writer;
+
+  /**
+   * step counter, used as abscissa when solver has no sweep variable
+   */
+  unsigned int    _step;
+};
+
+#endif
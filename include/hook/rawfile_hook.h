@@ -30,8 +30,9 @@
 #include <time.h>
 
 /**
- * write electrode IV into spice raw file (Ascii format).
+ * write electrode IV into spice raw file (Ascii or Binary format).
  * then user can view the IV curve by some other program.
+ * each point is appended to the file as soon as it is solved.
  * ( can we do real time display here? )
  */
 class RawFileHook : public Hook
@@ -100,14 +101,34 @@ private:
  std::vector<std::pair<std::string, std::string> >  _variables;
 
  /**
-  * the variable value buffer
+  * the total number of values
   */
- std::vector< std::vector<double> > _values;
+ unsigned int _n_values;
 
  /**
-  * the total number of values
+  * stream position of the number of points in file head
   */
- unsigned int _n_values;
+ std::streampos _n_points_pos;
+
+ /**
+  * width of the number of points field, enough for any count
+  */
+ static const int _n_points_width = 12;
+
+ /**
+  * write raw file head
+  */
+ void _write_head();
+
+ /**
+  * append one point to raw file
+  */
+ void _write_point(const std::vector<double> & row);
+
+ /**
+  * overwrite the number of points in file head by _n_values
+  */
+ void _write_n_points();
 
 };
 
@@ -29,6 +29,8 @@
 #include <vector>
 #include <string>
 
+class AsyncWriter;
+
 /**
  * write vtk file
  */
@@ -72,6 +74,16 @@ private:
    */
   std::string     _vtk_prefix;
 
+  /**
+   * file extension, .vtu or .pvtu for rank-local pieces
+   */
+  std::string     _vtk_ext;
+
+  /**
+   * background writer, NULL for synchronous output
+   */
+  AsyncWriter *   _writer;
+
   /**
   * count
   */
@@ -0,0 +1,136 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __hierarchy_transfer_h__
+#define __hierarchy_transfer_h__
+
+#include <map>
+#include <vector>
+#include <string>
+
+#include "interpolation_base.h"
+
+class Node;
+class MeshBase;
+class SimulationSystem;
+
+/**
+ * transfer node data across hierarchical mesh refinement.
+ * the node values are saved on processor 0 keyed by node id together with
+ * the node itself, and new nodes are filled from the nodes of their
+ * parent element with the embedding matrix of refinement.
+ * a node created by refinement never takes the value of a node freed by
+ * coarsening, even when it reuses its address.
+ * no scattered data interpolant is built, the cost is O(N).
+ * for unrelated meshes, i.e. conform refinement, use the scattered data interpolators.
+ *
+ * usage:
+ *   add_variable() for each variable before refinement,
+ *   prolong() on processor 0 after refinement (before flatten),
+ *   sync() on all processors after the mesh is broadcast,
+ *   apply() for each variable to set the data into the new system.
+ */
+class HierarchyTransfer
+{
+public:
+
+  HierarchyTransfer(MeshBase & mesh) : _mesh(mesh) {}
+
+  /**
+   * save the node value of variable, collective
+   * interpolation is done in the space given by type, i.e. Asinh for doping,
+   * SignedLog for carrier density
+   */
+  void add_variable(const SimulationSystem & system, const std::string & variable, InterpolationBase::InterpolationType type);
+
+  /**
+   * fill the new nodes from their parent elements, processor 0 only
+   */
+  void prolong();
+
+  /**
+   * bind the values to node id of the new mesh and broadcast them, collective
+   */
+  void sync();
+
+  /**
+   * set the value of variable to the node data of new system
+   */
+  void apply(SimulationSystem & system, const std::string & variable) const;
+
+private:
+
+  MeshBase & _mesh;
+
+  /**
+   * variable names
+   */
+  std::vector<std::string> _variables;
+
+  /**
+   * interpolation type of each variable
+   */
+  std::vector<InterpolationBase::InterpolationType> _types;
+
+  /**
+   * the node of each id with saved value, processor 0 only
+   */
+  std::map<unsigned int, const Node *> _node_of_id;
+
+  /**
+   * scaled node values of each variable keyed by node id, processor 0 only
+   */
+  std::vector< std::map<unsigned int, double> > _id_values;
+
+  /**
+   * scaled values of each variable for the nodes of active elements after prolong(),
+   * they are not freed by mesh contraction. processor 0 only
+   */
+  std::vector< std::map<const Node *, double> > _node_values;
+
+  /**
+   * node has the same identity as the node saved with its id
+   */
+  bool _known(const Node * node) const;
+
+  /**
+   * take the id for a new node, values saved under this id are dropped
+   */
+  void _claim(const Node * node);
+
+  /**
+   * saved value of variable v at node, NULL if none
+   */
+  const double * _value(unsigned int v, const Node * node) const;
+
+  /**
+   * node values of each variable indexed by node id, after sync()
+   */
+  std::vector< std::vector<double> > _values;
+
+  /**
+   * node has value for each variable, after sync()
+   */
+  std::vector< std::vector<char> > _has_value;
+};
+
+#endif
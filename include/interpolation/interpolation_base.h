@@ -4,6 +4,7 @@
 #include <cassert>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "point.h"
 
@@ -67,6 +68,17 @@ public:
    */
   virtual double get_interpolated_value(const Point & point, int group)const=0;
 
+  /**
+   * get interpolated values with GROUP_ID group in a batch of locations.
+   * dirived class can override it to process the batch in parallel
+   */
+  virtual void get_interpolated_values(const std::vector<Point> & points, int group, std::vector<double> & values) const
+  {
+    values.resize(points.size());
+    for(unsigned int n=0; n<points.size(); ++n)
+      values[n] = this->get_interpolated_value(points[n], group);
+  }
+
   /**
    * InterpolationType, should support linear (for potential, etc) and asinh (doping concentration and carrier density)
    */
@@ -83,15 +95,10 @@ public:
   void set_interpolation_type(int group, InterpolationType type)
   { _interpolation_type[group] = type; }
 
-protected:
-
-  std::map<int, InterpolationType> _interpolation_type;
-
-  std::map<std::string, int> _variable_group_map;
-
-  //how to store the point and their value?
-
-  inline double scaleValue(InterpolationType type, const double value) const
+  /**
+   * map value into the space where interpolation is done
+   */
+  static inline double scaleValue(InterpolationType type, const double value)
   {
     switch(type)
     {
@@ -102,7 +109,10 @@ protected:
     return 0.0; //prevent warning
   }
 
-  inline double unscaleValue(InterpolationType type, const double value) const
+  /**
+   * map interpolated value back
+   */
+  static inline double unscaleValue(InterpolationType type, const double value)
   {
     switch(type)
     {
@@ -113,6 +123,13 @@ protected:
     return 0.0;//prevent warning
   }
 
+protected:
+
+  std::map<int, InterpolationType> _interpolation_type;
+
+  std::map<std::string, int> _variable_group_map;
+
+  //how to store the point and their value?
 };
 
 
@@ -0,0 +1,140 @@
+#ifndef __interpolation_kdtree_h__
+#define __interpolation_kdtree_h__
+
+#include <vector>
+#include <map>
+
+#include "interpolation_base.h"
+
+
+/**
+ * local scattered data interpolation in 1D/2D/3D backed by a static kd-tree.
+ * the kd-tree is built once for each group, each query searches the k nearest
+ * data points and fits them by moving least squares (linear polynomial with
+ * inverse distance weight) or by inverse distance weighting (Shepard).
+ * the fit is done in the space given by interpolation type, use Asinh for doping.
+ *
+ * the setup cost is O(N log N) and each query is O(log N + k), no global
+ * interpolant is built. queries are const and thread safe, a batch of points
+ * can be split into several threads by get_interpolated_values().
+ *
+ * options (by set_option):
+ *   "k=12"      number of nearest neighbors, default 4*dim
+ *   "mls"       moving least squares fit (default)
+ *   "idw"       inverse distance weighting
+ *   "threads=1" number of threads for batch query
+ */
+class Interpolation_KDTree : public InterpolationBase
+{
+public:
+
+  /**
+   * constructor, dim is the number of used coordinates of point
+   */
+  Interpolation_KDTree (unsigned int dim=3);
+
+  ~Interpolation_KDTree ();
+
+  /**
+   * clear internal interpolation data
+   */
+  void clear();
+
+  /**
+   * build kd-tree of group
+   */
+  void setup(int group);
+
+  /**
+   * options of k nearest neighbors, fit method and threads
+   */
+  virtual void set_option(const std::string & option);
+
+  /**
+   * broadcast data to all the processor
+   */
+  virtual void broadcast(unsigned int root=0);
+
+  /**
+   * add the data with GROUP_ID group for interpolation
+   * NOTE: only the first dim coordinates of point are used.
+   */
+  void add_scatter_data(const Point & point, int group, double value);
+
+  /**
+   * get interpolated value with GROUP_ID group in location point
+   */
+  double get_interpolated_value(const Point & point, int group) const;
+
+  /**
+   * get interpolated values of a batch of points, split into threads
+   */
+  virtual void get_interpolated_values(const std::vector<Point> & points, int group, std::vector<double> & values) const;
+
+private:
+
+  struct DATA
+  {
+    /// coordinates of data points, dim per point
+    std::vector<double> coords;
+    /// scaled values
+    std::vector<double> values;
+    /// point index in kd-tree order
+    std::vector<unsigned int> index;
+    /// split axis of each tree node, the node is the median of its range
+    std::vector<unsigned char> axis;
+    /// tree is built
+    bool built;
+
+    DATA() : built(false) {}
+  };
+
+  /**
+   * build the subtree of range [lo, hi) of index
+   */
+  void _build(DATA & data, unsigned int lo, unsigned int hi);
+
+  /**
+   * k nearest search in the subtree of range [lo, hi),
+   * heap is a max heap of (squared distance, point index)
+   */
+  void _search(const DATA & data, const double * p, unsigned int lo, unsigned int hi,
+               std::vector< std::pair<double, unsigned int> > & heap) const;
+
+  /**
+   * fit the value at p by neighbors in heap
+   */
+  double _fit(const DATA & data, const double * p, const std::vector< std::pair<double, unsigned int> > & heap) const;
+
+  /**
+   * interpolated value in scaled space
+   */
+  double _scaled_value(const DATA & data, const Point & point) const;
+
+  /**
+   * batch query of points [begin, end)
+   */
+  void _batch(const DATA & data, InterpolationType type, const std::vector<Point> & points,
+              unsigned int begin, unsigned int end, std::vector<double> & values) const;
+
+  /**
+   * thread entry of batch query
+   */
+  static void * _batch_thread(void *);
+
+  unsigned int _dim;
+
+  /// number of nearest neighbors
+  unsigned int _k;
+
+  /// use moving least squares, else inverse distance weighting
+  bool _mls;
+
+  /// threads of batch query
+  unsigned int _n_threads;
+
+  std::map<int, DATA> _field;
+};
+
+
+#endif
@@ -26,6 +26,7 @@
 #include <complex>
 #include <vector>
 #include <map>
+#include <cstddef>
 
 
 #include "parser_parameter.h"   // for parameter calibrating from user input file
@@ -129,6 +130,36 @@ struct PMI_Environment
 
 };
 
+/**
+ * PMI_NodeContext, location, data and time of the node a PMI function is evaluated on.
+ * it is passed explicitly to the reentrant PMI interface instead of the node mapped
+ * by the material class.
+ */
+struct PMI_NodeContext
+{
+  /**
+   * location of the node
+   */
+  const Point         *    point;
+
+  /**
+   * data of the node, doping, mole fraction, ...
+   */
+  const FVM_NodeData  *    node_data;
+
+  /**
+   * current time
+   */
+  PetscScalar              time;
+
+  /**
+   * constructor
+   */
+  PMI_NodeContext(const Point *p=0, const FVM_NodeData *d=0, PetscScalar t=0.0)
+  : point(p), node_data(d), time(t)
+  {}
+};
+
 /**
  * the parameter structure
  */
@@ -183,6 +214,20 @@ struct  PARA
 };
 
 
+/**
+ * the parameter descriptions of a PMI class, shared by the PMI objects of all the
+ * regions which load the same model. the values stay in each PMI object, the table
+ * only records them as byte offsets to the object, so calibration never changes it
+ */
+struct PMI_ParameterTable
+{
+  /**
+   * the description and value offset of each parameter, PARA::value is not used
+   */
+  std::map<std::string, std::pair<PARA, std::ptrdiff_t> >  parameters;
+};
+
+
 /**
  * structure for complex material refraction to a specific length of optical wave
  */
@@ -320,6 +365,134 @@ protected:
 
   std::string _calibrate_error_info;
 
+private:
+  /**
+   * table shared with the PMI objects of the same class, holds the parameters
+   * moved out of parameter_map. NULL when parameter_map holds all the parameters
+   */
+  const PMI_ParameterTable * _parameter_table;
+
+  /**
+   * buffer of get_parameter_info()
+   */
+  std::map<std::string, PARA > _parameter_info;
+
+  /**
+   * find parameter in parameter_map and the shared table, value is the address in this object
+   * @return false if no such parameter
+   */
+  bool find_parameter(const std::string & name, PARA & para) const;
+
+  /**
+   * all the parameters in parameter_map and the shared table, value is the address in this object
+   */
+  void collect_parameters(std::map<std::string, PARA > & paras) const;
+
+public:
+  /**
+   * fill table by parameter_map, the value of each parameter as offset to this object
+   */
+  void build_parameter_table(PMI_ParameterTable & table) const;
+
+  /**
+   * drop parameter_map and use table built by another PMI object of the same class.
+   * @return false if table does not describe the parameters of this object, parameter_map is kept then
+   */
+  bool share_parameter_table(const PMI_ParameterTable & table);
+
+public:
+  /**
+   * PMI functions evaluated in the scope read the given node context instead of
+   * the node mapped by the material class. the scope belongs to current thread,
+   * so different threads can evaluate the same PMI object on different nodes.
+   */
+  class ContextScope
+  {
+  public:
+    ContextScope(const PMI_Server &server, const PMI_NodeContext &ctx)
+    : _server(server), _previous(server.set_node_context(&ctx)) {}
+
+    ~ContextScope() { _server.set_node_context(_previous); }
+
+  private:
+    const PMI_Server & _server;
+    const PMI_NodeContext * _previous;
+  };
+
+protected:
+  /**
+   * @return data of current node, from the context of current thread or the mapped node
+   */
+  const FVM_NodeData * CurrentNodeData() const;
+
+  /**
+   * @return location of current node, from the context of current thread or the mapped node
+   */
+  const Point * CurrentPoint() const;
+
+protected:
+  /**
+   * declare n values cached for each node. the values must only depend on
+   * doping and mole fraction of the node and, when temperature is true, on
+   * lattice temperature. they are evaluated by EvalNodeCache() at the first
+   * access and evaluated again when any of these quantities changes.
+   * call it in the constructor of derived class.
+   */
+  void DeclareNodeCache(unsigned int n, bool temperature=false);
+
+  /**
+   * @return the cached values of current node,
+   * Tl is ignored when the cached values do not depend on temperature
+   */
+  const PetscScalar * ReadNodeCache(const PetscScalar &Tl=0.0) const;
+
+  /**
+   * @return the cached values of the node in given context, the context is only
+   * made current when the values have to be evaluated. used by the array functions
+   */
+  const PetscScalar * ReadNodeCache(const PMI_NodeContext &ctx, const PetscScalar &Tl=0.0) const;
+
+public:
+  /**
+   * invalidate the cached values of all the nodes
+   */
+  void ClearNodeCache();
+
+protected:
+  /**
+   * @return all the parameter values in full precision, identifies
+   * tabulated model data of current parameter set
+   */
+  std::string ParameterSignature() const;
+
+private:
+  /**
+   * number of cached values of each node
+   */
+  unsigned int _node_cache_size;
+
+  /**
+   * cached values depend on lattice temperature
+   */
+  bool _node_cache_temperature;
+
+  /**
+   * key (Tl, Na, Nd, mole_x, mole_y) followed by cached values of each node,
+   * indexed by the offset of node data
+   */
+  mutable std::vector<PetscScalar> _node_cache;
+
+  /**
+   * values evaluated without node data
+   */
+  mutable std::vector<PetscScalar> _node_cache_buffer;
+
+  /**
+   * @return the cache entry of node_data with its key updated,
+   * valid is false when the values must be evaluated again
+   */
+  PetscScalar * NodeCacheEntry(const FVM_NodeData *node_data, const PetscScalar &T, bool &valid) const;
+
 public:
   /**
    * aux function return node coordinate.
@@ -416,6 +589,24 @@ public:
    * destructor, seems nothing to do
    */
   virtual ~PMI_Server(){}
+
+  // the virtual functions below are appended after the ones above. this keeps
+  // source compatibility only: the virtuals of the PMIS_* classes still move and
+  // the object layout changed, so material libraries must be rebuilt
+public:
+
+  /**
+   * set the node context of current thread, NULL falls back to the mapped node.
+   * it is virtual so the context is stored in the material library which reads it.
+   * @return the previous context
+   */
+  virtual const PMI_NodeContext * set_node_context(const PMI_NodeContext *ctx) const;
+
+protected:
+  /**
+   * evaluate the n declared values of current node
+   */
+  virtual void EvalNodeCache(const PetscScalar &Tl, PetscScalar *values) const {}
 }
 ;
 
@@ -498,6 +689,16 @@ public:
    */
   PetscScalar ReadDopingNd () const;
 
+  /**
+   * aux function return total Acceptor concentration of the node in given context
+   */
+  PetscScalar ReadDopingNa (const PMI_NodeContext &ctx) const;
+
+  /**
+   * aux function return total Donor concentration of the node in given context
+   */
+  PetscScalar ReadDopingNd (const PMI_NodeContext &ctx) const;
+
   /**
    * aux function return minimal distance to surface
    */
@@ -951,6 +1152,94 @@ public:
   virtual AutoDScalar BB_Tunneling(const AutoDScalar &Tl, const AutoDScalar &E) =0;
 
 
+  //---------------------------------------------------------------------------
+  // reentrant interface, the node is given by explicit context
+
+  /**
+   * @return conduction band shift due to band gap narrowing of node ctx
+   */
+  PetscScalar EgNarrowToEc (const PMI_NodeContext &ctx, const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
+  { ContextScope scope(*this, ctx); return EgNarrowToEc(p, n, Tl); }
+
+  AutoDScalar EgNarrowToEc (const PMI_NodeContext &ctx, const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
+  { ContextScope scope(*this, ctx); return EgNarrowToEc(p, n, Tl); }
+
+  /**
+   * @return valence band shift due to band gap narrowing of node ctx
+   */
+  PetscScalar EgNarrowToEv (const PMI_NodeContext &ctx, const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
+  { ContextScope scope(*this, ctx); return EgNarrowToEv(p, n, Tl); }
+
+  AutoDScalar EgNarrowToEv (const PMI_NodeContext &ctx, const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
+  { ContextScope scope(*this, ctx); return EgNarrowToEv(p, n, Tl); }
+
+  /**
+   * @return effective intrinsic carrier concentration of node ctx
+   */
+  PetscScalar nie (const PMI_NodeContext &ctx, const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
+  { ContextScope scope(*this, ctx); return nie(p, n, Tl); }
+
+  AutoDScalar nie (const PMI_NodeContext &ctx, const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
+  { ContextScope scope(*this, ctx); return nie(p, n, Tl); }
+
+  /**
+   * @return total recombination of node ctx
+   */
+  PetscScalar Recomb (const PMI_NodeContext &ctx, const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
+  { ContextScope scope(*this, ctx); return Recomb(p, n, Tl); }
+
+  AutoDScalar Recomb (const PMI_NodeContext &ctx, const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
+  { ContextScope scope(*this, ctx); return Recomb(p, n, Tl); }
+
+  /**
+   * conduction band shift of size nodes in one call, node i has context ctx[i].
+   * the default evaluates the scalar version node by node
+   */
+  virtual void EgNarrowToEc (unsigned int size, const PMI_NodeContext *ctx,
+                             const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *dEc);
+
+  /**
+   * valence band shift of size nodes in one call
+   */
+  virtual void EgNarrowToEv (unsigned int size, const PMI_NodeContext *ctx,
+                             const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *dEv);
+
+  /**
+   * effective intrinsic carrier concentration of size nodes in one call
+   */
+  virtual void nie (unsigned int size, const PMI_NodeContext *ctx,
+                    const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *ni);
+
+  /**
+   * total recombination of size nodes in one call
+   */
+  virtual void Recomb (unsigned int size, const PMI_NodeContext *ctx,
+                       const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R);
+
+  /**
+   * band gap narrowing of size nodes in one call
+   */
+  virtual void EgNarrow (unsigned int size, const PMI_NodeContext *ctx,
+                         const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *dEg);
+
+  /**
+   * SRH recombination of size nodes in one call
+   */
+  virtual void R_SHR (unsigned int size, const PMI_NodeContext *ctx,
+                      const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R);
+
+  /**
+   * Auger recombination of size nodes in one call
+   */
+  virtual void R_Auger (unsigned int size, const PMI_NodeContext *ctx,
+                        const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R);
+
+  /**
+   * direct recombination of size nodes in one call
+   */
+  virtual void R_Direct (unsigned int size, const PMI_NodeContext *ctx,
+                         const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R);
+
 };
 
 
@@ -1030,6 +1319,46 @@ public:
   virtual AutoDScalar HoleMob (const AutoDScalar &p,  const AutoDScalar &n,  const AutoDScalar &Tl,
                                const AutoDScalar &Ep, const AutoDScalar &Et, const AutoDScalar &Tp) const=0;
 
+  //---------------------------------------------------------------------------
+  // reentrant interface, the node is given by explicit context
+
+  /**
+   * @return the electron mobility of node ctx
+   */
+  PetscScalar ElecMob (const PMI_NodeContext &ctx, const PetscScalar &p,  const PetscScalar &n,  const PetscScalar &Tl,
+                       const PetscScalar &Ep, const PetscScalar &Et, const PetscScalar &Tn) const
+  { ContextScope scope(*this, ctx); return ElecMob(p, n, Tl, Ep, Et, Tn); }
+
+  AutoDScalar ElecMob (const PMI_NodeContext &ctx, const AutoDScalar &p,  const AutoDScalar &n,  const AutoDScalar &Tl,
+                       const AutoDScalar &Ep, const AutoDScalar &Et, const AutoDScalar &Tn) const
+  { ContextScope scope(*this, ctx); return ElecMob(p, n, Tl, Ep, Et, Tn); }
+
+  /**
+   * @return the hole mobility of node ctx
+   */
+  PetscScalar HoleMob (const PMI_NodeContext &ctx, const PetscScalar &p,  const PetscScalar &n,  const PetscScalar &Tl,
+                       const PetscScalar &Ep, const PetscScalar &Et, const PetscScalar &Tp) const
+  { ContextScope scope(*this, ctx); return HoleMob(p, n, Tl, Ep, Et, Tp); }
+
+  AutoDScalar HoleMob (const PMI_NodeContext &ctx, const AutoDScalar &p,  const AutoDScalar &n,  const AutoDScalar &Tl,
+                       const AutoDScalar &Ep, const AutoDScalar &Et, const AutoDScalar &Tp) const
+  { ContextScope scope(*this, ctx); return HoleMob(p, n, Tl, Ep, Et, Tp); }
+
+  /**
+   * electron mobility of size nodes in one call, node i has context ctx[i].
+   * the default evaluates the scalar version node by node
+   */
+  virtual void ElecMob (unsigned int size, const PMI_NodeContext *ctx,
+                        const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                        const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tn, PetscScalar *mu) const;
+
+  /**
+   * hole mobility of size nodes in one call
+   */
+  virtual void HoleMob (unsigned int size, const PMI_NodeContext *ctx,
+                        const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                        const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tp, PetscScalar *mu) const;
+
 };
 
 
@@ -1095,6 +1424,18 @@ public:
    */
   virtual AutoDScalar HoleGenRateEBM (const AutoDScalar &Tp,const AutoDScalar &Tl,const AutoDScalar &Eg) const=0;
 
+  /**
+   * electron generation rate of size edges or nodes in one call, item i has context ctx[i].
+   * the default evaluates the scalar version one by one
+   */
+  virtual void ElecGenRate (unsigned int size, const PMI_NodeContext *ctx,
+                            const PetscScalar *Tl, const PetscScalar *Ep, const PetscScalar *Eg, PetscScalar *G) const;
+
+  /**
+   * hole generation rate of size edges or nodes in one call
+   */
+  virtual void HoleGenRate (unsigned int size, const PMI_NodeContext *ctx,
+                            const PetscScalar *Tl, const PetscScalar *Ep, const PetscScalar *Eg, PetscScalar *G) const;
 
 };
 
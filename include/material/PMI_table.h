@@ -0,0 +1,191 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __PMI_table_h__
+#define __PMI_table_h__
+
+#include <string>
+#include <vector>
+
+#include "adolc.h"
+
+using namespace adtl;
+
+
+/**
+ * build of the translation unit which tabulates a model. it is part of the table key,
+ * so a rebuilt model never loads tables sampled by the old code
+ */
+#define PMI_TABLE_BUILD_ID   (__DATE__ " " __TIME__)
+
+
+/**
+ * tabulated surrogate of an expensive PMI model. the model is sampled once on a
+ * tensor product grid over declared input ranges, each axis uniform in linear
+ * or log scale. lookups use tensor product cubic convolution (Catmull-Rom) of
+ * the samples, which is C1 continuous and linear in the samples, so the
+ * gradient with respect to the inputs is exact for the interpolant.
+ *
+ * tables are identified by the model name, the build of the model code and the
+ * parameter signature. a table is shared by all the PMI objects of the same material
+ * library and written to a disk cache, later runs of the same build with the same
+ * parameters load it instead of sampling. the cache is a per user directory,
+ * $XDG_CACHE_HOME/genius/pmi or $HOME/.cache/genius/pmi (%LOCALAPPDATA%\genius\pmi_cache
+ * on windows), created with owner only access. environment GENIUS_PMI_CACHE overrides
+ * it, an empty string disables the disk cache.
+ */
+class PMI_Table
+{
+public:
+
+  /**
+   * scale of an input axis
+   */
+  enum Scale {Linear, Log};
+
+  /**
+   * the model to be tabulated
+   */
+  class Function
+  {
+  public:
+    virtual ~Function() {}
+
+    /**
+     * evaluate all the outputs f at input x
+     */
+    virtual void operator() (const PetscScalar *x, PetscScalar *f) const = 0;
+  };
+
+  PMI_Table();
+
+  /**
+   * remove axes and release the table
+   */
+  void clear();
+
+  /**
+   * declare the next input axis with n (>=4) points in [min, max], at most 4 axes
+   */
+  void add_axis(PetscScalar min, PetscScalar max, unsigned int n, Scale scale=Linear);
+
+  /**
+   * load the table from memory or disk cache, else sample func with n_outputs (<=16)
+   * outputs and estimate the interpolation error.
+   * @param model      unique name of the tabulated function
+   * @param build_id   build of the model code, PMI_TABLE_BUILD_ID at the caller
+   * @param signature  parameter values the function depends on
+   */
+  void build(const Function &func, unsigned int n_outputs,
+             const std::string &model, const std::string &build_id, const std::string &signature);
+
+  /**
+   * @return true when the table is ready for lookup
+   */
+  bool built() const { return _data != 0; }
+
+  /**
+   * @return true when x is inside the declared input ranges
+   */
+  bool in_range(const PetscScalar *x) const;
+
+  /**
+   * interpolated outputs f at x, and optionally the gradient dfdx[o*dim+d]
+   */
+  void value(const PetscScalar *x, PetscScalar *f, PetscScalar *dfdx=0) const;
+
+  /**
+   * interpolated outputs f at x with AD derivatives by chain rule
+   */
+  void value(const AutoDScalar *x, AutoDScalar *f) const;
+
+  /**
+   * @return max absolute error of output o at sampled test points
+   */
+  PetscScalar max_error(unsigned int o) const;
+
+  /**
+   * @return max error of output o relative to the exact value at sampled test points
+   */
+  PetscScalar max_relative_error(unsigned int o) const;
+
+  /**
+   * @return a readable summary of the table size, origin and error
+   */
+  std::string info() const;
+
+  /**
+   * table data, shared by the tables with the same key
+   */
+  struct Data
+  {
+    /// samples, node major with the first axis fastest
+    std::vector<PetscScalar> values;
+    /// max absolute error of each output
+    std::vector<PetscScalar> abs_error;
+    /// max relative error of each output
+    std::vector<PetscScalar> rel_error;
+    /// loaded from disk cache
+    bool cached;
+  };
+
+private:
+
+  struct Axis
+  {
+    PetscScalar min;
+    PetscScalar max;
+    unsigned int n;
+    Scale scale;
+    /// begin and step of grid in scaled coordinate
+    PetscScalar u0;
+    PetscScalar h;
+  };
+
+  std::vector<Axis> _axes;
+
+  unsigned int _n_outputs;
+
+  const Data * _data;
+
+  /**
+   * the unique key of table, model, build, signature and grid
+   */
+  std::string _key(const std::string &model, const std::string &build_id, const std::string &signature) const;
+
+  /**
+   * sample func on grid and estimate error
+   */
+  void _sample(const Function &func, Data &data) const;
+
+  bool _load(const std::string &file, const std::string &key, Data &data) const;
+
+  void _save(const std::string &file, const std::string &key, const Data &data) const;
+
+  /**
+   * interpolated outputs by samples of data
+   */
+  void _value(const std::vector<PetscScalar> &values, const PetscScalar *x, PetscScalar *f, PetscScalar *dfdx) const;
+};
+
+
+#endif
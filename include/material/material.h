@@ -26,6 +26,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 #include "genius_common.h"
 
@@ -93,6 +94,18 @@ public:
    */
   void load_material( const std::string & material );
 
+  /**
+   * open the dll files of materials once before the regions are built.
+   * all the regions of the same material share the opened library and its
+   * resolved symbols, the preloaded libraries stay open until release_preloaded_materials()
+   */
+  static void preload_materials( const std::vector<std::string> & materials );
+
+  /**
+   * drop the references held by preload_materials
+   */
+  static void release_preloaded_materials();
+
 
   /**
    * function pointer to set_ad_number, set the independent variable
@@ -126,6 +139,11 @@ public:
    */
   virtual std::string get_pmi_info(const std::string& type, const int verbosity = 0) = 0;
 
+  /**
+   * @return the PMI object of given type, NULL if this material has no such PMI
+   */
+  virtual PMI_Server * get_pmi(const std::string& type) = 0;
+
 protected:
 
   /**
@@ -172,6 +190,22 @@ protected:
   void                      *dll_file;
 #endif
 
+  /**
+   * formatted material name, the key of dll file in the library registry
+   */
+  std::string                dll_name;
+
+  /**
+   * find symbol in the dll file, the lookup is cached for all the regions of the material
+   */
+  void * load_symbol( const std::string & name );
+
+  /**
+   * let pmi created by model_fun_name use the parameter table shared by all the regions
+   * of the material which load the same model. the table lives as long as the dll file
+   */
+  void share_parameter_table( PMI_Server * pmi, const std::string & model_fun_name );
+
 };
 
 
@@ -249,6 +283,11 @@ public:
    */
   std::string get_pmi_info(const std::string& type, const int verbosity = 0) ;
 
+  /**
+   * @return the PMI object of given type
+   */
+  PMI_Server * get_pmi(const std::string& type);
+
 };
 
 
@@ -312,6 +351,11 @@ public:
    */
   std::string get_pmi_info(const std::string& type, const int verbosity = 0) ;
 
+  /**
+   * @return the PMI object of given type
+   */
+  PMI_Server * get_pmi(const std::string& type);
+
 };
 
 
@@ -369,6 +413,11 @@ public:
    * get an information string of the PMI models
    */
   std::string get_pmi_info(const std::string& type, const int verbosity = 0) ;
+
+  /**
+   * @return the PMI object of given type
+   */
+  PMI_Server * get_pmi(const std::string& type);
 };
 
 
@@ -426,6 +475,11 @@ public:
    * get an information string of the PMI models
    */
   std::string get_pmi_info(const std::string& type, const int verbosity = 0) ;
+
+  /**
+   * @return the PMI object of given type
+   */
+  PMI_Server * get_pmi(const std::string& type);
 };
 
 
@@ -478,6 +532,11 @@ public:
    */
   std::string get_pmi_info(const std::string& type, const int verbosity = 0) ;
 
+  /**
+   * @return the PMI object of given type
+   */
+  PMI_Server * get_pmi(const std::string& type);
+
 };
 
 } // namespace Material
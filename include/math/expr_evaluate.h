@@ -2,6 +2,7 @@
 #define __expr_evalute_h__
 
 #include "expr_eval.h"
+#include "adolc.h"
 
 
 /**
@@ -71,8 +72,31 @@ public:
   double operator () (double x, double y, double z, double t)
   { return eval(x,y,z,t); }
 
+  /**
+   * evalute an expression and its partial derivatives for AD based jacobian,
+   * the derivatives of coordinate(x, y, z) and time are the AD values of the arguments
+   */
+  adtl::AutoDScalar eval(const adtl::AutoDScalar &x, const adtl::AutoDScalar &y, const adtl::AutoDScalar &z, const adtl::AutoDScalar &t);
+
+  /**
+   * evalute an expression and its partial derivatives for AD based jacobian
+   */
+  adtl::AutoDScalar operator () (const adtl::AutoDScalar &x, const adtl::AutoDScalar &y, const adtl::AutoDScalar &z, const adtl::AutoDScalar &t)
+  { return eval(x,y,z,t); }
+
+  /**
+   * compare the derivatives of AD evaluation to central difference at given point
+   * @return true when they agree within relative tolerance tol
+   */
+  bool check_derivative(double x, double y, double z, double t, double tol=1e-4);
+
 private:
 
+  /**
+   * address of independent variable x, y, z and t
+   */
+  double * var[4];
+
   /**
    * all the variables
    */
@@ -0,0 +1,467 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __fermi_dirac_h__
+#define __fermi_dirac_h__
+
+#include <cmath>
+#include <algorithm>
+
+
+/**
+ * Fermi-Dirac integrals of order -3/2, -1/2, 1/2, 3/2 and the inverse of order 1/2.
+ *
+ * F_j(x) = 1/Gamma(j+1) \int_0^\infty t^j/(1+exp(t-x)) dt, which goes to exp(x)
+ * as x -> -inf and dF_j/dx = F_{j-1}. each order is a Chebyshev expansion of 20 terms
+ * on six blocks of x: x<=0 in t=exp(x), [0,2], [2,6], [6,14], [14,30] in x, and x>30
+ * in w=30/x scaled by x^(j+1). the relative error is below 1e-13.
+ *
+ * the value and the derivative are evaluated together on the same block. the block is
+ * selected by arithmetic instead of branches, so the loops of the batched versions have
+ * no branch and can be vectorized by compiler.
+ */
+namespace FermiDirac
+{
+
+  /**
+   * Chebyshev coefficients of [order][block][term]
+   */
+  template <int dummy>
+  struct Table
+  {
+    static const double c[4][6][20];
+  };
+
+  template <int dummy>
+  const double Table<dummy>::c[4][6][20] =
+  {
+    // order -3/2
+    {
+      // x <= 0, t = exp(x)
+      {
+        +6.25700787326290420e-01, -2.97282345838521533e-01, +6.19322479541586160e-02, -1.22118423215213344e-02,
+        +2.33552380651963314e-03, -4.38051259700383876e-04, +8.10566141497573130e-05, -1.48501075851900803e-05,
+        +2.69995790235725050e-06, -4.87935615388133302e-07, +8.77488731174112235e-08, -1.57166869235825674e-08,
+        +2.80543543956928844e-09, -4.99317811740831536e-10, +8.86470394378386686e-11, -1.57036842103036287e-11,
+        +2.77653507690470472e-12, -4.90067735756730347e-13, +8.62944428081232723e-14, -1.47341779157234489e-14
+      },
+      // 0 < x <= 2
+      {
+        +4.21963562741436149e-01, +1.71165079620411754e-02, -2.32956065016109715e-02, +2.00342916677482804e-03,
+        +4.63138223299830432e-04, -9.94369270622883877e-05, -2.83148533737575353e-06, +2.82279921368439871e-06,
+        -1.89004547190351135e-07, -5.28783542905742083e-08, +9.46267764381808132e-09, +4.28490093325084314e-10,
+        -2.67178299301817767e-10, +1.37961969745026492e-11, +5.13059194463215295e-12, -7.87236454266213753e-13,
+        -5.07673641680444776e-14, +2.30594778468433283e-14, -8.64120777371926347e-16, -4.66640337365659023e-16
+      },
+      // 2 < x <= 6
+      {
+        +3.19348862030266190e-01, -8.95518210314877189e-02, +1.10789332858626764e-02, +6.80767706023848850e-04,
+        -8.45175353811093038e-04, +2.56456057099634495e-04, -4.48033137661627348e-05, +2.77119020083442344e-06,
+        +1.11908727035113051e-06, -4.78607661036092399e-07, +1.03004326326164441e-07, -1.19023433797872097e-08,
+        -6.54967178765783055e-10, +7.09974608090096980e-10, -1.94332262298429850e-10, +3.08236243353713335e-11,
+        -1.47579766316902079e-12, -8.24403494803507304e-13, +3.17367973916242473e-13, -6.46339284217229931e-14
+      },
+      // 6 < x <= 14
+      {
+        +1.88313724598616422e-01, -4.29239709503519765e-02, +7.70475301906608720e-03, -1.57618262901474239e-03,
+        +3.30234962024310253e-04, -6.52870234859595288e-05, +1.11954441713993869e-05, -1.41873638743115611e-06,
+        +3.68410919995548197e-08, +5.17465791374254592e-08, -2.21265271347398023e-08, +6.37474657743946634e-09,
+        -1.52394832291177053e-09, +3.19953125237939258e-10, -5.98313043067833804e-11, +9.80471368846197575e-12,
+        -1.30910841005564530e-12, +1.00838579817619908e-13, +1.47053564946873605e-14, -9.01233866368157073e-15
+      },
+      // 14 < x <= 30
+      {
+        +1.23939268633375330e-01, -2.37477398509193215e-02, +3.43292497895497867e-03, -5.56403045341248895e-04,
+        +9.57095466627864370e-05, -1.71468151971317507e-05, +3.17442001930134418e-06, -6.04987333054029300e-07,
+        +1.18331419044829550e-07, -2.36455017794546224e-08, +4.79172449733474120e-09, -9.74640374912931768e-10,
+        +1.96514319693098352e-10, -3.87483332075668957e-11, +7.36584367041784768e-12, -1.32850797091032858e-12,
+        +2.22580897563628223e-13, -3.34128397212956311e-14, +4.13089527965679363e-15, -3.14790711626620491e-16
+      },
+      // x > 30, w = 30/x
+      {
+        +5.64482026786567115e-01, +3.90578209873949857e-04, +9.86297838254185459e-05, +5.69745979007551142e-07,
+        +7.64858425234702889e-08, +1.72886621245787612e-09, +1.85705153283198167e-10, +1.05771518627077555e-11,
+        +1.23225376950924687e-12, +1.38672536156328479e-13, +2.20316119462436624e-14, +3.84163207158259035e-15,
+        +6.69062481964746749e-16, +7.31404190542914731e-17, -1.40861430838815675e-17, -1.22521134530144862e-17,
+        -4.16387540222158007e-18, -6.45276894707204757e-19, +1.28818771504638981e-19, +1.09585314184429908e-19
+      }
+    },
+    // order -1/2
+    {
+      // x <= 0, t = exp(x)
+      {
+        +7.74341960245551131e-01, -1.93335556801508684e-01, +2.74565198103372300e-02, -4.11273457766586463e-03,
+        +6.34524060874166193e-04, -9.97613095377028247e-05, +1.58919966752115231e-05, -2.55620916525836059e-06,
+        +4.14229690643557698e-07, -6.75217122580592960e-08, +1.10591815670278164e-08, -1.81854371856581775e-09,
+        +3.00036569505826588e-10, -4.96435100670728443e-11, +8.23417357137389534e-12, -1.36871029531568417e-12,
+        +2.27942231709210258e-13, -3.80265402144747342e-14, +6.35141085446379491e-15, -1.03396231055030199e-15
+      },
+      // 0 < x <= 2
+      {
+        +1.03056383285565900e+00, +4.33611365992241593e-01, +3.77826969881656961e-03, -3.95979078748513735e-03,
+        +2.62858261729636319e-04, +4.65969708637223144e-05, -8.52164385632446415e-06, -1.88748627866609879e-07,
+        +1.79729848002498019e-07, -1.10259569347029747e-08, -2.66534222533724123e-09, +4.42266179812958081e-10,
+        +1.72789087246411846e-11, -1.04734201587930403e-11, +5.20844758771379540e-13, +1.72717150583090252e-13,
+        -2.53208744154094322e-14, -1.46404865835740586e-15, +6.46757889457032430e-16, -2.59079245902592664e-17
+      },
+      // 2 < x <= 6
+      {
+        +2.14068914735623084e+00, +6.27618790774669755e-01, -4.51162943687558049e-02, +3.97470287989125457e-03,
+        +1.06077912231048845e-04, -1.60074408008984575e-04, +4.22808111498088832e-05, -6.56034300521284724e-06,
+        +4.06224732738814066e-07, +1.12898104893560285e-07, -4.66705317753844759e-08, +9.42357213988666217e-09,
+        -1.05102650405967585e-09, -3.54334578741176123e-11, +4.85107951545883620e-11, -1.28570895916021715e-11,
+        +1.97798892386041969e-12, -1.05429097425533714e-13, -4.22639843263027305e-14, +1.59832704089767794e-14
+      },
+      // 6 < x <= 14
+      {
+        +3.51216598531809465e+00, +7.37845392356333507e-01, -4.13477883213372588e-02, +4.91634537136118131e-03,
+        -7.55447802764397077e-04, +1.27615807141166380e-04, -2.12894290328321007e-05, +3.18817230840457825e-06,
+        -3.67620741636119302e-07, +1.31039153652645327e-08, +9.07436650059264356e-09, -3.74592341723428126e-09,
+        +1.00913223596186561e-09, -2.25248774972907116e-10, +4.43069288428380015e-11, -7.80295301125036568e-12,
+        +1.21299095195439071e-12, -1.55769728564558972e-13, +1.23481171437007332e-14, +9.54476950567078615e-16
+      },
+      // 14 < x <= 30
+      {
+        +5.24217480725242702e+00, +9.77782449151182731e-01, -4.63826736111561805e-02, +4.44962057638958498e-03,
+        -5.39256230144124571e-04, +7.40281013147909244e-05, -1.10278852427042032e-05, +1.74633634301015987e-06,
+        -2.90670915629124912e-07, +5.04620864680990401e-08, -9.06834457676062658e-09, +1.67098552287524149e-09,
+        -3.11964021953312359e-10, +5.81995274237485382e-11, -1.06913617061316588e-11, +1.90488071349327010e-12,
+        -3.23775048306185965e-13, +5.14138330078928718e-14, -7.38164601307913817e-15, +8.86641476886518037e-16
+      },
+      // x > 30, w = 30/x
+      {
+        +1.12818513544459353e+00, -2.58893279111238898e-04, -6.50007145971647204e-05, -1.59704557332535203e-07,
+        -2.08886095894932054e-08, -2.99425954144679057e-10, -3.01145023962142669e-11, -1.26643177511759465e-12,
+        -1.30951955260796703e-13, -1.17306935035551775e-14, -1.61237970625869447e-15, -2.49766291090685834e-16,
+        -4.39974592767674547e-17, -6.66198259896401779e-18, -2.79526306836014326e-19, +3.50900823664504458e-19,
+        +1.73842917450701738e-19, +4.38440680559353334e-20, +5.01602001051155808e-21, -1.08591032572105265e-21
+      }
+    },
+    // order 1/2
+    {
+      // x <= 0, t = exp(x)
+      {
+        +8.71009738646305487e-01, -1.16094254955589268e-01, +1.13964332993326343e-02, -1.31002275499740063e-03,
+        +1.64277460483192050e-04, -2.17754830010224860e-05, +2.99991835864174537e-06, -4.25203778339061746e-07,
+        +6.15987672571050288e-08, -9.07968780281549349e-09, +1.35733157999980800e-09, -2.05292208617557850e-10,
+        +3.13569291437862403e-11, -4.82999844670364581e-12, +7.49405576335842774e-13, -1.17017262417649561e-13,
+        +1.83742387471878091e-14, -2.90085303341170946e-15, +4.61359437881160204e-16, -7.17063911351568476e-17
+      },
+      // 0 < x <= 2
+      {
+        +1.68553827314098914e+00, +1.02867469800625067e+00, +1.09392789194931644e-01, +5.85901906181139132e-04,
+        -5.00798469793615575e-04, +2.71379905586029306e-05, +3.89880995765140419e-06, -6.21526693152040140e-07,
+        -1.11076669216902198e-08, +1.01330661237407900e-08, -5.73411170170352500e-10, -1.21937327463763860e-10,
+        +1.88641410595084616e-11, +6.44540672386137622e-13, -3.80198175751324144e-13, +1.82221821777390665e-14,
+        +5.44939608366818238e-15, -7.57628468834532487e-16, -5.40877481662094217e-17, +1.48701540786285095e-17
+      },
+      // 2 < x <= 6
+      {
+        +6.82233120041622332e+00, +4.32649458908121698e+00, +3.11822043947389049e-01, -1.50741240936623430e-02,
+        +1.03369432197502643e-03, +1.27594202162726072e-05, -2.55856775005537628e-05, +5.98208377391892252e-06,
+        -8.34155138717457968e-07, +5.03216960587592856e-08, +1.03474532145874232e-08, -4.14722775858460165e-09,
+        +7.88250429458623829e-10, -8.45797974795155665e-11, -1.61251275690088122e-12, +3.10224994991481454e-12,
+        -7.96956712383551599e-13, +1.18866014616647774e-13, -6.84252710259807958e-15, -1.90600557183937671e-15
+      },
+      // 6 < x <= 14
+      {
+        +2.48152323328783169e+01, +1.41313595179150511e+01, +7.32929046984971744e-01, -2.70615603457154096e-02,
+        +2.39436478210989893e-03, -2.93663349492552137e-04, +4.14758782778256211e-05, -5.97765951161398850e-06,
+        +7.93767098404305662e-07, -8.37100240196981954e-08, +3.36996755486842251e-09, +1.46640622099173291e-09,
+        -5.86779227119264208e-10, +1.48434639535163594e-10, -3.10634167991934685e-11, +5.74605658244859046e-12,
+        -9.55847034620376602e-13, +1.41370806594389452e-13, -1.76729200645381496e-14, +1.45082115676098324e-15
+      },
+      // 14 < x <= 30
+      {
+        +7.97648816953299473e+01, +4.21229291524640388e+01, +1.94666565714958439e+00, -6.11245565080165559e-02,
+        +4.37559247507447128e-03, -4.22582675920921570e-04, +4.81878433152257751e-05, -6.13555104358756276e-06,
+        +8.47937128697147892e-07, -1.25156698209053637e-07, +1.95164397744102467e-08, -3.18413839956310681e-09,
+        +5.37594974482659568e-10, -9.26993538831853365e-11, +1.60849915470384270e-11, -2.76410852009188302e-12,
+        +4.63517638262741483e-13, -7.41258418992155342e-14, +1.06141126459332212e-14, -1.56628381618741255e-15
+      },
+      // x > 30, w = 30/x
+      {
+        +7.52639740378081123e-01, +5.16022786378069853e-04, +1.29115416486602570e-04, +6.29559547846272026e-08,
+        +8.06945737564629685e-09, +6.39292609617942327e-11, +6.07453846467510333e-12, +1.77958549799210264e-13,
+        +1.64955710295690703e-14, +1.14286558349064815e-15, +1.34498895078687291e-16, +1.75402321241597406e-17,
+        +2.89085794772304702e-18, +4.79461824900079234e-19, +6.90415133994194369e-20, +6.25663471079327674e-21,
+        +3.30326659370476088e-23, -1.13042056156329220e-21, -5.93577791389589842e-21, -3.74308538398742487e-21
+      }
+    },
+    // order 3/2
+    {
+      // x <= 0, t = exp(x)
+      {
+        +9.29056866124100100e-01, -6.59961650056665045e-02, +4.50164175641111150e-03, -3.99234607451648058e-04,
+        +4.08794047753341811e-05, -4.58602009811396708e-06, +5.48143845802485799e-07, -6.86474639407059019e-08,
+        +8.91102370321487927e-09, -1.19009478433017136e-09, +1.62658718903801998e-10, -2.26622113879358739e-11,
+        +3.20885479888885687e-12, -4.60681251274370311e-13, +6.69323087545880286e-14, -9.82763510181558919e-15,
+        +1.45619107805056309e-15, -2.18276975512310945e-16, +3.38484762717079555e-17, -5.02397778590282402e-18
+      },
+      // 0 < x <= 2
+      {
+        +2.25921285560374763e+00, +1.63084187854352325e+00, +2.57022199025017328e-01, +1.83155979441208434e-02,
+        +6.98454894528038141e-05, -5.04697279751131002e-05, +2.31329310434650881e-06, +2.79279830353819706e-07,
+        -3.94787349346504061e-08, -5.85236431532825498e-10, +5.12750149329538535e-10, -2.69216138680645214e-11,
+        -5.10759217734681327e-12, +7.40169150916035461e-13, +2.24043368347000125e-14, -1.28243583725587164e-14,
+        +6.06594398114163180e-16, +1.70141659741088713e-16, -4.28985869004224108e-17, -7.76271886914981537e-18
+      },
+      // 2 < x <= 6
+      {
+        +1.54350446486217958e+01, +1.33328403568850575e+01, +2.17078435658743896e+00, +1.03596116541804395e-01,
+        -3.77172087846976145e-03, +2.11855999895227241e-04, +1.12955607399871151e-06, -3.53593176575297992e-06,
+        +7.41470259897401359e-07, -9.38336213354847166e-08, +5.44689219463301424e-09, +8.69018359811261267e-10,
+        -3.38554114512490780e-10, +6.07587062602487742e-11, -6.26271136146573147e-12, -5.41204657768798173e-14,
+        +1.86574176140623443e-13, -4.64162419270627797e-14, +6.55281017919368243e-15, -4.93927933208017354e-16
+      },
+      // 6 < x <= 14
+      {
+        +1.15176811431107012e+02, +9.77950712375433255e+01, +1.41584210782607620e+01, +4.87023121468572684e-01,
+        -1.33839484981122091e-02, +9.41155561533591704e-04, -9.58952299917082302e-05, +1.16234603385221421e-05,
+        -1.47348737072376073e-06, +1.75643806803862291e-07, -1.70352874179245099e-08, +7.19408034138035961e-10,
+        +2.19661072013649843e-10, -8.54946575071487765e-11, +2.03861794220262735e-11, -4.01259313936583488e-12,
+        +7.01340440459802248e-13, -1.09881378023731220e-13, +1.42770926964443670e-14, -2.23484996351847507e-15
+      },
+      // 14 < x <= 30
+      {
+        +7.76223274102620167e+02, +6.30332390934041200e+02, +8.43681074179440884e+01, +2.58972008623266836e+00,
+        -6.07019738321006516e-02, +3.46192370541211804e-03, -2.77631416572620283e-04, +2.70513749733337543e-05,
+        -3.00519716524983557e-06, +3.68186972616009255e-07, -4.87890327700514411e-08, +6.90139537968174460e-09,
+        -1.03048519280173570e-09, +1.60464956867547336e-10, -2.56824365534572577e-11, +4.17671209783034633e-12,
+        -6.67927326173561720e-13, +1.09939937529282275e-13, -2.44975470177175789e-14, +3.07243115223483945e-17
+      },
+      // x > 30, w = 30/x
+      {
+        +3.01674309088841741e-01, +1.03088213554982104e-03, +2.57647962985169804e-04, -4.15416434969430113e-08,
+        -5.24856548624651429e-09, -1.76906513702803961e-11, -1.60330516071726805e-12, -3.00012175254027885e-14,
+        -2.51973740530767535e-15, -1.29919368084774591e-16, -1.31247831023469281e-17, -1.38978673040304867e-18,
+        -2.10752373727703053e-19, -3.01886834801536896e-20, +1.87106696262951025e-20, +2.24245782190418797e-20,
+        +1.27855567687263821e-20, +2.29412386949875086e-21, -1.10701084733174057e-20, -7.53289567905104843e-21
+      }
+    }
+  };
+
+
+  /**
+   * index of order in table
+   */
+  enum Order { M3HALF=0, MHALF=1, HALF=2, P3HALF=3 };
+
+
+  /**
+   * the block of x and its Chebyshev variable, shared by all the orders
+   */
+  struct Argument
+  {
+    int    block;
+    double u;
+    double t;
+    double xs;
+    double sqrt_xs;
+
+    explicit Argument(double x)
+    {
+      // map of each block onto [-1, 1] by x, t and w
+      static const double cx[6] = { 0.0,  1.0,  0.5,  0.25,  0.125, 0.0 };
+      static const double ct[6] = { 2.0,  0.0,  0.0,  0.0,   0.0,   0.0 };
+      static const double cw[6] = { 0.0,  0.0,  0.0,  0.0,   0.0,   2.0 };
+      static const double c0[6] = {-1.0, -1.0, -2.0, -2.5,  -2.75, -1.0 };
+
+      block   = (x>0.0) + (x>2.0) + (x>6.0) + (x>14.0) + (x>30.0);
+      t       = exp(std::min(x, 0.0));
+      xs      = std::max(x, 30.0);
+      sqrt_xs = sqrt(xs);
+      u = cx[block]*x + ct[block]*t + cw[block]*(30.0/xs) + c0[block];
+    }
+
+    /**
+     * scale of the expansion of order j
+     */
+    double scale(Order order) const
+    {
+      static const double st[6] = { 1.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+      static const double sc[6] = { 0.0, 1.0, 1.0, 1.0, 1.0, 0.0 };
+      static const double sx[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+
+      // x^(j+1) of the last block
+      double p = 0.0;
+      switch(order)
+      {
+        case M3HALF : p = 1.0/sqrt_xs;       break;
+        case MHALF  : p = sqrt_xs;           break;
+        case HALF   : p = xs*sqrt_xs;        break;
+        case P3HALF : p = xs*xs*sqrt_xs;     break;
+      }
+      return st[block]*t + sc[block] + sx[block]*p;
+    }
+  };
+
+
+  /**
+   * evaluate Chebyshev series of 20 terms by Clenshaw recurrence
+   */
+  inline double chebyshev(const double * c, double u)
+  {
+    const double u2 = 2.0*u;
+    double b1 = 0.0, b2 = 0.0;
+    for(int k=19; k>=1; --k)
+    {
+      const double b0 = u2*b1 - b2 + c[k];
+      b2 = b1;
+      b1 = b0;
+    }
+    return u*b1 - b2 + c[0];
+  }
+
+
+  /**
+   * F_j(x) of given order at argument a
+   */
+  inline double eval(Order order, const Argument & a)
+  {
+    return a.scale(order)*chebyshev(Table<0>::c[order][a.block], a.u);
+  }
+
+
+  /**
+   * @return F_{-1/2}(x), d is F_{-3/2}(x)
+   */
+  inline double mhalf(double x, double & d)
+  {
+    const Argument a(x);
+    d = eval(M3HALF, a);
+    return eval(MHALF, a);
+  }
+
+  /**
+   * @return F_{1/2}(x), d is F_{-1/2}(x)
+   */
+  inline double half(double x, double & d)
+  {
+    const Argument a(x);
+    d = eval(MHALF, a);
+    return eval(HALF, a);
+  }
+
+  /**
+   * @return F_{3/2}(x), d is F_{1/2}(x)
+   */
+  inline double three_half(double x, double & d)
+  {
+    const Argument a(x);
+    d = eval(HALF, a);
+    return eval(P3HALF, a);
+  }
+
+  /**
+   * @return F_{-1/2}(x)
+   */
+  inline double mhalf(double x)
+  { return eval(MHALF, Argument(x)); }
+
+  /**
+   * @return F_{1/2}(x)
+   */
+  inline double half(double x)
+  { return eval(HALF, Argument(x)); }
+
+  /**
+   * @return F_{3/2}(x)
+   */
+  inline double three_half(double x)
+  { return eval(P3HALF, Argument(x)); }
+
+
+  /**
+   * @return x which satisfies F_{1/2}(x) = y, d is dx/dy.
+   * the initial guess of Joyce-Dixon (small y) or Sommerfeld (large y) expansion
+   * is corrected by two Newton steps. y should be positive.
+   */
+  inline double inv_half(double y, double & d)
+  {
+    const double ys = std::max(y, 1e-300);
+    const double x_small = log(ys) + ys*(3.5355339059327379e-001 - ys*(4.9500897298752622e-003
+                                     - ys*(1.4838577128872821e-004 - ys*4.4256301190009895e-006)));
+    const double x_large = sqrt(std::max(std::pow(0.75*1.772453850905516*ys, 4.0/3.0) - 1.6449340668482264, 0.0));
+    double x = ys < 8.463 ? x_small : x_large;
+
+    double f = 0.0, df = 1.0;
+    for(int i=0; i<2; ++i)
+    {
+      f = half(x, df);
+      x -= (f - ys)/df;
+    }
+    f = half(x, df);
+
+    d = 1.0/df;
+    return x;
+  }
+
+  /**
+   * @return x which satisfies F_{1/2}(x) = y
+   */
+  inline double inv_half(double y)
+  {
+    double d;
+    return inv_half(y, d);
+  }
+
+
+  /**
+   * batched F_{-1/2} and its derivative of n points
+   */
+  inline void mhalf(unsigned int n, const double * x, double * f, double * d)
+  {
+    for(unsigned int i=0; i<n; ++i)
+      f[i] = mhalf(x[i], d[i]);
+  }
+
+  /**
+   * batched F_{1/2} and its derivative of n points
+   */
+  inline void half(unsigned int n, const double * x, double * f, double * d)
+  {
+    for(unsigned int i=0; i<n; ++i)
+      f[i] = half(x[i], d[i]);
+  }
+
+  /**
+   * batched F_{3/2} and its derivative of n points
+   */
+  inline void three_half(unsigned int n, const double * x, double * f, double * d)
+  {
+    for(unsigned int i=0; i<n; ++i)
+      f[i] = three_half(x[i], d[i]);
+  }
+
+  /**
+   * batched inverse of F_{1/2} and its derivative of n points
+   */
+  inline void inv_half(unsigned int n, const double * y, double * x, double * d)
+  {
+    for(unsigned int i=0; i<n; ++i)
+      x[i] = inv_half(y[i], d[i]);
+  }
+
+}
+
+#endif
@@ -13,6 +13,7 @@
 #endif
 
 #include "adolc.h"
+#include "fermi_dirac.h"
 using namespace adtl;
 
 /* define the constant */
@@ -282,103 +283,41 @@ inline double pd1erf ( double x )
 
 
 /* ----------------------------------------------------------------------------
- * fermi_half:  This function returns value of 1/2 order Fermi-Dirac Integral
+ * fermi_half:  This function returns value of 1/2 order Fermi-Dirac Integral,
+ * see FermiDirac::half.
  */
 inline double fermi_half(double x)
 {
-  /* use an analytic expression. The result achieves within 0.4% error in all ranges.*/
-  if(x<-4.5)
-  {
-    //for small arguments, fhfp and exp are almost identical.
-    return 1.0/exp(-x);
-  }
-  else if(x<0.0)
-  {
-    double v = std::pow(x,4) + 50 + 33.6*x*(1-0.68*exp(-0.17*(x+1)*(x+1)));
-    double p = 1.329340388179*std::pow(v,double(-0.375));
-    return 1.0/(exp(-x) + p);
-  }
-  else
-  {
-    double v = std::pow(x,4) + 50 + 33.6*x*(1-0.68*exp(-0.17*(x+1)*(x+1)));
-    double p = 1.329340388179*std::pow(v,double(-0.375));
-    return 1.0/(1.0/exp(x) + p);
-  }
+  return FermiDirac::half(x);
 }
 
 
+/* ----------------------------------------------------------------------------
+ * fermi_half:  AD version of fermi_half, the value and derivative are
+ * evaluated together, the derivative is fermi_mhalf
+ */
 inline AutoDScalar fermi_half(const AutoDScalar &x)
 {
-  /* use an analytic expression. The result achieves within 0.4% error in all ranges.*/
-  if(x<-4.5)
-  {
-    //for small arguments, fhfp and exp are almost identical.
-    return 1.0/exp(-x);
-  }
-  else if(x<0.0)
-  {
-    AutoDScalar v = adtl::pow(x,4) + 50 + 33.6*x*(1-0.68*exp(-0.17*(x+1)*(x+1)));
-    AutoDScalar p = 1.329340388179*adtl::pow(v,double(-0.375));
-    return 1.0/(exp(-x) + p);
-  }
-  else
-  {
-    AutoDScalar v = adtl::pow(x,4) + 50 + 33.6*x*(1-0.68*exp(-0.17*(x+1)*(x+1)));
-    AutoDScalar p = 1.329340388179*adtl::pow(v,double(-0.375));
-    return 1.0/(1.0/exp(x) + p);
-  }
+  double d;
+  AutoDScalar tmp;
+  tmp.setValue(FermiDirac::half(x.getValue(), d));
+  for (unsigned int i=0; i<AutoDScalar::numdir; ++i)
+    tmp.setADValue(i, d*x.getADValue(i));
+  return tmp;
 }
 
 
 /*-----------------------------------------------------------------------
  *
  *     fhfm evaluates the fermi-dirac integral of minus one-half order
- *     f-1/2(x) from x
+ *     f-1/2(x) from x, see FermiDirac::mhalf.
  */
 inline double fermi_mhalf(double x)
 {
-/*     the formulae used are after j.s. blakemore, ''semiconductor
- *     statistics,'' new york: pergamon press, appendix c, 1962, for
- *     x greater than or equal to 5.5; when x is less than 5.5,
- *     f-1/2=1/(1/f+a+2*b*f+3*c*f*f+4*d*f*f*f) where f=f1/2 and it
- *     is the derivative of approximate form of f1/2 (see function
- *     fermi_half)
- *     the maximum relative error is about 1.2%
- */
-  double a=3.53553e-1,b=4.95009e-3,c=1.48386e-4,d=4.42563e-6;
-  if(x<-4.5)
-  {
-    //for small argument, fhfm1 and exp are almost identical.
-    return exp(x);
-  }
-  else
-  {
-    if(x<5.5)
-    {
-      double f=fermi_half(x);
-      return f/(1.0+f*(a+f*(-2.0*b+f*(3*c-4*d*f))));
-    }
-    else
-      return 2.0*x/(SQRTPI*std::pow((x*x+0.6),double(0.25)));
-  }
+  return FermiDirac::mhalf(x);
 }
 
 
-/* ----------------------------------------------------------------------------
- * fermi_half:  AD version of fermi_half
- */
-
-/*
-inline AutoDScalar fermi_half(const AutoDScalar &x)
-{
-    AutoDScalar tmp;
-    tmp.setValue(fermi_half(x.getValue()));
-    for (unsigned int i=0; i<AutoDScalar::numdir; ++i)
-      tmp.setADValue(i, fermi_mhalf(x.getValue())*x.getADValue(i) );
-    return tmp;
-}
-*/
-
 /*-----------------------------------------------------------------------
  *
  *     fhfm2 evaluates the fermi-dirac integral of minus one-half order
@@ -407,62 +346,46 @@ inline double fermi_mhalf_f(double x)
 
 
 /* ----------------------------------------------------------------------------
- * inv_fermi_half:  This function returns inverse value of Fermi-Dirac Integral
+ * inv_fermi_half:  This function returns inverse value of Fermi-Dirac Integral,
+ * see FermiDirac::inv_half.
  */
 inline double inv_fermi_half(double x)
 {
-  if(x<8.463)
-    return log(x) + x*(3.5355339059327379e-001 - x*(4.9500897298752622e-003
-                       - x*(1.4838577128872821e-004 - x*4.4256301190009895e-006)));
-  else
-    return sqrt(std::pow(0.75*SQRTPI*x,double(4.0/3.0)) - PI*PI/6.0);
+  return FermiDirac::inv_half(x);
 }
 
 
 /*-----------------------------------------------------------------------
- *   GAMMA calculates f1/2(eta)/exp(eta) according to the approximate
- *   formula in casey's book,dummy arguement x=f1/2(eta).
+ *   GAMMA calculates f1/2(eta)/exp(eta), dummy arguement x=f1/2(eta).
+ *   eta is the inverse of fermi_half, the result is limited to VerySmallNumericValue
  */
 inline  double gamma_f(double x)
 {
-  const double a=3.53553e-1,b=4.95009e-3,c=1.48386e-4;
-  const double d=4.42563e-6,pi1=1.772453851e0,pi2=9.869604401e0;
-  double temx;
-  if(x>1.0e1)
-  {
-    temx=sqrt(std::pow(7.5e-1*pi1*x,double(4.e0/3.e0))-pi2/6.e0);
-    if(x > MaximumExponent)
-      return VerySmallNumericValue;
-    else
-      return x/exp(temx);
-  }
-  else if(x>0.0)
-  {
-    temx=x*(a+x*(-b+x*(c-x*d)));
-    return 1.0/exp(temx);
-  }
+  if(x>0.0)
+    return std::max(x*exp(-FermiDirac::inv_half(x)), VerySmallNumericValue);
   else
     return 1.0;
 }
 
 
+/*-----------------------------------------------------------------------
+ *   AD version of gamma_f, d(gamma)/dx = exp(-eta)*(1 - x*d(eta)/dx)
+ */
 inline  AutoDScalar gamma_f(const AutoDScalar &x)
 {
-  const double a=3.53553e-1,b=4.95009e-3,c=1.48386e-4;
-  const double d=4.42563e-6,pi1=1.772453851e0,pi2=9.869604401e0;
-  AutoDScalar temx;
-  if(x>1.0e1)
+  if(x>0.0)
   {
-    temx=sqrt(adtl::pow(7.5e-1*pi1*x,double(4.e0/3.e0))-pi2/6.e0);
-    if(x > MaximumExponent)
-      return VerySmallNumericValue;
-    else
-      return x/exp(temx);
-  }
-  else if(x>0.0)
-  {
-    temx=x*(a+x*(-b+x*(c-x*d)));
-    return 1.0/exp(temx);
+    double deta;
+    const double v   = x.getValue();
+    const double g   = exp(-FermiDirac::inv_half(v, deta));
+    if(v*g < VerySmallNumericValue) return VerySmallNumericValue;
+
+    const double dg  = g*(1.0 - v*deta);
+    AutoDScalar tmp;
+    tmp.setValue(v*g);
+    for (unsigned int i=0; i<AutoDScalar::numdir; ++i)
+      tmp.setADValue(i, dg*x.getADValue(i));
+    return tmp;
   }
   else
     return 1.0;
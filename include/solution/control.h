@@ -32,6 +32,8 @@
 #include "solver_base.h"
 #include "mxml.h"
 
+class HierarchyTransfer;
+
 
 // purify namespace
 // undefine "REAL", which was defined by the tetgen and triangle mesh generator
@@ -194,6 +196,16 @@ public:
    * process and do "REFINE.UNIFORM" card
    */
   int  do_refine_uniform  ( const Parser::Card & c );
+
+  /**
+   * save doping/mole fraction into hierarchy transfer before refine
+   */
+  void save_hierarchy_transfer ( HierarchyTransfer & transfer );
+
+  /**
+   * set doping/mole fraction of refined mesh from hierarchy transfer
+   */
+  void apply_hierarchy_transfer ( HierarchyTransfer & transfer );
   
   /**
    * do total dose effect simulation
@@ -215,6 +227,12 @@ public:
    */
   int  plot_mesh ( const Parser::Card & c );
 
+  /**
+   * process and do "BATCH" card, the following cards are done once for each
+   * variant in the parameter table, starting from the same solution
+   */
+  int  do_batch ( const Parser::Card & c, const std::vector<Parser::Card> & cards );
+
 private:
 
   Parser::InputParser *_decks;
@@ -265,6 +283,21 @@ private:
   mxml_node_t *_dom_solution;
 
   std::string _fname_solution;
+
+  /**
+   * tag of current batch variant, appended to output file names
+   */
+  std::string _batch_tag;
+
+  /**
+   * dispatch a single input card
+   */
+  int do_card ( const Parser::Card & c );
+
+  /**
+   * insert batch variant tag into file name
+   */
+  std::string batch_file_name( const std::string & fname ) const;
 };
 
 class SolverControlHook : public Hook
@@ -23,9 +23,11 @@
 #define __data_storage_h__
 
 #include <vector>
+#include <cstring>
 #include "enum_data_type.h"
 #include "vector_value.h"
 #include "tensor_value.h"
+#include "checkpoint_file.h"
 
 class DataStorage
 {
@@ -350,8 +352,62 @@ public:
     return counter;
   }
 
+  /**
+   * write all the data blocks to checkpoint file
+   */
+  void write(CheckpointWriter & out) const
+  {
+    out.write<unsigned int>(_size);
+    _write_blocks(out, _scalar_fill, _scalar_block);
+    _write_blocks(out, _complex_fill, _complex_block);
+    _write_blocks(out, _vector_fill, _vector_block);
+    _write_blocks(out, _tensor_fill, _tensor_block);
+  }
+
+  /**
+   * load data blocks from checkpoint file, the size and variable layout must not change
+   * @return false when layout mismatch
+   */
+  bool read(CheckpointReader & in)
+  {
+    if( in.read<unsigned int>() != _size ) return false;
+    return _read_blocks(in, _scalar_fill, _scalar_block) &&
+           _read_blocks(in, _complex_fill, _complex_block) &&
+           _read_blocks(in, _vector_fill, _vector_block) &&
+           _read_blocks(in, _tensor_fill, _tensor_block);
+  }
+
 private:
 
+  template <typename T>
+  static void _write_blocks(CheckpointWriter & out, const std::vector<bool> & fill, const std::vector< std::vector<T> > & block)
+  {
+    out.write<unsigned int>(fill.size());
+    for(unsigned int n=0; n<fill.size(); ++n)
+    {
+      out.write<unsigned char>(fill[n]);
+      if(fill[n]) out.write_array(block[n]);
+    }
+  }
+
+  template <typename T>
+  bool _read_blocks(CheckpointReader & in, const std::vector<bool> & fill, std::vector< std::vector<T> > & block) const
+  {
+    if( in.read<unsigned int>() != fill.size() ) return false;
+    for(unsigned int n=0; n<fill.size(); ++n)
+    {
+      if( in.read<unsigned char>() != static_cast<unsigned char>(fill[n]) ) return false;
+      if( !fill[n] ) continue;
+
+      size_t size;
+      const T * p = in.read_array<T>(size);
+      if( !in.good() || size != _size ) return false;
+      // the mapped data may be unaligned
+      if(size) std::memcpy(&block[n][0], p, size*sizeof(T));
+    }
+    return in.good();
+  }
+
   /**
    * the size of data array
    */
@@ -25,6 +25,7 @@
 #define __external_circuit_h__
 
 #include <string>
+#include <vector>
 #include <complex>
 
 #include "genius_common.h"
@@ -292,6 +293,52 @@ public:
     _current_old = _current;
   }
 
+  /**
+   * save the stimulate and potential/current of this electrode,
+   * used when several solves should start from the same state
+   */
+  virtual void backup()
+  { pack_state(_backup_state); }
+
+  /**
+   * restore state saved by backup()
+   */
+  virtual void restore()
+  { unpack_state(_backup_state); }
+
+  /**
+   * pack the stimulate, driven type and potential/current history of this electrode,
+   * derived circuit appends its own state
+   */
+  virtual void pack_state(std::vector<Real> & state) const
+  {
+    state.clear();
+    state.push_back(_Vapp);
+    state.push_back(_Iapp);
+    state.push_back(static_cast<Real>(_drv));
+    state.push_back(_potential);
+    state.push_back(_potential_old);
+    state.push_back(_current);
+    state.push_back(_current_old);
+  }
+
+  /**
+   * load state made by pack_state()
+   * @return false when the state does not match this circuit
+   */
+  virtual bool unpack_state(const std::vector<Real> & state)
+  {
+    if( state.size() < 7 ) return false;
+    _Vapp          = state[0];
+    _Iapp          = state[1];
+    _drv           = static_cast<DRIVEN>(static_cast<int>(state[2]));
+    _potential     = state[3];
+    _potential_old = state[4];
+    _current       = state[5];
+    _current_old   = state[6];
+    return true;
+  }
+
 
 protected:
   /**
@@ -314,6 +361,11 @@ protected:
    */
   Real      _current_old;
 
+  /**
+   * state saved by backup()
+   */
+  std::vector<Real>  _backup_state;
+
 
   // current statistic
 public:
@@ -367,6 +419,19 @@ public:
   Real & current_hole()
   { return _current_hole;}
 
+  /**
+   * @return the derivative of current to each tangent parameter,
+   * per unit of the parameter as given in its PMI
+   */
+  const std::vector<Real> & current_tangent() const
+  { return _current_tangent;}
+
+  /**
+   * @return writable reference to current derivatives of tangent parameters.
+   */
+  std::vector<Real> & current_tangent()
+  { return _current_tangent;}
+
 protected:
 
   /**
@@ -389,6 +454,11 @@ protected:
    */
   Real      _current_hole;
 
+  /**
+   * the current derivative to each tangent parameter
+   */
+  std::vector<Real>  _current_tangent;
+
   // ac settings 
 public:
   /**
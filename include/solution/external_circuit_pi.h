@@ -188,6 +188,27 @@ public:
     _V1 = _V1_last;
   }
 
+  /**
+   * pack state, with the potential of internal node
+   */
+  virtual void pack_state(std::vector<Real> & state) const
+  {
+    ExternalCircuit::pack_state(state);
+    state.push_back(_V1);
+    state.push_back(_V1_last);
+  }
+
+  /**
+   * load state made by pack_state()
+   */
+  virtual bool unpack_state(const std::vector<Real> & state)
+  {
+    if( state.size() != 9 || !ExternalCircuit::unpack_state(state) ) return false;
+    _V1      = state[7];
+    _V1_last = state[8];
+    return true;
+  }
+
   /**
    * init op state before transient simulation
    */
@@ -168,6 +168,27 @@ public:
     _cap_current = _cap_current_old;
   }
 
+  /**
+   * pack state, with the current of lumped capacitance
+   */
+  virtual void pack_state(std::vector<Real> & state) const
+  {
+    ExternalCircuit::pack_state(state);
+    state.push_back(_cap_current);
+    state.push_back(_cap_current_old);
+  }
+
+  /**
+   * load state made by pack_state()
+   */
+  virtual bool unpack_state(const std::vector<Real> & state)
+  {
+    if( state.size() != 9 || !ExternalCircuit::unpack_state(state) ) return false;
+    _cap_current     = state[7];
+    _cap_current_old = state[8];
+    return true;
+  }
+
   /**
    * init op state before transient simulation
    */
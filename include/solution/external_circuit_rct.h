@@ -159,6 +159,27 @@ public:
     _v = _v_last;
   }
 
+  /**
+   * pack state, with the potential of TL segments
+   */
+  virtual void pack_state(std::vector<Real> & state) const
+  {
+    ExternalCircuit::pack_state(state);
+    state.insert(state.end(), _v.begin(), _v.end());
+    state.insert(state.end(), _v_last.begin(), _v_last.end());
+  }
+
+  /**
+   * load state made by pack_state()
+   */
+  virtual bool unpack_state(const std::vector<Real> & state)
+  {
+    if( state.size() != 7 + _v.size() + _v_last.size() || !ExternalCircuit::unpack_state(state) ) return false;
+    std::copy(state.begin()+7, state.begin()+7+_v.size(), _v.begin());
+    std::copy(state.begin()+7+_v.size(), state.end(), _v_last.begin());
+    return true;
+  }
+
   /**
    * init op state before transient simulation
    */
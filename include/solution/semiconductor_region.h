@@ -330,6 +330,50 @@ private:
   void DDM1_Gummel_Carrier_Electron(PetscScalar * x, Mat A, Vec r, InsertMode &add_value_flag);
 
   void DDM1_Gummel_Carrier_Hole(PetscScalar * x, Mat A, Vec r, InsertMode &add_value_flag);
+
+  /**
+   * field dependent generation (band band tunneling and impact ionization) on the edges of DDML1.
+   * the kernel depends only on advanced model and solution type, it is selected once before
+   * the element loop instead of testing them on each edge
+   */
+  struct DDM1_GenerationKernel
+  {
+    /// band band tunneling enabled
+    bool bbt;
+    /// impact ionization enabled
+    bool ii;
+    /// driving force of impact ionization
+    ModelSpecify::IIForce ii_force;
+  };
+
+  /**
+   * select the generation kernel for this evaluation
+   */
+  DDM1_GenerationKernel DDM1_generation_kernel() const;
+
+  /**
+   * row index and value of generation terms, kept between DDM1_Function calls to reuse its capacity
+   */
+  std::vector<PetscInt>     _ddm1_generation_index;
+  std::vector<PetscScalar>  _ddm1_generation_value;
+
+  /**
+   * node context and carrier density of the nodes gathered for the bulk PMI calls of DDM1_Function,
+   * and the results of these calls in the same order. kept between calls to reuse their capacity
+   */
+  std::vector<PMI_NodeContext>  _ddm1_node_context;
+  std::vector<PetscScalar>      _ddm1_node_n;
+  std::vector<PetscScalar>      _ddm1_node_p;
+  std::vector<PetscScalar>      _ddm1_node_T;
+  std::vector<PetscScalar>      _ddm1_node_dEc;
+  std::vector<PetscScalar>      _ddm1_node_dEv;
+  std::vector<PetscScalar>      _ddm1_node_R;
+  std::vector<PetscScalar>      _ddm1_node_ni;
+
+  /**
+   * local node order of each node data, indexed by node data offset
+   */
+  std::vector<unsigned int>     _ddm1_local_node_order;
 #endif
 
 public:
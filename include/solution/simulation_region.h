@@ -144,6 +144,33 @@ public:
    */
   void reserve_data_block(unsigned int n_cell_data, unsigned int n_node_data);
 
+  /**
+   * make a copy of node/cell data block, i.e. the solution of this region
+   */
+  void backup_data_block();
+
+  /**
+   * restore node/cell data block from the copy made by backup_data_block()
+   * @return false when no backup or variable layout changed
+   */
+  bool restore_data_block();
+
+  /**
+   * free the copy of node/cell data block
+   */
+  void clear_data_block_backup();
+
+  /**
+   * write node/cell data block of this processor to checkpoint file
+   */
+  void write_data_block(CheckpointWriter &) const;
+
+  /**
+   * load node/cell data block from checkpoint file
+   * @return false when the region or its variable layout changed
+   */
+  bool read_data_block(CheckpointReader &);
+
   /**
    * insert local mesh element into the region, only copy the pointer
    * and create cell data
@@ -884,6 +911,12 @@ protected:
    */
   DataStorage _node_data_storage;
 
+  /**
+   * backup of cell/node data block
+   */
+  DataStorage _cell_data_storage_backup;
+  DataStorage _node_data_storage_backup;
+
   /**
    * the edges belongs to this regon, for fast FVM integral
    * the two fvm_node of this edge is ordered as id(1) \< id(2)
@@ -44,6 +44,7 @@ class BoundaryConditionCollector;
 class ElectricalSource;
 class FieldSource;
 class SPICE_CKT;
+class AsyncWriter;
 
 /**
  * @brief the main structure for mesh and solution data storage
@@ -213,9 +214,9 @@ public:
   void export_tif(const std::string& filename) const;
 
   /**
-   * @brief export solution to vtk file
+   * @brief export solution to vtk file, encoded and written by background writer if given
    */
-  void export_vtk(const std::string& filename, bool ascii) const;
+  void export_vtk(const std::string& filename, bool ascii, AsyncWriter * writer=NULL) const;
 
   /**
    * @brief export solution to vtk file
@@ -393,6 +394,34 @@ public:
    */
   void do_interpolation(const InterpolationBase *, const std::string &);
 
+  /**
+   * save the solution (region data and electrode state) of the system,
+   * later solves can restart from this state by restore_solution()
+   */
+  void backup_solution();
+
+  /**
+   * restore the solution saved by backup_solution()
+   */
+  void restore_solution();
+
+  /**
+   * free the memory used by solution backup
+   */
+  void clear_solution_backup();
+
+  /**
+   * write the full solver state: data blocks of all the regions, time integration
+   * history and circuit state into binary checkpoint file <filename>.<processor_id>
+   */
+  void export_checkpoint(const std::string& filename) const;
+
+  /**
+   * load the state saved by export_checkpoint(). the mesh, partition and
+   * variable layout must be the same as the one which wrote the checkpoint
+   */
+  void import_checkpoint(const std::string& filename);
+
   /**
    * set unique solver name to _solver_active_history
    */
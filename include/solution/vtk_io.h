@@ -37,6 +37,7 @@
 
 // Forward declarations
 class MeshBase;
+class AsyncWriter;
 
 
 #ifdef HAVE_VTK
@@ -77,12 +78,25 @@ public:
 
   /**
    * This method implements writing a mesh to a specified fil
-   * in VTK format
+   * in VTK format. a ".pvtu" file name writes one ".vtu" piece
+   * per processor without gathering data to processor 0
    */
   virtual void write (const std::string& );
 
+  /**
+   * let the file be written by background I/O thread.
+   * data is still collected here, only encoding and writing are deferred
+   */
+  void set_async_writer(AsyncWriter * writer)
+  { _writer = writer; }
+
 private:
 
+  /**
+   * background writer, NULL for synchronous write
+   */
+  AsyncWriter * _writer;
+
   // boundary info
   std::vector<unsigned int>       _el;
   std::vector<unsigned short int> _sl;
@@ -169,12 +183,50 @@ private:
                                    std::vector<float > & sol_z,
                                    const std::string & sol_name, vtkUnstructuredGrid* grid);
 
+  /**
+   * write the .pvtu index of all the partition pieces
+   */
+  void write_pvtu(const std::string &name, vtkUnstructuredGrid* grid);
+
+  /**
+   * @return the piece file name of processor rank, i.e. foo.pvtu -> foo_p<rank>.vtu
+   */
+  static std::string piece_file_name(const std::string &name, unsigned int rank);
+
+  /**
+   * @return the point index of region node in partition piece
+   */
+  unsigned int local_point_index(unsigned int region, unsigned int node_id) const;
+
   /**
    * pointer to the VTK grid
    */
   vtkUnstructuredGrid* _vtk_grid;
 
+  /**
+   * write rank-local partition piece instead of gathering to processor 0
+   */
+  bool _partition;
+
+  /**
+   * elem id to cell index in partition piece
+   */
+  std::map<unsigned int, unsigned int> _local_cell_id_map;
+
+  /**
+   * <elem id, side> of boundary face to cell index in partition piece
+   */
+  std::map< std::pair<unsigned int, unsigned short int>, unsigned int > _local_boundary_cell_id_map;
+
+  /**
+   * write out the grid into file, by background I/O thread when _writer is set
+   * @note grid is released here
+   */
+  void write_grid(vtkUnstructuredGrid* grid, const std::string &name, const std::string &header);
+
   class XMLUnstructuredGridWriter;
+
+  class WriteJob;
 #endif
 
 
@@ -187,10 +239,11 @@ private:
 inline
 VTKIO::VTKIO (SimulationSystem& system) :
     FieldInput<SimulationSystem> (system),
-    FieldOutput<SimulationSystem> (system)
+    FieldOutput<SimulationSystem> (system), _writer(NULL)
 {
 #ifdef HAVE_VTK
   _vtk_grid = NULL;
+  _partition = false;
 #endif
 }
 
@@ -198,10 +251,11 @@ VTKIO::VTKIO (SimulationSystem& system) :
 
 inline
 VTKIO::VTKIO (const SimulationSystem& system) :
-    FieldOutput<SimulationSystem>(system)
+    FieldOutput<SimulationSystem>(system), _writer(NULL)
 {
 #ifdef HAVE_VTK
   _vtk_grid = NULL;
+  _partition = false;
 #endif
 }
 
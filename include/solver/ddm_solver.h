@@ -26,6 +26,8 @@
 
 #include "fvm_flex_nonlinear_solver.h"
 
+class PMI_Server;
+
 /**
  * the common method for device drift-diffusion method solver
  */
@@ -58,6 +60,12 @@ public:
    */
   virtual int solve_dcsweep();
 
+  /**
+   * do dcsweep for a family of curves, each branch has different bias on ensemble electrode.
+   * branches are distributed to ensemble groups by a shared task queue.
+   */
+  virtual int solve_dcsweep_ensemble();
+
   /**
    * do op
    */
@@ -68,11 +76,29 @@ public:
    */
   virtual int solve_transient();
 
+  /**
+   * do transient simulation by parareal method, each ensemble group integrates one time slice
+   */
+  virtual int solve_transient_parareal();
+
   /**
    * IV curve automatically trace
    */
   virtual int solve_iv_trace();
 
+  /**
+   * periodic steady-state by shooting-Newton method.
+   * the period is integrated by transient solver, and the periodic mismatch
+   * is solved by matrix-free GMRES on the monodromy operator
+   */
+  virtual int solve_pss();
+
+  /**
+   * apply the scaled shooting operator (M-I) to w, M is the monodromy matrix.
+   * called by PETSc shell matrix
+   */
+  void pss_shooting_operator(Vec w, Vec y);
+
   /**
    * do nonlinear solve with pseudo time step
    */
@@ -180,6 +206,15 @@ public:
    */
   virtual void petsc_ksp_convergence_test(PetscInt its, PetscReal rnorm, KSPConvergedReason* reason);
 
+  /**
+   * split the dofs by physical field (potential, carrier, temperature)
+   * or by region type (semiconductor, insulator, conductor).
+   * electrode and circuit dofs always form the last split
+   */
+  virtual void build_field_split(SolverSpecify::PreconditionerType type,
+                                 std::vector<std::string> & names,
+                                 std::vector< std::vector<PetscInt> > & dofs) const;
+
 protected:
 
   /**
@@ -207,6 +242,81 @@ protected:
    */
   Vec            LTE;
 
+  /**
+   * the time marching loop of transient simulation from TStart to TStop
+   */
+  int solve_transient_march();
+
+  /**
+   * integrate from TStart to TStop from the state in the system, the final state is saved to xT
+   */
+  int transient_integrate(Vec xT);
+
+  /**
+   * when not NULL, solve_transient_march appends the clock of each accepted time step to it
+   */
+  std::vector<PetscReal> * tran_step_record;
+
+  /**
+   * when not NULL, solve_transient_march steps to these clocks instead of its own step control,
+   * only steps of a diverged solve are inserted
+   */
+  const std::vector<PetscReal> * tran_step_replay;
+
+  /**
+   * make v the initial state of next transient integration.
+   * history of external circuit comes from the solution backup of the system
+   */
+  void transient_load_state(Vec v);
+
+  /**
+   * propagate state u0 from t0 to t1, by coarse (BDF1 with large step) or fine (user specified) transient solver
+   */
+  int parareal_propagate(Vec u0, PetscReal t0, PetscReal t1, bool coarse, Vec u1);
+
+  /**
+   * current of each electrode, for parareal convergence check
+   */
+  void parareal_terminal_current(std::vector<PetscReal> & I) const;
+
+
+
+  // vectors for PSS shooting-Newton
+
+  /**
+   * initial state of the period
+   */
+  Vec          pss_x0;
+
+  /**
+   * state after one period from pss_x0
+   */
+  Vec          pss_xT;
+
+  /**
+   * scaling of each dof, potential by thermal voltage and others by their magnitude
+   */
+  Vec          pss_scale;
+
+  /**
+   * work vector
+   */
+  Vec          pss_work;
+
+  /**
+   * transient solver failed in a perturbed period
+   */
+  bool         pss_diverged;
+
+  /**
+   * clock of the accepted time steps of the unperturbed period
+   */
+  std::vector<PetscReal> pss_steps;
+
+  /**
+   * build pss_scale from state v
+   */
+  void pss_build_scale(Vec v);
 
 
   // extra KSP solver for Trace mode
@@ -241,6 +351,16 @@ protected:
    */
   PC           pcc;
 
+  /**
+   * the voltage or current scan loop of dcsweep
+   */
+  int solve_dcsweep_scan();
+
+  /**
+   * create a direct linear solver with J as operator
+   */
+  void create_direct_ksp(KSP & k, PC & pc);
+
   /**
    * create ksp solver for trace mode
    */
@@ -257,6 +377,118 @@ protected:
   virtual void set_trace_electrode(BoundaryCondition *)
   { genius_error(); }
 
+
+
+  // adjoint sensitivity of electrode current and charge to PMI parameters
+
+  /**
+   * a real PMI parameter for sensitivity analysis
+   */
+  struct SensitivityParameter
+  {
+    /// region:type:parameter as given by user
+    std::string   label;
+    /// the PMI object owns this parameter
+    PMI_Server  * pmi;
+    /// pointer to the scaled parameter value
+    PetscScalar * value;
+    /// the physical unit of this parameter
+    PetscScalar   unit;
+    /// the physical unit in string
+    std::string   unit_string;
+  };
+
+  /**
+   * parameters of SolverSpecify::Sensitivity_Parameter
+   */
+  std::vector<SensitivityParameter> sens_parameters;
+
+  /**
+   * bcs of each electrode in SolverSpecify::Sensitivity_Electrode
+   */
+  std::vector< std::vector<BoundaryCondition *> > sens_electrodes;
+
+  /**
+   * dI/dp of the last solution, indexed by [electrode][parameter].
+   * in A per physical unit of the parameter
+   */
+  std::vector< std::vector<PetscReal> > sens_dI_dp;
+
+  /**
+   * dQ/dp of the last solution, indexed by [electrode][parameter].
+   * in C per physical unit of the parameter
+   */
+  std::vector< std::vector<PetscReal> > sens_dQ_dp;
+
+  /**
+   * ksp solver for the adjoint equation, J^T lambda = dI/dx
+   */
+  KSP          sens_ksp;
+
+  /**
+   * PC for adjoint equation
+   */
+  PC           sens_pc;
+
+  /**
+   * find the PMI parameters and electrodes of sensitivity analysis
+   */
+  void sensitivity_setup();
+
+  /**
+   * find the PMI parameter of each label, given as region:type:parameter
+   */
+  void sensitivity_parameter_setup(const std::vector<std::string> & labels, std::vector<SensitivityParameter> & paras);
+
+  /**
+   * set the value of parameter and recalibrate its PMI
+   */
+  void sensitivity_set_parameter(const SensitivityParameter & para, PetscScalar value);
+
+  /**
+   * add the derivative of electrode charge of bc to solution into pQ_px
+   */
+  void sensitivity_charge_jacobian(const BoundaryCondition * bc, Vec pQ_px) const;
+
+  /**
+   * compute dI/dp and dQ/dp of the converged stationary solution by adjoint method and record them into solution dom.
+   * the Jacobian at converged solution is factorized once, each electrode needs two transposed solves
+   */
+  void sensitivity_analysis(mxml_node_t *eSolution);
+
+  /**
+   * partial derivative of the residual and electrode current to parameter at fixed solution,
+   * by central difference of the parameter. work is a temporary vector
+   */
+  void sensitivity_residual_derivative(const SensitivityParameter & para, Vec dF, std::vector<PetscReal> & dI, Vec work);
+
+  /**
+   * current of each electrode in sens_electrodes, as computed by the last residual evaluation
+   */
+  void sensitivity_electrode_current(std::vector<PetscReal> & I) const;
+
+  /**
+   * save/restore the currents of all the electrodes, which are overwritten by residual evaluation
+   */
+  void save_electrode_current(std::vector<PetscReal> & state) const;
+  void restore_electrode_current(const std::vector<PetscReal> & state);
+
+
+
+  // forward tangent of solution to PMI parameters
+
+  /**
+   * parameters of SolverSpecify::Tangent_Parameter
+   */
+  std::vector<SensitivityParameter> tangent_parameters;
+
+  /**
+   * solve the tangent dx/dp of the converged solution for each tangent parameter by the
+   * linear solver of the last Newton step, J dx/dp = -pF/pp. the total derivative of each
+   * electrode current is saved into its external circuit for IV output
+   */
+  void tangent_analysis();
+
   /**
    * x norm of potential
    */
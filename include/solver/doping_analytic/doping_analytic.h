@@ -176,7 +176,11 @@ private:
  void _custom_profile_data_apply(const std::string &ion, std::pair<int, InterpolationBase * > df, const std::string &region_app);
  
   
- double _do_data_interp(std::pair<int, InterpolationBase * > df, const Node *node, const std::string &msg=std::string());
+ /**
+  * interpolate the doping data at a batch of nodes
+  */
+ void _do_data_interp(std::pair<int, InterpolationBase * > df, const std::vector<const Node *> &nodes,
+                      std::vector<double> &values, const std::string &msg=std::string());
 
 };
 
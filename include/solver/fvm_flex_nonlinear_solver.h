@@ -24,6 +24,7 @@
 #define __fvm_flex_nonlinear_solver_h__
 
 #include <vector>
+#include <string>
 
 #include "config.h"
 #include "enum_petsc_type.h"
@@ -233,6 +234,15 @@ public:
    */
   virtual void flush_system(Vec ) {}
 
+  /**
+   * virtual function, build the index sets of field split preconditioner.
+   * each split is named and holds the on processor global dofs of it.
+   * derived class knows its dof layout and should fill the splits.
+   */
+  virtual void build_field_split(SolverSpecify::PreconditionerType ,
+                                 std::vector<std::string> & ,
+                                 std::vector< std::vector<PetscInt> > & ) const {}
+
 protected:
   
   /**ksp_residual_history
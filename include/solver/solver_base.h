@@ -167,6 +167,12 @@ protected:
    */
   HookList           _hooks;
 
+  /**
+   * @return the root node of solution dom
+   */
+  mxml_node_t* solution_dom_root() const
+  { return _dom_solution_root; }
+
   /**
    * create a solution dom element, and add to the dom document
    */
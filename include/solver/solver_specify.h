@@ -68,6 +68,26 @@ namespace SolverSpecify
    */
   extern bool      out_append;
 
+  /**
+   * hooks write output files by background I/O thread
+   */
+  extern bool      out_async;
+
+  /**
+   * IV hooks (gnuplot/rawfile) write binary records instead of text
+   */
+  extern bool      out_binary;
+
+  /**
+   * memory limit of queued output snapshots, in MB
+   */
+  extern double    out_async_buffer;
+
+  /**
+   * policy when the output queue is full: block, drop or coalesce
+   */
+  extern std::string  out_async_policy;
+
   /**
    * hooks to be installed, \<id \<hook_name, hook_parameters\> \>
    */
@@ -398,6 +418,59 @@ namespace SolverSpecify
    */
   extern bool      tran_histroy;
 
+  /**
+   * true when the transient state is loaded from checkpoint, the next
+   * transient solve continues from it. it is not reset by set_default_parameter()
+   */
+  extern bool      tran_restart;
+
+  /**
+   * time, time step and BDF2 order flag loaded from checkpoint
+   */
+  extern double    restart_clock;
+  extern double    restart_dt;
+  extern bool      restart_BDF2_LowerOrder;
+
+  /**
+   * number of plain transient periods before shooting-Newton iteration of PSS solution
+   */
+  extern int       PSS_Cycles;
+
+  /**
+   * max shooting-Newton iteration of PSS solution
+   */
+  extern int       PSS_MaxIteration;
+
+  /**
+   * max GMRES iteration on the monodromy operator in each shooting-Newton step
+   */
+  extern int       PSS_KSPMaxIteration;
+
+  /**
+   * tolerance of scaled periodic mismatch |x(T)-x(0)|
+   */
+  extern double    PSS_Tol;
+
+  /**
+   * parareal transient, each ensemble group integrates one time slice
+   */
+  extern bool      Parareal;
+
+  /**
+   * number of BDF1 steps of coarse propagator in each time slice
+   */
+  extern int       Parareal_CoarseSteps;
+
+  /**
+   * max parareal iteration
+   */
+  extern int       Parareal_MaxIteration;
+
+  /**
+   * relative tolerance of terminal current changes between parareal iterations
+   */
+  extern double    Parareal_Tol;
+
   /**
    * current time
    */
@@ -493,6 +566,54 @@ namespace SolverSpecify
    */
   extern int       DC_Cycles;
 
+  /**
+   * do ensemble DC sweep, each branch is distributed to an ensemble group
+   */
+  extern bool      Ensemble;
+
+  /**
+   * electrode which is biased differently for each ensemble branch
+   */
+  extern std::string     Ensemble_Electrode;
+
+  /**
+   * the bias of Ensemble_Electrode for each branch
+   */
+  extern std::vector<double>    Ensemble_Values;
+
+  /**
+   * voltage step used to ramp Ensemble_Electrode to the branch bias
+   */
+  extern double    Ensemble_VStep;
+
+  /**
+   * the branch index being solved, -1 for no branch (i.e. bias ramp)
+   */
+  extern int       Ensemble_Branch;
+
+  /**
+   * electrodes whose current and charge sensitivity to PMI parameters is computed
+   * at each converged stationary solution by adjoint method
+   */
+  extern std::vector<std::string>    Sensitivity_Electrode;
+
+  /**
+   * PMI parameters for sensitivity analysis, each is given as region:type:parameter
+   */
+  extern std::vector<std::string>    Sensitivity_Parameter;
+
+  /**
+   * PMI parameters whose solution tangent dx/dp is computed at each converged stationary
+   * solution, each is given as region:type:parameter
+   */
+  extern std::vector<std::string>    Tangent_Parameter;
+
+  /**
+   * parameter change of each tangent for first order extrapolation of electrode current,
+   * in the unit of the parameter
+   */
+  extern std::vector<double>         Tangent_Delta;
+
 
   /**
    * use node set, only for mixA solver
@@ -232,6 +232,16 @@ private:
 
   std::vector<track_t> _tracks;
 
+  /**
+   * number of tracks read and broadcast at a time
+   */
+  static const unsigned int _track_block_size = 65536;
+
+  /**
+   * append tracks from a broadcast block, 8 doubles each
+   */
+  void _add_tracks(const std::vector<double> & meta_data);
+
   void _read_particle_profile_track_evt(const std::string &, Real );
 #ifdef HAVE_HDF5
   void _read_particle_profile_track_hdf5(const std::string &, const std::string & path, Real );
@@ -186,6 +186,57 @@ namespace CogendaHDF5
       return true;
     }
 
+    /**
+     * @returns the number of records in dataset <grp>/dName, 0 if it can not be opened
+     */
+    hsize_t countData(hid_t grp, const std::string& dName) const
+    {
+      hid_t dset = H5Dopen(grp, dName.c_str(), H5P_DEFAULT);
+      if (dset<0)    return 0;
+
+      hid_t dspace = H5Dget_space(dset);
+      hsize_t nelmts = dspace<0 ? 0 : H5Sget_simple_extent_npoints(dspace);
+
+      if (dspace>=0) H5Sclose(dspace);
+      H5Dclose(dset);
+      return nelmts;
+    }
+
+    /**
+     * read records [offset, offset+count) of <grp>/dName by hyperslab, replacing the records in memory.
+     * only count records are held in memory, so a large dataset can be read in chunks
+     * @returns true if success, false otherwise
+     */
+    bool readData(hid_t grp, const std::string& dName, hsize_t offset, hsize_t count)
+    {
+      _data.clear();
+      if (count==0)  return true;
+
+      hid_t dset = H5Dopen(grp, dName.c_str(), H5P_DEFAULT);
+      if (dset<0)    return false;
+
+      hid_t dspace = H5Dget_space(dset);
+      if (dspace<0)
+      {
+        H5Dclose(dset);
+        return false;
+      }
+
+      const hsize_t start[1] = {offset};
+      const hsize_t dims[1]  = {count};
+      hid_t mspace = H5Screate_simple(1, dims, NULL);
+      herr_t err = H5Sselect_hyperslab(dspace, H5S_SELECT_SET, start, NULL, dims, NULL);
+
+      _data.resize(count, filler());
+      if (err>=0)
+        err = H5Dread(dset, memDataType(), mspace, dspace, H5P_DEFAULT, &_data[0]);
+
+      H5Sclose(mspace);
+      H5Sclose(dspace);
+      H5Dclose(dset);
+      return err>=0;
+    }
+
     /**
      * write data to the hdf5 file.
      * @param grp   id of the group containing the dataset. Tracks will be read from <grp>/dName.
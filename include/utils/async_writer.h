@@ -0,0 +1,209 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __async_writer_h__
+#define __async_writer_h__
+
+#include <set>
+#include <deque>
+#include <string>
+#include <fstream>
+
+#include "config.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+/**
+ * background writer for solution output.
+ * hook takes a snapshot of the data into a Job (all the collective
+ * communication is done here), and the Job is encoded and written by a
+ * dedicated I/O thread while the solver goes on.
+ * the memory held by queued jobs is bounded, when it is exceeded the
+ * policy decides: BLOCK waits for the I/O thread, DROP discards the new
+ * snapshot, COALESCE discards the oldest queued snapshot.
+ * without pthread support, jobs are written immediately.
+ * @note the I/O thread never calls MPI
+ */
+class AsyncWriter
+{
+public:
+
+  enum Policy {BLOCK, DROP, COALESCE};
+
+  /**
+   * a snapshot to be written, owns all its data
+   */
+  class Job
+  {
+  public:
+    virtual ~Job() {}
+
+    /**
+     * encode and write the snapshot, called by I/O thread
+     */
+    virtual void write()=0;
+
+    /**
+     * @return memory held by this job in bytes
+     */
+    virtual size_t bytes() const=0;
+
+    /**
+     * @return false if the job must not be discarded, i.e. a row appended to data file
+     */
+    virtual bool droppable() const { return true; }
+
+    /**
+     * @return the file name of this snapshot
+     */
+    virtual std::string name() const { return ""; }
+  };
+
+  /**
+   * append text to an opened stream, keeps the order of rows
+   */
+  class TextJob : public Job
+  {
+  public:
+    TextJob(std::ofstream &out, const std::string &text) : _out(out), _text(text) {}
+    virtual void write()  { _out << _text; _out.flush(); }
+    virtual size_t bytes() const { return _text.size(); }
+    virtual bool droppable() const { return false; }
+  private:
+    std::ofstream & _out;
+    std::string     _text;
+  };
+
+  /**
+   * constructor, start the I/O thread
+   * @param max_bytes  memory limit of the queued jobs
+   */
+  AsyncWriter(size_t max_bytes, Policy policy);
+
+  /**
+   * destructor, flush the queue and stop the I/O thread
+   */
+  ~AsyncWriter();
+
+  /**
+   * put a job into the queue, the writer takes the ownership of it
+   */
+  void enqueue(Job *job);
+
+  /**
+   * wait until all the queued jobs are written
+   */
+  void flush();
+
+  /**
+   * @return number of snapshots discarded by DROP/COALESCE policy
+   */
+  unsigned int n_dropped() const
+  { return _n_dropped; }
+
+  /**
+   * @return file names of discarded snapshots
+   */
+  const std::set<std::string> & dropped() const
+  { return _dropped; }
+
+  /**
+   * @return policy by its name: block, drop or coalesce
+   */
+  static Policy policy(const std::string &name);
+
+private:
+
+  /**
+   * queued jobs
+   */
+  std::deque<Job *> _queue;
+
+  /**
+   * memory held by queued jobs
+   */
+  size_t  _queue_bytes;
+
+  /**
+   * memory limit
+   */
+  size_t  _max_bytes;
+
+  /**
+   * full queue policy
+   */
+  Policy  _policy;
+
+  /**
+   * discarded snapshots
+   */
+  unsigned int _n_dropped;
+
+  /**
+   * file names of discarded snapshots
+   */
+  std::set<std::string> _dropped;
+
+  /**
+   * the I/O thread is writing a job
+   */
+  bool    _busy;
+
+  /**
+   * ask I/O thread to exit
+   */
+  bool    _stop;
+
+#ifdef HAVE_PTHREAD
+  pthread_t        _thread;
+
+  pthread_mutex_t  _mutex;
+
+  /**
+   * signaled when a job is queued or stop is required
+   */
+  pthread_cond_t   _cond_job;
+
+  /**
+   * signaled when a job is finished
+   */
+  pthread_cond_t   _cond_done;
+
+  /**
+   * I/O thread entry
+   */
+  static void * _thread_entry(void *);
+
+  /**
+   * I/O thread loop
+   */
+  void _run();
+#endif
+
+  // not copyable
+  AsyncWriter(const AsyncWriter &);
+  AsyncWriter & operator= (const AsyncWriter &);
+};
+
+#endif
@@ -0,0 +1,193 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __checkpoint_file_h__
+#define __checkpoint_file_h__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+
+#include "config.h"
+
+
+/**
+ * versioned binary file for solver checkpoint.
+ * the file holds raw data blocks of one processor, each processor writes its own file.
+ * data is written in native byte order, the reader checks the magic and version only.
+ */
+class CheckpointWriter
+{
+public:
+
+  /**
+   * open the file for writing, the data goes to a temporary file
+   * which is renamed by close(), a killed job never leaves a broken checkpoint
+   */
+  CheckpointWriter(const std::string &file);
+
+  ~CheckpointWriter();
+
+  /**
+   * @return true when the file is opened
+   */
+  bool good() const { return _out.good(); }
+
+  /**
+   * write a value of POD type
+   */
+  template <typename T>
+  void write(const T &v)
+  { _out.write(reinterpret_cast<const char *>(&v), sizeof(T)); }
+
+  /**
+   * write a string with its length
+   */
+  void write(const std::string &s)
+  {
+    write<unsigned int>(s.size());
+    _out.write(s.data(), s.size());
+  }
+
+  /**
+   * write an array of POD type with its length
+   */
+  template <typename T>
+  void write_array(const T *v, size_t n)
+  {
+    write<unsigned long long>(n);
+    if(n) _out.write(reinterpret_cast<const char *>(v), n*sizeof(T));
+  }
+
+  template <typename T>
+  void write_array(const std::vector<T> &v)
+  { write_array(v.empty() ? static_cast<const T *>(0) : &v[0], v.size()); }
+
+  /**
+   * finish the file
+   * @return true for success
+   */
+  bool close();
+
+private:
+
+  std::string   _file;
+
+  std::ofstream _out;
+};
+
+
+
+/**
+ * read checkpoint file. the file is memory mapped (read into memory on windows)
+ * and arrays are copied directly from the mapped pages.
+ * @note the mapped data may be unaligned, use memcpy to access it
+ */
+class CheckpointReader
+{
+public:
+
+  CheckpointReader(const std::string &file);
+
+  ~CheckpointReader();
+
+  /**
+   * @return true when the file is mapped and the header is valid
+   * and no read out of range happened
+   */
+  bool good() const { return _data!=0 && _good; }
+
+  /**
+   * read a value of POD type
+   */
+  template <typename T>
+  T read()
+  {
+    T v = T();
+    const char * p = _advance(sizeof(T));
+    if(p) std::memcpy(&v, p, sizeof(T));
+    return v;
+  }
+
+  /**
+   * read a string with its length
+   */
+  std::string read_string()
+  {
+    unsigned int n = read<unsigned int>();
+    const char * p = _advance(n);
+    return p ? std::string(p, n) : std::string();
+  }
+
+  /**
+   * read an array of POD type with its length
+   * @return pointer to the array in mapped memory, valid until the reader is destroyed
+   */
+  template <typename T>
+  const T * read_array(size_t &n)
+  {
+    n = static_cast<size_t>(read<unsigned long long>());
+    const char * p = _advance(n*sizeof(T));
+    if(!p) n = 0;
+    return reinterpret_cast<const T *>(p);
+  }
+
+  template <typename T>
+  bool read_array(std::vector<T> &v)
+  {
+    size_t n;
+    const T * p = read_array<T>(n);
+    if(!good()) return false;
+    v.resize(n);
+    if(n) std::memcpy(&v[0], p, n*sizeof(T));
+    return true;
+  }
+
+private:
+
+  /**
+   * mapped file
+   */
+  const char * _data;
+
+  size_t       _size;
+
+  size_t       _pos;
+
+  bool         _good;
+
+  /**
+   * move the cursor by n bytes
+   * @return the start of the block, NULL when out of range
+   */
+  const char * _advance(size_t n)
+  {
+    if(!_data || _pos + n > _size) { _good = false; return 0; }
+    const char * p = _data + _pos;
+    _pos += n;
+    return p;
+  }
+};
+
+
+#endif
@@ -0,0 +1,85 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __ensemble_queue_h__
+#define __ensemble_queue_h__
+
+#include "genius_env.h"
+
+/**
+ * a shared task counter for ensemble run.
+ * each ensemble group fetches the next task index from it,
+ * so a fast group takes more tasks than a slow one.
+ * the counter lives on the first processor of comm_ensemble and is
+ * accessed by one-sided MPI communication. without MPI-3, tasks are
+ * assigned to groups in round-robin order.
+ * @note constructor and destructor are collective over Genius::comm_ensemble()
+ */
+class EnsembleQueue
+{
+public:
+
+  /**
+   * constructor, with total number of tasks
+   */
+  EnsembleQueue(unsigned int n_tasks);
+
+  ~EnsembleQueue();
+
+  /**
+   * @return the next task for this ensemble group, -1 when all the tasks are taken.
+   * @note collective over Genius::comm_world()
+   */
+  int next();
+
+  /**
+   * @return total number of tasks
+   */
+  unsigned int n_tasks() const
+  { return _n_tasks; }
+
+private:
+
+  /**
+   * total number of tasks
+   */
+  unsigned int _n_tasks;
+
+  /**
+   * tasks taken by this group, used by round-robin assignment
+   */
+  unsigned int _n_taken;
+
+#if defined(HAVE_MPI) && MPI_VERSION >= 3
+  /**
+   * the shared counter, only allocated on the first processor
+   */
+  int  * _counter;
+
+  /**
+   * MPI window exposes the counter
+   */
+  MPI_Win _win;
+#endif
+};
+
+#endif
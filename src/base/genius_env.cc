@@ -26,6 +26,7 @@
 #include <ios>
 #include <fstream>
 #include <string>
+#include <algorithm>
 
 #ifdef HAVE_SLEPC
   #include "slepcsys.h"
@@ -35,10 +36,29 @@
 // Genius::GeniusPrivateData data initialization
 int  Genius::GeniusPrivateData::_n_processors = 1;
 int  Genius::GeniusPrivateData::_processor_id = 0;
+int  Genius::GeniusPrivateData::_n_ensembles = 1;
+int  Genius::GeniusPrivateData::_ensemble_id = 0;
+bool Genius::GeniusPrivateData::_mpi_init_by_genius = false;
 
 #ifdef HAVE_MPI
 MPI_Comm Genius::GeniusPrivateData::_comm_world;
 MPI_Comm Genius::GeniusPrivateData::_comm_self;
+MPI_Comm Genius::GeniusPrivateData::_comm_ensemble;
+#endif
+
+
+#ifdef HAVE_MPI
+/**
+ * search -ensemble n in the raw command line.
+ * we can not use PetscOptions here since petsc is not initialized yet.
+ */
+static int _ensemble_groups_from_command_line(int argc, char ** args)
+{
+  for(int i=1; i<argc-1; ++i)
+    if( std::string(args[i]) == "-ensemble" )
+      return std::max(1, atoi(args[i+1]));
+  return 1;
+}
 #endif
 
 std::string Genius::GeniusPrivateData::_input_file;
@@ -48,6 +68,34 @@ bool Genius::GeniusPrivateData::_experiment_code=true;
 
 bool Genius::init_processors(int *argc, char *** args)
 {
+#ifdef HAVE_MPI
+  // ensemble run, each group of processors runs an independent copy of the simulation.
+  // we init MPI by ourself and let petsc work on the group communicator
+  int n_ensembles = _ensemble_groups_from_command_line(*argc, *args);
+  if( n_ensembles > 1 )
+  {
+    MPI_Init(argc, args);
+    Genius::GeniusPrivateData::_mpi_init_by_genius = true;
+
+    int world_size, world_rank;
+    MPI_Comm_size (MPI_COMM_WORLD, &world_size);
+    MPI_Comm_rank (MPI_COMM_WORLD, &world_rank);
+
+    // can not have more groups than processors
+    n_ensembles = std::min(n_ensembles, world_size);
+
+    // contiguous processors are grouped together
+    int color = static_cast<int>( (static_cast<long>(world_rank)*n_ensembles)/world_size );
+
+    MPI_Comm comm_group;
+    MPI_Comm_split(MPI_COMM_WORLD, color, world_rank, &comm_group);
+    PETSC_COMM_WORLD = comm_group;
+
+    Genius::GeniusPrivateData::_n_ensembles = n_ensembles;
+    Genius::GeniusPrivateData::_ensemble_id = color;
+  }
+#endif
+
   // GENIUS is built on top of PETSC, we should init PETSC first
 #ifdef HAVE_SLEPC
   // if we have slepc, call  SlepcInitialize instead of PetscInitialize
@@ -64,6 +112,12 @@ bool Genius::init_processors(int *argc, char *** args)
   // duplicate an other MPI_Comm for Genius parallel communication
   MPI_Comm_dup( PETSC_COMM_WORLD, &Genius::GeniusPrivateData::_comm_world );
   MPI_Comm_dup( PETSC_COMM_SELF, &Genius::GeniusPrivateData::_comm_self );
+
+  // communicator for all the ensemble groups, it is the same as _comm_world when no ensemble
+  if( Genius::GeniusPrivateData::_mpi_init_by_genius )
+    MPI_Comm_dup( MPI_COMM_WORLD, &Genius::GeniusPrivateData::_comm_ensemble );
+  else
+    MPI_Comm_dup( PETSC_COMM_WORLD, &Genius::GeniusPrivateData::_comm_ensemble );
 #endif
 
   return true;
@@ -75,6 +129,7 @@ bool Genius::clean_processors()
 #ifdef HAVE_MPI
   MPI_Comm_free(&Genius::GeniusPrivateData::_comm_world);
   MPI_Comm_free(&Genius::GeniusPrivateData::_comm_self);
+  MPI_Comm_free(&Genius::GeniusPrivateData::_comm_ensemble);
 #endif
 
   // end PETSC
@@ -84,6 +139,16 @@ bool Genius::clean_processors()
   PetscFinalize();
 #endif
 
+#ifdef HAVE_MPI
+  // petsc will not finalize MPI it did not init
+  if( Genius::GeniusPrivateData::_mpi_init_by_genius )
+  {
+    MPI_Comm group = PETSC_COMM_WORLD;
+    MPI_Comm_free(&group);
+    MPI_Finalize();
+  }
+#endif
+
 
   return true;
 }
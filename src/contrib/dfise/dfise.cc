@@ -55,7 +55,7 @@ namespace DFISE
 #include "dfise_lex.yy.c"
 #include "dfise_parser.tab.c"
 
-  int DFISE_MESH::parse_dfise(const std::string & file)
+  int DFISE_MESH::parse_dfise(const std::string & file, bool keep_topology)
   {
     std::string grid_file = file + ".grd";
     std::string data_file = file + ".dat";
@@ -88,6 +88,9 @@ namespace DFISE
     //parse grid file
     if(parse_dfise_grid_file(grid_file)) return 1;
 
+    // edges and faces are only used to build element vertices, free them before the dataset comes in
+    if(!keep_topology) grid.release_topology();
+
     //parse dataset file
     if(parse_dfise_dataset_file(data_file)) return 1;
 
@@ -127,26 +130,51 @@ namespace DFISE
   {
     std::cout<<"  Reading DF-ISE grid file " << grid_file << "..."<< std::endl;
 
-    // top block
+    _reading_dataset = false;
+    _region_index = 0;
+
+    // top block, the Info and Data blocks are consumed during parsing
     BLOCK *block= new BLOCK;
+    BLOCK_BUILDER builder(block, this);
 
     yyin = fopen(grid_file.c_str(), "r");
     assert( yyin != NULL );
-    assert(!yyparse(block));
+    int ierr = yyparse(&builder);
+    assert(!ierr);
     fclose(yyin);
     YY_FLUSH_BUFFER;
 
-    for(unsigned int n=0; n<block->n_sub_blocks(); ++n)
+    block->clear();
+    delete block;
+
+    return ierr;
+  }
+
+
+  bool DFISE_MESH::consume(const std::vector<BLOCK *> & parents, BLOCK * block)
+  {
+    // top level blocks
+    if(parents.empty())
     {
-      BLOCK * sub = block->get_sub_block(n);
-      if(sub->keyword()=="Info") read_grid_info(sub);
-      if(sub->keyword()=="Data") read_grid_data(sub);
+      if(block->keyword()=="Info")
+      {
+        if(_reading_dataset) read_dataset_info(block);
+        else                 read_grid_info(block);
+      }
+      // the Data block is empty here, its sub blocks have been consumed
+      return true;
     }
 
-    block->clear();
-    delete block;
+    // sub blocks of Data, convert them as soon as they are parsed
+    if(parents.size()==1 && parents[0]->keyword()=="Data")
+    {
+      if(_reading_dataset) read_dataset_data(block);
+      else                 read_grid_data(block);
+      return true;
+    }
 
-    return 0;
+    // deeper blocks, i.e. Elements of Region and Values of Dataset, are kept for their parent
+    return false;
   }
 
 
@@ -201,6 +229,9 @@ namespace DFISE
       }
     }
 
+    grid.dimension = grid_info.dimension;
+    grid.region_elements.resize(grid_info.nb_regions);
+
     //grid_info.print(std::cout);
   }
 
@@ -208,156 +239,119 @@ namespace DFISE
 
   void DFISE_MESH::read_grid_data(BLOCK *block)
   {
-    grid.dimension = grid_info.dimension;
-
     // set CoordSystem
+    if(block->keyword()=="CoordSystem")
     {
-      BLOCK * CoordSystem = block->get_sub_block("CoordSystem");
-      assert(CoordSystem!=NULL);
-
       for(unsigned int n=0; n<3; ++n)
-        grid.translate[n] = (CoordSystem->get_float_parameter("translate", n));
+        grid.translate[n] = (block->get_float_parameter("translate", n));
 
       for(unsigned int m=0; m<3; ++m)
         for(unsigned int n=0; n<3; ++n)
-          grid.transform[m*3+n] = (CoordSystem->get_float_parameter("transform", m*3+n));
+          grid.transform[m*3+n] = (block->get_float_parameter("transform", m*3+n));
+      return;
     }
 
     // read Vertices
+    if(block->keyword()=="Vertices")
     {
-      BLOCK * Vertices = block->get_sub_block("Vertices");
-      assert(Vertices!=NULL);
-      assert(Vertices->index()==static_cast<int>(grid_info.nb_vertices));
+      assert(block->index()==static_cast<int>(grid_info.nb_vertices));
 
       grid.Vertices.reserve(grid_info.nb_vertices);
       if(grid_info.dimension == 3)
         for(unsigned int n=0; n<grid_info.nb_vertices; ++n)
         {
           Point p;
-          p[0] = Vertices->get_float_value(3*n);
-          p[1] = Vertices->get_float_value(3*n+1);
-          p[2] = Vertices->get_float_value(3*n+2);
+          p[0] = block->get_float_value(3*n);
+          p[1] = block->get_float_value(3*n+1);
+          p[2] = block->get_float_value(3*n+2);
           grid.Vertices.push_back(p);
         }
       if(grid_info.dimension == 2)
         for(unsigned int n=0; n<grid_info.nb_vertices; ++n)
         {
           Point p;
-          p[0] = Vertices->get_float_value(2*n);
-          p[1] = Vertices->get_float_value(2*n+1);
+          p[0] = block->get_float_value(2*n);
+          p[1] = block->get_float_value(2*n+1);
           p[2] = 0;
           grid.Vertices.push_back(p);
         }
+      return;
     }
 
     // read edges
+    if(block->keyword()=="Edges")
     {
-      BLOCK * Edges = block->get_sub_block("Edges");
-      assert(Edges!=NULL);
-      assert(Edges->index()==static_cast<int>(grid_info.nb_edges));
+      assert(block->index()==static_cast<int>(grid_info.nb_edges));
 
       grid.Edges.reserve(grid_info.nb_edges);
       for(unsigned int n=0; n<grid_info.nb_edges; ++n)
       {
-        grid.add_edge(std::make_pair((Edges->get_int_value(2*n)), (Edges->get_int_value(2*n+1))));
+        grid.add_edge(std::make_pair((block->get_int_value(2*n)), (block->get_int_value(2*n+1))));
       }
+      return;
     }
 
     // read faces
-    if(grid_info.dimension == 3)
+    if(block->keyword()=="Faces")
     {
-      BLOCK * Faces = block->get_sub_block("Faces");
-      assert(Faces!=NULL);
-      assert(Faces->index()==static_cast<int>(grid_info.nb_faces));
+      assert(grid_info.dimension == 3);
+      assert(block->index()==static_cast<int>(grid_info.nb_faces));
       grid.Faces.resize(grid_info.nb_faces);
 
       unsigned int next=0;
       for(unsigned int n=0; n<grid_info.nb_faces; ++n)
       {
-        int nb_edges = Faces->get_int_value(next++);
+        int nb_edges = block->get_int_value(next++);
+        grid.Faces[n].reserve(nb_edges);
         for(int e=0; e<nb_edges; e++)
-          grid.Faces[n].push_back((Faces->get_int_value(next++)));
+          grid.Faces[n].push_back((block->get_int_value(next++)));
       }
+      return;
     }
 
     // read locations
+    if(block->keyword()=="Locations")
     {
-      BLOCK * Locations = block->get_sub_block("Locations");
-      assert(Locations!=NULL);
-
       if(grid_info.dimension == 2)
-        assert(Locations->index()==static_cast<int>(grid_info.nb_edges));
+        assert(block->index()==static_cast<int>(grid_info.nb_edges));
 
       if(grid_info.dimension == 3)
-        assert(Locations->index()==static_cast<int>(grid_info.nb_faces));
+        assert(block->index()==static_cast<int>(grid_info.nb_faces));
 
-      for(unsigned int n=0; n<Locations->n_values(); ++n)
+      grid.Locations.reserve(block->index());
+      for(unsigned int n=0; n<block->n_values(); ++n)
       {
-        std::string location_string = Locations->get_string_value(n);
+        std::string location_string = block->get_string_value(n);
         for(unsigned int c=0; c<location_string.size(); ++c )
           grid.Locations.push_back(location_string[c]);
       }
 
-      assert( grid.Locations.size() == Locations->index() );
-
+      assert( grid.Locations.size() == static_cast<unsigned int>(block->index()) );
+      return;
     }
 
     // read Elements
+    if(block->keyword()=="Elements")
     {
-      BLOCK * Elements = block->get_sub_block("Elements");
-      assert(Elements!=NULL);
-      assert(Elements->index()==static_cast<int>(grid_info.nb_elements));
+      assert(block->index()==static_cast<int>(grid_info.nb_elements));
       grid.Elements.resize(grid_info.nb_elements);
 
       unsigned int next=0;
       for(unsigned int n=0; n<grid_info.nb_elements; ++n)
       {
-        int elem_code = Elements->get_int_value(next++);
+        int elem_code = block->get_int_value(next++);
         grid.Elements[n].elem_code = elem_code;
+
+        unsigned int n_faces=0;
         switch(elem_code)
         {
-        case 1: //Segment
-          {
-            for(unsigned int i=0; i<2; i++)
-              grid.Elements[n].faces.push_back((Elements->get_int_value(next++)));
-            break;
-          }
-        case 2: //Triangle
-          {
-            for(unsigned int i=0; i<3; i++)
-              grid.Elements[n].faces.push_back((Elements->get_int_value(next++)));
-            break;
-          }
-        case 3: //Rectangle
-          {
-            for(unsigned int i=0; i<4; i++)
-              grid.Elements[n].faces.push_back((Elements->get_int_value(next++)));
-            break;
-          }
-        case 5: //Tetrahedron
-          {
-            for(unsigned int i=0; i<4; i++)
-              grid.Elements[n].faces.push_back((Elements->get_int_value(next++)));
-            break;
-          }
-        case 6: //Pyramid
-          {
-            for(unsigned int i=0; i<5; i++)
-              grid.Elements[n].faces.push_back((Elements->get_int_value(next++)));
-            break;
-          }
-        case 7: //Prism
-          {
-            for(unsigned int i=0; i<5; i++)
-              grid.Elements[n].faces.push_back((Elements->get_int_value(next++)));
-            break;
-          }
-        case 8: //Brick
-          {
-            for(unsigned int i=0; i<6; i++)
-              grid.Elements[n].faces.push_back((Elements->get_int_value(next++)));
-            break;
-          }
+        case 1: n_faces = 2; break; //Segment
+        case 2: n_faces = 3; break; //Triangle
+        case 3: n_faces = 4; break; //Rectangle
+        case 5: n_faces = 4; break; //Tetrahedron
+        case 6: n_faces = 5; break; //Pyramid
+        case 7: n_faces = 5; break; //Prism
+        case 8: n_faces = 6; break; //Brick
         default :
           {
             //
@@ -365,41 +359,40 @@ namespace DFISE
             exit(0);
           }
         }
+
+        grid.Elements[n].faces.reserve(n_faces);
+        for(unsigned int i=0; i<n_faces; i++)
+          grid.Elements[n].faces.push_back((block->get_int_value(next++)));
+
         grid.build_node(grid.Elements[n]);
       }
+      return;
     }
 
     // read region(material) information
     //NOTE! when material equals to "Interface" or "Contact", we need some special process
-    int region_index=0;
-    grid.region_elements.resize(grid_info.nb_regions);
-    for(unsigned int n=0; n<block->n_sub_blocks(); ++n)
+    if(block->keyword()=="Region")
     {
-      BLOCK * region = block->get_sub_block(n);
+      block->set_label( fix_region_name(block->label()) );
+      assert(block->label()==grid_info.regions[_region_index]);
+      std::string material = block->get_string_parameter("material", 0);
+      assert(material==grid_info.materials[_region_index]);
 
-      if(region->keyword()=="Region")
-      {
-        region->set_label( fix_region_name(region->label()) );
-        assert(region->label()==grid_info.regions[region_index]);
-        std::string material = region->get_string_parameter("material", 0);
-        assert(material==grid_info.materials[region_index]);
+      grid.regions.push_back(block->label());
+      grid.materials.push_back(material);
 
-        grid.regions.push_back(region->label());
-        grid.materials.push_back(material);
-
-        BLOCK * Elements = region->get_sub_block("Elements");
-        unsigned int n_elem = Elements->index();
-        for(unsigned int i=0; i<n_elem; ++i)
-        {
-          unsigned int elem_index = (Elements->get_int_value(i));
-          grid.Elements[elem_index].region_index = region_index;
-          grid.region_elements[region_index].push_back(elem_index);
-        }
-        region_index++;
+      BLOCK * Elements = block->get_sub_block("Elements");
+      unsigned int n_elem = Elements->index();
+      grid.region_elements[_region_index].reserve(n_elem);
+      for(unsigned int i=0; i<n_elem; ++i)
+      {
+        unsigned int elem_index = (Elements->get_int_value(i));
+        grid.Elements[elem_index].region_index = _region_index;
+        grid.region_elements[_region_index].push_back(elem_index);
       }
+      _region_index++;
     }
 
-
   }
 
 
@@ -408,25 +401,23 @@ namespace DFISE
   {
     std::cout<<"  Reading DF-ISE dataset file " << dataset_file << "..."<< std::endl;
 
+    _reading_dataset = true;
+
+    // top block, each Dataset is consumed as soon as it is parsed
     BLOCK *block = new BLOCK;
+    BLOCK_BUILDER builder(block, this);
 
     yyin = fopen(dataset_file.c_str(), "r");
     assert( yyin != NULL );
-    assert(!yyparse(block));
+    int ierr = yyparse(&builder);
+    assert(!ierr);
     fclose(yyin);
     YY_FLUSH_BUFFER;
 
-    for(unsigned int n=0; n<block->n_sub_blocks(); ++n)
-    {
-      BLOCK * sub = block->get_sub_block(n);
-      if(sub->keyword()=="Info") read_dataset_info(sub);
-      if(sub->keyword()=="Data") read_dataset_data(sub);
-    }
-
     block->clear();
     delete block;
 
-    return 0;
+    return ierr;
   }
 
 
@@ -465,110 +456,106 @@ namespace DFISE
   }
 
 
-  void DFISE_MESH::read_dataset_data(BLOCK *block)
+  void DFISE_MESH::read_dataset_data(BLOCK *dataset_block)
   {
-    //block->print();
-    for(unsigned int n=0; n<block->n_sub_blocks(); ++n)
-    {
-      BLOCK * dataset_block = block->get_sub_block(n);
-      assert(dataset_block->keyword()=="Dataset");
+    //dataset_block->print();
+    assert(dataset_block->keyword()=="Dataset");
 
-      DATASET * dataset = new DATASET;
+    DATASET * dataset = new DATASET;
 
-      dataset->name = dataset_block->label();
-      dataset->function = dataset_block->get_string_parameter("function",0);
-      dataset->type = dataset_block->get_string_parameter("type",0)=="scalar" ? DATASET::scalar : DATASET::vector;
-      dataset->dimension= dataset_block->get_int_parameter("dimension",0);
-      dataset->location=DATASET::location_string_to_enum(dataset_block->get_string_parameter("location",0));
+    dataset->name = dataset_block->label();
+    dataset->function = dataset_block->get_string_parameter("function",0);
+    dataset->type = dataset_block->get_string_parameter("type",0)=="scalar" ? DATASET::scalar : DATASET::vector;
+    dataset->dimension= dataset_block->get_int_parameter("dimension",0);
+    dataset->location=DATASET::location_string_to_enum(dataset_block->get_string_parameter("location",0));
 
-      int n_validity = dataset_block->n_values_in_parameter("validity");
-      for(int i=0; i<n_validity; ++i)
-      {
-        std::string region = fix_region_name(dataset_block->get_string_parameter("validity", i));
-        dataset->validity.push_back(region);
+    int n_validity = dataset_block->n_values_in_parameter("validity");
+    for(int i=0; i<n_validity; ++i)
+    {
+      std::string region = fix_region_name(dataset_block->get_string_parameter("validity", i));
+      dataset->validity.push_back(region);
 
-        int region_index = grid_info.fieldregion_index_by_label(region);
-        dataset->Regions.push_back(region_index);
-      }
+      int region_index = grid_info.fieldregion_index_by_label(region);
+      dataset->Regions.push_back(region_index);
+    }
 
-      //read data
-      if(dataset->type==DATASET::scalar)
-      {
-        BLOCK * Values = dataset_block->get_sub_block("Values");
-        dataset->n_data = Values->index();
-        assert(Values->n_values()==dataset->n_data);
-        for(unsigned int i=0; i<dataset->n_data; ++i)
-          dataset->Scalar_Values.push_back(Values->get_float_value(i));
-      }
+    //read data
+    if(dataset->type==DATASET::scalar)
+    {
+      BLOCK * Values = dataset_block->get_sub_block("Values");
+      dataset->n_data = Values->index();
+      assert(Values->n_values()==dataset->n_data);
+      // take the value array over, no copy
+      dataset->Scalar_Values.swap(Values->_values);
+    }
 
-      //
-      if(dataset->type==DATASET::vector)
-      {
-        int index=0;
+    //
+    if(dataset->type==DATASET::vector)
+    {
+      int index=0;
 
-        BLOCK * Values = dataset_block->get_sub_block("Values");
-        dataset->n_data = Values->index()/dataset->dimension;
-        assert(Values->n_values()==dataset->n_data*dataset->dimension);
+      BLOCK * Values = dataset_block->get_sub_block("Values");
+      dataset->n_data = Values->index()/dataset->dimension;
+      assert(Values->n_values()==dataset->n_data*dataset->dimension);
 
-        for(int i=0; i<dataset->n_data; ++i)
-        {
-          std::vector<double> vector_value;
-          for(unsigned int n=0; n<dataset->dimension; ++n)
-            vector_value.push_back(Values->get_float_value(index++));
-          dataset->Vector_Values.push_back(vector_value);
-        }
+      dataset->Vector_Values.resize(dataset->n_data);
+      for(unsigned int i=0; i<dataset->n_data; ++i)
+      {
+        std::vector<double> & vector_value = dataset->Vector_Values[i];
+        vector_value.reserve(dataset->dimension);
+        for(unsigned int n=0; n<dataset->dimension; ++n)
+          vector_value.push_back(Values->get_float_value(index++));
       }
+    }
 
-      // build dataset value -> grid vertex map
-      if( dataset->location == DATASET::vertex )
+    // build dataset value -> grid vertex map
+    if( dataset->location == DATASET::vertex )
+    {
+      // flag the vertices, they are visited in the order of node index later
+      std::vector<bool> node_flag(grid_info.nb_vertices, false);
+      for(unsigned int r=0; r<grid_info.nb_regions; ++r)
       {
-        std::set<unsigned int> node_set;
-        for(unsigned int r=0; r<grid_info.nb_regions; ++r)
+        if(!dataset->is_valid(grid_info.region_label(r))) continue;
+
+        for(unsigned int e=0; e<grid.region_elements[r].size(); ++e)
         {
-          if(!dataset->is_valid(grid_info.region_label(r))) continue;
+          unsigned int elem_id = grid.region_elements[r][e];
+          const  Element & elem = grid.Elements[elem_id];
 
-          for(unsigned int e=0; e<grid.region_elements[r].size(); ++e)
-          {
-            unsigned int elem_id = grid.region_elements[r][e];
-            const  Element & elem = grid.Elements[elem_id];
-
-            for(unsigned int m=0; m<elem.vertices.size(); ++m)
-            {
-              unsigned int id = elem.vertices[m];
-              node_set.insert(id);
-            }
-          }
+          for(unsigned int m=0; m<elem.vertices.size(); ++m)
+            node_flag[elem.vertices[m]] = true;
         }
-
-        for(std::set<unsigned int>::iterator it=node_set.begin(); it!=node_set.end(); ++it)
-          dataset->node_to_value_index_map.insert(std::make_pair(*it, dataset->node_to_value_index_map.size()));
-
-        assert(dataset->node_to_value_index_map.size() == dataset->n_data);
       }
 
-      // build dataset value -> grid elem map
-      if( dataset->location == DATASET::element )
-      {
-        std::set<unsigned int> elem_set;
-        for(unsigned int r=0; r<grid_info.nb_regions; ++r)
-        {
-          if(!dataset->is_valid(grid_info.region_label(r))) continue;
+      unsigned int value_index = 0;
+      for(unsigned int id=0; id<node_flag.size(); ++id)
+        if(node_flag[id])
+          dataset->node_to_value_index_map.insert(dataset->node_to_value_index_map.end(), std::make_pair(id, value_index++));
 
-          for(unsigned int e=0; e<grid.region_elements[r].size(); ++e)
-          {
-            unsigned int elem_id = grid.region_elements[r][e];
-            elem_set.insert(elem_id);
-          }
-        }
+      assert(dataset->node_to_value_index_map.size() == dataset->n_data);
+    }
 
-        for(std::set<unsigned int>::iterator it=elem_set.begin(); it!=elem_set.end(); ++it)
-          dataset->elem_to_value_index_map.insert(std::make_pair(*it, dataset->elem_to_value_index_map.size()));
+    // build dataset value -> grid elem map
+    if( dataset->location == DATASET::element )
+    {
+      std::vector<bool> elem_flag(grid_info.nb_elements, false);
+      for(unsigned int r=0; r<grid_info.nb_regions; ++r)
+      {
+        if(!dataset->is_valid(grid_info.region_label(r))) continue;
 
-        assert(dataset->elem_to_value_index_map.size() == dataset->n_data);
+        for(unsigned int e=0; e<grid.region_elements[r].size(); ++e)
+          elem_flag[grid.region_elements[r][e]] = true;
       }
 
-      data_sets.push_back(dataset);
+      unsigned int value_index = 0;
+      for(unsigned int id=0; id<elem_flag.size(); ++id)
+        if(elem_flag[id])
+          dataset->elem_to_value_index_map.insert(dataset->elem_to_value_index_map.end(), std::make_pair(id, value_index++));
+
+      assert(dataset->elem_to_value_index_map.size() == dataset->n_data);
     }
+
+    data_sets.push_back(dataset);
   }
 
 
@@ -33,20 +33,21 @@
 #include "dfise_info.h"
 #include "dfise_grid.h"
 #include "dfise_dataset.h"
+#include "dfise_block.h"
 
 namespace DFISE
 {
 
-  class BLOCK;
-
   /**
    * a dfise mesh is consisted by grid/boundary file and data file
+   * the blocks are converted as soon as the parser finishes them,
+   * the whole block tree of the file is never held in memory
    */
-  class DFISE_MESH
+  class DFISE_MESH : public BLOCK_CONSUMER
   {
   public:
 
-    DFISE_MESH() {}
+    DFISE_MESH():_reading_dataset(false), _region_index(0) {}
 
     /**
      * free the datasets
@@ -59,8 +60,15 @@ namespace DFISE
 
     /**
      * read df-ise data into internal data structure
+     * when keep_topology is false, edges and faces of the grid are freed after
+     * element vertices are built. the mesh can not be written back then.
+     */
+    int parse_dfise(const std::string & file, bool keep_topology=true);
+
+    /**
+     * convert the block finished by parser
      */
-    int parse_dfise(const std::string & file);
+    virtual bool consume(const std::vector<BLOCK *> & parents, BLOCK * block);
 
     /**
      * write dfise file
@@ -214,12 +222,28 @@ namespace DFISE
 
     void read_grid_info(BLOCK *);
 
+    /**
+     * read one sub block of grid Data
+     */
     void read_grid_data(BLOCK *);
 
     void read_dataset_info(BLOCK *);
 
+    /**
+     * read one Dataset block
+     */
     void read_dataset_data(BLOCK *);
 
+    /**
+     * the file under parsing is dataset file
+     */
+    bool _reading_dataset;
+
+    /**
+     * the index of next Region block in grid file
+     */
+    int _region_index;
+
     /**
      * DFISE region may contain black char ' ', replace it with '_'
      */
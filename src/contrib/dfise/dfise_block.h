@@ -29,6 +29,7 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <iostream>
 
 
 namespace DFISE
@@ -36,42 +37,41 @@ namespace DFISE
 
   /**
    * use this stupid struct to contain int/double/std::string date
+   * only used for block parameters, which are small
    */
   struct TOKEN
   {
     enum TOKEN_TYPE {int_token, float_token, string_token};
     TOKEN_TYPE    token_type;
-    void * value;
-
-    void free_value()
-    {
-      switch(token_type)
-      {
-      case int_token     : delete (int *)value; break;
-      case float_token   : delete (double *)value; break;
-      case string_token  : delete (std::string *)value; break;
-      }
-    }
+    int           ival;
+    double        dval;
+    std::string   sval;
 
+    TOKEN(int i):token_type(int_token), ival(i), dval(i) {}
+    TOKEN(double d):token_type(float_token), ival(0), dval(d) {}
+    TOKEN(const std::string &s):token_type(string_token), ival(0), dval(0), sval(s) {}
   };
 
 
   /**
    * data structure for DF-ISE "block"
    * (A DFISE file comprises a sequence of blocks)
+   * the individual values of a block are stored compactly:
+   * numbers in a double array and strings in a string array.
+   * DF-ISE never mixes them in one block.
    */
   class BLOCK
   {
   public:
 
     /// empty constructor
-    BLOCK() {}
+    BLOCK():_index(0) {}
 
     /// constructor with keyword
-    BLOCK(const std::string & k):_keyword(k) {}
+    BLOCK(const std::string & k):_keyword(k), _index(0) {}
 
     /**
-     * don't free any TOKEN except call clear()!
+     * don't free any sub block except call clear()!
      */
     ~BLOCK() {}
 
@@ -84,42 +84,43 @@ namespace DFISE
     void set_index(int i)
     { _index = i; }
 
-    void add_parameter(const std::string & p, const std::vector<TOKEN *> & v)
+    void add_parameter(const std::string & p, const std::vector<TOKEN> & v)
     { _parameters[p] = v; }
 
-    void add_values(const std::vector<TOKEN *> & new_value)
+    void add_value(double v)
+    { _values.push_back(v); }
+
+    void add_value(const std::string & v)
+    { _string_values.push_back(v); }
+
+    void add_values(const std::vector<TOKEN> & new_value)
     {
       for(unsigned int n=0; n<new_value.size(); ++n)
-        _values.push_back(new_value[n]);
+      {
+        if(new_value[n].token_type == TOKEN::string_token)
+          _string_values.push_back(new_value[n].sval);
+        else
+          _values.push_back(new_value[n].dval);
+      }
     }
 
+    /**
+     * hint the number of numerical values this block will hold
+     */
+    void reserve_values(unsigned int n)
+    { _values.reserve(n); }
+
     void add_sub_block(BLOCK * sub_block)
     { _sub_blocks.push_back(sub_block); }
 
-    void append(const BLOCK & block)
-    {
-      std::map<std::string, std::vector<TOKEN *> >::const_iterator it = block._parameters.begin();
-      for(; it!=block._parameters.end(); ++it)
-        _parameters[it->first] = it->second;
-
-      for(unsigned int n=0; n<block._values.size(); ++n)
-        _values.push_back(block._values[n]);
-
-      for(unsigned int n=0; n<block._sub_blocks.size(); ++n)
-        _sub_blocks.push_back(block._sub_blocks[n]);
-    }
-
     /**
      * free everything
      */
     void clear()
     {
-      std::map<std::string, std::vector<TOKEN *> >::iterator it = _parameters.begin();
-      for(; it!=_parameters.end(); ++it)
-        clear(it->second);
       _parameters.clear();
-
-      clear(_values);
+      std::vector<double>().swap(_values);
+      std::vector<std::string>().swap(_string_values);
 
       for(unsigned int n=0; n<_sub_blocks.size(); ++n)
       {
@@ -133,7 +134,7 @@ namespace DFISE
     {
       std::cout<<_keyword<<std::endl;
       std::cout<<" parameters:"<< _parameters.size() <<std::endl;
-      std::cout<<" values:"<< _values.size() <<std::endl;
+      std::cout<<" values:"<< n_values() <<std::endl;
       std::cout<<" sub blocks:"<< _sub_blocks.size() <<std::endl;
       for(unsigned int n=0; n<_sub_blocks.size(); ++n)
         _sub_blocks[n]->print();
@@ -169,14 +170,19 @@ namespace DFISE
     const std::string & label() const
       { return _label; }
 
+    /**
+     * @return true when parameter exist
+     */
+    bool has_parameter(const std::string & name) const
+    { return _parameters.find(name)!=_parameters.end(); }
+
     /**
      * @return the size of value associated with this parameter
      */
     unsigned int n_values_in_parameter(const std::string & name)
     {
       assert(_parameters.find(name)!=_parameters.end());
-      std::vector<TOKEN *> & token = _parameters[name];
-      return token.size();
+      return _parameters[name].size();
     }
 
     /**
@@ -184,68 +190,61 @@ namespace DFISE
      */
     unsigned int n_values() const
     {
-      return _values.size();
+      return _values.size() + _string_values.size();
     }
 
     /**
-     * @return the ith pointer to std::string value of parameter name
+     * @return the ith std::string value of parameter name
      */
     std::string get_string_parameter(const std::string & name, unsigned int i)
     {
       assert(_parameters.find(name)!=_parameters.end());
-      std::vector<TOKEN *> & token = _parameters[name];
+      const std::vector<TOKEN> & token = _parameters[name];
       assert(i<token.size());
-      assert(token[i]->token_type == TOKEN::string_token);
-      return *(std::string*)token[i]->value;
+      assert(token[i].token_type == TOKEN::string_token);
+      return token[i].sval;
     }
 
     /**
-     * @return the  ith pointer to int value of parameter name
+     * @return the ith int value of parameter name
      */
     int get_int_parameter(const std::string & name, unsigned int i)
     {
       assert(_parameters.find(name)!=_parameters.end());
-      std::vector<TOKEN *> & token = _parameters[name];
+      const std::vector<TOKEN> & token = _parameters[name];
       assert(i<token.size());
-      assert(token[i]->token_type == TOKEN::int_token);
-      return *(int*)token[i]->value;
+      assert(token[i].token_type == TOKEN::int_token);
+      return token[i].ival;
     }
 
     /**
-     * @return the ith pointer to float value of parameter name
+     * @return the ith float value of parameter name
      */
     double get_float_parameter(const std::string & name, unsigned int i)
     {
       assert(_parameters.find(name)!=_parameters.end());
-      std::vector<TOKEN *> & token = _parameters[name];
+      const std::vector<TOKEN> & token = _parameters[name];
       assert(i<token.size());
-      assert(token[i]->token_type == TOKEN::int_token || token[i]->token_type == TOKEN::float_token);
-      if(token[i]->token_type == TOKEN::int_token)
-        return *(int*)token[i]->value;
-      return *(double*)token[i]->value;
+      assert(token[i].token_type == TOKEN::int_token || token[i].token_type == TOKEN::float_token);
+      return token[i].dval;
     }
 
-    std::string get_string_value(unsigned int i)
+    std::string get_string_value(unsigned int i) const
     {
-      assert(i<_values.size());
-      assert(_values[i]->token_type == TOKEN::string_token);
-      return *(std::string*)_values[i]->value;
+      assert(i<_string_values.size());
+      return _string_values[i];
     }
 
-    int get_int_value(unsigned int i)
+    int get_int_value(unsigned int i) const
     {
       assert(i<_values.size());
-      assert(_values[i]->token_type == TOKEN::int_token);
-      return *(int*)_values[i]->value;
+      return static_cast<int>(_values[i]);
     }
 
-    double get_float_value(unsigned int i)
+    double get_float_value(unsigned int i) const
     {
       assert(i<_values.size());
-      assert(_values[i]->token_type == TOKEN::int_token || _values[i]->token_type == TOKEN::float_token);
-      if(_values[i]->token_type == TOKEN::int_token)
-        return *(int*)_values[i]->value;
-      return *(double*)_values[i]->value;
+      return _values[i];
     }
 
   public:
@@ -268,32 +267,107 @@ namespace DFISE
     /**
      * all the parameters in this block
      */
-    std::map<std::string, std::vector<TOKEN *> >  _parameters;
+    std::map<std::string, std::vector<TOKEN> >  _parameters;
 
     /**
-     * all the individual values in this block
+     * all the individual numerical values in this block
      */
-    std::vector<TOKEN *>  _values;
+    std::vector<double>  _values;
+
+    /**
+     * all the individual string values in this block
+     */
+    std::vector<std::string>  _string_values;
 
     /**
      * the sub blocks
      */
     std::vector<BLOCK *> _sub_blocks;
 
+  };
+
+
+  /**
+   * the receiver of finished blocks.
+   * it is called by the parser as soon as a block is closed,
+   * and can convert the block into its own data structure at once
+   */
+  class BLOCK_CONSUMER
+  {
+  public:
+
+    virtual ~BLOCK_CONSUMER() {}
+
+    /**
+     * @param parents  the enclosing blocks (outermost first), which are still under parsing
+     * @param block    the finished block
+     * @return true when the block is consumed, then it will be freed and not linked to its parent
+     */
+    virtual bool consume(const std::vector<BLOCK *> & parents, BLOCK * block)=0;
+  };
+
+
+  /**
+   * the state of the parser: the stack of open blocks.
+   * with a consumer, a large file never lives as a whole block tree in memory,
+   * each data block is converted and freed right after it is parsed
+   */
+  class BLOCK_BUILDER
+  {
+  public:
+
+    BLOCK_BUILDER(BLOCK * root, BLOCK_CONSUMER * consumer=0)
+      :_root(root), _consumer(consumer) {}
+
     /**
-     * free tokens and the value in tokens!
+     * @return the top level block
      */
-    void clear(std::vector<TOKEN *> & tokens)
+    BLOCK * root()
+    { return _root; }
+
+    /**
+     * @return the block under parsing
+     */
+    BLOCK * current()
+    { return _open_blocks.empty() ? _root : _open_blocks.back(); }
+
+    /**
+     * begin a new block
+     */
+    BLOCK * open_block(const std::string & keyword)
     {
-      for(unsigned int n=0; n<tokens.size(); ++n)
+      BLOCK * block = new BLOCK(keyword);
+      _open_blocks.push_back(block);
+      return block;
+    }
+
+    /**
+     * finish the current block
+     * @return the block, or NULL when it has been consumed
+     */
+    BLOCK * close_block()
+    {
+      assert(!_open_blocks.empty());
+      BLOCK * block = _open_blocks.back();
+      _open_blocks.pop_back();
+
+      if(_consumer && _consumer->consume(_open_blocks, block))
       {
-        tokens[n]->free_value();
-        delete tokens[n];
+        block->clear();
+        delete block;
+        return 0;
       }
-      tokens.clear();
+      return block;
     }
-  };
 
+  private:
+
+    BLOCK * _root;
+
+    BLOCK_CONSUMER * _consumer;
+
+    std::vector<BLOCK *> _open_blocks;
+  };
 
 }
 
@@ -52,6 +52,16 @@ namespace DFISE
     _edge_set.clear();
   }
 
+  void GRID::release_topology()
+  {
+    std::vector< std::pair<int, int> >().swap(Edges);
+    std::vector< std::vector<int> >().swap(Faces);
+    std::vector< char >().swap(Locations);
+    _edge_set.clear();
+    for(unsigned int n=0; n<Elements.size(); ++n)
+      std::vector<int>().swap(Elements[n].faces);
+  }
+
   std::vector<int> GRID::get_face_nodes(int face_index)
   {
     bool face_inverse = face_index < 0;
@@ -130,6 +130,12 @@ namespace DFISE
      */
     void clear();
 
+    /**
+     * free edges, faces and locations as well as element faces,
+     * which are only used to build element vertices
+     */
+    void release_topology();
+
     /**
      * add edge
      */
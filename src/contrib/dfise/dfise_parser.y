@@ -2,14 +2,14 @@
 
 extern int yylineno;
 extern int yylex();
-int yyerror(BLOCK *, char *s);
+int yyerror(BLOCK_BUILDER *, char *s);
 
 //#define VERBOSE
 
 %}
 %start file
 
-%parse-param {BLOCK * ise_block}
+%parse-param {BLOCK_BUILDER * ise_block}
 
 %union  {
     int    ival;
@@ -17,7 +17,7 @@ int yyerror(BLOCK *, char *s);
     char   cval;
     char   sval[256];
     BLOCK * bval;
-    std::vector<TOKEN *> * tokens;
+    std::vector<TOKEN> * tokens;
     TOKEN * token;
    }
 
@@ -26,7 +26,7 @@ int yyerror(BLOCK *, char *s);
 %token <dval> FLOAT
 %token <sval> STRING KEYWORD PARAMETER
 
-%type <bval> block body bodyitem
+%type <bval> block
 %type <token> value
 %type <tokens> values data
 
@@ -34,7 +34,7 @@ int yyerror(BLOCK *, char *s);
 
 file     : DFISE FILE_FORMAT blocks
 {
-           ise_block->set_keyword($1);
+           ise_block->root()->set_keyword($1);
 }
          ;
 
@@ -42,92 +42,93 @@ file     : DFISE FILE_FORMAT blocks
 blocks   : block
 {
            /* top level block */
-           ise_block->add_sub_block($1);
+           if($1) ise_block->root()->add_sub_block($1);
 }
          | blocks block
 {
            /* top level block */
-           ise_block->add_sub_block($2);
+           if($2) ise_block->root()->add_sub_block($2);
 }
          ;
 
 
-block    : KEYWORD '{' body '}'
+block    : KEYWORD '{'
 {
 #ifdef VERBOSE
     printf("block1:%s {body}\n", $1);
 #endif
          /* new block */
-         $$ = new BLOCK($1);
-         $$->append(*$3);
-         delete $3;
+         ise_block->open_block($1);
 }
-         | KEYWORD '(' INTEGER ')' '{' body '}'
+           body '}'
+{
+         /* NULL if the block is consumed */
+         $$ = ise_block->close_block();
+}
+         | KEYWORD '(' INTEGER ')' '{'
 {
 #ifdef VERBOSE
     printf("block2:%s (%d) {body}\n", $1, $3);
 #endif
          /* new block */
-         $$ = new BLOCK($1);
-         $$->set_index($3);
-         $$->append(*$6);
-         delete $6;
+         BLOCK * block = ise_block->open_block($1);
+         block->set_index($3);
+         block->reserve_values($3);
+}
+           body '}'
+{
+         $$ = ise_block->close_block();
 }
-         | KEYWORD '(' STRING ')' '{' body '}'
+         | KEYWORD '(' STRING ')' '{'
 {
 #ifdef VERBOSE
     printf("block3:%s (%s) {body}\n", $1, $3);
 #endif
          /* new block */
-         $$ = new BLOCK($1);
-         $$->set_label($3);
-         $$->append(*$6);
-         delete $6;
+         ise_block->open_block($1)->set_label($3);
+}
+           body '}'
+{
+         $$ = ise_block->close_block();
 }
          ;
 
 body     :  bodyitem
-{
-         $$ = new BLOCK;
-         $$->append(*$1);
-         delete $1;
-}
          |  body bodyitem
-{
-         $$ = $1;
-         $$->append(*$2);
-         delete $2;
-}
          ;
 
 bodyitem :  block
 {
-            $$ = new BLOCK;
-            $$->add_sub_block($1);
+            if($1) ise_block->current()->add_sub_block($1);
+}
+         |  INTEGER
+{
+            /* individual values are pushed into current block directly */
+            ise_block->current()->add_value($1);
+}
+         |  FLOAT
+{
+            ise_block->current()->add_value($1);
 }
-         |  data
+         |  STRING
 {
-            $$ = new BLOCK;
-            /* data is pushed into TOKENS vector */
-            $$->add_values(*$1);
-            delete $1;
+            ise_block->current()->add_value(std::string($1));
+}
+         |  '[' values ']'
+{
+            ise_block->current()->add_values(*$2);
+            delete $2;
 }
          | KEYWORD '=' data
 {
-           $$ = new BLOCK;
-           $$->add_parameter($1, *$3);
+           ise_block->current()->add_parameter($1, *$3);
            delete $3;
 }
          | KEYWORD '=' KEYWORD
 {
-           $$ = new BLOCK;
-           TOKEN * new_token = new TOKEN;
-           new_token->token_type = TOKEN::string_token;
-           new_token->value = new std::string;
-           *((std::string*)new_token->value) = $3;
-           std::vector<TOKEN *> tokens;
-           tokens.push_back(new_token);
-           $$->add_parameter($1, tokens);
+           std::vector<TOKEN> tokens;
+           tokens.push_back(TOKEN(std::string($3)));
+           ise_block->current()->add_parameter($1, tokens);
 }
          ;
 
@@ -135,8 +136,9 @@ bodyitem :  block
 
 data     : value
 {
-         $$ = new std::vector<TOKEN *>;
-         $$->push_back($1);
+         $$ = new std::vector<TOKEN>;
+         $$->push_back(*$1);
+         delete $1;
 }
          | '[' values ']'
 {
@@ -146,46 +148,36 @@ data     : value
 
 values   :  value
 {
-         $$ = new std::vector<TOKEN *>;
-         $$->push_back($1);
+         $$ = new std::vector<TOKEN>;
+         $$->push_back(*$1);
+         delete $1;
 }
          |  values value
 {
          $$ = $1;
-         $$->push_back($2);
+         $$->push_back(*$2);
+         delete $2;
 }
          ;
 
 
 value    : INTEGER
 {
-         // read integer data, insert into vector TOKENS
-         $$ = new TOKEN;
-         $$->token_type = TOKEN::int_token;
-         $$->value = new int;
-         *((int*)$$->value) = $1;
+         $$ = new TOKEN($1);
 }
          | FLOAT
 {
-         // read float data, insert into vector TOKENS
-         $$ = new TOKEN;
-         $$->token_type = TOKEN::float_token;
-         $$->value = new double;
-         *((double*)$$->value) = $1;
+         $$ = new TOKEN($1);
 }
          | STRING
 {
-         // read string data, insert into vector TOKENS
-         $$ = new TOKEN;
-         $$->token_type = TOKEN::string_token;
-         $$->value = new std::string;
-         *((std::string*)$$->value) = $1;
+         $$ = new TOKEN(std::string($1));
 }
          ;
 
 %%
 
-int yyerror(BLOCK *, char *)
+int yyerror(BLOCK_BUILDER *, char *)
 {
    printf("\nline %d unrecognized chars %s \n",yylineno, yylval.sval);
    return 0;
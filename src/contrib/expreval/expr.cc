@@ -6,11 +6,14 @@
 // Includes
 #include <new>
 #include <memory>
+#include <cmath>
+#include <cfloat>
 
 #include "expr.h"
 #include "expr_parser.h"
 #include "expr_node.h"
 #include "expr_except.h"
+#include "expr_program.h"
 
 using namespace std;
 using namespace ExprEval;
@@ -20,7 +23,7 @@ using namespace ExprEval;
 //------------------------------------------------------------------------------
 
 // Constructor
-Expression::Expression() : m_vlist(0), m_flist(0), m_dlist(0), m_expr(0)
+Expression::Expression() : m_vlist(0), m_flist(0), m_dlist(0), m_expr(0), m_program(0)
     {
     m_abortcount = 200000;
     m_abortreset = 200000;
@@ -31,6 +34,7 @@ Expression::~Expression()
     {
     // Delete expression nodes
     delete m_expr;
+    delete m_program;
     }
 
 // Set value list
@@ -129,18 +133,34 @@ void Expression::Parse(const string &exstr)
     
     // Parse the expression
     m_expr = p->Parse(exstr);
+
+    // Compile the expression into bytecode
+    auto_ptr<Program> program(new Program());
+    program->Finish(m_expr->Compile(*program));
+    if(program->IsValid())
+        m_program = program.release();
     }
     
 // Clear the expression
 void Expression::Clear()
     {
     delete m_expr;
-    m_expr = 0; 
+    m_expr = 0;
+    delete m_program;
+    m_program = 0;
     }
 
 // Evaluate an expression
 double Expression::Evaluate()
     {
+    if(m_program)
+        {
+        // the node tree reports the error of a non finite result
+        double result = m_program->Evaluate();
+        if(fabs(result) <= DBL_MAX)
+            return result;
+        }
+
     if(m_expr)
         {
         return m_expr->Evaluate();
@@ -150,4 +170,9 @@ double Expression::Evaluate()
         throw(EmptyExpressionException());
         }    
     }
-            
+
+// Get bytecode
+Program *Expression::GetProgram() const
+    {
+    return m_program;
+    }
@@ -18,6 +18,7 @@ namespace ExprEval
     class FunctionList;
     class DataList;
     class Node;
+    class Program;
     
     // Expression class
     //--------------------------------------------------------------------------
@@ -52,12 +53,16 @@ namespace ExprEval
             
             // Evaluate expression
             double Evaluate();
+
+            // Bytecode of the parsed expression, 0 if it can not be compiled
+            Program *GetProgram() const;
             
         protected:
             ValueList *m_vlist;
             FunctionList *m_flist;
             DataList *m_dlist;
             Node *m_expr;
+            Program *m_program;
             unsigned long m_abortcount;
             unsigned long m_abortreset;
         };
@@ -16,6 +16,7 @@
 #include "expr_funclist.h"
 #include "expr_datalist.h"
 #include "expr_except.h"
+#include "expr_program.h"
 
 using namespace std;
 using namespace ExprEval;
@@ -43,6 +44,12 @@ double Node::Evaluate()
     return DoEvaluate();
     }
 
+// Compile, evaluate the node tree
+long Node::Compile(Program &prog)
+    {
+    return prog.Fallback(this);
+    }
+
 // Function node
 //------------------------------------------------------------------------------
 
@@ -70,6 +77,95 @@ string FunctionNode::GetName() const
     return m_factory->GetName();
     }
 
+// Compile
+long FunctionNode::Compile(Program &prog)
+    {
+    struct FunctionCode
+        {
+        const char *name;
+        Program::OpCode op;
+        long args; // -1 for min/max chain
+        };
+
+    static const FunctionCode codes[] =
+        {
+            { "abs",   Program::OpAbs,   1 }, { "sqrt",  Program::OpSqrt,  1 },
+            { "sin",   Program::OpSin,   1 }, { "cos",   Program::OpCos,   1 },
+            { "tan",   Program::OpTan,   1 }, { "sinh",  Program::OpSinh,  1 },
+            { "cosh",  Program::OpCosh,  1 }, { "tanh",  Program::OpTanh,  1 },
+            { "asin",  Program::OpAsin,  1 }, { "acos",  Program::OpAcos,  1 },
+            { "atan",  Program::OpAtan,  1 }, { "asinh", Program::OpAsinh, 1 },
+            { "acosh", Program::OpAcosh, 1 }, { "atanh", Program::OpAtanh, 1 },
+            { "log",   Program::OpLog10, 1 }, { "ln",    Program::OpLn,    1 },
+            { "exp",   Program::OpExp,   1 }, { "erf",   Program::OpErf,   1 },
+            { "erfc",  Program::OpErfc,  1 }, { "floor", Program::OpFloor, 1 },
+            { "ceil",  Program::OpCeil,  1 }, { "atan2", Program::OpAtan2, 2 },
+            { "logn",  Program::OpLogn,  2 }, { "equal", Program::OpEqual, 2 },
+            { "above", Program::OpAbove, 2 }, { "below", Program::OpBelow, 2 },
+            { "if",    Program::OpIf,    3 }, { "min",   Program::OpMin,  -1 },
+            { "max",   Program::OpMax,  -1 }
+        };
+
+    string name = GetName();
+
+    // random functions change their state, the tree must evaluate them
+    if(name == "rand" || name == "random" || name == "randomize")
+        return -1;
+
+    // functions with reference or data parameters keep the node tree
+    if(!m_refs.empty() || !m_data.empty())
+        return CompileFallback(prog);
+
+    for(unsigned int i = 0; i < sizeof(codes)/sizeof(codes[0]); i++)
+        {
+        if(name != codes[i].name)
+            continue;
+
+        vector<long> args;
+        for(vector<Node*>::size_type pos = 0; pos < m_nodes.size(); pos++)
+            {
+            long r = m_nodes[pos]->Compile(prog);
+            if(r < 0)
+                return -1;
+            args.push_back(r);
+            }
+
+        if(codes[i].args == -1 && args.size() >= 1)
+            {
+            long r = args[0];
+            for(vector<long>::size_type pos = 1; pos < args.size(); pos++)
+                r = prog.Binary(codes[i].op, r, args[pos]);
+            return r;
+            }
+
+        if(codes[i].args != (long)args.size())
+            break;
+
+        switch(codes[i].args)
+            {
+            case 1:  return prog.Unary(codes[i].op, args[0]);
+            case 2:  return prog.Binary(codes[i].op, args[0], args[1]);
+            default: return prog.Ternary(codes[i].op, args[0], args[1], args[2]);
+            }
+        }
+
+    return CompileFallback(prog);
+    }
+
+// Compile as call into the node tree
+long FunctionNode::CompileFallback(Program &prog)
+    {
+    // the instructions of the arguments are dead, compiling them only
+    // registers the variables the tree reads
+    for(vector<Node*>::size_type pos = 0; pos < m_nodes.size(); pos++)
+        m_nodes[pos]->Compile(prog);
+
+    for(vector<double*>::size_type pos = 0; pos < m_refs.size(); pos++)
+        prog.Variable(m_refs[pos]);
+
+    return Node::Compile(prog);
+    }
+
 // Set argument count
 void FunctionNode::SetArgumentCount(long argMin, long argMax, long refMin, long refMax,
         long dataMin, long dataMax)
@@ -368,6 +464,21 @@ double MultiNode::DoEvaluate()
     return result;
     }
 
+// Compile
+long MultiNode::Compile(Program &prog)
+    {
+    long result = -1;
+
+    for(vector<Node*>::size_type pos = 0; pos < m_nodes.size(); pos++)
+        {
+        result = m_nodes[pos]->Compile(prog);
+        if(result < 0)
+            return -1;
+        }
+
+    return result;
+    }
+
 // Parse
 void MultiNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -475,6 +586,13 @@ double AssignNode::DoEvaluate()
     return (*m_var = m_rhs->Evaluate());
     }
 
+// Compile
+long AssignNode::Compile(Program &)
+    {
+    // assignment changes the variable, the tree must evaluate it
+    return -1;
+    }
+
 // Parse
 void AssignNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -563,6 +681,15 @@ double AddNode::DoEvaluate()
     return m_lhs->Evaluate() + m_rhs->Evaluate();
     }
 
+// Compile
+long AddNode::Compile(Program &prog)
+    {
+    long left = m_lhs->Compile(prog);
+    long right = m_rhs->Compile(prog);
+
+    return prog.Binary(Program::OpAdd, left, right);
+    }
+
 // Parse
 void AddNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -607,6 +734,15 @@ double SubtractNode::DoEvaluate()
     return m_lhs->Evaluate() - m_rhs->Evaluate();
     }
 
+// Compile
+long SubtractNode::Compile(Program &prog)
+    {
+    long left = m_lhs->Compile(prog);
+    long right = m_rhs->Compile(prog);
+
+    return prog.Binary(Program::OpSub, left, right);
+    }
+
 // Parse
 void SubtractNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -651,6 +787,15 @@ double MultiplyNode::DoEvaluate()
     return m_lhs->Evaluate() * m_rhs->Evaluate();
     }
 
+// Compile
+long MultiplyNode::Compile(Program &prog)
+    {
+    long left = m_lhs->Compile(prog);
+    long right = m_rhs->Compile(prog);
+
+    return prog.Binary(Program::OpMul, left, right);
+    }
+
 // Parse
 void MultiplyNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -704,6 +849,15 @@ double DivideNode::DoEvaluate()
         }
     }
 
+// Compile
+long DivideNode::Compile(Program &prog)
+    {
+    long left = m_lhs->Compile(prog);
+    long right = m_rhs->Compile(prog);
+
+    return prog.Binary(Program::OpDiv, left, right);
+    }
+
 // Parse
 void DivideNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -747,6 +901,12 @@ double NegateNode::DoEvaluate()
     return -(m_rhs->Evaluate());
     }
 
+// Compile
+long NegateNode::Compile(Program &prog)
+    {
+    return prog.Unary(Program::OpNeg, m_rhs->Compile(prog));
+    }
+
 // Parse
 void NegateNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -796,6 +956,15 @@ double ExponentNode::DoEvaluate()
     return result;
     }
 
+// Compile
+long ExponentNode::Compile(Program &prog)
+    {
+    long left = m_lhs->Compile(prog);
+    long right = m_rhs->Compile(prog);
+
+    return prog.Binary(Program::OpPow, left, right);
+    }
+
 // Parse
 void ExponentNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -822,7 +991,7 @@ void ExponentNode::Parse(Parser &parser, Parser::size_type start, Parser::size_t
 //------------------------------------------------------------------------------
 
 // Constructor
-VariableNode::VariableNode(Expression *expr) : Node(expr), m_var(0)
+VariableNode::VariableNode(Expression *expr) : Node(expr), m_var(0), m_const(false)
     {
     }
 
@@ -837,6 +1006,15 @@ double VariableNode::DoEvaluate()
     return *m_var;
     }
 
+// Compile
+long VariableNode::Compile(Program &prog)
+    {
+    if(m_const)
+        return prog.Constant(*m_var);
+
+    return prog.Variable(m_var);
+    }
+
 // Parse
 void VariableNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -886,6 +1064,7 @@ void VariableNode::Parse(Parser &parser, Parser::size_type start, Parser::size_t
 
     // Set information
     m_var = vaddr;
+    m_const = vlist->IsConstant(ident);
     }
 
 // Value node
@@ -907,6 +1086,12 @@ double ValueNode::DoEvaluate()
     return m_val;
     }
 
+// Compile
+long ValueNode::Compile(Program &prog)
+    {
+    return prog.Constant(m_val);
+    }
+
 // Parse
 void ValueNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
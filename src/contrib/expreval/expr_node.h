@@ -19,6 +19,7 @@ namespace ExprEval
     class Expression;
     class FunctionFactory;
     class DataEntry;
+    class Program;
 
     // Node class
     //--------------------------------------------------------------------------
@@ -34,6 +35,10 @@ namespace ExprEval
 
             double Evaluate(); // Calls Expression::TestAbort, then DoEvaluate
 
+            // Emit bytecode of the node, return the result register or -1 if
+            // the node can not be compiled. Default evaluates the node tree.
+            virtual long Compile(Program &prog);
+
         protected:
             Expression *m_expr;
         };
@@ -50,6 +55,9 @@ namespace ExprEval
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
 
+            // Compile known math functions by name
+            long Compile(Program &prog);
+
 
         private:
             // Function factory
@@ -63,6 +71,10 @@ namespace ExprEval
             long m_dataMin;
             long m_dataMax;
 
+            // Evaluate this node by the tree, the variables it reads are
+            // registered to the program for derivatives
+            long CompileFallback(Program &prog);
+
         protected:
             // Set argument count (called in derived constructors)
             void SetArgumentCount(long argMin = 0, long argMax = 0,
@@ -90,6 +102,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            long Compile(Program &prog);
 
         private:
             ::std::vector<Node*> m_nodes;
@@ -106,6 +119,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            long Compile(Program &prog);
 
         private:
             double *m_var;
@@ -123,6 +137,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            long Compile(Program &prog);
 
         private:
             Node *m_lhs;
@@ -140,6 +155,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            long Compile(Program &prog);
 
         private:
             Node *m_lhs;
@@ -157,6 +173,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            long Compile(Program &prog);
 
         private:
             Node *m_lhs;
@@ -174,6 +191,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            long Compile(Program &prog);
 
         private:
             Node *m_lhs;
@@ -191,6 +209,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            long Compile(Program &prog);
 
         private:
             Node *m_rhs;
@@ -207,6 +226,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            long Compile(Program &prog);
 
         private:
             Node *m_lhs;
@@ -224,9 +244,11 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            long Compile(Program &prog);
 
         private:
             double *m_var;
+            bool m_const;
         };
 
     // Value node
@@ -240,6 +262,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            long Compile(Program &prog);
 
         private:
             double m_val;
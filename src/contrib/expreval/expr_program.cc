@@ -0,0 +1,416 @@
+// File:    expr_program.cc
+// Purpose: Flat register based bytecode of a parsed expression
+//------------------------------------------------------------------------------
+
+// Includes
+#include <cmath>
+#include <algorithm>
+
+#include "asinh.hpp"
+#include "acosh.hpp"
+#include "atanh.hpp"
+
+#include "expr_program.h"
+#include "expr_node.h"
+
+using namespace std;
+using namespace ExprEval;
+
+// Anonymous namespace for items
+namespace
+    {
+    // Complementary error function, the same Chebyshev fit as erfc function node
+    double chebyshev_erfc(double x)
+        {
+        const double a1 = -1.26551223,   a2 = 1.00002368,
+                     a3 =  0.37409196,   a4 = 0.09678418,
+                     a5 = -0.18628806,   a6 = 0.27886807,
+                     a7 = -1.13520398,   a8 = 1.48851587,
+                     a9 = -0.82215223,  a10 = 0.17087277;
+
+        double z = fabs(x);
+        if(z <= 0) return 1.0;
+
+        double t = 1/(1+0.5*z);
+        double result = t*exp((-z*z) +a1+t*(a2+t*(a3+t*(a4+t*(a5+t*(a6+t*(a7+t*(a8+t*(a9+t*a10)))))))));
+
+        if(x < 0) result = 2-result;
+        return result;
+        }
+
+    const double two_over_sqrt_pi = 1.12837916709551257390;
+    }
+
+
+// Program
+//------------------------------------------------------------------------------
+
+// Constructor
+Program::Program() : m_result(-1), m_differentiable(true)
+    {
+    }
+
+// Clear all instructions
+void Program::Clear()
+    {
+    m_code.clear();
+    m_live.clear();
+    m_reg.clear();
+    m_dreg.clear();
+    m_vars.clear();
+    m_result = -1;
+    m_differentiable = true;
+    }
+
+// Constant
+long Program::Constant(double value)
+    {
+    Instruction inst = { OpConst, -1, -1, -1, value, 0, 0 };
+    m_code.push_back(inst);
+    return m_code.size() - 1;
+    }
+
+// Variable, each address is loaded only once
+long Program::Variable(double *var)
+    {
+    vector<Instruction>::size_type pos;
+    for(pos = 0; pos < m_code.size(); pos++)
+        {
+        if(m_code[pos].op == OpVar && m_code[pos].var == var)
+            return pos;
+        }
+
+    long index = find(m_vars.begin(), m_vars.end(), var) - m_vars.begin();
+    if(index == (long)m_vars.size())
+        m_vars.push_back(var);
+
+    Instruction inst = { OpVar, index, -1, -1, 0.0, var, 0 };
+    m_code.push_back(inst);
+    return m_code.size() - 1;
+    }
+
+// Evaluate the node tree, derivatives by central difference
+long Program::Fallback(Node *node)
+    {
+    m_differentiable = false;
+
+    Instruction inst = { OpNode, -1, -1, -1, 0.0, 0, node };
+    m_code.push_back(inst);
+    return m_code.size() - 1;
+    }
+
+// Unary operator, folded when the operand is constant
+long Program::Unary(OpCode op, long a)
+    {
+    if(a < 0)
+        return -1;
+
+    if(m_code[a].op == OpConst)
+        return Constant(Apply(op, m_code[a].value, 0.0, 0.0));
+
+    Instruction inst = { op, a, -1, -1, 0.0, 0, 0 };
+    m_code.push_back(inst);
+    return m_code.size() - 1;
+    }
+
+// Binary operator, folded when both operands are constant
+long Program::Binary(OpCode op, long a, long b)
+    {
+    if(a < 0 || b < 0)
+        return -1;
+
+    if(m_code[a].op == OpConst && m_code[b].op == OpConst)
+        return Constant(Apply(op, m_code[a].value, m_code[b].value, 0.0));
+
+    Instruction inst = { op, a, b, -1, 0.0, 0, 0 };
+    m_code.push_back(inst);
+    return m_code.size() - 1;
+    }
+
+// Ternary operator, only the selected branch is kept for constant condition
+long Program::Ternary(OpCode op, long a, long b, long c)
+    {
+    if(a < 0 || b < 0 || c < 0)
+        return -1;
+
+    if(op == OpIf && m_code[a].op == OpConst)
+        return m_code[a].value != 0.0 ? b : c;
+
+    Instruction inst = { op, a, b, c, 0.0, 0, 0 };
+    m_code.push_back(inst);
+    return m_code.size() - 1;
+    }
+
+// Mark live instructions and load the constants
+void Program::Finish(long result)
+    {
+    m_live.clear();
+    m_result = result;
+    if(result < 0)
+        return;
+
+    vector<bool> live(m_code.size(), false);
+    live[result] = true;
+    for(long pos = result; pos >= 0; pos--)
+        {
+        if(!live[pos])
+            continue;
+        const Instruction &inst = m_code[pos];
+        if(inst.a >= 0 && inst.op != OpVar) live[inst.a] = true;
+        if(inst.b >= 0) live[inst.b] = true;
+        if(inst.c >= 0) live[inst.c] = true;
+        }
+
+    m_reg.assign(m_code.size(), 0.0);
+    m_differentiable = true;
+    for(long pos = 0; pos <= result; pos++)
+        {
+        if(!live[pos])
+            continue;
+        if(m_code[pos].op == OpConst)
+            m_reg[pos] = m_code[pos].value;
+        else
+            m_live.push_back(pos);
+        if(m_code[pos].op == OpNode)
+            m_differentiable = false;
+        }
+    }
+
+// Program is ready
+bool Program::IsValid() const
+    {
+    return m_result >= 0;
+    }
+
+// Derivatives are exact, no central difference
+bool Program::IsDifferentiable() const
+    {
+    return m_differentiable;
+    }
+
+// Number of variables
+vector<double*>::size_type Program::VariableCount() const
+    {
+    return m_vars.size();
+    }
+
+// Address of variable
+double *Program::VariableAddress(vector<double*>::size_type v) const
+    {
+    return m_vars[v];
+    }
+
+// Value of one instruction
+double Program::Apply(OpCode op, double a, double b, double c)
+    {
+    switch(op)
+        {
+        case OpAdd:   return a + b;
+        case OpSub:   return a - b;
+        case OpMul:   return a * b;
+        case OpDiv:   return a / b;
+        case OpNeg:   return -a;
+        case OpPow:   return pow(a, b);
+        case OpAbs:   return fabs(a);
+        case OpSqrt:  return sqrt(a);
+        case OpSin:   return sin(a);
+        case OpCos:   return cos(a);
+        case OpTan:   return tan(a);
+        case OpSinh:  return sinh(a);
+        case OpCosh:  return cosh(a);
+        case OpTanh:  return tanh(a);
+        case OpAsin:  return asin(a);
+        case OpAcos:  return acos(a);
+        case OpAtan:  return atan(a);
+        case OpAsinh: return boost::math::asinh(a);
+        case OpAcosh: return boost::math::acosh(a);
+        case OpAtanh: return boost::math::atanh(a);
+        case OpLog10: return log10(a);
+        case OpLn:    return log(a);
+        case OpExp:   return exp(a);
+        case OpErf:   return 1 - chebyshev_erfc(a);
+        case OpErfc:  return chebyshev_erfc(a);
+        case OpFloor: return floor(a);
+        case OpCeil:  return ceil(a);
+        case OpAtan2: return atan2(a, b);
+        case OpLogn:  return log(a) / log(b);
+        case OpMin:   return b < a ? b : a;
+        case OpMax:   return b > a ? b : a;
+        case OpEqual: return a == b ? 1.0 : 0.0;
+        case OpAbove: return a > b ? 1.0 : 0.0;
+        case OpBelow: return a < b ? 1.0 : 0.0;
+        case OpIf:    return a != 0.0 ? b : c;
+        default:      return 0.0;
+        }
+    }
+
+// Run the live instructions
+void Program::Run()
+    {
+    double *reg = &m_reg[0];
+    vector<long>::size_type pos;
+    for(pos = 0; pos < m_live.size(); pos++)
+        {
+        const long i = m_live[pos];
+        const Instruction &inst = m_code[i];
+        switch(inst.op)
+            {
+            case OpVar:
+                reg[i] = *inst.var;
+                break;
+            case OpNode:
+                reg[i] = inst.node->Evaluate();
+                break;
+            case OpAdd:
+                reg[i] = reg[inst.a] + reg[inst.b];
+                break;
+            case OpSub:
+                reg[i] = reg[inst.a] - reg[inst.b];
+                break;
+            case OpMul:
+                reg[i] = reg[inst.a] * reg[inst.b];
+                break;
+            case OpDiv:
+                reg[i] = reg[inst.a] / reg[inst.b];
+                break;
+            default:
+                reg[i] = Apply(inst.op, reg[inst.a], inst.b >= 0 ? reg[inst.b] : 0.0, inst.c >= 0 ? reg[inst.c] : 0.0);
+                break;
+            }
+        }
+    }
+
+// Evaluate value
+double Program::Evaluate()
+    {
+    Run();
+    return m_reg[m_result];
+    }
+
+// Derivatives of the node tree by central difference to each variable
+void Program::NodeDerivative(Node *node, unsigned int ndir, const double *seed, double *d)
+    {
+    for(unsigned int k = 0; k < ndir; k++)
+        d[k] = 0.0;
+
+    vector<double*>::size_type v;
+    for(v = 0; v < m_vars.size(); v++)
+        {
+        const double *s = &seed[v*ndir];
+        bool active = false;
+        for(unsigned int k = 0; k < ndir; k++)
+            if(s[k] != 0.0) active = true;
+        if(!active)
+            continue;
+
+        double &x = *m_vars[v];
+        const double x0 = x;
+        const double h = 1e-6*max(fabs(x0), 1e-6);
+        x = x0 + h;
+        const double fp = node->Evaluate();
+        x = x0 - h;
+        const double fm = node->Evaluate();
+        x = x0;
+
+        const double df = (fp - fm)/(2*h);
+        for(unsigned int k = 0; k < ndir; k++)
+            d[k] += df*s[k];
+        }
+    }
+
+// Evaluate value and forward derivatives
+double Program::Evaluate(unsigned int ndir, const double *seed, double *tangent)
+    {
+    Run();
+
+    const double *reg = &m_reg[0];
+    m_dreg.assign(m_code.size()*ndir, 0.0);
+
+    vector<long>::size_type pos;
+    for(pos = 0; pos < m_live.size(); pos++)
+        {
+        const long i = m_live[pos];
+        const Instruction &inst = m_code[i];
+
+        double *d = &m_dreg[i*ndir];
+        const double *da = inst.a >= 0 && inst.op != OpVar ? &m_dreg[inst.a*ndir] : 0;
+        const double *db = inst.b >= 0 ? &m_dreg[inst.b*ndir] : 0;
+        const double *dc = inst.c >= 0 ? &m_dreg[inst.c*ndir] : 0;
+        const double a = da ? reg[inst.a] : 0.0;
+        const double b = db ? reg[inst.b] : 0.0;
+        const double r = reg[i];
+
+        // partial derivatives of the result to operand a and b
+        double pa = 0.0, pb = 0.0;
+        switch(inst.op)
+            {
+            case OpVar:
+                for(unsigned int k = 0; k < ndir; k++)
+                    d[k] = seed[inst.a*ndir + k];
+                continue;
+            case OpNode:
+                NodeDerivative(inst.node, ndir, seed, d);
+                continue;
+            case OpFloor:
+            case OpCeil:
+            case OpEqual:
+            case OpAbove:
+            case OpBelow:
+                continue;
+            case OpIf:
+                {
+                const double *src = a != 0.0 ? db : dc;
+                for(unsigned int k = 0; k < ndir; k++)
+                    d[k] = src[k];
+                continue;
+                }
+            case OpMin:
+            case OpMax:
+                {
+                const double *src = r == b && r != a ? db : da;
+                for(unsigned int k = 0; k < ndir; k++)
+                    d[k] = src[k];
+                continue;
+                }
+            case OpAdd:   pa = 1.0; pb = 1.0; break;
+            case OpSub:   pa = 1.0; pb = -1.0; break;
+            case OpMul:   pa = b; pb = a; break;
+            case OpDiv:   pa = 1.0/b; pb = -r/b; break;
+            case OpNeg:   pa = -1.0; break;
+            case OpPow:
+                pa = a != 0.0 ? b*r/a : (b == 1.0 ? 1.0 : 0.0);
+                pb = a > 0.0 ? r*log(a) : 0.0;
+                break;
+            case OpAbs:   pa = a < 0.0 ? -1.0 : 1.0; break;
+            case OpSqrt:  pa = 0.5/r; break;
+            case OpSin:   pa = cos(a); break;
+            case OpCos:   pa = -sin(a); break;
+            case OpTan:   pa = 1.0 + r*r; break;
+            case OpSinh:  pa = cosh(a); break;
+            case OpCosh:  pa = sinh(a); break;
+            case OpTanh:  pa = 1.0 - r*r; break;
+            case OpAsin:  pa = 1.0/sqrt(1.0 - a*a); break;
+            case OpAcos:  pa = -1.0/sqrt(1.0 - a*a); break;
+            case OpAtan:  pa = 1.0/(1.0 + a*a); break;
+            case OpAsinh: pa = 1.0/sqrt(a*a + 1.0); break;
+            case OpAcosh: pa = 1.0/sqrt(a*a - 1.0); break;
+            case OpAtanh: pa = 1.0/(1.0 - a*a); break;
+            case OpLog10: pa = 1.0/(a*log(10.0)); break;
+            case OpLn:    pa = 1.0/a; break;
+            case OpExp:   pa = r; break;
+            case OpErf:   pa =  two_over_sqrt_pi*exp(-a*a); break;
+            case OpErfc:  pa = -two_over_sqrt_pi*exp(-a*a); break;
+            case OpAtan2: pa = b/(a*a + b*b); pb = -a/(a*a + b*b); break;
+            case OpLogn:  pa = 1.0/(a*log(b)); pb = -r/(b*log(b)); break;
+            default: break;
+            }
+
+        for(unsigned int k = 0; k < ndir; k++)
+            d[k] = pa*da[k] + (db ? pb*db[k] : 0.0);
+        }
+
+    for(unsigned int k = 0; k < ndir; k++)
+        tangent[k] = m_dreg[m_result*ndir + k];
+
+    return m_reg[m_result];
+    }
@@ -0,0 +1,104 @@
+// File:    expr_program.h
+// Purpose: Flat register based bytecode of a parsed expression
+//------------------------------------------------------------------------------
+
+
+#ifndef __EXPREVAL_PROGRAM_H
+#define __EXPREVAL_PROGRAM_H
+
+// Includes
+#include <vector>
+
+// Part of expreval namespace
+namespace ExprEval
+    {
+    // Forward declarations
+    class Node;
+
+    // Program class
+    //--------------------------------------------------------------------------
+    // The node tree is compiled into a list of instructions. Each instruction
+    // writes the register of the same index, so the program is a plain loop
+    // without recursion or virtual calls. Constant sub expressions are folded
+    // and only the instructions which contribute to the result are executed.
+    // Besides the value, the program evaluates forward mode derivatives with
+    // respect to the variables it reads. Calls into the node tree are
+    // differentiated by central difference.
+    class Program
+        {
+        public:
+            enum OpCode
+                {
+                OpConst, OpVar, OpNode,
+                OpAdd, OpSub, OpMul, OpDiv, OpNeg, OpPow,
+                OpAbs, OpSqrt, OpSin, OpCos, OpTan, OpSinh, OpCosh, OpTanh,
+                OpAsin, OpAcos, OpAtan, OpAsinh, OpAcosh, OpAtanh,
+                OpLog10, OpLn, OpExp, OpErf, OpErfc, OpFloor, OpCeil,
+                OpAtan2, OpLogn, OpMin, OpMax, OpEqual, OpAbove, OpBelow,
+                OpIf
+                };
+
+            Program();
+
+            // Clear all instructions
+            void Clear();
+
+            // Emit instructions, return the register of result
+            long Constant(double value);
+            long Variable(double *var);
+            long Fallback(Node *node);
+            long Unary(OpCode op, long a);
+            long Binary(OpCode op, long a, long b);
+            long Ternary(OpCode op, long a, long b, long c);
+
+            // The last emitted instructions gives the result, prepare the program
+            void Finish(long result);
+
+            // Program is finished and can be evaluated
+            bool IsValid() const;
+
+            // No call into node tree, derivatives are exact
+            bool IsDifferentiable() const;
+
+            // Variables read by the program
+            ::std::vector<double*>::size_type VariableCount() const;
+            double *VariableAddress(::std::vector<double*>::size_type v) const;
+
+            // Evaluate value
+            double Evaluate();
+
+            // Evaluate value and ndir forward derivatives. seed[v*ndir+k] is the
+            // derivative of variable v in direction k, result goes to tangent[k]
+            double Evaluate(unsigned int ndir, const double *seed, double *tangent);
+
+        private:
+            struct Instruction
+                {
+                OpCode op;
+                long a, b, c;
+                double value;
+                double *var;
+                Node *node;
+                };
+
+            // Compute value of one instruction
+            static double Apply(OpCode op, double a, double b, double c);
+
+            // Run all the live instructions
+            void Run();
+
+            // Derivatives of a node tree call to the variables, result goes to d[k]
+            void NodeDerivative(Node *node, unsigned int ndir, const double *seed, double *d);
+
+            ::std::vector<Instruction> m_code;
+            ::std::vector<long> m_live;
+            ::std::vector<double> m_reg;
+            ::std::vector<double> m_dreg;
+            ::std::vector<double*> m_vars;
+            long m_result;
+            bool m_differentiable;
+        };
+
+    } // namespace ExprEval
+
+#endif // __EXPREVAL_PROGRAM_H
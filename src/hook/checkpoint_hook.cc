@@ -0,0 +1,88 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include "solver_base.h"
+#include "checkpoint_hook.h"
+
+
+/*----------------------------------------------------------------------
+ * constructor
+ */
+CheckpointHook::CheckpointHook ( SolverBase & solver, const std::string & name, void * param)
+  : Hook ( solver, name ), _file_name ( SolverSpecify::out_prefix + ".chk" ), _interval ( 10 ), _count ( 0 )
+{
+  const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
+  for ( std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
+        parm_it != parm_list.end(); parm_it++ )
+  {
+    if ( parm_it->name() == "file" && parm_it->type() == Parser::STRING )
+      _file_name = parm_it->get_string();
+    if ( parm_it->name() == "interval" && parm_it->type() == Parser::INTEGER )
+      _interval = std::max ( 1, parm_it->get_int() );
+  }
+}
+
+
+/*----------------------------------------------------------------------
+ * destructor
+ */
+CheckpointHook::~CheckpointHook()
+{}
+
+
+/*----------------------------------------------------------------------
+ *   This is executed previously to each solution step.
+ */
+void CheckpointHook::pre_solve()
+{
+  if ( ++_count < _interval ) return;
+  _count = 0;
+
+  // the time step history is only updated after post_solve,
+  // here it is consistent with the solution data
+  get_solver().get_system().export_checkpoint ( _file_name );
+}
+
+
+/*----------------------------------------------------------------------
+ * This is executed after the finalization of the solver
+ */
+void CheckpointHook::on_close()
+{
+  if ( _count )
+    get_solver().get_system().export_checkpoint ( _file_name );
+  _count = 0;
+}
+
+
+#ifdef DLLHOOK
+
+// dll interface
+extern "C"
+{
+  Hook* get_hook ( SolverBase & solver, const std::string & name, void * fun_data )
+  {
+    return new CheckpointHook ( solver, name, fun_data );
+  }
+
+}
+
+#endif
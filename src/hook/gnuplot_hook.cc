@@ -23,6 +23,7 @@
 #include <ctime>
 #include <string>
 #include <cstdlib>
+#include <sstream>
 #include <iomanip>
 
 #include "config.h"
@@ -34,6 +35,7 @@
 #include "solver_base.h"
 #include "gnuplot_hook.h"
 #include "spice_ckt.h"
+#include "async_writer.h"
 #include "mxml.h"
 #include "MXMLUtil.h"
 
@@ -42,7 +44,8 @@
  */
 GnuplotHook::GnuplotHook(SolverBase & solver, const std::string & name, void * file)
     : Hook(solver, name), _input_file((const char *)file),
-    _gnuplot_file(SolverSpecify::out_prefix + ".dat"), _ddm(false), _mixA(false)
+    _gnuplot_file(SolverSpecify::out_prefix + ".dat"), _ddm(false), _mixA(false), _ensemble_branch(-1), _writer(NULL),
+    _binary(false), _n_columns(0), _n_rows(0)
 {
 
   SolverSpecify::SolverType solver_type = this->get_solver().solver_type();
@@ -67,6 +70,13 @@ GnuplotHook::GnuplotHook(SolverBase & solver, const std::string & name, void * f
   if( SolverSpecify::Type==SolverSpecify::STEADYSTATE )
     _gnuplot_file = SolverSpecify::out_prefix + ".steady.dat";
 
+  // binary records, ensemble and parareal data blocks are kept in text
+  if( SolverSpecify::out_binary && !SolverSpecify::Ensemble && !SolverSpecify::Parareal )
+  {
+    _binary = true;
+    _gnuplot_file += ".bin";
+  }
+
 
   if ( !Genius::processor_id() )
   {
@@ -76,13 +86,22 @@ GnuplotHook::GnuplotHook(SolverBase & solver, const std::string & name, void * f
     bool file_exist = ( access( _gnuplot_file.c_str(),  R_OK ) == 0 );
 #endif
 
-    if(file_exist && SolverSpecify::out_append)
+    if(_binary)
+      _open_binary_file(file_exist && SolverSpecify::out_append);
+    else if(file_exist && SolverSpecify::out_append)
+    {
+      _check_append_columns(_read_text_head());
       _out.open(_gnuplot_file.c_str(), std::ios::app);
+    }
     else
     {
       _out.open(_gnuplot_file.c_str(), std::ios::trunc);
-      _write_gnuplot_head();
+      _write_gnuplot_head(_out);
     }
+
+    // rows must not be discarded, the writer always blocks when full
+    if ( SolverSpecify::out_async )
+      _writer = new AsyncWriter(static_cast<size_t>(SolverSpecify::out_async_buffer*1024*1024), AsyncWriter::BLOCK);
   }
 
 }
@@ -93,7 +112,7 @@ GnuplotHook::GnuplotHook(SolverBase & solver, const std::string & name, void * f
  */
 GnuplotHook::~GnuplotHook()
 {
-
+  delete _writer;
 }
 
 
@@ -118,16 +137,18 @@ void GnuplotHook::pre_solve()
  */
 void GnuplotHook::post_solve()
 {
+  // bias ramp of ensemble dcsweep, not recorded
+  if ( SolverSpecify::Ensemble && SolverSpecify::Ensemble_Branch < 0 )
+    return;
 
   // save electrode IV
   // only root processor do this command
   if ( !Genius::processor_id() )
   {
-    // set the float number precision
-    _out.precision(14);
-
-    // set output width and format
-    _out<< std::scientific << std::right;
+    // values of this step
+    std::vector<double> row;
+    // the first value is written as the leading column
+    bool lead = false;
 
     if( SolverSpecify::Type==SolverSpecify::DCSWEEP       ||
         SolverSpecify::Type == SolverSpecify::STEADYSTATE ||
@@ -138,8 +159,9 @@ void GnuplotHook::post_solve()
       // if transient simulation, we need to record time
       if (SolverSpecify::Type == SolverSpecify::TRANSIENT)
       {
-        _out << SolverSpecify::clock/PhysicalUnit::s << '\t';
-        _out << std::setw(25) << SolverSpecify::dt/PhysicalUnit::s;
+        row.push_back( SolverSpecify::clock/PhysicalUnit::s );
+        row.push_back( SolverSpecify::dt/PhysicalUnit::s );
+        lead = true;
       }
 
 
@@ -148,7 +170,7 @@ void GnuplotHook::post_solve()
         const SPICE_CKT * spice_ckt = this->get_solver().get_system().get_circuit();
         for(unsigned int n=0; n<spice_ckt->n_ckt_nodes(); n++)
         {
-          _out << std::setw(25) << spice_ckt->get_solution(n);
+          row.push_back( spice_ckt->get_solution(n) );
         }
 
         const BoundaryConditionCollector * bcs = this->get_solver().get_system().get_bcs();
@@ -159,7 +181,7 @@ void GnuplotHook::post_solve()
           // electrode
           if( bc->has_current_flow() )
           {
-            _out << std::setw(25) << bc->current()/PhysicalUnit::A;
+            row.push_back( bc->current()/PhysicalUnit::A );
           }
         }
 
@@ -178,15 +200,25 @@ void GnuplotHook::post_solve()
           if( bc->is_electrode() )
           {
             //record vapp, electrode potential and electrode current
-            _out << std::setw(25) << bc->ext_circuit()->Vapp()/PhysicalUnit::V;
-            _out << std::setw(25) << bc->ext_circuit()->potential()/PhysicalUnit::V;
-            _out << std::setw(25) << bc->ext_circuit()->current()/PhysicalUnit::A;
+            row.push_back( bc->ext_circuit()->Vapp()/PhysicalUnit::V );
+            row.push_back( bc->ext_circuit()->potential()/PhysicalUnit::V );
+            row.push_back( bc->ext_circuit()->current()/PhysicalUnit::A );
 
             if( bc->bc_type() == OhmicContact )
             {
-              //_out << std::setw(25) << bc->ext_circuit()->current_displacement()/PhysicalUnit::A;
-              _out << std::setw(25) << bc->ext_circuit()->current_electron()/PhysicalUnit::A;
-              _out << std::setw(25) << bc->ext_circuit()->current_hole()/PhysicalUnit::A;
+              //row.push_back( bc->ext_circuit()->current_displacement()/PhysicalUnit::A;
+              row.push_back( bc->ext_circuit()->current_electron()/PhysicalUnit::A );
+              row.push_back( bc->ext_circuit()->current_hole()/PhysicalUnit::A );
+            }
+
+            // first order extrapolation of current to the parameter changed by delta
+            const std::vector<Real> & dI_dp = bc->ext_circuit()->current_tangent();
+            for(unsigned int k=0; k<SolverSpecify::Tangent_Parameter.size(); ++k)
+            {
+              const Real dI = k < dI_dp.size() ? dI_dp[k] : 0.0;
+              row.push_back( dI/PhysicalUnit::A );
+              if( !SolverSpecify::Tangent_Delta.empty() )
+                row.push_back( (bc->ext_circuit()->current() + dI*SolverSpecify::Tangent_Delta[k])/PhysicalUnit::A );
             }
             
             power += bc->ext_circuit()->Vapp()*bc->ext_circuit()->current();
@@ -196,31 +228,31 @@ void GnuplotHook::post_solve()
 
           if( bc->has_current_flow() )
           {
-            _out << std::setw(25) << bc->current()/PhysicalUnit::A;
+            row.push_back( bc->current()/PhysicalUnit::A );
           }
 
           if( bc->bc_type() == IF_Metal_Ohmic || bc->bc_type() == IF_Metal_Schottky)
           {
-            _out << std::setw(25) << bc->psi()/PhysicalUnit::V;
+            row.push_back( bc->psi()/PhysicalUnit::V );
           }
 
           // charge integral interface
           if( bc->bc_type() == ChargeIntegral )
           {
-            _out << std::setw(25) << bc->scalar("qf")/PhysicalUnit::C;
-            _out << std::setw(25) << bc->psi()/PhysicalUnit::V;
+            row.push_back( bc->scalar("qf")/PhysicalUnit::C );
+            row.push_back( bc->psi()/PhysicalUnit::V );
           }
 
           // current pass though homo interface
           if( _ddm && bc->bc_type() == HomoInterface)
           {
-            _out << std::setw(25) << bc->scalar("electron_current")/PhysicalUnit::A;
-            _out << std::setw(25) << bc->scalar("hole_current")/PhysicalUnit::A;
-            _out << std::setw(25) << bc->scalar("displacement_current")/PhysicalUnit::A;
+            row.push_back( bc->scalar("electron_current")/PhysicalUnit::A );
+            row.push_back( bc->scalar("hole_current")/PhysicalUnit::A );
+            row.push_back( bc->scalar("displacement_current")/PhysicalUnit::A );
           }
         }
         
-        _out<< std::setw(25) << power/(PhysicalUnit::V*PhysicalUnit::A);
+        row.push_back( power/(PhysicalUnit::V*PhysicalUnit::A) );
       }
 
     }
@@ -229,7 +261,8 @@ void GnuplotHook::post_solve()
     if( SolverSpecify::Type==SolverSpecify::ACSWEEP)
     {
       PetscScalar omega = 2*3.14159265358979323846*SolverSpecify::Freq*PhysicalUnit::s;
-      _out << SolverSpecify::Freq*PhysicalUnit::s << '\t';
+      row.push_back( SolverSpecify::Freq*PhysicalUnit::s );
+      lead = true;
 
       // search for all the bc
       const BoundaryConditionCollector * bcs = this->get_solver().get_system().get_bcs();
@@ -242,34 +275,37 @@ void GnuplotHook::post_solve()
         {
 
           // DC potential and current
-          _out << std::setw(25) << bc->ext_circuit()->potential()/PhysicalUnit::V;
-          _out << std::setw(25) << bc->ext_circuit()->current()/PhysicalUnit::A;
+          row.push_back( bc->ext_circuit()->potential()/PhysicalUnit::V );
+          row.push_back( bc->ext_circuit()->current()/PhysicalUnit::A );
 
           //record electrode potential and electrode current for AC simulation
-          _out << std::setw(25) << bc->ext_circuit()->Vac()/PhysicalUnit::V;
+          row.push_back( bc->ext_circuit()->Vac()/PhysicalUnit::V );
 
-          _out << std::setw(25) << bc->ext_circuit()->potential_ac().real()/PhysicalUnit::V;
-          _out << std::setw(25) << bc->ext_circuit()->potential_ac().imag()/PhysicalUnit::V;
+          row.push_back( bc->ext_circuit()->potential_ac().real()/PhysicalUnit::V );
+          row.push_back( bc->ext_circuit()->potential_ac().imag()/PhysicalUnit::V );
 
-          _out << std::setw(25) << bc->ext_circuit()->current_ac().real()/PhysicalUnit::A;
-          _out << std::setw(25) << bc->ext_circuit()->current_ac().imag()/PhysicalUnit::A;
+          row.push_back( bc->ext_circuit()->current_ac().real()/PhysicalUnit::A );
+          row.push_back( bc->ext_circuit()->current_ac().imag()/PhysicalUnit::A );
 
           std::complex<PetscScalar> Y;
           Y = (bc->ext_circuit()->current_ac()/PhysicalUnit::A)/(SolverSpecify::VAC/PhysicalUnit::V);
-          _out << std::setw(25) << Y.real();
-          _out << std::setw(25) << Y.imag()/omega;
+          row.push_back( Y.real() );
+          row.push_back( Y.imag()/omega );
 
           continue;
         }
 
         if( bc->has_current_flow() )
         {
-          _out << std::setw(25) << bc->current()/PhysicalUnit::A;
+          row.push_back( bc->current()/PhysicalUnit::A );
         }
       }
     }
 
-    _out << std::endl;
+    if( _binary )
+      _write_binary_row(row);
+    else
+      _write_text_row(row, lead);
 
     ////----
     {
@@ -301,14 +337,230 @@ void GnuplotHook::post_iteration()
  */
 void GnuplotHook::on_close()
 {
+  if ( _writer )
+    _writer->flush();
+
   if ( !Genius::processor_id() )
+  {
+    // all the records are in file, fix the number of rows in head
+    if ( _binary )
+    {
+      _out.seekp(_n_rows_pos);
+      _out << std::left << std::setw(_head_field_width) << _n_rows;
+    }
     _out.close();
+  }
 }
 
+/*----------------------------------------------------------------------
+ * write one row as text columns
+ */
+void GnuplotHook::_write_text_row(const std::vector<double> & row, bool lead)
+{
+  // the row is formatted here and appended to file by background writer
+  std::ostringstream row_text;
+  std::ostream & out = _writer ? static_cast<std::ostream &>(row_text) : static_cast<std::ostream &>(_out);
+
+  // set the float number precision
+  out.precision(14);
+
+  // set output width and format
+  out<< std::scientific << std::right;
+
+  // begin a new data block for each ensemble branch, gnuplot can access it by index
+  if ( SolverSpecify::Ensemble && SolverSpecify::Ensemble_Branch != _ensemble_branch )
+  {
+    _ensemble_branch = SolverSpecify::Ensemble_Branch;
+    out << "\n\n# ensemble branch " << _ensemble_branch << ' '
+         << SolverSpecify::Ensemble_Electrode << " = "
+         << SolverSpecify::Ensemble_Values[_ensemble_branch]/PhysicalUnit::V << std::endl;
+  }
+
+  // each time slice of parareal transient is a data block, merged in time order
+  if ( SolverSpecify::Parareal && _ensemble_branch < 0 )
+  {
+    _ensemble_branch = Genius::ensemble_id();
+    out << "# ensemble branch " << _ensemble_branch << " parareal time slice" << std::endl;
+  }
+
+  for(unsigned int n=0; n<row.size(); n++)
+  {
+    if( n==0 && lead )
+      out << row[n] << '\t';
+    else
+      out << std::setw(25) << row[n];
+  }
+
+  out << std::endl;
+
+  if(_writer)
+    _writer->enqueue(new AsyncWriter::TextJob(_out, row_text.str()));
+}
+
+
+
+/*----------------------------------------------------------------------
+ * write one row as fixed size binary record, the record always has
+ * the column number in file head
+ */
+void GnuplotHook::_write_binary_row(std::vector<double> & row)
+{
+  // nothing recorded for this solution type
+  if( row.empty() || !_n_columns ) return;
+  genius_assert( row.size() == _n_columns );
+
+  const char * record = reinterpret_cast<const char *>(&row[0]);
+  const size_t record_size = row.size()*sizeof(double);
+
+  if(_writer)
+    _writer->enqueue(new AsyncWriter::TextJob(_out, std::string(record, record_size)));
+  else
+  {
+    _out.write(record, record_size);
+    _out.flush();
+  }
+
+  _n_rows++;
+}
+
+
+
+/*----------------------------------------------------------------------
+ * open binary file. the file head is the text head with '#' lines,
+ * followed by the fixed width fields of columns, rows and data offset.
+ * the data is rows of float64 records in native byte order, i.e. gnuplot reads
+ * it by  binary skip=<data offset> format='%<columns>float64'
+ */
+void GnuplotHook::_open_binary_file(bool append)
+{
+  if( append && _read_binary_head() )
+  {
+    _check_append_columns(_n_columns);
+
+    // overwrite the incomplete record left by a killed run
+    _out.open(_gnuplot_file.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    _out.seekp(_data_pos + static_cast<std::streamoff>(_n_rows*_n_columns*sizeof(double)));
+    return;
+  }
+
+  _out.open(_gnuplot_file.c_str(), std::ios::trunc | std::ios::binary);
+  _n_columns = _write_gnuplot_head(_out);
+  _n_rows = 0;
+
+  _out << "# Binary: float64" << std::endl;
+  _out << "# Columns: " << std::left << std::setw(_head_field_width) << _n_columns << std::endl;
+  _out << "# Rows: ";
+  _n_rows_pos = _out.tellp();
+  _out << std::left << std::setw(_head_field_width) << 0 << std::endl;
+  _out << "# Data offset: ";
+  std::streampos offset_pos = _out.tellp();
+  _out << std::left << std::setw(_head_field_width) << 0 << std::endl;
+
+  // align the records to 8 bytes
+  while( _out.tellp() % 8 != 7 ) _out << '#';
+  _out << '\n';
+
+  _data_pos = _out.tellp();
+  _out.seekp(offset_pos);
+  _out << std::left << std::setw(_head_field_width) << static_cast<long>(_data_pos);
+  _out.seekp(_data_pos);
+  _out.flush();
+}
+
+
+
+/*----------------------------------------------------------------------
+ * read the head of an existing binary file, the number of complete records
+ * is computed from file size. return false if it is not a valid binary file
+ */
+bool GnuplotHook::_read_binary_head()
+{
+  std::ifstream in(_gnuplot_file.c_str(), std::ios::binary);
+  if( !in.good() ) return false;
+
+  bool has_rows = false;
+  long offset = -1;
+  std::string line;
+  while( in.peek() == '#' )
+  {
+    std::streampos line_pos = in.tellg();
+    std::getline(in, line);
+
+    if( line.find("# Columns: ") == 0 )
+      _n_columns = atoi(line.substr(11).c_str());
+    else if( line.find("# Rows: ") == 0 )
+    {
+      _n_rows_pos = line_pos + static_cast<std::streamoff>(8);
+      has_rows = true;
+    }
+    else if( line.find("# Data offset: ") == 0 )
+    {
+      offset = atol(line.substr(15).c_str());
+      break;
+    }
+  }
+
+  if( !has_rows || offset < 0 || !_n_columns ) return false;
+
+  in.seekg(0, std::ios::end);
+  long size = static_cast<long>(in.tellg());
+  if( size < offset ) return false;
+
+  _data_pos = offset;
+  _n_rows = (size - offset)/(_n_columns*sizeof(double));
+  return true;
+}
+
+
+
+/*----------------------------------------------------------------------
+ * count the variables in the head of an existing text file
+ */
+unsigned int GnuplotHook::_read_text_head()
+{
+  std::ifstream in(_gnuplot_file.c_str());
+
+  unsigned int n_columns = 0;
+  std::string line;
+  while( std::getline(in, line) )
+  {
+    // the head is '#' lines with empty lines between them
+    if( line.empty() ) continue;
+    if( line[0] != '#' ) break;
+    // variables are written as '#' <tab> index <tab> name
+    if( line.size() > 1 && line[1] == '\t' )
+      n_columns++;
+  }
+  return n_columns;
+}
+
+
+
+/*----------------------------------------------------------------------
+ * appended rows must have the columns of existing file, which is not true
+ * when electrodes or recorded quantities changed since the file was written
+ */
+void GnuplotHook::_check_append_columns(unsigned int n_file_columns)
+{
+  std::ostringstream head;
+  unsigned int n_columns = _write_gnuplot_head(head);
+  // nothing to append for this solution type
+  if( n_columns && n_columns != n_file_columns )
+  {
+    MESSAGE<<"ERROR: Can't append to " << _gnuplot_file << ", it has " << n_file_columns
+           << " columns but this solution records " << n_columns << " columns." << std::endl; RECORD();
+    genius_error();
+  }
+}
+
+
+
 //----------------------------------------------------------------------
 
-void  GnuplotHook::_write_gnuplot_head()
+unsigned int GnuplotHook::_write_gnuplot_head(std::ostream & out)
 {
+  unsigned int n_columns = 0;
+
 
   // prepare the file head
   // only root processor do this command
@@ -320,39 +572,42 @@ void  GnuplotHook::_write_gnuplot_head()
     time(&_time);
 
     // write file head
-    _out << "# Title: Gnuplot File Created by Genius TCAD Simulation" << std::endl;
-    _out << "# Date: " << ctime(&_time) << std::endl;
+    out << "# Title: Gnuplot File Created by Genius TCAD Simulation" << std::endl;
+    out << "# Date: " << ctime(&_time) << std::endl;
 
     switch (SolverSpecify::Type)
     {
       case SolverSpecify::DCSWEEP   :
-        _out << "# Plotname: DC transfer characteristic" << std::endl; break;
+        out << "# Plotname: DC transfer characteristic" << std::endl; break;
       case SolverSpecify::OP   :
-        _out << "# Plotname: OP" << std::endl; break;
+        out << "# Plotname: OP" << std::endl; break;
       case SolverSpecify::TRACE     :
-        _out << "# Plotname: DC curve trace" << std::endl; break;
+        out << "# Plotname: DC curve trace" << std::endl; break;
       case SolverSpecify::TRANSIENT :
-        _out << "# Plotname: Transient Analysis" << std::endl; break;
+        out << "# Plotname: Transient Analysis" << std::endl; break;
+      case SolverSpecify::PSS       :
+        out << "# Plotname: Periodic Steady-State" << std::endl; break;
       case SolverSpecify::ACSWEEP   :
-        _out << "# Plotname: AC small signal Analysis" << std::endl; break;
+        out << "# Plotname: AC small signal Analysis" << std::endl; break;
         default: break;
     }
 
     // write variables
-    _out << "# Variables: " << std::endl;
+    out << "# Variables: " << std::endl;
 
     if( SolverSpecify::Type==SolverSpecify::DCSWEEP       ||
         SolverSpecify::Type == SolverSpecify::STEADYSTATE ||
         SolverSpecify::Type == SolverSpecify::OP          ||
         SolverSpecify::Type==SolverSpecify::TRACE         ||
-        SolverSpecify::Type==SolverSpecify::TRANSIENT )
+        SolverSpecify::Type==SolverSpecify::TRANSIENT     ||
+        SolverSpecify::Type==SolverSpecify::PSS )
     {
       unsigned int n_var = 0;
-      // if transient simulation, we need to record time
-      if ( SolverSpecify::Type == SolverSpecify::TRANSIENT )
+      // if transient simulation, we need to record time. PSS records its last period as transient
+      if ( SolverSpecify::Type == SolverSpecify::TRANSIENT || SolverSpecify::Type == SolverSpecify::PSS )
       {
-        _out << '#' <<'\t' << ++n_var <<'\t' << "Time" << " [s]"<< std::endl;
-        _out << '#' <<'\t' << ++n_var <<'\t' << "TimeStep" << " [s]"<< std::endl;
+        out << '#' <<'\t' << ++n_var <<'\t' << "Time" << " [s]"<< std::endl;
+        out << '#' <<'\t' << ++n_var <<'\t' << "TimeStep" << " [s]"<< std::endl;
       }
 
       if( _mixA ) // mix mode
@@ -365,9 +620,9 @@ void  GnuplotHook::_write_gnuplot_head()
           std::string electrode = spice_ckt->ckt_node_name(n);
 
           if(spice_ckt->is_voltage_node(n))
-            _out << '#' <<'\t' << ++n_var <<'\t' << "V(" + electrode + ")"  << " [V]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "V(" + electrode + ")"  << " [V]"<< std::endl;
           else
-            _out << '#' <<'\t' << ++n_var <<'\t' << "I(" + electrode + ")"  << " [A]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "I(" + electrode + ")"  << " [A]"<< std::endl;
         }
 
         // record electrode IV information
@@ -382,7 +637,7 @@ void  GnuplotHook::_write_gnuplot_head()
             std::string bc_label = bc->label();
             if(!bc->electrode_label().empty())
               bc_label = bc->electrode_label() + '[' + bc_label + ']';
-            _out << '#' <<'\t' << ++n_var <<'\t' << "I(" + bc_label + ")"   << " [A]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "I(" + bc_label + ")"   << " [A]"<< std::endl;
           }
         }
       }
@@ -402,15 +657,24 @@ void  GnuplotHook::_write_gnuplot_head()
             if(!bc->electrode_label().empty())
               bc_label = bc->electrode_label() + '[' + bc_label + ']';
 
-            _out << '#' <<'\t' << ++n_var <<'\t' << "Vapp(" + bc_label + ")"  << " [V]"<< std::endl;
-            _out << '#' <<'\t' << ++n_var <<'\t' << "P(" + bc_label + ")"     << " [V]"<< std::endl;
-            _out << '#' <<'\t' << ++n_var <<'\t' << "I(" + bc_label + ")"     << " [A]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "Vapp(" + bc_label + ")"  << " [V]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "P(" + bc_label + ")"     << " [V]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "I(" + bc_label + ")"     << " [A]"<< std::endl;
 
             if( bc->bc_type() == OhmicContact )
             {
-              //_out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_displacement_current"   << " [A]"<< std::endl;
-              _out << '#' <<'\t' << ++n_var <<'\t' << "Ie(" + bc_label + ")"   << " [A]"<< std::endl;
-              _out << '#' <<'\t' << ++n_var <<'\t' << "Ih(" + bc_label + ")"   << " [A]"<< std::endl;
+              //out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_displacement_current"   << " [A]"<< std::endl;
+              out << '#' <<'\t' << ++n_var <<'\t' << "Ie(" + bc_label + ")"   << " [A]"<< std::endl;
+              out << '#' <<'\t' << ++n_var <<'\t' << "Ih(" + bc_label + ")"   << " [A]"<< std::endl;
+            }
+
+            // current derivative of each tangent parameter, and the extrapolated current
+            for(unsigned int k=0; k<SolverSpecify::Tangent_Parameter.size(); ++k)
+            {
+              const std::string & p_label = SolverSpecify::Tangent_Parameter[k];
+              out << '#' <<'\t' << ++n_var <<'\t' << "dI(" + bc_label + ")/d(" + p_label + ")" << " [A/unit]"<< std::endl;
+              if( !SolverSpecify::Tangent_Delta.empty() )
+                out << '#' <<'\t' << ++n_var <<'\t' << "I(" + bc_label + ")@(" + p_label + ")" << " [A]"<< std::endl;
             }
 
             continue;
@@ -419,42 +683,43 @@ void  GnuplotHook::_write_gnuplot_head()
           if( bc->has_current_flow() )
           {
             std::string bc_label = bc->label();
-            _out << '#' <<'\t' << ++n_var <<'\t' << "I(" + bc_label + ")"   << " [A]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "I(" + bc_label + ")"   << " [A]"<< std::endl;
           }
 
           if( bc->bc_type() == IF_Metal_Ohmic || bc->bc_type() == IF_Metal_Schottky)
           {
             std::string bc_label = bc->label();
-            _out << '#' <<'\t' << ++n_var <<'\t' << "V(" + bc_label + ")"   << " [V]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "V(" + bc_label + ")"   << " [V]"<< std::endl;
           }
 
           // charge integral interface
           if( bc->bc_type() == ChargeIntegral )
           {
             std::string bc_label = bc->label();
-            _out << '#' <<'\t' << ++n_var <<'\t' << "Q(" + bc_label + ")"          << " [C]"<< std::endl;
-            _out << '#' <<'\t' << ++n_var <<'\t' << "V(" + bc_label + ")"  << " [V]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "Q(" + bc_label + ")"          << " [C]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "V(" + bc_label + ")"  << " [V]"<< std::endl;
           }
 
           if( _ddm && bc->bc_type() == HomoInterface)
           {
             std::string bc_label = bc->label();
-            _out << '#' <<'\t' << ++n_var <<'\t' << "Ie(" + bc_label + ")"   << " [A]"<< std::endl;
-            _out << '#' <<'\t' << ++n_var <<'\t' << "Ih(" + bc_label + ")"   << " [A]"<< std::endl;
-            _out << '#' <<'\t' << ++n_var <<'\t' << "Idisp(" + bc_label + ")"   << " [A]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "Ie(" + bc_label + ")"   << " [A]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "Ih(" + bc_label + ")"   << " [A]"<< std::endl;
+            out << '#' <<'\t' << ++n_var <<'\t' << "Idisp(" + bc_label + ")"   << " [A]"<< std::endl;
           }
         }
         
-        _out << '#' <<'\t' << ++n_var <<'\t' << "Power" << " [W]"<< std::endl;
+        out << '#' <<'\t' << ++n_var <<'\t' << "Power" << " [W]"<< std::endl;
       }
 
+      n_columns = n_var;
     }
 
     if( SolverSpecify::Type==SolverSpecify::ACSWEEP)
     {
       unsigned int n_var = 0;
 
-      _out << '#' <<'\t' << ++n_var <<'\t' << "frequency" << " [Hz]"<< std::endl;
+      out << '#' <<'\t' << ++n_var <<'\t' << "frequency" << " [Hz]"<< std::endl;
 
       // record electrode IV information
       const BoundaryConditionCollector * bcs = this->get_solver().get_system().get_bcs();
@@ -473,20 +738,20 @@ void  GnuplotHook::_write_gnuplot_head()
           if(!bc->electrode_label().empty())
             bc_label = bc->electrode_label() + '[' + bc_label + ']';
           // DC
-          _out << '#' <<'\t' << ++n_var <<'\t' << "Vdc(" + bc_label + ")" << " [V]"<< std::endl;
-          _out << '#' <<'\t' << ++n_var <<'\t' << "Idc(" + bc_label + ")" << " [A]"<< std::endl;
+          out << '#' <<'\t' << ++n_var <<'\t' << "Vdc(" + bc_label + ")" << " [V]"<< std::endl;
+          out << '#' <<'\t' << ++n_var <<'\t' << "Idc(" + bc_label + ")" << " [A]"<< std::endl;
 
           // AC
-          _out << '#' <<'\t' << ++n_var <<'\t' << "Vac(" + bc_label + ")" << " [V]"<< std::endl;
+          out << '#' <<'\t' << ++n_var <<'\t' << "Vac(" + bc_label + ")" << " [V]"<< std::endl;
 
-          _out << '#' <<'\t' << ++n_var <<'\t' << "Pac.real(" + bc_label + ")" << " [V]"<< std::endl;
-          _out << '#' <<'\t' << ++n_var <<'\t' << "Pac.imag(" + bc_label + ")" << " [V]"<< std::endl;
+          out << '#' <<'\t' << ++n_var <<'\t' << "Pac.real(" + bc_label + ")" << " [V]"<< std::endl;
+          out << '#' <<'\t' << ++n_var <<'\t' << "Pac.imag(" + bc_label + ")" << " [V]"<< std::endl;
 
-          _out << '#' <<'\t' << ++n_var <<'\t' << "Iac.real(" + bc_label + ")" << " [A]"<< std::endl;
-          _out << '#' <<'\t' << ++n_var <<'\t' << "Iac.imag(" + bc_label + ")" << " [A]"<< std::endl;
+          out << '#' <<'\t' << ++n_var <<'\t' << "Iac.real(" + bc_label + ")" << " [A]"<< std::endl;
+          out << '#' <<'\t' << ++n_var <<'\t' << "Iac.imag(" + bc_label + ")" << " [A]"<< std::endl;
 
-          _out << '#' <<'\t' << ++n_var <<'\t' << "G(" + ac_bc_label + ',' +bc_label   << ") [S]"<< std::endl;
-          _out << '#' <<'\t' << ++n_var <<'\t' << "C(" + ac_bc_label + ',' +bc_label   << ") [F]"<< std::endl;
+          out << '#' <<'\t' << ++n_var <<'\t' << "G(" + ac_bc_label + ',' +bc_label   << ") [S]"<< std::endl;
+          out << '#' <<'\t' << ++n_var <<'\t' << "C(" + ac_bc_label + ',' +bc_label   << ") [F]"<< std::endl;
 
           continue;
         }
@@ -494,15 +759,18 @@ void  GnuplotHook::_write_gnuplot_head()
         if( bc->has_current_flow() )
         {
           std::string bc_label = bc->label();
-          _out << '#' <<'\t' << ++n_var <<'\t' << "Idc(" + bc_label + ")"   << " [A]"<< std::endl;
+          out << '#' <<'\t' << ++n_var <<'\t' << "Idc(" + bc_label + ")"   << " [A]"<< std::endl;
         }
       }
+
+      n_columns = n_var;
     }
 
-    _out << std::endl;
+    out << std::endl;
 
   }
 
+  return n_columns;
 }
 
 
@@ -0,0 +1,505 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <cstring>
+#include <algorithm>
+
+#include "mesh_base.h"
+#include "solver_base.h"
+#include "hdf5_hook.h"
+#include "parallel.h"
+#include "CogendaHDF5.h"
+
+using PhysicalUnit::um;
+using PhysicalUnit::s;
+using PhysicalUnit::V;
+using PhysicalUnit::A;
+
+
+#ifdef HAVE_HDF5
+
+namespace
+{
+  /**
+   * round the mantissa of v to bits, the trailing zero bits compress well
+   */
+  float truncate_mantissa(float v, unsigned int bits)
+  {
+    if( bits == 0 || bits >= 23 ) return v;
+    unsigned int u;
+    std::memcpy(&u, &v, sizeof(u));
+    if( (u & 0x7f800000u) == 0x7f800000u ) return v; // inf or nan
+    const unsigned int drop = 23 - bits;
+    u += (1u << (drop-1));
+    u &= ~((1u << drop) - 1);
+    std::memcpy(&v, &u, sizeof(u));
+    return v;
+  }
+
+  double truncate_mantissa(double v, unsigned int bits)
+  {
+    if( bits == 0 || bits >= 52 ) return v;
+    unsigned long long u;
+    std::memcpy(&u, &v, sizeof(u));
+    if( (u & 0x7ff0000000000000ULL) == 0x7ff0000000000000ULL ) return v; // inf or nan
+    const unsigned int drop = 52 - bits;
+    u += (1ULL << (drop-1));
+    u &= ~((1ULL << drop) - 1);
+    std::memcpy(&v, &u, sizeof(u));
+    return v;
+  }
+
+  /**
+   * encode value into buf, update the reconstructed last value
+   */
+  template <typename T>
+  void encode(const std::vector<double> &value, std::vector<double> &last, unsigned int bits, std::vector<T> &buf)
+  {
+    buf.resize(value.size());
+    for(unsigned int n=0; n<value.size(); ++n)
+    {
+      buf[n] = truncate_mantissa(static_cast<T>(value[n] - last[n]), bits);
+      last[n] += static_cast<double>(buf[n]);
+    }
+  }
+
+  /**
+   * write a 1D (cols=1) or 2D array as a chunked dataset
+   */
+  template <typename T>
+  void write_array(hid_t grp, const std::string &name, const std::vector<T> &data, hsize_t cols, unsigned int compress)
+  {
+    hsize_t dims[2] = { data.size()/cols, cols };
+    int rank = cols > 1 ? 2 : 1;
+    hid_t dspace = H5Screate_simple(rank, dims, NULL);
+    hid_t plist = H5Pcreate(H5P_DATASET_CREATE);
+    if( !data.empty() && compress )
+    {
+      H5Pset_chunk(plist, rank, dims);
+      H5Pset_shuffle(plist);
+      H5Pset_deflate(plist, compress);
+    }
+    hid_t dset = H5Dcreate(grp, name.c_str(), CogendaHDF5::getHDF5MemType<T>(), dspace, H5P_DEFAULT, plist, H5P_DEFAULT);
+    if( !data.empty() )
+      H5Dwrite(dset, CogendaHDF5::getHDF5MemType<T>(), H5S_ALL, H5S_ALL, H5P_DEFAULT, &data[0]);
+    H5Dclose(dset);
+    H5Pclose(plist);
+    H5Sclose(dspace);
+  }
+}
+
+#endif
+
+
+/*----------------------------------------------------------------------
+ * constructor, open the file for writing
+ */
+HDF5Hook::HDF5Hook ( SolverBase & solver, const std::string & name, void * param)
+  : Hook ( solver, name ), _file_name ( SolverSpecify::out_prefix + ".h5" ),
+    _double ( false ), _bits ( 0 ), _delta ( false ), _keyframe ( 16 ), _compress ( 4 ), _chunk ( 65536 ),
+    _step ( 0 ), _t_start ( 0 ), _t_stop ( std::numeric_limits<double>::infinity() ), _t_step ( 0 ), _t_last ( 0 )
+{
+  const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
+  for ( std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
+        parm_it != parm_list.end(); parm_it++ )
+  {
+    if ( parm_it->name() == "file" && parm_it->type() == Parser::STRING )
+      _file_name = parm_it->get_string();
+    if ( parm_it->name() == "variable" && parm_it->type() == Parser::STRING )
+      _node_variables.push_back ( parm_it->get_string() );
+    if ( parm_it->name() == "cellvariable" && parm_it->type() == Parser::STRING )
+      _cell_variables.push_back ( parm_it->get_string() );
+    if ( parm_it->name() == "precision" && parm_it->type() == Parser::STRING )
+      _double = ( parm_it->get_string() == "double" );
+    if ( parm_it->name() == "bits" && parm_it->type() == Parser::INTEGER )
+      _bits = std::max ( 0, parm_it->get_int() );
+    if ( parm_it->name() == "delta" && parm_it->type() == Parser::BOOL )
+      _delta = parm_it->get_bool();
+    if ( parm_it->name() == "keyframe" && parm_it->type() == Parser::INTEGER )
+      _keyframe = std::max ( 1, parm_it->get_int() );
+    if ( parm_it->name() == "compress" && parm_it->type() == Parser::INTEGER )
+      _compress = std::min ( 9, std::max ( 0, parm_it->get_int() ) );
+    if ( parm_it->name() == "chunk" && parm_it->type() == Parser::INTEGER )
+      _chunk = std::max ( 1, parm_it->get_int() );
+
+    if ( parm_it->name() == "tstep" && parm_it->type() == Parser::REAL )
+      _t_step=parm_it->get_real() * PhysicalUnit::s;
+    if ( parm_it->name() == "tstart" && parm_it->type() == Parser::REAL )
+      _t_start=parm_it->get_real() * PhysicalUnit::s;
+    if ( parm_it->name() == "tstop" && parm_it->type() == Parser::REAL )
+      _t_stop=parm_it->get_real() * PhysicalUnit::s;
+  }
+
+  // the primary solution variables by default
+  if ( _node_variables.empty() )
+  {
+    _node_variables.push_back ( "potential" );
+    _node_variables.push_back ( "electron" );
+    _node_variables.push_back ( "hole" );
+  }
+
+#ifdef HAVE_HDF5
+  _file = -1;
+  if ( Genius::processor_id() == 0 )
+  {
+    _file = H5Fcreate ( _file_name.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT );
+    if ( _file < 0 )
+    {
+      MESSAGE<<"ERROR: HDF5 hook can't create file "<<_file_name<<"."<<std::endl; RECORD();
+      genius_error();
+    }
+  }
+#else
+  MESSAGE<<"Warning: HDF5 hook requires Genius built with HDF5, no output will be written."<<std::endl; RECORD();
+#endif
+
+  _write_mesh();
+}
+
+
+/*----------------------------------------------------------------------
+ * destructor, close file
+ */
+HDF5Hook::~HDF5Hook()
+{
+#ifdef HAVE_HDF5
+  if ( _file >= 0 ) H5Fclose ( _file );
+#endif
+}
+
+
+/*----------------------------------------------------------------------
+ *   This is executed before the initialization of the solver
+ */
+void HDF5Hook::on_init()
+{}
+
+
+
+/*----------------------------------------------------------------------
+ *   This is executed previously to each solution step.
+ */
+void HDF5Hook::pre_solve()
+{}
+
+
+
+/*----------------------------------------------------------------------
+ *  This is executed after each solution step.
+ */
+void HDF5Hook::post_solve()
+{
+  if ( SolverSpecify::Type==SolverSpecify::TRANSIENT )
+  {
+    // restart
+    if ( SolverSpecify::clock < this->_t_last ) this->_t_last = SolverSpecify::clock;
+
+    if ( SolverSpecify::clock < _t_start || SolverSpecify::clock > _t_stop ) return;
+    if ( SolverSpecify::clock - this->_t_last < this->_t_step ) return;
+
+    _write_step ( SolverSpecify::clock/s );
+    _t_last = SolverSpecify::clock;
+    return;
+  }
+
+  if ( SolverSpecify::Type==SolverSpecify::DCSWEEP && SolverSpecify::Electrode_VScan.size() )
+  {
+    _write_step ( SolverSpecify::Electrode_VScan_Voltage/V );
+    return;
+  }
+
+  if ( SolverSpecify::Type==SolverSpecify::DCSWEEP && SolverSpecify::Electrode_IScan.size() )
+  {
+    _write_step ( SolverSpecify::Electrode_IScan_Current/A );
+    return;
+  }
+
+  _write_step ( _step );
+}
+
+
+
+/*----------------------------------------------------------------------
+ *  This is executed after each (nonlinear) iteration
+ */
+void HDF5Hook::post_iteration()
+{}
+
+
+
+/*----------------------------------------------------------------------
+ * This is executed after the finalization of the solver
+ */
+void HDF5Hook::on_close()
+{
+#ifdef HAVE_HDF5
+  if ( _file >= 0 )
+  {
+    CogendaHDF5::setAttribute<unsigned int> ( _file, "steps", _step );
+    H5Fclose ( _file );
+    _file = -1;
+  }
+#endif
+}
+
+
+
+void HDF5Hook::_write_mesh()
+{
+  const SimulationSystem &system = get_solver().get_system();
+  const MeshBase & mesh = system.mesh();
+
+  // allgather mesh, parallel code
+  std::vector<Real> pts;
+  mesh.pack_nodes ( pts );
+  std::vector<int> elems;
+  mesh.pack_elems ( elems );
+
+  std::vector< std::vector<unsigned int> > region_nodes ( system.n_regions() );
+  std::vector< std::vector<unsigned int> > region_cells ( system.n_regions() );
+  for ( unsigned int r=0; r<system.n_regions(); ++r )
+  {
+    const SimulationRegion * region = system.region ( r );
+    region->region_node ( region_nodes[r] );
+
+    // the same order as cell based variable data
+    for ( unsigned int n=0; n<region->n_cell(); ++n )
+      if ( region->get_region_elem ( n )->on_processor() )
+        region_cells[r].push_back ( region->get_region_elem ( n )->id() );
+    Parallel::allgather ( region_cells[r] );
+    std::sort ( region_cells[r].begin(), region_cells[r].end() );
+  }
+
+#ifdef HAVE_HDF5
+  if ( _file < 0 ) return;
+
+  CogendaHDF5::setAttribute<std::string> ( _file, CogendaHDF5::ATTR_fullname, "Genius field time series" );
+  CogendaHDF5::setAttribute<unsigned int> ( _file, "dimension", mesh.mesh_dimension() );
+  CogendaHDF5::setAttribute<std::string> ( _file, "encoding", _delta ? "delta" : "plain" );
+  CogendaHDF5::setAttribute<unsigned int> ( _file, "keyframe", _delta ? _keyframe : 1 );
+  CogendaHDF5::setAttribute<unsigned int> ( _file, "bits", _bits );
+
+  hid_t mesh_grp = H5Gcreate ( _file, "mesh", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT );
+  for ( unsigned int n=0; n<pts.size(); ++n ) pts[n] /= um;
+  write_array ( mesh_grp, "nodes", pts, 3, _compress );
+  write_array ( mesh_grp, "elems", elems, 1, _compress );
+  H5Gclose ( mesh_grp );
+
+  hid_t regions_grp = H5Gcreate ( _file, "region", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT );
+  for ( unsigned int r=0; r<system.n_regions(); ++r )
+  {
+    const SimulationRegion * region = system.region ( r );
+    hid_t region_grp = H5Gcreate ( regions_grp, region->name().c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT );
+    CogendaHDF5::setAttribute<std::string> ( region_grp, "material", region->material() );
+
+    hid_t node_grp = H5Gcreate ( region_grp, "node", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT );
+    write_array ( node_grp, "id", region_nodes[r], 1, _compress );
+    H5Gclose ( node_grp );
+
+    hid_t cell_grp = H5Gcreate ( region_grp, "cell", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT );
+    write_array ( cell_grp, "id", region_cells[r], 1, _compress );
+    H5Gclose ( cell_grp );
+
+    H5Gclose ( region_grp );
+  }
+  H5Gclose ( regions_grp );
+#endif
+}
+
+
+
+void HDF5Hook::_write_step(double axis)
+{
+  const SimulationSystem &system = get_solver().get_system();
+
+  for ( unsigned int r=0; r<system.n_regions(); ++r )
+  {
+    const SimulationRegion * region = system.region ( r );
+
+    for ( unsigned int loc=0; loc<2; ++loc )
+    {
+      const std::vector<std::string> & variables = loc ? _cell_variables : _node_variables;
+      DataLocation location = loc ? CELL_CENTER : POINT_CENTER;
+
+      for ( unsigned int n=0; n<variables.size(); ++n )
+      {
+        std::string variable = FormatVariableString ( variables[n] );
+        SimulationVariable v;
+        if ( !region->get_variable ( variable, location, v ) ) continue;
+        if ( v.variable_data_type != SCALAR ) continue;
+
+        // sync field data between all the processor, must executed in parallel!
+        std::vector<Real> value;
+        region->get_variable_data<Real> ( variable, location, value );
+
+#ifdef HAVE_HDF5
+        if ( _file >= 0 )
+          _append ( "/region/" + region->name() + ( loc ? "/cell" : "/node" ), variables[n], v.variable_unit_string, value );
+#endif
+      }
+    }
+  }
+
+#ifdef HAVE_HDF5
+  if ( _file >= 0 )
+  {
+    _append_axis ( axis );
+    // keep the file readable when the simulation is interrupted
+    H5Fflush ( _file, H5F_SCOPE_LOCAL );
+  }
+#endif
+
+  _step++;
+}
+
+
+#ifdef HAVE_HDF5
+
+void HDF5Hook::_append(const std::string &group, const std::string &variable, const std::string &unit, const std::vector<double> &value)
+{
+  if ( value.empty() ) return;
+
+  const std::string path = group + "/" + variable;
+  const hsize_t n_value = value.size();
+  hid_t mem_type = _double ? H5T_NATIVE_DOUBLE : H5T_NATIVE_FLOAT;
+
+  hid_t dset;
+  if ( H5Lexists ( _file, path.c_str(), H5P_DEFAULT ) > 0 )
+    dset = H5Dopen ( _file, path.c_str(), H5P_DEFAULT );
+  else
+  {
+    hsize_t dims[2] = { 0, n_value };
+    hsize_t max_dims[2] = { H5S_UNLIMITED, n_value };
+    hsize_t chunk[2] = { 1, std::min<hsize_t> ( n_value, _chunk ) };
+
+    hid_t dspace = H5Screate_simple ( 2, dims, max_dims );
+    hid_t plist = H5Pcreate ( H5P_DATASET_CREATE );
+    H5Pset_chunk ( plist, 2, chunk );
+    if ( _compress )
+    {
+      H5Pset_shuffle ( plist );
+      H5Pset_deflate ( plist, _compress );
+    }
+    dset = H5Dcreate ( _file, path.c_str(), mem_type, dspace, H5P_DEFAULT, plist, H5P_DEFAULT );
+    H5Pclose ( plist );
+    H5Sclose ( dspace );
+
+    CogendaHDF5::setAttribute<std::string> ( dset, "unit", unit );
+    // the variable may appear later than the axis
+    CogendaHDF5::setAttribute<unsigned int> ( dset, "first_step", _step );
+  }
+
+  // row 0 and each keyframe are full value, others are the difference to the last row
+  std::vector<double> & last = _last_value[path];
+  if ( !_delta || last.size() != value.size() || _step%_keyframe == 0 )
+    last.assign ( value.size(), 0.0 );
+
+  // extend dataset by one row
+  hid_t fspace = H5Dget_space ( dset );
+  hsize_t dims[2];
+  H5Sget_simple_extent_dims ( fspace, dims, NULL );
+  H5Sclose ( fspace );
+
+  hsize_t row = dims[0];
+  dims[0] = row + 1;
+  H5Dset_extent ( dset, dims );
+
+  fspace = H5Dget_space ( dset );
+  hsize_t start[2] = { row, 0 };
+  hsize_t count[2] = { 1, n_value };
+  H5Sselect_hyperslab ( fspace, H5S_SELECT_SET, start, NULL, count, NULL );
+  hid_t mspace = H5Screate_simple ( 1, &n_value, NULL );
+
+  if ( _double )
+  {
+    std::vector<double> buf;
+    encode ( value, last, _bits, buf );
+    H5Dwrite ( dset, mem_type, mspace, fspace, H5P_DEFAULT, &buf[0] );
+  }
+  else
+  {
+    std::vector<float> buf;
+    encode ( value, last, _bits, buf );
+    H5Dwrite ( dset, mem_type, mspace, fspace, H5P_DEFAULT, &buf[0] );
+  }
+
+  H5Sclose ( mspace );
+  H5Sclose ( fspace );
+  H5Dclose ( dset );
+}
+
+
+
+void HDF5Hook::_append_axis(double value)
+{
+  hid_t dset;
+  if ( H5Lexists ( _file, "axis", H5P_DEFAULT ) > 0 )
+    dset = H5Dopen ( _file, "axis", H5P_DEFAULT );
+  else
+  {
+    hsize_t dims[1] = { 0 };
+    hsize_t max_dims[1] = { H5S_UNLIMITED };
+    hsize_t chunk[1] = { 1024 };
+    hid_t dspace = H5Screate_simple ( 1, dims, max_dims );
+    hid_t plist = H5Pcreate ( H5P_DATASET_CREATE );
+    H5Pset_chunk ( plist, 1, chunk );
+    dset = H5Dcreate ( _file, "axis", H5T_NATIVE_DOUBLE, dspace, H5P_DEFAULT, plist, H5P_DEFAULT );
+    H5Pclose ( plist );
+    H5Sclose ( dspace );
+
+    std::string axis = "step";
+    if ( SolverSpecify::Type==SolverSpecify::TRANSIENT ) axis = "time [s]";
+    else if ( SolverSpecify::Type==SolverSpecify::DCSWEEP && SolverSpecify::Electrode_VScan.size() ) axis = "voltage [V]";
+    else if ( SolverSpecify::Type==SolverSpecify::DCSWEEP && SolverSpecify::Electrode_IScan.size() ) axis = "current [A]";
+    CogendaHDF5::setAttribute<std::string> ( dset, "unit", axis );
+  }
+
+  hsize_t dims[1] = { _step + 1 };
+  H5Dset_extent ( dset, dims );
+
+  hid_t fspace = H5Dget_space ( dset );
+  hsize_t start[1] = { _step };
+  hsize_t count[1] = { 1 };
+  H5Sselect_hyperslab ( fspace, H5S_SELECT_SET, start, NULL, count, NULL );
+  hid_t mspace = H5Screate_simple ( 1, count, NULL );
+  H5Dwrite ( dset, H5T_NATIVE_DOUBLE, mspace, fspace, H5P_DEFAULT, &value );
+
+  H5Sclose ( mspace );
+  H5Sclose ( fspace );
+  H5Dclose ( dset );
+}
+
+#endif
+
+
+#ifdef DLLHOOK
+
+// dll interface
+extern "C"
+{
+  Hook* get_hook ( SolverBase & solver, const std::string & name, void * fun_data )
+  {
+    return new HDF5Hook ( solver, name, fun_data );
+  }
+
+}
+
+#endif
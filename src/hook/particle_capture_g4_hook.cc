@@ -647,9 +647,10 @@ void ParticleCaptureG4Hook::process_particle_dose_octree()
   build_tracks();
   if(tracks.empty()) return;
 
-  unsigned int bin_size = tracks.size()/Genius::n_processors();
-  unsigned int begin = bin_size*Genius::processor_id();
-  unsigned int end   = std::min(begin+bin_size, tracks.size());
+  // the last bin takes the remainder
+  unsigned int bin_size = tracks.size()/Genius::n_processors()+1;
+  unsigned int begin = std::min(bin_size*Genius::processor_id(), static_cast<unsigned int>(tracks.size()));
+  unsigned int end   = std::min(begin+bin_size, static_cast<unsigned int>(tracks.size()));
   for(unsigned int t=begin; t<end; ++t)
   {
     const track_t & track = tracks[t];
@@ -0,0 +1,377 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <string>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+#include <iomanip>
+
+#include "elem.h"
+#include "mesh_base.h"
+#include "point_locator_base.h"
+#include "fe_type.h"
+#include "fe_interface.h"
+#include "fvm_node_info.h"
+#include "fvm_node_data.h"
+#include "solver_base.h"
+#include "probeset_hook.h"
+#include "async_writer.h"
+#include "parallel.h"
+
+
+/*----------------------------------------------------------------------
+ * constructor, collect the probe points
+ */
+ProbeSetHook::ProbeSetHook(SolverBase & solver, const std::string & name, void * param)
+    : Hook(solver, name), _probe_file(SolverSpecify::out_prefix + ".probeset"), _binary(false), _writer(NULL), _step(0)
+{
+  std::vector<Real> x, y, z;
+  Point line_start, line_end;
+  int line_n = 0;
+
+  const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
+  for(std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
+      parm_it != parm_list.end(); parm_it++)
+  {
+    // the ith x/y/z gives the ith point
+    if(parm_it->name() == "x" && parm_it->type() == Parser::REAL)
+      x.push_back(parm_it->get_real() * PhysicalUnit::um);
+    if(parm_it->name() == "y" && parm_it->type() == Parser::REAL)
+      y.push_back(parm_it->get_real() * PhysicalUnit::um);
+    if(parm_it->name() == "z" && parm_it->type() == Parser::REAL)
+      z.push_back(parm_it->get_real() * PhysicalUnit::um);
+
+    if(parm_it->name() == "pointfile" && parm_it->type() == Parser::STRING)
+      _read_point_file(parm_it->get_string());
+
+    // sample line
+    if(parm_it->name() == "line.x0" && parm_it->type() == Parser::REAL)
+      line_start(0) = parm_it->get_real() * PhysicalUnit::um;
+    if(parm_it->name() == "line.y0" && parm_it->type() == Parser::REAL)
+      line_start(1) = parm_it->get_real() * PhysicalUnit::um;
+    if(parm_it->name() == "line.z0" && parm_it->type() == Parser::REAL)
+      line_start(2) = parm_it->get_real() * PhysicalUnit::um;
+    if(parm_it->name() == "line.x1" && parm_it->type() == Parser::REAL)
+      line_end(0) = parm_it->get_real() * PhysicalUnit::um;
+    if(parm_it->name() == "line.y1" && parm_it->type() == Parser::REAL)
+      line_end(1) = parm_it->get_real() * PhysicalUnit::um;
+    if(parm_it->name() == "line.z1" && parm_it->type() == Parser::REAL)
+      line_end(2) = parm_it->get_real() * PhysicalUnit::um;
+    if(parm_it->name() == "line.n" && parm_it->type() == Parser::INTEGER)
+      line_n = parm_it->get_int();
+
+    if(parm_it->name() == "variable" && parm_it->type() == Parser::STRING)
+    {
+      std::string var_name = FormatVariableString(parm_it->get_string());
+      SolutionVariable v = solution_string_to_enum(var_name);
+      if(v != INVALID_Variable && variable_data_type(v) == SCALAR)
+      {
+        _variables.push_back(v);
+        _variable_names.push_back(var_name);
+      }
+      else
+      {
+        MESSAGE<<"Warning: probeset hook only supports scalar variable, " << parm_it->get_string() << " ignored."<<std::endl; RECORD();
+      }
+    }
+
+    if(parm_it->name() == "file" && parm_it->type() == Parser::STRING)
+      _probe_file = parm_it->get_string();
+    if(parm_it->name() == "format" && parm_it->type() == Parser::STRING)
+      _binary = (parm_it->get_string() == "binary");
+  }
+
+  for(unsigned int n=0; n<x.size(); ++n)
+    _points.push_back(Point(x[n], n<y.size() ? y[n] : 0.0, n<z.size() ? z[n] : 0.0));
+
+  for(int n=0; n<line_n; ++n)
+  {
+    Real t = line_n > 1 ? Real(n)/(line_n-1) : 0.0;
+    _points.push_back(line_start + t*(line_end - line_start));
+  }
+
+  if(_variables.empty())
+  {
+    _variables.push_back(POTENTIAL);  _variable_names.push_back("potential");
+    _variables.push_back(ELECTRON);   _variable_names.push_back("electron");
+    _variables.push_back(HOLE);       _variable_names.push_back("hole");
+  }
+
+  if ( !Genius::processor_id() )
+  {
+    if(_binary)
+      _out.open(_probe_file.c_str(), std::ios::trunc | std::ios::binary);
+    else
+      _out.open(_probe_file.c_str(), std::ios::trunc);
+
+    if ( SolverSpecify::out_async )
+      _writer = new AsyncWriter(static_cast<size_t>(SolverSpecify::out_async_buffer*1024*1024), AsyncWriter::BLOCK);
+  }
+}
+
+
+/*----------------------------------------------------------------------
+ * destructor, close file
+ */
+ProbeSetHook::~ProbeSetHook()
+{
+  delete _writer;
+  if ( !Genius::processor_id() )
+    _out.close();
+}
+
+
+
+void ProbeSetHook::_read_point_file(const std::string &file)
+{
+  std::vector<Real> coords;
+
+  if ( !Genius::processor_id() )
+  {
+    std::ifstream in(file.c_str());
+    if(!in.good())
+    {
+      MESSAGE<<"Warning: probeset hook can't open point file "<<file<<"."<<std::endl; RECORD();
+    }
+
+    std::string line;
+    while(std::getline(in, line))
+    {
+      if(line.empty() || line[0]=='#') continue;
+      std::istringstream ss(line);
+      Real p[3] = {0.0, 0.0, 0.0};
+      if(!(ss >> p[0] >> p[1])) continue;
+      ss >> p[2];
+      for(unsigned int i=0; i<3; ++i)
+        coords.push_back(p[i] * PhysicalUnit::um);
+    }
+  }
+
+  Parallel::broadcast(coords);
+  for(unsigned int n=0; n<coords.size()/3; ++n)
+    _points.push_back(Point(coords[3*n], coords[3*n+1], coords[3*n+2]));
+}
+
+
+
+double ProbeSetHook::_abscissa(std::string &label) const
+{
+  if(SolverSpecify::Type==SolverSpecify::TRANSIENT)
+  { label = "Time [s]"; return SolverSpecify::clock/PhysicalUnit::s; }
+
+  if(SolverSpecify::Type==SolverSpecify::DCSWEEP || SolverSpecify::Type==SolverSpecify::TRACE)
+  {
+    if(SolverSpecify::Electrode_VScan.size())
+    { label = SolverSpecify::Electrode_VScan[0] + " [V]"; return SolverSpecify::Electrode_VScan_Voltage/PhysicalUnit::V; }
+    if(SolverSpecify::Electrode_IScan.size())
+    { label = SolverSpecify::Electrode_IScan[0] + " [A]"; return SolverSpecify::Electrode_IScan_Current/PhysicalUnit::A; }
+  }
+
+  if(SolverSpecify::Type==SolverSpecify::ACSWEEP)
+  { label = "Frequency [Hz]"; return SolverSpecify::Freq*PhysicalUnit::s; }
+
+  label = "Step";
+  return _step;
+}
+
+
+/*----------------------------------------------------------------------
+ *   This is executed before the initialization of the solver
+ */
+void ProbeSetHook::on_init()
+{
+  const SimulationSystem & system = _solver.get_system();
+  const MeshBase & mesh = system.mesh();
+
+  // the mesh is the same on all the processors, locate the probes everywhere,
+  // but only the owner of the element computes the interpolation weights
+  const PointLocatorBase & point_locator = mesh.point_locator();
+  const FEType fe_type;
+
+  _elems.resize(_points.size(), NULL);
+  _weights.resize(_points.size());
+
+  unsigned int n_outside = 0;
+  for(unsigned int n=0; n<_points.size(); ++n)
+  {
+    const Elem * elem = point_locator(_points[n]);
+    _elems[n] = elem;
+    if(!elem) { n_outside++; continue; }
+    if(elem->processor_id() != Genius::processor_id()) continue;
+
+    const unsigned int dim = elem->dim();
+    const Point ref = FEInterface::inverse_map(dim, fe_type, elem, _points[n]);
+    for(unsigned int i=0; i<elem->n_nodes(); ++i)
+      _weights[n].push_back(FEInterface::shape(dim, fe_type, elem, i, ref));
+  }
+
+  if(n_outside)
+  {
+    MESSAGE<<"Warning: "<<n_outside<<" probe(s) outside the mesh, 0 will be recorded."<<std::endl; RECORD();
+  }
+
+  if ( Genius::processor_id() ) return;
+
+  std::string abscissa_label;
+  _abscissa(abscissa_label);
+
+  if(_binary)
+  {
+    std::string head("GENIUSPB");
+    int info[3] = {1, static_cast<int>(_points.size()), static_cast<int>(_variables.size())};
+    head.append(reinterpret_cast<const char *>(info), sizeof(info));
+    for(unsigned int n=0; n<_points.size(); ++n)
+      for(unsigned int d=0; d<3; ++d)
+      {
+        double c = _points[n](d)/PhysicalUnit::um;
+        head.append(reinterpret_cast<const char *>(&c), sizeof(double));
+      }
+    for(unsigned int v=0; v<_variables.size(); ++v)
+    {
+      std::string var = _variable_names[v] + " [" + variable_unit_string(_variables[v]) + "]";
+      head.append(var.c_str(), var.size()+1);
+    }
+    _out.write(head.data(), head.size());
+    _out.flush();
+    return;
+  }
+
+  time_t          _time;
+  time(&_time);
+
+  _out << "# Title: Probe Set File Created by Genius TCAD Simulation" << std::endl;
+  _out << "# Date: " << ctime(&_time) << std::endl;
+  _out << "# Probes (um): " << std::endl;
+  for(unsigned int n=0; n<_points.size(); ++n)
+  {
+    _out << '#' << std::setw(10) << n << std::setw(15) << _points[n](0)/PhysicalUnit::um
+         << std::setw(15) << _points[n](1)/PhysicalUnit::um << std::setw(15) << _points[n](2)/PhysicalUnit::um;
+    if(_elems[n])
+      _out << "  " << system.region(_elems[n]->subdomain_id())->name();
+    else
+      _out << "  outside";
+    _out << std::endl;
+  }
+  _out << "# Variables: " << std::endl;
+  int cCnt=0;
+  _out << '#' << std::setw(10) << ++cCnt << std::setw(30) << abscissa_label << std::endl;
+  for(unsigned int n=0; n<_points.size(); ++n)
+    for(unsigned int v=0; v<_variables.size(); ++v)
+    {
+      std::stringstream ss;
+      ss << _variable_names[v] << '@' << n << " [" << variable_unit_string(_variables[v]) << "]";
+      _out << '#' << std::setw(10) << ++cCnt << std::setw(30) << ss.str() << std::endl;
+    }
+  _out << std::endl;
+}
+
+
+
+/*----------------------------------------------------------------------
+ *  This is executed after each solution step.
+ */
+void ProbeSetHook::post_solve()
+{
+  const unsigned int n_var = _variables.size();
+
+  // interpolate the probes owned by this processor, others left zero
+  std::vector<double> values(_points.size()*n_var, 0.0);
+  for(unsigned int n=0; n<_points.size(); ++n)
+  {
+    const Elem * elem = _elems[n];
+    if(!elem || elem->processor_id() != Genius::processor_id()) continue;
+
+    for(unsigned int i=0; i<elem->n_nodes(); ++i)
+    {
+      const FVM_Node * fvm_node = elem->get_fvm_node(i);
+      if(!fvm_node || !fvm_node->node_data()) continue;
+      const FVM_NodeData * node_data = fvm_node->node_data();
+
+      for(unsigned int v=0; v<n_var; ++v)
+        if(node_data->is_variable_valid(_variables[v]))
+          values[n*n_var+v] += _weights[n][i]*node_data->get_variable_real(_variables[v])/variable_unit(_variables[v]);
+    }
+  }
+
+  // the only collective of each step
+  Parallel::sum(values);
+
+  _step++;
+
+  if ( Genius::processor_id() ) return;
+
+  std::string abscissa_label;
+  double abscissa = _abscissa(abscissa_label);
+
+  std::string row;
+  if(_binary)
+  {
+    row.append(reinterpret_cast<const char *>(&abscissa), sizeof(double));
+    if(!values.empty())
+      row.append(reinterpret_cast<const char *>(&values[0]), values.size()*sizeof(double));
+  }
+  else
+  {
+    std::stringstream ss;
+    ss.precision(6);
+    ss << std::scientific << std::right;
+    ss << ' ' << std::setw(15) << abscissa;
+    for(unsigned int i=0; i<values.size(); i++)
+      ss << std::setw(15) << values[i];
+    ss << std::endl;
+    row = ss.str();
+  }
+
+  if(_writer)
+    _writer->enqueue(new AsyncWriter::TextJob(_out, row));
+  else
+  {
+    _out.write(row.data(), row.size());
+    _out.flush();
+  }
+}
+
+
+
+/*----------------------------------------------------------------------
+ * This is executed after the finalization of the solver
+ */
+void ProbeSetHook::on_close()
+{
+  if ( _writer )
+    _writer->flush();
+}
+
+
+#ifdef DLLHOOK
+
+// dll interface
+extern "C"
+{
+  Hook* get_hook (SolverBase & solver, const std::string & name, void * fun_data)
+  {
+    return new ProbeSetHook(solver, name, fun_data );
+  }
+
+}
+
+#endif
@@ -36,7 +36,12 @@ RawFileHook::RawFileHook(SolverBase & solver, const std::string & name, void * f
     : Hook(solver, name), _input_file((const char *)file), _raw_file(SolverSpecify::out_prefix + ".raw"), _mixA(false), _n_values(0)
 {
   if ( !Genius::processor_id() )
-    _out.open(_raw_file.c_str());
+  {
+    if( SolverSpecify::out_binary )
+      _out.open(_raw_file.c_str(), std::ios::binary);
+    else
+      _out.open(_raw_file.c_str());
+  }
 
   SolverSpecify::SolverType solver_type = this->get_solver().solver_type();
 
@@ -165,8 +170,8 @@ void RawFileHook::on_init()
       }
     }
 
-    _values.resize( _variables.size() );
-
+    // the head is written now, data points are appended by each step
+    _write_head();
   }
 
 }
@@ -191,8 +196,9 @@ void RawFileHook::post_solve()
   // only root processor do this command
   if ( !Genius::processor_id() )
   {
-    // variable counter
-    unsigned int i=0;
+    // values of this point
+    std::vector<double> row;
+    row.reserve(_variables.size());
 
     if( SolverSpecify::Type==SolverSpecify::DCSWEEP ||
         SolverSpecify::Type==SolverSpecify::TRACE   ||
@@ -201,8 +207,8 @@ void RawFileHook::post_solve()
       // if transient simulation, we need to record time
       if (SolverSpecify::Type == SolverSpecify::TRANSIENT)
       {
-        _values[i++].push_back( SolverSpecify::clock/PhysicalUnit::s );
-        _values[i++].push_back( SolverSpecify::dt/PhysicalUnit::s );
+        row.push_back( SolverSpecify::clock/PhysicalUnit::s );
+        row.push_back( SolverSpecify::dt/PhysicalUnit::s );
       }
 
       if( !_mixA )
@@ -215,27 +221,27 @@ void RawFileHook::post_solve()
           // electrode
           if( bc->is_electrode() )
           {
-            _values[i++].push_back( bc->ext_circuit()->Vapp()/PhysicalUnit::V );
-            _values[i++].push_back( bc->ext_circuit()->potential()/PhysicalUnit::V );
-            _values[i++].push_back( bc->ext_circuit()->current()/PhysicalUnit::A );
+            row.push_back( bc->ext_circuit()->Vapp()/PhysicalUnit::V );
+            row.push_back( bc->ext_circuit()->potential()/PhysicalUnit::V );
+            row.push_back( bc->ext_circuit()->current()/PhysicalUnit::A );
             continue;
           }
 
           if( bc->has_current_flow() )
           {
-            _values[i++].push_back( bc->current()/PhysicalUnit::A );
+            row.push_back( bc->current()/PhysicalUnit::A );
           }
 
           if( bc->bc_type() == IF_Metal_Ohmic || bc->bc_type() == IF_Metal_Schottky)
           {
-            _values[i++].push_back( bc->psi()/PhysicalUnit::V );
+            row.push_back( bc->psi()/PhysicalUnit::V );
           }
 
           // charge integral interface
           if( bc->bc_type() == ChargeIntegral )
           {
-            _values[i++].push_back( bc->scalar("qf")/PhysicalUnit::C );
-            _values[i++].push_back( bc->psi()/PhysicalUnit::V );
+            row.push_back( bc->scalar("qf")/PhysicalUnit::C );
+            row.push_back( bc->psi()/PhysicalUnit::V );
           }
         }
       }
@@ -245,9 +251,9 @@ void RawFileHook::post_solve()
         for(unsigned int n=0; n<spice_ckt->n_ckt_nodes(); n++)
         {
           if(spice_ckt->is_voltage_node(n))
-            _values[i++].push_back(spice_ckt->get_solution(n));
+            row.push_back(spice_ckt->get_solution(n));
           else
-            _values[i++].push_back(spice_ckt->get_solution(n));
+            row.push_back(spice_ckt->get_solution(n));
         }
       }
     }
@@ -255,7 +261,7 @@ void RawFileHook::post_solve()
     if( SolverSpecify::Type==SolverSpecify::ACSWEEP)
     {
       //record frequency
-      _values[i++].push_back( SolverSpecify::Freq*PhysicalUnit::s );
+      row.push_back( SolverSpecify::Freq*PhysicalUnit::s );
 
       // record electrode IV information
       const BoundaryConditionCollector * bcs = this->get_solver().get_system().get_bcs();
@@ -266,14 +272,19 @@ void RawFileHook::post_solve()
         // skip bc which is not electrode
         if( !bc->is_electrode() ) continue;
         //
-        _values[i++].push_back( std::abs(bc->ext_circuit()->potential_ac())/PhysicalUnit::V );
-        _values[i++].push_back( std::arg(bc->ext_circuit()->potential_ac()) );
-        _values[i++].push_back( std::abs(bc->ext_circuit()->current_ac())/PhysicalUnit::A );
-        _values[i++].push_back( std::arg(bc->ext_circuit()->current_ac()) );
+        row.push_back( std::abs(bc->ext_circuit()->potential_ac())/PhysicalUnit::V );
+        row.push_back( std::arg(bc->ext_circuit()->potential_ac()) );
+        row.push_back( std::abs(bc->ext_circuit()->current_ac())/PhysicalUnit::A );
+        row.push_back( std::arg(bc->ext_circuit()->current_ac()) );
       }
     }
 
-    if(i)  _n_values++;
+    if(!row.empty())
+    {
+      _write_point(row);
+      _n_values++;
+      _write_n_points();
+    }
   }
 
 }
@@ -293,56 +304,97 @@ void RawFileHook::post_iteration()
  */
 void RawFileHook::on_close()
 {
-  // write spice raw file
+  // all the points and the number of points are already in raw file
   // only root processor do this command
   if ( !Genius::processor_id() )
-  {
-    // write raw file head
-    _out << "Title: SPICE Raw File Created by Genius TCAD Simulation" << std::endl;
-    _out << "Date: " << ctime(&_time) << std::endl;
+    _out.close();
 
-    switch (SolverSpecify::Type)
-    {
-        case SolverSpecify::DCSWEEP :
-          _out << "Plotname: DC transfer characteristic" << std::endl; break;
-        case SolverSpecify::TRACE     :
-          _out << "Plotname: DC curve trace" << std::endl; break;
-        case SolverSpecify::TRANSIENT :
-          _out << "Plotname: Transient Analysis" << std::endl; break;
-        case SolverSpecify::ACSWEEP   :
-          _out << "Plotname: AC small signal Analysis" << std::endl; break;
-        default: break;
-    }
+}
 
-    _out <<  "Flags: real" << std::endl;
 
-    _out <<  "No. Variables: " << _variables.size()    << std::endl;
-    _out <<  "No. Points: "    << _n_values  << '\n'   << std::endl;
 
-    // write variables
-    _out << "Variables:"<<std::endl;
-    for(unsigned int n=0; n<_variables.size(); n++)
-    {
-      _out << '\t' << n << '\t' << _variables[n].first << '\t' << _variables[n].second << std::endl;
-    }
+/*----------------------------------------------------------------------
+ * write spice raw file head, the number of points is a fixed width
+ * field which is overwritten after each point by _write_n_points()
+ */
+void RawFileHook::_write_head()
+{
+  _out << "Title: SPICE Raw File Created by Genius TCAD Simulation" << std::endl;
+  _out << "Date: " << ctime(&_time) << std::endl;
+
+  switch (SolverSpecify::Type)
+  {
+      case SolverSpecify::DCSWEEP :
+        _out << "Plotname: DC transfer characteristic" << std::endl; break;
+      case SolverSpecify::TRACE     :
+        _out << "Plotname: DC curve trace" << std::endl; break;
+      case SolverSpecify::TRANSIENT :
+        _out << "Plotname: Transient Analysis" << std::endl; break;
+      case SolverSpecify::ACSWEEP   :
+        _out << "Plotname: AC small signal Analysis" << std::endl; break;
+      default: break;
+  }
 
-    _out << std::endl;
+  _out <<  "Flags: real" << std::endl;
 
-    // write values
-    _out << "Values:"<<std::endl;
+  _out <<  "No. Variables: " << _variables.size()    << std::endl;
+  _out <<  "No. Points: ";
+  _n_points_pos = _out.tellp();
+  _out << std::left << std::setw(_n_points_width) << 0 << std::right << '\n' << std::endl;
+
+  // write variables
+  _out << "Variables:"<<std::endl;
+  for(unsigned int n=0; n<_variables.size(); n++)
+  {
+    _out << '\t' << n << '\t' << _variables[n].first << '\t' << _variables[n].second << std::endl;
+  }
+
+  _out << std::endl;
 
+  // values follow
+  if( SolverSpecify::out_binary )
+    _out << "Binary:"<<std::endl;
+  else
+  {
+    _out << "Values:"<<std::endl;
     _out << std::setprecision(15) << std::scientific << std::right;
+  }
+}
 
-    for(unsigned int i=0; i<_n_values; i++)
-    {
-      _out << " " << i;
-      for(unsigned int n=0; n<_variables.size(); n++)
-        _out  << '\t' << std::setw(25) << _values[n][i] << std::endl;
-    }
 
-    _out.close();
+
+/*----------------------------------------------------------------------
+ * append one point to raw file and flush it, so the file holds
+ * all the finished steps even if the simulation is killed
+ */
+void RawFileHook::_write_point(const std::vector<double> & row)
+{
+  if( SolverSpecify::out_binary )
+  {
+    // binary raw file holds native doubles, one point after another
+    _out.write(reinterpret_cast<const char *>(&row[0]), row.size()*sizeof(double));
+    _out.flush();
+    return;
   }
 
+  _out << " " << _n_values;
+  for(unsigned int n=0; n<row.size(); n++)
+    _out  << '\t' << std::setw(25) << row[n] << '\n';
+  _out.flush();
+}
+
+
+
+/*----------------------------------------------------------------------
+ * overwrite the number of points in file head and return to the end of file,
+ * so the head always matches the points written so far
+ */
+void RawFileHook::_write_n_points()
+{
+  _out.seekp(_n_points_pos);
+  _out << std::left << std::setw(_n_points_width) << _n_values << std::right;
+  _out.seekp(0, std::ios::end);
+  _out.flush();
 }
 
 
@@ -25,6 +25,7 @@
 #include "solver_base.h"
 #include "vtk_hook.h"
 #include "spice_ckt.h"
+#include "async_writer.h"
 #include "MXMLUtil.h"
 
 
@@ -33,7 +34,7 @@
  */
 VTKHook::VTKHook ( SolverBase & solver, const std::string & name, void * param)
     : Hook ( solver, name ), _vtk_prefix ( SolverSpecify::out_prefix ),
-      _ddm ( false ), _mixA ( false ), _ddm_ac ( false )
+      _vtk_ext ( ".vtu" ), _writer ( NULL ), _ddm ( false ), _mixA ( false ), _ddm_ac ( false )
 {
   this->count  =0;
 
@@ -70,13 +71,25 @@ VTKHook::VTKHook ( SolverBase & solver, const std::string & name, void * param)
       _t_start=parm_it->get_real() * PhysicalUnit::s;
     if ( parm_it->name() == "tstop" && parm_it->type() == Parser::REAL )
       _t_stop=parm_it->get_real() * PhysicalUnit::s;
+
+    // each processor writes its own piece, with a .pvtu index
+    if ( parm_it->name() == "pvtu" && parm_it->type() == Parser::BOOL && parm_it->get_bool() )
+      _vtk_ext=".pvtu";
+  }
+
+  // pieces of pvtu are queued by each processor independently, they can not be discarded
+  if ( SolverSpecify::out_async )
+  {
+    AsyncWriter::Policy policy = AsyncWriter::policy ( SolverSpecify::out_async_policy );
+    if ( _vtk_ext == ".pvtu" ) policy = AsyncWriter::BLOCK;
+    _writer = new AsyncWriter ( static_cast<size_t> ( SolverSpecify::out_async_buffer*1024*1024 ), policy );
   }
 
   const SimulationSystem &system = get_solver().get_system();
 
   std::ostringstream vtk_filename;
-  vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-  system.export_vtk ( vtk_filename.str(), false );
+  vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_ext;
+  system.export_vtk ( vtk_filename.str(), false, _writer );
 
   SolverSpecify::SolverType solver_type = this->get_solver().solver_type();
 
@@ -99,7 +112,9 @@ VTKHook::VTKHook ( SolverBase & solver, const std::string & name, void * param)
  * destructor, close file
  */
 VTKHook::~VTKHook()
-{}
+{
+  delete _writer;
+}
 
 
 /*----------------------------------------------------------------------
@@ -137,8 +152,8 @@ void VTKHook::post_solve()
     {
       const SimulationSystem &system = get_solver().get_system();
 
-      vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-      system.export_vtk ( vtk_filename.str(),false );
+      vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_ext;
+      system.export_vtk ( vtk_filename.str(), false, _writer );
 
       time_sequence.push_back ( std::make_pair ( Vscan/PhysicalUnit::V, vtk_filename.str() ) );
       _v_last = Vscan;
@@ -153,8 +168,8 @@ void VTKHook::post_solve()
     {
       const SimulationSystem &system = get_solver().get_system();
 
-      vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-      system.export_vtk ( vtk_filename.str(),false );
+      vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_ext;
+      system.export_vtk ( vtk_filename.str(), false, _writer );
 
       time_sequence.push_back ( std::make_pair ( Iscan/PhysicalUnit::A, vtk_filename.str() ) );
       _i_last = Iscan;
@@ -166,16 +181,16 @@ void VTKHook::post_solve()
   {
     const SimulationSystem &system = get_solver().get_system();
 
-    vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-    system.export_vtk ( vtk_filename.str(), false );
+    vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_ext;
+    system.export_vtk ( vtk_filename.str(), false, _writer );
   }
 
   if ( SolverSpecify::Type==SolverSpecify::TRACE )
   {
     const SimulationSystem &system = get_solver().get_system();
 
-    vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-    system.export_vtk ( vtk_filename.str(), false );
+    vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_ext;
+    system.export_vtk ( vtk_filename.str(), false, _writer );
   }
 
   if ( SolverSpecify::Type==SolverSpecify::TRANSIENT )
@@ -189,8 +204,8 @@ void VTKHook::post_solve()
       {
         const SimulationSystem &system = get_solver().get_system();
 
-        vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-        system.export_vtk ( vtk_filename.str(), false );
+        vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_ext;
+        system.export_vtk ( vtk_filename.str(), false, _writer );
 
         time_sequence.push_back ( std::make_pair ( SolverSpecify::clock/PhysicalUnit::ps, vtk_filename.str() ) );
         _t_last = SolverSpecify::clock;
@@ -203,8 +218,8 @@ void VTKHook::post_solve()
   {
     const SimulationSystem &system = get_solver().get_system();
 
-    vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-    system.export_vtk ( vtk_filename.str(), false );
+    vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_ext;
+    system.export_vtk ( vtk_filename.str(), false, _writer );
 
     time_sequence.push_back ( std::make_pair ( SolverSpecify::Freq*PhysicalUnit::us, vtk_filename.str() ) );
     _f_last = SolverSpecify::Freq;
@@ -215,8 +230,8 @@ void VTKHook::post_solve()
   {
     const SimulationSystem &system = get_solver().get_system();
 
-    vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-    system.export_vtk ( vtk_filename.str(),false );
+    vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_ext;
+    system.export_vtk ( vtk_filename.str(), false, _writer );
   }
   */
 
@@ -249,6 +264,16 @@ void VTKHook::post_iteration()
  */
 void VTKHook::on_close()
 {
+  // wait for background writer
+  if ( _writer )
+  {
+    _writer->flush();
+    if ( _writer->n_dropped() )
+    {
+      MESSAGE<<"VTK hook: "<<_writer->n_dropped()<<" snapshot(s) discarded by async output policy.\n"; RECORD();
+    }
+  }
+
   if ( time_sequence.size() ==0 ) return;
 
   if ( !Genius::processor_id() )
@@ -263,7 +288,8 @@ void VTKHook::on_close()
     out<< "<Collection>" <<std::endl;
 
     for ( unsigned int n=0; n<time_sequence.size(); ++n )
-      out<<"  <DataSet timestep=\""<<time_sequence[n].first<<"\" group=\"\" part=\"0\" file=\""<<time_sequence[n].second<<"\"/>"<<std::endl;
+      if ( !_writer || !_writer->dropped().count ( time_sequence[n].second ) )
+        out<<"  <DataSet timestep=\""<<time_sequence[n].first<<"\" group=\"\" part=\"0\" file=\""<<time_sequence[n].second<<"\"/>"<<std::endl;
 
     out<<"  </Collection>"<<std::endl;
     out<<"</VTKFile>"<<std::endl;
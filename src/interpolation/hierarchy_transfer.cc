@@ -0,0 +1,251 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <algorithm>
+
+#include "mesh_base.h"
+#include "elem.h"
+#include "simulation_system.h"
+#include "simulation_region.h"
+#include "boundary_info.h"
+#include "boundary_condition_collector.h"
+#include "mesh_tools.h"
+#include "hierarchy_transfer.h"
+#include "parallel.h"
+
+
+void HierarchyTransfer::add_variable(const SimulationSystem & system, const std::string & variable_string, InterpolationBase::InterpolationType type)
+{
+  SolutionVariable variable = solution_string_to_enum(FormatVariableString(variable_string));
+  genius_assert(variable!=INVALID_Variable);
+  genius_assert(variable_data_type(variable)==SCALAR);
+
+  // collect on processor node values, the same rule as SimulationSystem::fill_interpolator
+  std::map<unsigned int, double> value_map;
+  for( unsigned int r=0; r<system.n_regions(); r++)
+  {
+    const SimulationRegion * region = system.region(r);
+
+    SimulationRegion::const_processor_node_iterator on_processor_nodes_it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator on_processor_nodes_it_end = region->on_processor_nodes_end();
+    for(; on_processor_nodes_it!=on_processor_nodes_it_end; ++on_processor_nodes_it)
+    {
+      const FVM_Node * fvm_node = *on_processor_nodes_it;
+      const FVM_NodeData * node_data = fvm_node->node_data();
+
+      // if the fvm_node lies on the interface of two material regions,
+      // we shall use the node data in the more important region.
+      if( fvm_node->boundary_id() != BoundaryInfo::invalid_id )
+      {
+        unsigned int bc_index = system.get_bcs()->get_bc_index_by_bd_id(fvm_node->boundary_id());
+        const BoundaryCondition * bc = system.get_bcs()->get_bc(bc_index);
+        const FVM_Node * primary_fvm_node = (*bc->region_node_begin(fvm_node->root_node())).second.second;
+        node_data = primary_fvm_node->node_data();
+      }
+      if(node_data->is_variable_valid(variable))
+        value_map [fvm_node->root_node()->id()] = node_data->get_variable_real(variable);
+    }
+  }
+
+  // only processor 0 does the refinement, only it needs the values
+  Parallel::gather(0, value_map);
+
+  _variables.push_back(variable_string);
+  _types.push_back(type);
+  _id_values.push_back(std::map<unsigned int, double>());
+
+  if(Genius::processor_id() == 0)
+  {
+    std::map<unsigned int, double> & id_values = _id_values.back();
+    std::map<unsigned int, double>::const_iterator it = value_map.begin();
+    for(; it != value_map.end(); ++it)
+    {
+      id_values[it->first] = InterpolationBase::scaleValue(type, it->second);
+      _node_of_id[it->first] = _mesh.node_ptr(it->first);
+    }
+  }
+}
+
+
+
+bool HierarchyTransfer::_known(const Node * node) const
+{
+  std::map<unsigned int, const Node *>::const_iterator it = _node_of_id.find(node->id());
+  return it != _node_of_id.end() && it->second == node;
+}
+
+
+
+void HierarchyTransfer::_claim(const Node * node)
+{
+  for(unsigned int v=0; v<_id_values.size(); ++v)
+    _id_values[v].erase(node->id());
+  _node_of_id[node->id()] = node;
+}
+
+
+
+const double * HierarchyTransfer::_value(unsigned int v, const Node * node) const
+{
+  if(!_known(node)) return NULL;
+  std::map<unsigned int, double>::const_iterator it = _id_values[v].find(node->id());
+  return it == _id_values[v].end() ? NULL : &(it->second);
+}
+
+
+
+void HierarchyTransfer::prolong()
+{
+  genius_assert(Genius::processor_id() == 0);
+
+  // parent is always visited before its children
+  const unsigned int n_levels = MeshTools::n_levels(_mesh);
+  for(unsigned int level=1; level<n_levels; ++level)
+  {
+    MeshBase::const_element_iterator el = _mesh.level_elements_begin(level);
+    const MeshBase::const_element_iterator el_end = _mesh.level_elements_end(level);
+    for( ; el != el_end; ++el)
+    {
+      const Elem * elem = *el;
+      const Elem * parent = elem->parent();
+      if(!parent) continue;
+      const unsigned int c = parent->which_child_am_i(elem);
+
+      for(unsigned int i=0; i<elem->n_nodes(); ++i)
+      {
+        const Node * node = elem->get_node(i);
+
+        // node created by refinement, its id or address may belong to a node freed by coarsening
+        if(!_known(node))
+          _claim(node);
+
+        for(unsigned int v=0; v<_id_values.size(); ++v)
+        {
+          if(_value(v, node)) continue;
+
+          // weighted by embedding matrix, nodes without value are skipped
+          double value = 0.0, weight = 0.0;
+          for(unsigned int j=0; j<parent->n_nodes(); ++j)
+          {
+            const float em = parent->embedding_matrix(c, i, j);
+            if(em == 0.) continue;
+
+            const double * parent_value = _value(v, parent->get_node(j));
+            if(!parent_value) continue;
+            value  += em*(*parent_value);
+            weight += em;
+          }
+          if(weight > 0.)
+            _id_values[v][node->id()] = value/weight;
+        }
+      }
+    }
+  }
+
+  // node ids are renumbered when the mesh is prepared, keep the values by the nodes
+  // of active elements. nodes only used by coarsened elements are freed by then
+  _node_values.assign(_id_values.size(), std::map<const Node *, double>());
+  MeshBase::const_element_iterator el = _mesh.active_elements_begin();
+  const MeshBase::const_element_iterator el_end = _mesh.active_elements_end();
+  for( ; el != el_end; ++el)
+  {
+    const Elem * elem = *el;
+    for(unsigned int i=0; i<elem->n_nodes(); ++i)
+    {
+      const Node * node = elem->get_node(i);
+      for(unsigned int v=0; v<_id_values.size(); ++v)
+      {
+        const double * value = _value(v, node);
+        if(value)
+          _node_values[v][node] = *value;
+      }
+    }
+  }
+
+  _node_of_id.clear();
+  _id_values.clear();
+}
+
+
+
+void HierarchyTransfer::sync()
+{
+  const unsigned int n_nodes = _mesh.max_node_id();
+
+  _values.resize(_variables.size());
+  _has_value.resize(_variables.size());
+
+  for(unsigned int v=0; v<_variables.size(); ++v)
+  {
+    if(Genius::processor_id() == 0 && v < _node_values.size())
+    {
+      _values[v].assign(n_nodes, 0.0);
+      _has_value[v].assign(n_nodes, 0);
+
+      // only nodes of active elements after refinement have value
+      MeshBase::const_node_iterator node_it = _mesh.nodes_begin();
+      const MeshBase::const_node_iterator node_it_end = _mesh.nodes_end();
+      for( ; node_it != node_it_end; ++node_it)
+      {
+        const Node * node = *node_it;
+        std::map<const Node *, double>::const_iterator it = _node_values[v].find(node);
+        if(it == _node_values[v].end()) continue;
+        _values[v][node->id()] = InterpolationBase::unscaleValue(_types[v], it->second);
+        _has_value[v][node->id()] = 1;
+      }
+      _node_values[v].clear();
+    }
+
+    Parallel::broadcast(_values[v]);
+    Parallel::broadcast(_has_value[v]);
+  }
+}
+
+
+
+void HierarchyTransfer::apply(SimulationSystem & system, const std::string & variable_string) const
+{
+  SolutionVariable variable = solution_string_to_enum(FormatVariableString(variable_string));
+
+  unsigned int v = std::find(_variables.begin(), _variables.end(), variable_string) - _variables.begin();
+  genius_assert(v < _variables.size());
+
+  const std::vector<double> & values = _values[v];
+  const std::vector<char> & has_value = _has_value[v];
+
+  for(unsigned int n=0; n<system.n_regions(); n++)
+  {
+    SimulationRegion * region = system.region(n);
+
+    SimulationRegion::local_node_iterator node_it = region->on_local_nodes_begin();
+    SimulationRegion::local_node_iterator node_it_end = region->on_local_nodes_end();
+    for(; node_it!=node_it_end; ++node_it)
+    {
+      FVM_Node * fvm_node = (*node_it);
+      const unsigned int id = fvm_node->root_node()->id();
+      if(id >= has_value.size() || !has_value[id]) continue;
+
+      FVM_NodeData * node_data = fvm_node->node_data();
+      if(node_data->is_variable_valid(variable))
+        node_data->set_variable_real(variable, values[id]);
+    }
+  }
+}
@@ -0,0 +1,384 @@
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <limits>
+
+#include "config.h"
+#include "genius_common.h"
+#include "asinh.hpp"
+#include "interpolation_kdtree.h"
+#include "parallel.h"
+
+#include "log.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+
+namespace
+{
+  /**
+   * compare the coordinate of two points along axis
+   */
+  struct AxisLess
+  {
+    AxisLess(const std::vector<double> & c, unsigned int dim, unsigned int axis) : coords(c), dim(dim), axis(axis) {}
+    bool operator() (unsigned int a, unsigned int b) const
+    { return coords[a*dim+axis] < coords[b*dim+axis]; }
+    const std::vector<double> & coords;
+    unsigned int dim;
+    unsigned int axis;
+  };
+
+  /**
+   * a piece of batch query
+   */
+  struct BatchJob
+  {
+    const void * self;
+    const void * data;
+    int type;
+    const std::vector<Point> * points;
+    unsigned int begin;
+    unsigned int end;
+    std::vector<double> * values;
+  };
+}
+
+
+Interpolation_KDTree::Interpolation_KDTree(unsigned int dim)
+  : _dim(dim), _k(dim==1 ? 4 : 4*dim), _mls(true), _n_threads(1)
+{
+  genius_assert(_dim>=1 && _dim<=3);
+}
+
+
+Interpolation_KDTree::~Interpolation_KDTree()
+{
+  this->clear();
+}
+
+
+void Interpolation_KDTree::clear()
+{
+  _field.clear();
+}
+
+
+void Interpolation_KDTree::set_option(const std::string & option)
+{
+  if(option == "mls")
+    _mls = true;
+  else if(option == "idw")
+    _mls = false;
+  else if(option.find("k=") == 0)
+    _k = std::max(1, atoi(option.substr(2).c_str()));
+  else if(option.find("threads=") == 0)
+    _n_threads = std::max(1, atoi(option.substr(8).c_str()));
+}
+
+
+void Interpolation_KDTree::broadcast(unsigned int root)
+{
+  std::vector<int> groups;
+  std::map<int, DATA>::iterator it=_field.begin();
+  for(; it!=_field.end(); ++it)
+    groups.push_back(it->first);
+  Parallel::broadcast(groups, root);
+
+  for(unsigned int n=0; n<groups.size(); ++n)
+  {
+    DATA & data = _field[groups[n]];
+    // kd-tree not built yet
+    assert(!data.built);
+    Parallel::broadcast(data.coords, root);
+    Parallel::broadcast(data.values, root);
+  }
+}
+
+
+void Interpolation_KDTree::add_scatter_data(const Point & point, int group, double value)
+{
+  DATA & data = _field[group];
+  assert(!data.built);
+
+  for(unsigned int d=0; d<_dim; ++d)
+    data.coords.push_back(point(d));
+
+  InterpolationType type = _interpolation_type[group];
+  data.values.push_back(scaleValue(type, value));
+}
+
+
+void Interpolation_KDTree::setup(int group)
+{
+  // interpolation type may be set after the data
+  _interpolation_type[group];
+
+  DATA & data = _field[group];
+  if(data.built) return;
+
+  const unsigned int n_points = data.values.size();
+  data.index.resize(n_points);
+  for(unsigned int i=0; i<n_points; ++i)
+    data.index[i] = i;
+  data.axis.assign(n_points, 0);
+
+  _build(data, 0, n_points);
+  data.built = true;
+}
+
+
+void Interpolation_KDTree::_build(DATA & data, unsigned int lo, unsigned int hi)
+{
+  if(hi - lo <= 1) return;
+
+  // split at the axis with largest extent
+  double pmin[3], pmax[3];
+  for(unsigned int d=0; d<_dim; ++d)
+  {
+    pmin[d] =  std::numeric_limits<double>::max();
+    pmax[d] = -std::numeric_limits<double>::max();
+  }
+  for(unsigned int i=lo; i<hi; ++i)
+  {
+    const double * c = &data.coords[data.index[i]*_dim];
+    for(unsigned int d=0; d<_dim; ++d)
+    {
+      pmin[d] = std::min(pmin[d], c[d]);
+      pmax[d] = std::max(pmax[d], c[d]);
+    }
+  }
+  unsigned int axis = 0;
+  for(unsigned int d=1; d<_dim; ++d)
+    if(pmax[d]-pmin[d] > pmax[axis]-pmin[axis]) axis = d;
+
+  const unsigned int mid = (lo + hi)/2;
+  std::nth_element(data.index.begin()+lo, data.index.begin()+mid, data.index.begin()+hi, AxisLess(data.coords, _dim, axis));
+  data.axis[mid] = axis;
+
+  _build(data, lo, mid);
+  _build(data, mid+1, hi);
+}
+
+
+void Interpolation_KDTree::_search(const DATA & data, const double * p, unsigned int lo, unsigned int hi,
+                                   std::vector< std::pair<double, unsigned int> > & heap) const
+{
+  if(lo >= hi) return;
+
+  const unsigned int mid = (lo + hi)/2;
+  const unsigned int idx = data.index[mid];
+  const double * c = &data.coords[idx*_dim];
+
+  double d2 = 0.0;
+  for(unsigned int d=0; d<_dim; ++d)
+    d2 += (p[d]-c[d])*(p[d]-c[d]);
+
+  if(heap.size() < _k)
+  {
+    heap.push_back(std::make_pair(d2, idx));
+    std::push_heap(heap.begin(), heap.end());
+  }
+  else if(d2 < heap.front().first)
+  {
+    std::pop_heap(heap.begin(), heap.end());
+    heap.back() = std::make_pair(d2, idx);
+    std::push_heap(heap.begin(), heap.end());
+  }
+
+  const unsigned int axis = data.axis[mid];
+  const double diff = p[axis] - c[axis];
+
+  // near side first, far side only when it may hold a closer point
+  if(diff < 0)
+  {
+    _search(data, p, lo, mid, heap);
+    if(heap.size() < _k || diff*diff < heap.front().first)
+      _search(data, p, mid+1, hi, heap);
+  }
+  else
+  {
+    _search(data, p, mid+1, hi, heap);
+    if(heap.size() < _k || diff*diff < heap.front().first)
+      _search(data, p, lo, mid, heap);
+  }
+}
+
+
+double Interpolation_KDTree::_fit(const DATA & data, const double * p, const std::vector< std::pair<double, unsigned int> > & heap) const
+{
+  const unsigned int n = heap.size();
+
+  double vmin =  std::numeric_limits<double>::max();
+  double vmax = -std::numeric_limits<double>::max();
+  double d2max = 0.0;
+  for(unsigned int i=0; i<n; ++i)
+  {
+    const double v = data.values[heap[i].second];
+    vmin = std::min(vmin, v);
+    vmax = std::max(vmax, v);
+    d2max = std::max(d2max, heap[i].first);
+  }
+
+  // query point coincides with a data point
+  for(unsigned int i=0; i<n; ++i)
+    if(heap[i].first <= 1e-20*d2max)
+      return data.values[heap[i].second];
+
+  // inverse distance weight, also used by MLS
+  std::vector<double> w(n);
+  double idw_sum = 0.0, idw_w = 0.0;
+  for(unsigned int i=0; i<n; ++i)
+  {
+    w[i] = 1.0/heap[i].first;
+    idw_sum += w[i]*data.values[heap[i].second];
+    idw_w   += w[i];
+  }
+  const double idw = idw_sum/idw_w;
+
+  const unsigned int m = _dim+1;
+  if(!_mls || n < m+1) return idw;
+
+  // weighted linear least squares fit centered at p, coordinates scaled by search radius
+  const double h = std::sqrt(d2max);
+  double A[4][5];
+  for(unsigned int r=0; r<m; ++r)
+    for(unsigned int c=0; c<=m; ++c)
+      A[r][c] = 0.0;
+
+  for(unsigned int i=0; i<n; ++i)
+  {
+    const double * c = &data.coords[heap[i].second*_dim];
+    double b[4];
+    b[0] = 1.0;
+    for(unsigned int d=0; d<_dim; ++d)
+      b[d+1] = (c[d]-p[d])/h;
+
+    const double v = data.values[heap[i].second];
+    for(unsigned int r=0; r<m; ++r)
+    {
+      for(unsigned int s=0; s<m; ++s)
+        A[r][s] += w[i]*b[r]*b[s];
+      A[r][m] += w[i]*b[r]*v;
+    }
+  }
+
+  // gauss elimination with partial pivoting, degenerated neighbors fall back to IDW
+  const double scale = A[0][0];
+  for(unsigned int col=0; col<m; ++col)
+  {
+    unsigned int pivot = col;
+    for(unsigned int r=col+1; r<m; ++r)
+      if(std::abs(A[r][col]) > std::abs(A[pivot][col])) pivot = r;
+    if(std::abs(A[pivot][col]) < 1e-10*scale) return idw;
+    if(pivot != col)
+      for(unsigned int c=0; c<=m; ++c)
+        std::swap(A[col][c], A[pivot][c]);
+
+    for(unsigned int r=col+1; r<m; ++r)
+    {
+      const double f = A[r][col]/A[col][col];
+      for(unsigned int c=col; c<=m; ++c)
+        A[r][c] -= f*A[col][c];
+    }
+  }
+
+  double x[4];
+  for(int r=m-1; r>=0; --r)
+  {
+    double s = A[r][m];
+    for(unsigned int c=r+1; c<m; ++c)
+      s -= A[r][c]*x[c];
+    x[r] = s/A[r][r];
+  }
+
+  // no overshoot beyond the neighbors
+  return std::max(vmin, std::min(vmax, x[0]));
+}
+
+
+double Interpolation_KDTree::_scaled_value(const DATA & data, const Point & point) const
+{
+  assert(data.built);
+
+  double p[3];
+  for(unsigned int d=0; d<_dim; ++d)
+    p[d] = point(d);
+
+  std::vector< std::pair<double, unsigned int> > heap;
+  heap.reserve(_k+1);
+  _search(data, p, 0, data.index.size(), heap);
+
+  if(heap.empty()) return 0.0;
+  return _fit(data, p, heap);
+}
+
+
+double Interpolation_KDTree::get_interpolated_value(const Point & point, int group) const
+{
+  std::map<int, DATA>::const_iterator it = _field.find(group);
+  assert(it != _field.end());
+
+  InterpolationType type = _interpolation_type.find(group)->second;
+  return unscaleValue(type, _scaled_value(it->second, point));
+}
+
+
+void Interpolation_KDTree::_batch(const DATA & data, InterpolationType type, const std::vector<Point> & points,
+                                  unsigned int begin, unsigned int end, std::vector<double> & values) const
+{
+  for(unsigned int n=begin; n<end; ++n)
+    values[n] = unscaleValue(type, _scaled_value(data, points[n]));
+}
+
+
+void * Interpolation_KDTree::_batch_thread(void * arg)
+{
+  const BatchJob * job = static_cast<const BatchJob *>(arg);
+  const Interpolation_KDTree * self = static_cast<const Interpolation_KDTree *>(job->self);
+  const DATA * data = static_cast<const DATA *>(job->data);
+  self->_batch(*data, static_cast<InterpolationType>(job->type), *job->points, job->begin, job->end, *job->values);
+  return NULL;
+}
+
+
+void Interpolation_KDTree::get_interpolated_values(const std::vector<Point> & points, int group, std::vector<double> & values) const
+{
+  std::map<int, DATA>::const_iterator it = _field.find(group);
+  assert(it != _field.end());
+  InterpolationType type = _interpolation_type.find(group)->second;
+
+  values.resize(points.size());
+
+  // small batch is not worth the threads
+  unsigned int n_threads = std::min(_n_threads, static_cast<unsigned int>(points.size()/1024 + 1));
+
+  std::vector<BatchJob> jobs(n_threads);
+  const unsigned int chunk = (points.size() + n_threads - 1)/n_threads;
+  for(unsigned int t=0; t<n_threads; ++t)
+  {
+    jobs[t].self   = this;
+    jobs[t].data   = &(it->second);
+    jobs[t].type   = type;
+    jobs[t].points = &points;
+    jobs[t].begin  = std::min<unsigned int>(t*chunk, points.size());
+    jobs[t].end    = std::min<unsigned int>((t+1)*chunk, points.size());
+    jobs[t].values = &values;
+  }
+
+#ifdef HAVE_PTHREAD
+  // the caller does the last piece
+  std::vector<pthread_t> threads(n_threads-1);
+  for(unsigned int t=0; t<n_threads-1; ++t)
+    pthread_create(&threads[t], NULL, _batch_thread, &jobs[t]);
+  _batch_thread(&jobs[n_threads-1]);
+  for(unsigned int t=0; t<n_threads-1; ++t)
+    pthread_join(threads[t], NULL);
+#else
+  for(unsigned int t=0; t<n_threads; ++t)
+    _batch_thread(&jobs[t]);
+#endif
+}
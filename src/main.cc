@@ -119,7 +119,8 @@ int main(int argc, char ** args)
   PetscPushErrorHandler(genius_error_handler, NULL);
 
   //show the GENIUS Log
-  show_logo();
+  if( Genius::is_ensemble_master() )
+    show_logo();
 
 #ifndef COGENDA_COMMERCIAL_PRODUCT
   if( Genius::n_processors() > 1 )
@@ -141,7 +142,7 @@ int main(int argc, char ** args)
   // count the number of user's input argument
   if(argc<2)
   {
-    PetscPrintf(PETSC_COMM_WORLD,"usage: mpirun -n [1-9]+ genius -i card_file [petsc_option]\n");
+    PetscPrintf(PETSC_COMM_WORLD,"usage: mpirun -n [1-9]+ genius -i card_file [-ensemble n] [petsc_option]\n");
     Genius::clean_processors();
     exit(0);
   }
@@ -200,14 +201,24 @@ int main(int argc, char ** args)
   std::ofstream logfs;
   if (Genius::processor_id() == 0)
   {
-    genius_log.addStream("console", std::cerr.rdbuf());
+    // only the first ensemble group writes to console, other groups have their own log file
     std::stringstream log_file;
-    log_file << Genius::input_file() << ".log";
+    if( Genius::is_ensemble_master() )
+    {
+      genius_log.addStream("console", std::cerr.rdbuf());
+      log_file << Genius::input_file() << ".log";
+    }
+    else
+      log_file << Genius::input_file() << ".g" << Genius::ensemble_id() << ".log";
     logfs.open(log_file.str().c_str());
     genius_log.addStream("file", logfs.rdbuf());
   }
 
   MESSAGE<<"Genius boot with " << Genius::n_processors() << " MPI thread.\n\n";  RECORD();
+  if( Genius::n_ensembles() > 1 )
+  {
+    MESSAGE<<"Ensemble run with " << Genius::n_ensembles() << " groups, this is group " << Genius::ensemble_id() << ".\n\n";  RECORD();
+  }
 
   // test if input file can be opened on processor 0 for read
   if ( Genius::processor_id() == 0 )
@@ -289,6 +300,8 @@ int main(int argc, char ** args)
   // do solve process here
   AutoPtr<SolverControl>  solve_ctrl = AutoPtr<SolverControl>(new SolverControl());
   solve_ctrl->setDecks(input.get());
+  // only the first ensemble group writes solution file
+  if( Genius::is_ensemble_master() )
   {
     std::stringstream fsol;
     fsol << Genius::input_file() << ".sol";
@@ -340,7 +353,8 @@ int main(int argc, char ** args)
   //finish log system
   if (Genius::processor_id() == 0)
   {
-    genius_log.removeStream("console");
+    if( Genius::is_ensemble_master() )
+      genius_log.removeStream("console");
     genius_log.removeStream("file");
     logfs.close();
   }
@@ -92,26 +92,28 @@ public:
   // procedure of Bandgap Narrowing due to Heavy Doping
   PetscScalar EgNarrow(const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N = Na+Nd+1.0*std::pow(cm,-3);
-    PetscScalar x = log(N/N0_BGN);
-    return V0_BGN*(x+sqrt(x*x+CON_BGN));
+    return EgNarrow_value(ReadDopingNa()+ReadDopingNd());
   }
   PetscScalar EgNarrowToEc   (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl){return 0.5*EgNarrow(p, n, Tl);}
   PetscScalar EgNarrowToEv   (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl){return 0.5*EgNarrow(p, n, Tl);}
 
   AutoDScalar EgNarrow(const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N = Na+Nd+1.0*std::pow(cm,-3);
-    PetscScalar x = log(N/N0_BGN);
-    return V0_BGN*(x+sqrt(x*x+CON_BGN));
+    return EgNarrow_value(ReadDopingNa()+ReadDopingNd());
   }
   AutoDScalar EgNarrowToEc   (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl){return 0.5*EgNarrow(p, n, Tl);}
   AutoDScalar EgNarrowToEv   (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl){return 0.5*EgNarrow(p, n, Tl);}
 
+private:
+  // band gap narrowing of total doping Na+Nd
+  PetscScalar EgNarrow_value(const PetscScalar &Nt)
+  {
+    PetscScalar N = Nt+1.0*std::pow(cm,-3);
+    PetscScalar x = log(N/N0_BGN);
+    return V0_BGN*(x+sqrt(x*x+CON_BGN));
+  }
+public:
+
 
   //---------------------------------------------------------------------------
   //electron and hole effect mass
@@ -150,22 +152,32 @@ public:
     return NV300*adtl::pow(Tl/T300,NV_F);
   }
 
-  PetscScalar ni (const PetscScalar &Tl)
+  // formulas shared by the scalar, AD and array versions
+  template <typename T>
+  T ni_value (const T &Tl)
   {
-    PetscScalar bandgap = Eg(Tl);
+    T bandgap = Eg(Tl);
     return sqrt(Nc(Tl)*Nv(Tl))*exp(-bandgap/(2*kb*Tl));
   }
+  template <typename T>
+  T nie_value (const T &ni, const T &dEg, const T &Tl)
+  {
+    return ni*exp(dEg/(2*kb*Tl));
+  }
+
+  PetscScalar ni (const PetscScalar &Tl)
+  {
+    return ni_value(Tl);
+  }
 
   // nie, Eg narrow should be considered
   PetscScalar nie (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
-    PetscScalar bandgap = Eg(Tl);
-    return sqrt(Nc(Tl)*Nv(Tl))*exp(-bandgap/(2*kb*Tl))*exp(EgNarrow(p, n, Tl)/(2*kb*Tl));
+    return nie_value(ni_value(Tl), EgNarrow(p, n, Tl), Tl);
   }
   AutoDScalar nie (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
-    AutoDScalar bandgap = Eg(Tl);
-    return sqrt(Nc(Tl)*Nv(Tl))*exp(-bandgap/(2*kb*Tl))*exp(EgNarrow(p, n, Tl)/(2*kb*Tl));
+    return nie_value(ni_value(Tl), EgNarrow(p, n, Tl), Tl);
   }
 
   //end of Bandgap
@@ -237,31 +249,32 @@ private:
 public:
   PetscScalar TAUN (const PetscScalar &Tl)
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    return TAUN0/(1+(Na+Nd)/NSRHN)*std::pow(Tl/T300,EXN_TAU);
+    return TAUN_T(Tl)*TAUN_DOP(ReadDopingNa()+ReadDopingNd());
   }
   AutoDScalar TAUN (const AutoDScalar &Tl)
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    return TAUN0/(1+(Na+Nd)/NSRHN)*adtl::pow(Tl/T300,EXN_TAU);
+    return TAUN_T(Tl)*TAUN_DOP(ReadDopingNa()+ReadDopingNd());
   }
 
   PetscScalar TAUP (const PetscScalar &Tl)
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    return TAUP0/(1+(Na+Nd)/NSRHP)*std::pow(Tl/T300,EXP_TAU);
+    return TAUP_T(Tl)*TAUP_DOP(ReadDopingNa()+ReadDopingNd());
   }
   AutoDScalar TAUP (const AutoDScalar &Tl)
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    return TAUP0/(1+(Na+Nd)/NSRHP)*adtl::pow(Tl/T300,EXP_TAU);
+    return TAUP_T(Tl)*TAUP_DOP(ReadDopingNa()+ReadDopingNd());
   }
   // End of Lifetime
 
+private:
+  // temperature and doping dependent parts of the lift time
+  PetscScalar TAUN_T (const PetscScalar &Tl) { return TAUN0*std::pow(Tl/T300,EXN_TAU); }
+  AutoDScalar TAUN_T (const AutoDScalar &Tl) { return TAUN0*adtl::pow(Tl/T300,EXN_TAU); }
+  PetscScalar TAUP_T (const PetscScalar &Tl) { return TAUP0*std::pow(Tl/T300,EXP_TAU); }
+  AutoDScalar TAUP_T (const AutoDScalar &Tl) { return TAUP0*adtl::pow(Tl/T300,EXP_TAU); }
+  PetscScalar TAUN_DOP (const PetscScalar &Nt) { return 1.0/(1+Nt/NSRHN); }
+  PetscScalar TAUP_DOP (const PetscScalar &Nt) { return 1.0/(1+Nt/NSRHP); }
+
   //the fit parameter for density-gradient solver
   PetscScalar Gamman         () {return 3.6;}
   PetscScalar Gammap         () {return 5.6;}
@@ -338,13 +351,11 @@ public:
   // Total Auger Recombination
   PetscScalar R_Auger     (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
-    PetscScalar ni =   nie(p, n, Tl);
-    return AUGN*(p*n*n-n*ni*ni)+AUGP*(n*p*p-p*ni*ni);
+    return R_Auger_value(p, n, nie(p, n, Tl));
   }
   AutoDScalar R_Auger     (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
-    AutoDScalar ni =   nie(p, n, Tl);
-    return AUGN*(p*n*n-n*ni*ni)+AUGP*(n*p*p-p*ni*ni);
+    return R_Auger_value(p, n, nie(p, n, Tl));
   }
 
   //---------------------------------------------------------------------------
@@ -377,17 +388,11 @@ public:
   // SHR Recombination
   PetscScalar R_SHR     (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
-    PetscScalar ni =   nie(p, n, Tl);
-    PetscScalar taun = TAUN(Tl);
-    PetscScalar taup = TAUP(Tl);
-    return (p*n-ni*ni)/(taup*(n+ni)+taun*(p+ni));
+    return R_SHR_value(p, n, nie(p, n, Tl), TAUN(Tl), TAUP(Tl));
   }
   AutoDScalar R_SHR     (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
-    AutoDScalar ni =   nie(p, n, Tl);
-    AutoDScalar taun = TAUN(Tl);
-    AutoDScalar taup = TAUP(Tl);
-    return (p*n-ni*ni)/(taup*(n+ni)+taun*(p+ni));
+    return R_SHR_value(p, n, nie(p, n, Tl), TAUN(Tl), TAUP(Tl));
   }
 
 
@@ -418,14 +423,7 @@ public:
   // total Recombination
   PetscScalar Recomb (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
-    PetscScalar ni =   nie(p, n, Tl);
-    PetscScalar taun = TAUN(Tl);
-    PetscScalar taup = TAUP(Tl);
-    PetscScalar Rshr = (p*n-ni*ni)/(taup*(n+ni)+taun*(p+ni));
-    PetscScalar Rdir = C_DIRECT*(n*p-ni*ni);
-    PetscScalar Raug = AUGN*(p*n*n-n*ni*ni)+AUGP*(n*p*p-p*ni*ni);
-    if(Raug<0) Raug = 0.0;
-    return Rshr+Rdir+Raug;
+    return Recomb_value(p, n, nie(p, n, Tl), TAUN(Tl), TAUP(Tl));
   }
   AutoDScalar Recomb (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
@@ -439,6 +437,105 @@ public:
     return Rshr+Rdir+Raug;
   }
 
+private:
+  // formulas shared by the scalar, AD and array versions
+  template <typename T>
+  T R_Auger_value (const T &p, const T &n, const T &ni)
+  {
+    return AUGN*(p*n*n-n*ni*ni)+AUGP*(n*p*p-p*ni*ni);
+  }
+  template <typename T>
+  T R_SHR_value (const T &p, const T &n, const T &ni, const T &taun, const T &taup)
+  {
+    return (p*n-ni*ni)/(taup*(n+ni)+taun*(p+ni));
+  }
+  // negative Auger term is clipped, the AD version above does not clip it
+  PetscScalar Recomb_value (const PetscScalar &p, const PetscScalar &n, const PetscScalar &ni,
+                            const PetscScalar &taun, const PetscScalar &taup)
+  {
+    PetscScalar Rshr = R_SHR_value(p, n, ni, taun, taup);
+    PetscScalar Rdir = C_DIRECT*(n*p-ni*ni);
+    PetscScalar Raug = R_Auger_value(p, n, ni);
+    if(Raug<0) Raug = 0.0;
+    return Rshr+Rdir+Raug;
+  }
+
+  //---------------------------------------------------------------------------
+  // bulk terms of size nodes. the doping is read from the node data of each
+  // context without switching node context, the temperature terms are evaluated
+  // again only when Tl differs from the previous node
+public:
+  void EgNarrow (unsigned int size, const PMI_NodeContext *ctx,
+                 const PetscScalar *, const PetscScalar *, const PetscScalar *, PetscScalar *dEg)
+  {
+    for(unsigned int i=0; i<size; ++i)
+      dEg[i] = EgNarrow_value(ReadDopingNa(ctx[i])+ReadDopingNd(ctx[i]));
+  }
+
+  void EgNarrowToEc (unsigned int size, const PMI_NodeContext *ctx,
+                     const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *dEc)
+  {
+    for(unsigned int i=0; i<size; ++i)
+      dEc[i] = 0.5*EgNarrow_value(ReadDopingNa(ctx[i])+ReadDopingNd(ctx[i]));
+  }
+
+  void EgNarrowToEv (unsigned int size, const PMI_NodeContext *ctx,
+                     const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *dEv)
+  {
+    for(unsigned int i=0; i<size; ++i)
+      dEv[i] = 0.5*EgNarrow_value(ReadDopingNa(ctx[i])+ReadDopingNd(ctx[i]));
+  }
+
+  void nie (unsigned int size, const PMI_NodeContext *ctx,
+            const PetscScalar *, const PetscScalar *, const PetscScalar *Tl, PetscScalar *ni_e)
+  {
+    PetscScalar T = -1.0, ni0 = 0.0;
+    for(unsigned int i=0; i<size; ++i)
+    {
+      if( Tl[i] != T ) { T = Tl[i]; ni0 = ni_value(T); }
+      PetscScalar Nt = ReadDopingNa(ctx[i])+ReadDopingNd(ctx[i]);
+      ni_e[i] = nie_value(ni0, EgNarrow_value(Nt), T);
+    }
+  }
+
+  void Recomb (unsigned int size, const PMI_NodeContext *ctx,
+               const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R)
+  {
+    PetscScalar T = -1.0, ni0 = 0.0, taun0 = 0.0, taup0 = 0.0;
+    for(unsigned int i=0; i<size; ++i)
+    {
+      if( Tl[i] != T ) { T = Tl[i]; ni0 = ni_value(T); taun0 = TAUN_T(T); taup0 = TAUP_T(T); }
+      PetscScalar Nt = ReadDopingNa(ctx[i])+ReadDopingNd(ctx[i]);
+      PetscScalar ni = nie_value(ni0, EgNarrow_value(Nt), T);
+      R[i] = Recomb_value(p[i], n[i], ni, taun0*TAUN_DOP(Nt), taup0*TAUP_DOP(Nt));
+    }
+  }
+
+  void R_SHR (unsigned int size, const PMI_NodeContext *ctx,
+              const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R)
+  {
+    PetscScalar T = -1.0, ni0 = 0.0, taun0 = 0.0, taup0 = 0.0;
+    for(unsigned int i=0; i<size; ++i)
+    {
+      if( Tl[i] != T ) { T = Tl[i]; ni0 = ni_value(T); taun0 = TAUN_T(T); taup0 = TAUP_T(T); }
+      PetscScalar Nt = ReadDopingNa(ctx[i])+ReadDopingNd(ctx[i]);
+      PetscScalar ni = nie_value(ni0, EgNarrow_value(Nt), T);
+      R[i] = R_SHR_value(p[i], n[i], ni, taun0*TAUN_DOP(Nt), taup0*TAUP_DOP(Nt));
+    }
+  }
+
+  void R_Auger (unsigned int size, const PMI_NodeContext *ctx,
+                const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R)
+  {
+    PetscScalar T = -1.0, ni0 = 0.0;
+    for(unsigned int i=0; i<size; ++i)
+    {
+      if( Tl[i] != T ) { T = Tl[i]; ni0 = ni_value(T); }
+      PetscScalar Nt = ReadDopingNa(ctx[i])+ReadDopingNd(ctx[i]);
+      R[i] = R_Auger_value(p[i], n[i], nie_value(ni0, EgNarrow_value(Nt), T));
+    }
+  }
+
   // End of Recombination
 private:
   PetscScalar  WTN0;
@@ -23,6 +23,8 @@
 #include <cmath>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
+#include <limits>
 
 #include "point.h"
 #include "fvm_node_data.h"
@@ -31,16 +33,58 @@
 
 using namespace adtl;
 
+#ifdef _MSC_VER
+  #define PMI_THREAD_LOCAL __declspec(thread)
+#else
+  #define PMI_THREAD_LOCAL __thread
+#endif
+
+/**
+ * the explicit node context of current thread
+ */
+static PMI_THREAD_LOCAL const PMI_NodeContext * thread_node_context = 0;
+
+/**
+ * set the node context of current thread
+ */
+const PMI_NodeContext * PMI_Server::set_node_context(const PMI_NodeContext *ctx) const
+{
+  const PMI_NodeContext * previous = thread_node_context;
+  thread_node_context = ctx;
+  return previous;
+}
+
+/**
+ * @return data of current node
+ */
+const FVM_NodeData * PMI_Server::CurrentNodeData() const
+{
+  if( thread_node_context ) return thread_node_context->node_data;
+  if( pp_node_data ) return *pp_node_data;
+  return 0;
+}
+
+/**
+ * @return location of current node
+ */
+const Point * PMI_Server::CurrentPoint() const
+{
+  if( thread_node_context ) return thread_node_context->point;
+  if( pp_point ) return *pp_point;
+  return 0;
+}
+
 /**
  * aux function return node coordinate.
  */
 void PMI_Server::ReadCoordinate (PetscScalar& x, PetscScalar& y, PetscScalar& z) const
 {
-  if(pp_point)
+  const Point * point = CurrentPoint();
+  if(point)
   {
-    x = (*pp_point)->x();
-    y = (*pp_point)->y();
-    z = (*pp_point)->z();
+    x = point->x();
+    y = point->y();
+    z = point->z();
   }
   else
   {
@@ -55,6 +99,8 @@ void PMI_Server::ReadCoordinate (PetscScalar& x, PetscScalar& y, PetscScalar& z)
  */
 PetscScalar PMI_Server::ReadTime () const
 {
+  if( thread_node_context )
+    return thread_node_context->time;
   if( p_clock )
     return *p_clock;
   return 0.0;
@@ -86,8 +132,9 @@ unsigned int PMI_Server::VariableIndex(const std::string &v) const
  */
 PetscScalar PMI_Server::ReadRealVariable (const unsigned int v) const
 {
-  if( pp_node_data )
-    return (*pp_node_data)->data<Real>(v);
+  const FVM_NodeData * node_data = CurrentNodeData();
+  if( node_data )
+    return node_data->data<Real>(v);
   return 0.0;
 }
 
@@ -97,12 +144,226 @@ PetscScalar PMI_Server::ReadRealVariable (const unsigned int v) const
  */
 PetscScalar PMI_Server::ReadRealVariable (const std::string & v) const
 {
-  if( pp_node_data )
-    return (*pp_node_data)->data<Real>(v);
+  const FVM_NodeData * node_data = CurrentNodeData();
+  if( node_data )
+    return node_data->data<Real>(v);
   return 0.0;
 }
 
 
+/**
+ * the key of node cache, lattice temperature and node data
+ */
+static const unsigned int node_cache_key = 5;
+
+/**
+ * declare n values cached for each node
+ */
+void PMI_Server::DeclareNodeCache(unsigned int n, bool temperature)
+{
+  _node_cache_size = n;
+  _node_cache_temperature = temperature;
+  _node_cache_buffer.resize(n);
+  ClearNodeCache();
+}
+
+
+/**
+ * @return the cache entry of node_data
+ */
+PetscScalar * PMI_Server::NodeCacheEntry(const FVM_NodeData *node_data, const PetscScalar &T, bool &valid) const
+{
+  const unsigned int stride = node_cache_key + _node_cache_size;
+  const unsigned int offset = node_data->offset();
+
+  if( (offset+1)*stride > _node_cache.size() )
+  {
+    unsigned int n_nodes = std::max(offset+1, node_data->data_storage()->size());
+    _node_cache.resize(n_nodes*stride, std::numeric_limits<PetscScalar>::quiet_NaN());
+  }
+
+  PetscScalar * entry = &_node_cache[offset*stride];
+  const PetscScalar key[node_cache_key] =
+    { T, node_data->Total_Na(), node_data->Total_Nd(), node_data->mole_x(), node_data->mole_y() };
+
+  // NaN of an empty entry never matches
+  valid = ( entry[0] == key[0] && entry[1] == key[1] && entry[2] == key[2] &&
+            entry[3] == key[3] && entry[4] == key[4] );
+  if( !valid )
+    std::copy(key, key+node_cache_key, entry);
+
+  return entry+node_cache_key;
+}
+
+
+/**
+ * @return the cached values of current node
+ */
+const PetscScalar * PMI_Server::ReadNodeCache(const PetscScalar &Tl) const
+{
+  const PetscScalar T = _node_cache_temperature ? Tl : 0.0;
+
+  // debug environment, no node data
+  const FVM_NodeData * node_data = CurrentNodeData();
+  if( !node_data )
+  {
+    EvalNodeCache(T, &_node_cache_buffer[0]);
+    return &_node_cache_buffer[0];
+  }
+
+  bool valid;
+  PetscScalar * values = NodeCacheEntry(node_data, T, valid);
+  if( !valid )
+    EvalNodeCache(T, values);
+  return values;
+}
+
+
+/**
+ * @return the cached values of the node in given context
+ */
+const PetscScalar * PMI_Server::ReadNodeCache(const PMI_NodeContext &ctx, const PetscScalar &Tl) const
+{
+  const PetscScalar T = _node_cache_temperature ? Tl : 0.0;
+
+  if( !ctx.node_data )
+  {
+    ContextScope scope(*this, ctx);
+    EvalNodeCache(T, &_node_cache_buffer[0]);
+    return &_node_cache_buffer[0];
+  }
+
+  bool valid;
+  PetscScalar * values = NodeCacheEntry(ctx.node_data, T, valid);
+  if( !valid )
+  {
+    ContextScope scope(*this, ctx);
+    EvalNodeCache(T, values);
+  }
+  return values;
+}
+
+
+/**
+ * invalidate the cached values of all the nodes
+ */
+void PMI_Server::ClearNodeCache()
+{
+  _node_cache.clear();
+}
+
+
+/**
+ * @return all the parameter values in full precision
+ */
+std::string PMI_Server::ParameterSignature() const
+{
+  std::map<std::string, PARA> paras;
+  collect_parameters(paras);
+
+  std::stringstream ss;
+  ss << std::setprecision(17);
+  for( std::map<std::string, PARA>::const_iterator it = paras.begin(); it != paras.end() ; ++it )
+  {
+    ss << it->first << '=';
+    if ( it->second.type == PARA::String )
+      ss << *((std::string*)it->second.value);
+    else
+      ss << *((PetscScalar*)it->second.value);
+    ss << ';';
+  }
+  return ss.str();
+}
+
+
+/**
+ * find parameter in parameter_map and the shared table
+ */
+bool PMI_Server::find_parameter(const std::string & name, PARA & para) const
+{
+  std::map<std::string, PARA>::const_iterator it = parameter_map.find(name);
+  if( it != parameter_map.end() )
+  {
+    para = it->second;
+    return true;
+  }
+
+  if( !_parameter_table ) return false;
+
+  std::map<std::string, std::pair<PARA, std::ptrdiff_t> >::const_iterator t = _parameter_table->parameters.find(name);
+  if( t == _parameter_table->parameters.end() ) return false;
+
+  para = t->second.first;
+  para.value = const_cast<char *>(reinterpret_cast<const char *>(this)) + t->second.second;
+  return true;
+}
+
+
+/**
+ * all the parameters in parameter_map and the shared table
+ */
+void PMI_Server::collect_parameters(std::map<std::string, PARA > & paras) const
+{
+  paras = parameter_map;
+  if( !_parameter_table ) return;
+
+  std::map<std::string, std::pair<PARA, std::ptrdiff_t> >::const_iterator t = _parameter_table->parameters.begin();
+  for( ; t != _parameter_table->parameters.end(); ++t )
+  {
+    // parameters added after sharing stay in parameter_map
+    if( paras.find(t->first) != paras.end() ) continue;
+    PARA & para = paras[t->first];
+    para = t->second.first;
+    para.value = const_cast<char *>(reinterpret_cast<const char *>(this)) + t->second.second;
+  }
+}
+
+
+/**
+ * fill table by parameter_map
+ */
+void PMI_Server::build_parameter_table(PMI_ParameterTable & table) const
+{
+  table.parameters.clear();
+  for( std::map<std::string, PARA>::const_iterator it = parameter_map.begin(); it != parameter_map.end() ; ++it )
+  {
+    PARA para = it->second;
+    para.value = 0;
+    std::ptrdiff_t offset = static_cast<const char *>(it->second.value) - reinterpret_cast<const char *>(this);
+    table.parameters.insert( std::make_pair(it->first, std::make_pair(para, offset)) );
+  }
+}
+
+
+/**
+ * drop parameter_map and use table of the same class. the parameters must have the same
+ * description and offset, a value which is not a member of this object never matches
+ */
+bool PMI_Server::share_parameter_table(const PMI_ParameterTable & table)
+{
+  if( _parameter_table ) return false;
+
+  PMI_ParameterTable own;
+  build_parameter_table(own);
+  if( own.parameters.size() != table.parameters.size() ) return false;
+
+  std::map<std::string, std::pair<PARA, std::ptrdiff_t> >::const_iterator it1 = own.parameters.begin();
+  std::map<std::string, std::pair<PARA, std::ptrdiff_t> >::const_iterator it2 = table.parameters.begin();
+  for( ; it1 != own.parameters.end(); ++it1, ++it2 )
+  {
+    const PARA & p1 = it1->second.first;
+    const PARA & p2 = it2->second.first;
+    if( it1->first != it2->first || it1->second.second != it2->second.second ) return false;
+    if( p1.name != p2.name || p1.type != p2.type || p1.brief_intro != p2.brief_intro ) return false;
+    if( p1.unit_in_string != p2.unit_in_string || p1.unit_in_real != p2.unit_in_real ) return false;
+  }
+
+  std::map<std::string, PARA>().swap(parameter_map);
+  _parameter_table = &table;
+  return true;
+}
+
+
 #ifdef   __CALIBRATE__
 
 /**
@@ -111,10 +372,10 @@ PetscScalar PMI_Server::ReadRealVariable (const std::string & v) const
  */
 int PMI_Server::calibrate_real_parameter(const std::string & var_name, PetscScalar var_value)
 {
-  std::map<std::string, PARA>::iterator it = parameter_map.find(var_name);
-  if( it != parameter_map.end() && it->second.type==PARA::Real)
+  PARA para;
+  if( find_parameter(var_name, para) && para.type==PARA::Real)
   {
-    *((PetscScalar*)it->second.value) = var_value*(it->second.unit_in_real);
+    *((PetscScalar*)para.value) = var_value*(para.unit_in_real);
     return 0;
   }
 
@@ -129,10 +390,10 @@ int PMI_Server::calibrate_real_parameter(const std::string & var_name, PetscScal
  */
 int PMI_Server::calibrate_string_parameter(const std::string & var_name, const std::string &var_value)
 {
-  std::map<std::string, PARA>::iterator it = parameter_map.find(var_name);
-  if( it != parameter_map.end() && it->second.type==PARA::String)
+  PARA para;
+  if( find_parameter(var_name, para) && para.type==PARA::String)
   {
-    *((std::string*)it->second.value) = var_value;
+    *((std::string*)para.value) = var_value;
     return 0;
   }
 
@@ -163,7 +424,13 @@ int PMI_Server::calibrate(std::vector<Parser::Parameter> & pmi_parameters)
     }
   }
 
+  // post calibrate process reports inconsistent settings in calibrate error info
+  const std::string::size_type info_size = _calibrate_error_info.size();
   this->post_calibrate_process();
+  if( _calibrate_error_info.size() > info_size ) ierr++;
+
+  // cached values depend on parameters
+  this->ClearNodeCache();
 
   return ierr;
 }
@@ -175,7 +442,8 @@ int PMI_Server::calibrate(std::vector<Parser::Parameter> & pmi_parameters)
  */
 std::map<std::string, PARA > & PMI_Server::get_parameter_info()
 {
-  return parameter_map;
+  collect_parameters(_parameter_info);
+  return _parameter_info;
 }
 
 /**
@@ -203,8 +471,11 @@ const std::string & PMI_Server::get_parameter_string(const int verbosity)
          << std::setw(wd_unit) << "Unit" << "   "
          << std::setw(twd) << std::left << "Description" << std::right << std::endl;
 
-  for( std::map<std::string, PARA>::const_iterator it = parameter_map.begin();
-      it != parameter_map.end() ; ++it )
+  std::map<std::string, PARA> paras;
+  collect_parameters(paras);
+
+  for( std::map<std::string, PARA>::const_iterator it = paras.begin();
+      it != paras.end() ; ++it )
   {
     output << std::setw(wd_name) << it->second.name ;
     if ( it->second.type == PARA::String )
@@ -242,7 +513,8 @@ const std::string & PMI_Server::get_parameter_string(const int verbosity)
  * also set the physical constants
  */
 PMI_Server::PMI_Server(const PMI_Environment &env)
-  : pp_variables(env.pp_variables), pp_point(env.pp_point), pp_node_data(env.pp_node_data), p_clock(env.p_clock)
+  : pp_variables(env.pp_variables), pp_point(env.pp_point), pp_node_data(env.pp_node_data), p_clock(env.p_clock),
+    _parameter_table(0), _node_cache_size(0), _node_cache_temperature(false)
 {
 
   m  = env.m;
@@ -308,7 +580,8 @@ void PMIS_Server::SetFakeStrainEnvironment(const TensorValue<PetscScalar> &T)
  */
 PetscScalar PMIS_Server::ReadxMoleFraction () const
 {
-  if(pp_node_data) return (*pp_node_data)->mole_x();
+  const FVM_NodeData * node_data = CurrentNodeData();
+  if(node_data) return node_data->mole_x();
   return _mole_x;
 }
 
@@ -317,9 +590,10 @@ PetscScalar PMIS_Server::ReadxMoleFraction () const
  */
 PetscScalar PMIS_Server::ReadxMoleFraction (const PetscScalar mole_xmin, const PetscScalar mole_xmax) const
 {
-  if(pp_node_data)
+  const FVM_NodeData * node_data = CurrentNodeData();
+  if(node_data)
   {
-    PetscScalar mole_x=(*pp_node_data)->mole_x();
+    PetscScalar mole_x=node_data->mole_x();
     if( mole_x < mole_xmin ) return mole_xmin;
     if( mole_x > mole_xmax ) return mole_xmax;
     return mole_x;
@@ -332,7 +606,8 @@ PetscScalar PMIS_Server::ReadxMoleFraction (const PetscScalar mole_xmin, const P
  */
 PetscScalar PMIS_Server::ReadyMoleFraction () const
 {
-  if(pp_node_data) return (*pp_node_data)->mole_y();
+  const FVM_NodeData * node_data = CurrentNodeData();
+  if(node_data) return node_data->mole_y();
   return _mole_y;
 }
 
@@ -341,9 +616,10 @@ PetscScalar PMIS_Server::ReadyMoleFraction () const
  */
 PetscScalar PMIS_Server::ReadyMoleFraction (const PetscScalar mole_ymin, const PetscScalar mole_ymax) const
 {
-  if(pp_node_data)
+  const FVM_NodeData * node_data = CurrentNodeData();
+  if(node_data)
   {
-    PetscScalar mole_y=(*pp_node_data)->mole_y();
+    PetscScalar mole_y=node_data->mole_y();
     if( mole_y < mole_ymin ) return mole_ymin;
     if( mole_y > mole_ymax ) return mole_ymax;
     return mole_y;
@@ -356,7 +632,8 @@ PetscScalar PMIS_Server::ReadyMoleFraction (const PetscScalar mole_ymin, const P
  */
 PetscScalar PMIS_Server::ReadDopingNa () const
 {
-  if(pp_node_data)  return (*pp_node_data)->Total_Na();
+  const FVM_NodeData * node_data = CurrentNodeData();
+  if(node_data) return node_data->Total_Na();
   return _Na;
 }
 
@@ -365,7 +642,26 @@ PetscScalar PMIS_Server::ReadDopingNa () const
  */
 PetscScalar PMIS_Server::ReadDopingNd () const
 {
-  if(pp_node_data) return (*pp_node_data)->Total_Nd();
+  const FVM_NodeData * node_data = CurrentNodeData();
+  if(node_data) return node_data->Total_Nd();
+  return _Nd;
+}
+
+/**
+ * aux function return total Acceptor concentration of the node in given context
+ */
+PetscScalar PMIS_Server::ReadDopingNa (const PMI_NodeContext &ctx) const
+{
+  if(ctx.node_data) return ctx.node_data->Total_Na();
+  return _Na;
+}
+
+/**
+ * aux function return total Donor concentration of the node in given context
+ */
+PetscScalar PMIS_Server::ReadDopingNd (const PMI_NodeContext &ctx) const
+{
+  if(ctx.node_data) return ctx.node_data->Total_Nd();
   return _Nd;
 }
 
@@ -374,7 +670,8 @@ PetscScalar PMIS_Server::ReadDopingNd () const
  */
 PetscScalar PMIS_Server::ReadDmin () const
 {
-  if(pp_node_data) return (*pp_node_data)->dmin();
+  const FVM_NodeData * node_data = CurrentNodeData();
+  if(node_data) return node_data->dmin();
   return _dmin;
 }
 
@@ -384,12 +681,212 @@ PetscScalar PMIS_Server::ReadDmin () const
  */
 TensorValue<PetscScalar> PMIS_Server::ReadStrain() const
 {
-  if(pp_node_data) return (*pp_node_data)->strain();
+  const FVM_NodeData * node_data = CurrentNodeData();
+  if(node_data) return node_data->strain();
   return _strain;
 }
 
 
 
+/*****************************************************************************
+ *               Reentrant bulk interface of semiconductor
+ ****************************************************************************/
+
+/**
+ * conduction band shift of size nodes, node by node
+ */
+void PMIS_BandStructure::EgNarrowToEc (unsigned int size, const PMI_NodeContext *ctx,
+                                       const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *dEc)
+{
+  if( !size ) return;
+  ContextScope scope(*this, ctx[0]);
+  for(unsigned int i=0; i<size; ++i)
+  {
+    set_node_context(ctx+i);
+    dEc[i] = EgNarrowToEc(p[i], n[i], Tl[i]);
+  }
+}
+
+
+/**
+ * valence band shift of size nodes, node by node
+ */
+void PMIS_BandStructure::EgNarrowToEv (unsigned int size, const PMI_NodeContext *ctx,
+                                       const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *dEv)
+{
+  if( !size ) return;
+  ContextScope scope(*this, ctx[0]);
+  for(unsigned int i=0; i<size; ++i)
+  {
+    set_node_context(ctx+i);
+    dEv[i] = EgNarrowToEv(p[i], n[i], Tl[i]);
+  }
+}
+
+
+/**
+ * effective intrinsic carrier concentration of size nodes, node by node
+ */
+void PMIS_BandStructure::nie (unsigned int size, const PMI_NodeContext *ctx,
+                              const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *ni)
+{
+  if( !size ) return;
+  ContextScope scope(*this, ctx[0]);
+  for(unsigned int i=0; i<size; ++i)
+  {
+    set_node_context(ctx+i);
+    ni[i] = nie(p[i], n[i], Tl[i]);
+  }
+}
+
+
+/**
+ * total recombination of size nodes, node by node
+ */
+void PMIS_BandStructure::Recomb (unsigned int size, const PMI_NodeContext *ctx,
+                                 const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R)
+{
+  if( !size ) return;
+  ContextScope scope(*this, ctx[0]);
+  for(unsigned int i=0; i<size; ++i)
+  {
+    set_node_context(ctx+i);
+    R[i] = Recomb(p[i], n[i], Tl[i]);
+  }
+}
+
+
+/**
+ * band gap narrowing of size nodes, node by node
+ */
+void PMIS_BandStructure::EgNarrow (unsigned int size, const PMI_NodeContext *ctx,
+                                   const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *dEg)
+{
+  if( !size ) return;
+  ContextScope scope(*this, ctx[0]);
+  for(unsigned int i=0; i<size; ++i)
+  {
+    set_node_context(ctx+i);
+    dEg[i] = EgNarrow(p[i], n[i], Tl[i]);
+  }
+}
+
+
+/**
+ * SRH recombination of size nodes, node by node
+ */
+void PMIS_BandStructure::R_SHR (unsigned int size, const PMI_NodeContext *ctx,
+                                const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R)
+{
+  if( !size ) return;
+  ContextScope scope(*this, ctx[0]);
+  for(unsigned int i=0; i<size; ++i)
+  {
+    set_node_context(ctx+i);
+    R[i] = R_SHR(p[i], n[i], Tl[i]);
+  }
+}
+
+
+/**
+ * Auger recombination of size nodes, node by node
+ */
+void PMIS_BandStructure::R_Auger (unsigned int size, const PMI_NodeContext *ctx,
+                                  const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R)
+{
+  if( !size ) return;
+  ContextScope scope(*this, ctx[0]);
+  for(unsigned int i=0; i<size; ++i)
+  {
+    set_node_context(ctx+i);
+    R[i] = R_Auger(p[i], n[i], Tl[i]);
+  }
+}
+
+
+/**
+ * direct recombination of size nodes, node by node
+ */
+void PMIS_BandStructure::R_Direct (unsigned int size, const PMI_NodeContext *ctx,
+                                   const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R)
+{
+  if( !size ) return;
+  ContextScope scope(*this, ctx[0]);
+  for(unsigned int i=0; i<size; ++i)
+  {
+    set_node_context(ctx+i);
+    R[i] = R_Direct(p[i], n[i], Tl[i]);
+  }
+}
+
+
+/**
+ * electron mobility of size nodes, node by node
+ */
+void PMIS_Mobility::ElecMob (unsigned int size, const PMI_NodeContext *ctx,
+                             const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                             const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tn, PetscScalar *mu) const
+{
+  if( !size ) return;
+  ContextScope scope(*this, ctx[0]);
+  for(unsigned int i=0; i<size; ++i)
+  {
+    set_node_context(ctx+i);
+    mu[i] = ElecMob(p[i], n[i], Tl[i], Ep[i], Et[i], Tn[i]);
+  }
+}
+
+
+/**
+ * hole mobility of size nodes, node by node
+ */
+void PMIS_Mobility::HoleMob (unsigned int size, const PMI_NodeContext *ctx,
+                             const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                             const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tp, PetscScalar *mu) const
+{
+  if( !size ) return;
+  ContextScope scope(*this, ctx[0]);
+  for(unsigned int i=0; i<size; ++i)
+  {
+    set_node_context(ctx+i);
+    mu[i] = HoleMob(p[i], n[i], Tl[i], Ep[i], Et[i], Tp[i]);
+  }
+}
+
+
+/**
+ * electron generation rate of size items, one by one
+ */
+void PMIS_Avalanche::ElecGenRate (unsigned int size, const PMI_NodeContext *ctx,
+                                  const PetscScalar *Tl, const PetscScalar *Ep, const PetscScalar *Eg, PetscScalar *G) const
+{
+  if( !size ) return;
+  ContextScope scope(*this, ctx[0]);
+  for(unsigned int i=0; i<size; ++i)
+  {
+    set_node_context(ctx+i);
+    G[i] = ElecGenRate(Tl[i], Ep[i], Eg[i]);
+  }
+}
+
+
+/**
+ * hole generation rate of size items, one by one
+ */
+void PMIS_Avalanche::HoleGenRate (unsigned int size, const PMI_NodeContext *ctx,
+                                  const PetscScalar *Tl, const PetscScalar *Ep, const PetscScalar *Eg, PetscScalar *G) const
+{
+  if( !size ) return;
+  ContextScope scope(*this, ctx[0]);
+  for(unsigned int i=0; i<size; ++i)
+  {
+    set_node_context(ctx+i);
+    G[i] = HoleGenRate(Tl[i], Ep[i], Eg[i]);
+  }
+}
+
+
+
 
 /*****************************************************************************
  *               Physical Model Interface for Optical
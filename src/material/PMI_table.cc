@@ -0,0 +1,541 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cassert>
+#include <limits>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "config.h"
+#ifdef WINDOWS
+  #include <direct.h>
+#else
+  #include <sys/stat.h>
+  #include <sys/types.h>
+  #include <cerrno>
+#endif
+
+#include "PMI_table.h"
+
+
+namespace
+{
+  /**
+   * tables of this material library, indexed by key
+   */
+  std::map<std::string, PMI_Table::Data> & table_registry()
+  {
+    static std::map<std::string, PMI_Table::Data> registry;
+    return registry;
+  }
+
+  const char * table_magic = "GENIUS_PMI_TABLE 2";
+
+  /**
+   * 64 bit FNV-1a hash in hex, used as cache file name
+   */
+  std::string key_hash(const std::string &key)
+  {
+    unsigned long long h = 14695981039346656037ULL;
+    for(unsigned int i=0; i<key.size(); ++i)
+    {
+      h ^= static_cast<unsigned char>(key[i]);
+      h *= 1099511628211ULL;
+    }
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << h;
+    return ss.str();
+  }
+
+  /**
+   * create directory and its parents, only the owner can access the new ones
+   * @return false if the directory can't be created
+   */
+  bool make_dir(const std::string &dir)
+  {
+    for(std::string::size_type p = dir.find_first_of("/\\", 1); ; p = dir.find_first_of("/\\", p+1))
+    {
+      const std::string sub = dir.substr(0, p);
+#ifdef WINDOWS
+      _mkdir(sub.c_str());
+#else
+      if( mkdir(sub.c_str(), 0700) != 0 && errno != EEXIST ) return false;
+#endif
+      if( p == std::string::npos ) break;
+    }
+
+#ifdef WINDOWS
+    return true;
+#else
+    struct stat st;
+    return stat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+  }
+
+  /**
+   * per user cache directory, GENIUS_PMI_CACHE overrides it
+   * @return empty string when disk cache is disabled or not available
+   */
+  std::string cache_dir()
+  {
+    if( getenv("GENIUS_PMI_CACHE") ) return getenv("GENIUS_PMI_CACHE");
+
+    std::string dir;
+#ifdef WINDOWS
+    if( getenv("LOCALAPPDATA") ) dir = std::string(getenv("LOCALAPPDATA")) + "\\genius\\pmi_cache";
+#else
+    if( getenv("XDG_CACHE_HOME") && *getenv("XDG_CACHE_HOME") ) dir = std::string(getenv("XDG_CACHE_HOME")) + "/genius/pmi";
+    else if( getenv("HOME") && *getenv("HOME") )               dir = std::string(getenv("HOME")) + "/.cache/genius/pmi";
+#endif
+    if( dir.empty() || !make_dir(dir) ) return "";
+    return dir;
+  }
+
+  /**
+   * cubic convolution stencil of one axis at t in cell i, the points out of
+   * range are folded into the first three points by quadratic extrapolation
+   * @return the number of stencil points
+   */
+  unsigned int stencil(unsigned int i, PetscScalar t, unsigned int n,
+                       unsigned int *idx, PetscScalar *w, PetscScalar *dw)
+  {
+    const PetscScalar t2 = t*t, t3 = t2*t;
+    const PetscScalar cw[4]  = { 0.5*(-t3+2*t2-t), 0.5*(3*t3-5*t2+2), 0.5*(-3*t3+4*t2+t), 0.5*(t3-t2) };
+    const PetscScalar cdw[4] = { 0.5*(-3*t2+4*t-1), 0.5*(9*t2-10*t), 0.5*(-9*t2+8*t+1), 0.5*(3*t2-2*t) };
+
+    // interior cell
+    if( i >= 1 && i+2 < n )
+    {
+      for(unsigned int k=0; k<4; ++k)
+      {
+        idx[k] = i-1+k;
+        w[k]   = cw[k];
+        dw[k]  = cdw[k];
+      }
+      return 4;
+    }
+
+    unsigned int m = 0;
+    for(int k=0; k<4; ++k)
+    {
+      int j = static_cast<int>(i) - 1 + k;
+      int base = j, dir = 1;
+      PetscScalar fold[3] = {1.0, 0.0, 0.0};
+      if( j < 0 )               { base = 0;   dir =  1; fold[0] = 3.0; fold[1] = -3.0; fold[2] = 1.0; }
+      if( j > static_cast<int>(n)-1 ) { base = n-1; dir = -1; fold[0] = 3.0; fold[1] = -3.0; fold[2] = 1.0; }
+
+      for(int l=0; l<3; ++l)
+      {
+        if( fold[l] == 0.0 ) continue;
+        unsigned int jj = base + dir*l;
+        unsigned int s = 0;
+        for(; s<m; ++s)
+          if( idx[s] == jj ) break;
+        if( s == m ) { idx[m] = jj; w[m] = 0.0; dw[m] = 0.0; ++m; }
+        w[s]  += fold[l]*cw[k];
+        dw[s] += fold[l]*cdw[k];
+      }
+    }
+    return m;
+  }
+
+
+  /**
+   * weighted sum of the stencil along the first axis, N>0 is the number of
+   * outputs known at compile time, the loops of small tables are unrolled
+   */
+  template <unsigned int N>
+  inline void axis_sum(const std::vector<PetscScalar> &values, unsigned int offset, unsigned int m,
+                       const unsigned int *idx, unsigned int stride, const PetscScalar *w, const PetscScalar *dw,
+                       unsigned int n_out, PetscScalar *sum, PetscScalar *dsum)
+  {
+    const unsigned int n = N ? N : n_out;
+    for(unsigned int o=0; o<n; ++o)
+      sum[o] = dsum[o] = 0.0;
+    for(unsigned int k=0; k<m; ++k)
+    {
+      const PetscScalar * v = &values[offset + idx[k]*stride];
+      for(unsigned int o=0; o<n; ++o)
+      {
+        sum[o]  += w[k]*v[o];
+        dsum[o] += dw[k]*v[o];
+      }
+    }
+  }
+}
+
+
+PMI_Table::PMI_Table()
+  : _n_outputs(0), _data(0)
+{}
+
+
+void PMI_Table::clear()
+{
+  _axes.clear();
+  _n_outputs = 0;
+  _data = 0;
+}
+
+
+void PMI_Table::add_axis(PetscScalar min, PetscScalar max, unsigned int n, Scale scale)
+{
+  assert( _axes.size() < 4 );
+  assert( n >= 4 && max > min );
+  assert( scale == Linear || min > 0 );
+
+  Axis axis;
+  axis.min   = min;
+  axis.max   = max;
+  axis.n     = n;
+  axis.scale = scale;
+  axis.u0    = scale == Log ? std::log(min) : min;
+  axis.h     = ((scale == Log ? std::log(max) : max) - axis.u0)/(n-1);
+  _axes.push_back(axis);
+
+  _data = 0;
+}
+
+
+std::string PMI_Table::_key(const std::string &model, const std::string &build_id, const std::string &signature) const
+{
+  std::stringstream ss;
+  ss << std::setprecision(17) << model << '\n' << build_id << '\n' << signature << '\n' << _n_outputs;
+  for(unsigned int d=0; d<_axes.size(); ++d)
+    ss << ' ' << _axes[d].min << ' ' << _axes[d].max << ' ' << _axes[d].n << ' ' << _axes[d].scale;
+  return ss.str();
+}
+
+
+void PMI_Table::build(const Function &func, unsigned int n_outputs,
+                      const std::string &model, const std::string &build_id, const std::string &signature)
+{
+  assert( n_outputs >= 1 && n_outputs <= 16 );
+  _n_outputs = n_outputs;
+  const std::string key = _key(model, build_id, signature);
+
+  std::map<std::string, Data> & registry = table_registry();
+  std::map<std::string, Data>::iterator it = registry.find(key);
+  if( it != registry.end() )
+  {
+    _data = &(it->second);
+    return;
+  }
+
+  Data & data = registry[key];
+
+  const std::string dir = cache_dir();
+  const std::string file = dir + "/genius_pmi_" + key_hash(key) + ".tab";
+
+  if( dir.empty() || !_load(file, key, data) )
+  {
+    _sample(func, data);
+    if( !dir.empty() ) _save(file, key, data);
+  }
+
+  _data = &data;
+}
+
+
+void PMI_Table::_sample(const Function &func, Data &data) const
+{
+  const unsigned int dim = _axes.size();
+
+  unsigned int n_nodes = 1;
+  for(unsigned int d=0; d<dim; ++d)
+    n_nodes *= _axes[d].n;
+
+  data.values.resize(n_nodes*_n_outputs);
+  data.cached = false;
+
+  PetscScalar x[4];
+  for(unsigned int node=0; node<n_nodes; ++node)
+  {
+    unsigned int r = node;
+    for(unsigned int d=0; d<dim; ++d)
+    {
+      const Axis & axis = _axes[d];
+      const PetscScalar u = axis.u0 + (r%axis.n)*axis.h;
+      x[d] = axis.scale == Log ? std::exp(u) : u;
+      r /= axis.n;
+    }
+    func(x, &data.values[node*_n_outputs]);
+  }
+
+  // compare with the model at pseudo random points, uniform in scaled coordinate
+  PetscScalar scale = 0.0;
+  for(unsigned int i=0; i<data.values.size(); ++i)
+    scale = std::max(scale, std::abs(data.values[i]));
+  const PetscScalar tiny = 1e-6*scale + std::numeric_limits<PetscScalar>::min();
+
+  data.abs_error.assign(_n_outputs, 0.0);
+  data.rel_error.assign(_n_outputs, 0.0);
+
+  std::vector<PetscScalar> exact(_n_outputs), approx(_n_outputs);
+  unsigned long long seed = 88172645463325252ULL;
+  const unsigned int n_tests = std::min(4*n_nodes, 20000u);
+  for(unsigned int i=0; i<n_tests; ++i)
+  {
+    for(unsigned int d=0; d<dim; ++d)
+    {
+      seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+      const PetscScalar r = (seed >> 11)*(1.0/9007199254740992.0);
+      const Axis & axis = _axes[d];
+      const PetscScalar u = axis.u0 + r*(axis.n-1)*axis.h;
+      x[d] = axis.scale == Log ? std::exp(u) : u;
+    }
+    func(x, &exact[0]);
+    _value(data.values, x, &approx[0], 0);
+    for(unsigned int o=0; o<_n_outputs; ++o)
+    {
+      const PetscScalar err = std::abs(approx[o] - exact[o]);
+      data.abs_error[o] = std::max(data.abs_error[o], err);
+      data.rel_error[o] = std::max(data.rel_error[o], err/std::max(std::abs(exact[o]), tiny));
+    }
+  }
+}
+
+
+bool PMI_Table::_load(const std::string &file, const std::string &key, Data &data) const
+{
+  std::ifstream in(file.c_str(), std::ios::binary);
+  if( !in.good() ) return false;
+
+  std::string magic;
+  std::getline(in, magic);
+  if( magic != table_magic ) return false;
+
+  // full key guards against hash collision and changed grid
+  unsigned int key_size = 0;
+  in.read(reinterpret_cast<char *>(&key_size), sizeof(unsigned int));
+  if( !in.good() || key_size != key.size() ) return false;
+  std::string stored(key_size, ' ');
+  in.read(&stored[0], key_size);
+  if( stored != key ) return false;
+
+  unsigned int n_values = 0;
+  in.read(reinterpret_cast<char *>(&n_values), sizeof(unsigned int));
+
+  unsigned int n_nodes = 1;
+  for(unsigned int d=0; d<_axes.size(); ++d)
+    n_nodes *= _axes[d].n;
+  if( !in.good() || n_values != n_nodes*_n_outputs ) return false;
+
+  data.abs_error.resize(_n_outputs);
+  data.rel_error.resize(_n_outputs);
+  data.values.resize(n_values);
+  in.read(reinterpret_cast<char *>(&data.abs_error[0]), _n_outputs*sizeof(PetscScalar));
+  in.read(reinterpret_cast<char *>(&data.rel_error[0]), _n_outputs*sizeof(PetscScalar));
+  in.read(reinterpret_cast<char *>(&data.values[0]), n_values*sizeof(PetscScalar));
+  if( !in.good() ) return false;
+
+  data.cached = true;
+  return true;
+}
+
+
+void PMI_Table::_save(const std::string &file, const std::string &key, const Data &data) const
+{
+  // write to a private file and rename, processors may save the same table
+  std::stringstream tmp;
+  tmp << file << '.' << static_cast<const void *>(&data) << '.' << clock();
+
+  std::ofstream out(tmp.str().c_str(), std::ios::binary);
+  if( !out.good() ) return;
+
+  const unsigned int key_size = key.size();
+  const unsigned int n_values = data.values.size();
+  out << table_magic << '\n';
+  out.write(reinterpret_cast<const char *>(&key_size), sizeof(unsigned int));
+  out.write(key.data(), key_size);
+  out.write(reinterpret_cast<const char *>(&n_values), sizeof(unsigned int));
+  out.write(reinterpret_cast<const char *>(&data.abs_error[0]), _n_outputs*sizeof(PetscScalar));
+  out.write(reinterpret_cast<const char *>(&data.rel_error[0]), _n_outputs*sizeof(PetscScalar));
+  out.write(reinterpret_cast<const char *>(&data.values[0]), n_values*sizeof(PetscScalar));
+  out.close();
+
+  if( !out.good() || std::rename(tmp.str().c_str(), file.c_str()) != 0 )
+    std::remove(tmp.str().c_str());
+}
+
+
+bool PMI_Table::in_range(const PetscScalar *x) const
+{
+  for(unsigned int d=0; d<_axes.size(); ++d)
+    if( !(x[d] >= _axes[d].min && x[d] <= _axes[d].max) ) return false;
+  return true;
+}
+
+
+void PMI_Table::_value(const std::vector<PetscScalar> &values, const PetscScalar *x, PetscScalar *f, PetscScalar *dfdx) const
+{
+  const unsigned int dim = _axes.size();
+  const unsigned int n_out = _n_outputs;
+
+  unsigned int idx[4][4], m[4], stride[4];
+  PetscScalar  w[4][4], dw[4][4], dudx[4];
+
+  unsigned int s = n_out;
+  for(unsigned int d=0; d<dim; ++d)
+  {
+    const Axis & axis = _axes[d];
+    const PetscScalar xd = std::max(axis.min, std::min(axis.max, x[d]));
+    const PetscScalar t  = ((axis.scale == Log ? std::log(xd) : xd) - axis.u0)/axis.h;
+    const unsigned int i = std::min(static_cast<unsigned int>(std::max(t, 0.0)), axis.n-2);
+    m[d] = stencil(i, t-i, axis.n, idx[d], w[d], dw[d]);
+    dudx[d] = axis.scale == Log ? 1.0/(axis.h*xd) : 1.0/axis.h;
+    stride[d] = s;
+    s *= axis.n;
+  }
+
+  for(unsigned int o=0; o<n_out; ++o)
+    f[o] = 0.0;
+  if( dfdx )
+    for(unsigned int k=0; k<n_out*dim; ++k)
+      dfdx[k] = 0.0;
+
+  // loop over the stencils of outer axes, the first axis is summed inside
+  PetscScalar sum[16], dsum[16];
+  unsigned int c[4] = {0, 0, 0, 0};
+  while( true )
+  {
+    unsigned int offset = 0;
+    PetscScalar weight = 1.0;
+    for(unsigned int d=1; d<dim; ++d)
+    {
+      offset += idx[d][c[d]]*stride[d];
+      weight *= w[d][c[d]];
+    }
+
+    switch(n_out)
+    {
+    case 1  : axis_sum<1>(values, offset, m[0], idx[0], stride[0], w[0], dw[0], 1, sum, dsum); break;
+    case 2  : axis_sum<2>(values, offset, m[0], idx[0], stride[0], w[0], dw[0], 2, sum, dsum); break;
+    default : axis_sum<0>(values, offset, m[0], idx[0], stride[0], w[0], dw[0], n_out, sum, dsum); break;
+    }
+
+    for(unsigned int o=0; o<n_out; ++o)
+      f[o] += weight*sum[o];
+
+    if( dfdx )
+    {
+      for(unsigned int o=0; o<n_out; ++o)
+        dfdx[o*dim] += weight*dsum[o];
+      for(unsigned int d=1; d<dim; ++d)
+      {
+        PetscScalar dweight = dw[d][c[d]];
+        for(unsigned int e=1; e<dim; ++e)
+          if( e != d ) dweight *= w[e][c[e]];
+        for(unsigned int o=0; o<n_out; ++o)
+          dfdx[o*dim+d] += dweight*sum[o];
+      }
+    }
+
+    unsigned int d = 1;
+    for(; d<dim; ++d)
+    {
+      if( ++c[d] < m[d] ) break;
+      c[d] = 0;
+    }
+    if( d >= dim ) break;
+  }
+
+  if( dfdx )
+    for(unsigned int o=0; o<n_out; ++o)
+      for(unsigned int d=0; d<dim; ++d)
+        dfdx[o*dim+d] *= dudx[d];
+}
+
+
+void PMI_Table::value(const PetscScalar *x, PetscScalar *f, PetscScalar *dfdx) const
+{
+  assert( _data );
+  _value(_data->values, x, f, dfdx);
+}
+
+
+void PMI_Table::value(const AutoDScalar *x, AutoDScalar *f) const
+{
+  assert( _data );
+  const unsigned int dim = _axes.size();
+
+  PetscScalar xv[4], fv[4], buffer[16];
+  std::vector<PetscScalar> large;
+  PetscScalar * dfdx = buffer;
+  if( _n_outputs > 4 )
+  {
+    large.resize(_n_outputs*(dim+1));
+    dfdx = &large[_n_outputs];
+  }
+  PetscScalar * fval = _n_outputs > 4 ? &large[0] : fv;
+
+  for(unsigned int d=0; d<dim; ++d)
+    xv[d] = x[d].getValue();
+  _value(_data->values, xv, fval, dfdx);
+
+  for(unsigned int o=0; o<_n_outputs; ++o)
+  {
+    f[o] = fval[o];
+    for(unsigned int p=0; p<AutoDScalar::numdir; ++p)
+    {
+      PetscScalar ad = 0.0;
+      for(unsigned int d=0; d<dim; ++d)
+        ad += dfdx[o*dim+d]*x[d].getADValue(p);
+      f[o].setADValue(p, ad);
+    }
+  }
+}
+
+
+PetscScalar PMI_Table::max_error(unsigned int o) const
+{
+  return _data ? _data->abs_error[o] : 0.0;
+}
+
+
+PetscScalar PMI_Table::max_relative_error(unsigned int o) const
+{
+  return _data ? _data->rel_error[o] : 0.0;
+}
+
+
+std::string PMI_Table::info() const
+{
+  std::stringstream ss;
+  ss << "table";
+  for(unsigned int d=0; d<_axes.size(); ++d)
+    ss << (d ? "x" : " ") << _axes[d].n;
+  if( !_data ) return ss.str() + " not built";
+
+  ss << (_data->cached ? ", loaded from cache" : ", sampled") << ", max error";
+  ss << std::setprecision(3);
+  for(unsigned int o=0; o<_n_outputs; ++o)
+    ss << (o ? "," : "") << " " << _data->abs_error[o] << " (" << 100*_data->rel_error[o] << "%)";
+  return ss.str();
+}
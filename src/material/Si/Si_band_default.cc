@@ -110,25 +110,32 @@ public:
   }
 
   //---------------------------------------------------------------------------
-  // procedure of Bandgap Narrowing due to Heavy Doping
-  PetscScalar EgNarrow(const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
+  // doping dependent terms, cached for each node
+  enum CacheTerm { EG_NARROW, TAU_N_DOP, TAU_P_DOP, N_CACHE_TERM };
+
+  void EvalNodeCache(const PetscScalar &, PetscScalar *values) const
   {
     PetscScalar Na = ReadDopingNa();
     PetscScalar Nd = ReadDopingNd();
     PetscScalar N = Na+Nd+1.0*std::pow(cm,-3);
     PetscScalar x = log(N/N0_BGN);
-    return V0_BGN*(x+sqrt(x*x+CON_BGN));
+    values[EG_NARROW] = V0_BGN*(x+sqrt(x*x+CON_BGN));
+    values[TAU_N_DOP] = 1.0/(1+(Na+Nd)/NSRHN);
+    values[TAU_P_DOP] = 1.0/(1+(Na+Nd)/NSRHP);
+  }
+
+  //---------------------------------------------------------------------------
+  // procedure of Bandgap Narrowing due to Heavy Doping
+  PetscScalar EgNarrow(const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
+  {
+    return ReadNodeCache()[EG_NARROW];
   }
   PetscScalar EgNarrowToEc   (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl){return 0.5*EgNarrow(p, n, Tl);}
   PetscScalar EgNarrowToEv   (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl){return 0.5*EgNarrow(p, n, Tl);}
 
   AutoDScalar EgNarrow(const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N = Na+Nd+1.0*std::pow(cm,-3);
-    PetscScalar x = log(N/N0_BGN);
-    return V0_BGN*(x+sqrt(x*x+CON_BGN));
+    return ReadNodeCache()[EG_NARROW];
   }
   AutoDScalar EgNarrowToEc   (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl){return 0.5*EgNarrow(p, n, Tl);}
   AutoDScalar EgNarrowToEv   (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl){return 0.5*EgNarrow(p, n, Tl);}
@@ -220,22 +227,32 @@ public:
   }
 
   //---------------------------------------------------------------------------
-  PetscScalar ni (const PetscScalar &Tl)
+  // formulas shared by the scalar, AD and array versions
+  template <typename T>
+  T ni_value (const T &Tl)
   {
-    PetscScalar bandgap = Eg(Tl);
+    T bandgap = Eg(Tl);
     return sqrt(Nc(Tl)*Nv(Tl))*exp(-bandgap/(2*kb*Tl));
   }
+  template <typename T>
+  T nie_value (const T &ni, const T &dEg, const T &Tl)
+  {
+    return ni*exp(dEg/(2*kb*Tl));
+  }
+
+  PetscScalar ni (const PetscScalar &Tl)
+  {
+    return ni_value(Tl);
+  }
 
   // nie, Eg narrow should be considered
   PetscScalar nie (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
-    PetscScalar bandgap = Eg(Tl);
-    return sqrt(Nc(Tl)*Nv(Tl))*exp(-bandgap/(2*kb*Tl))*exp(EgNarrow(p, n, Tl)/(2*kb*Tl));
+    return nie_value(ni_value(Tl), EgNarrow(p, n, Tl), Tl);
   }
   AutoDScalar nie (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
-    AutoDScalar bandgap = Eg(Tl);
-    return sqrt(Nc(Tl)*Nv(Tl))*exp(-bandgap/(2*kb*Tl))*exp(EgNarrow(p, n, Tl)/(2*kb*Tl));
+    return nie_value(ni_value(Tl), EgNarrow(p, n, Tl), Tl);
   }
 
   //particle energy to elec-hole pare generation rate
@@ -612,31 +629,30 @@ public:
   // electron lift time for SHR Recombination
   PetscScalar TAUN (const PetscScalar &Tl)
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    return TAUN0/(1+(Na+Nd)/NSRHN)*std::pow(Tl/T300,EXN_TAU);
+    return TAUN_T(Tl)*ReadNodeCache()[TAU_N_DOP];
   }
   AutoDScalar TAUN (const AutoDScalar &Tl)
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    return TAUN0/(1+(Na+Nd)/NSRHN)*adtl::pow(Tl/T300,EXN_TAU);
+    return TAUN_T(Tl)*ReadNodeCache()[TAU_N_DOP];
   }
 
   //---------------------------------------------------------------------------
   // hole lift time for SHR Recombination
   PetscScalar TAUP (const PetscScalar &Tl)
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    return TAUP0/(1+(Na+Nd)/NSRHP)*std::pow(Tl/T300,EXP_TAU);
+    return TAUP_T(Tl)*ReadNodeCache()[TAU_P_DOP];
   }
   AutoDScalar TAUP (const AutoDScalar &Tl)
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    return TAUP0/(1+(Na+Nd)/NSRHP)*adtl::pow(Tl/T300,EXP_TAU);
+    return TAUP_T(Tl)*ReadNodeCache()[TAU_P_DOP];
   }
+
+private:
+  // temperature dependent part of the lift time
+  PetscScalar TAUN_T (const PetscScalar &Tl) { return TAUN0*std::pow(Tl/T300,EXN_TAU); }
+  AutoDScalar TAUN_T (const AutoDScalar &Tl) { return TAUN0*adtl::pow(Tl/T300,EXN_TAU); }
+  PetscScalar TAUP_T (const PetscScalar &Tl) { return TAUP0*std::pow(Tl/T300,EXP_TAU); }
+  AutoDScalar TAUP_T (const AutoDScalar &Tl) { return TAUP0*adtl::pow(Tl/T300,EXP_TAU); }
   // End of Lifetime
 
   //[the fit parameter for density-gradient solver]
@@ -733,13 +749,11 @@ public:
   // Total Auger Recombination
   PetscScalar R_Auger     (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
-    PetscScalar ni =   nie(p, n, Tl);
-    return AUGN*(p*n*n-n*ni*ni)+AUGP*(n*p*p-p*ni*ni);
+    return R_Auger_value(p, n, nie(p, n, Tl));
   }
   AutoDScalar R_Auger     (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
-    AutoDScalar ni =   nie(p, n, Tl);
-    return AUGN*(p*n*n-n*ni*ni)+AUGP*(n*p*p-p*ni*ni);
+    return R_Auger_value(p, n, nie(p, n, Tl));
   }
 
   //---------------------------------------------------------------------------
@@ -772,17 +786,11 @@ public:
   // SHR Recombination
   PetscScalar R_SHR     (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
-    PetscScalar ni =   nie(p, n, Tl);
-    PetscScalar taun = TAUN(Tl);
-    PetscScalar taup = TAUP(Tl);
-    return (p*n-ni*ni)/(taup*(n+ni)+taun*(p+ni));
+    return R_SHR_value(p, n, nie(p, n, Tl), TAUN(Tl), TAUP(Tl));
   }
   AutoDScalar R_SHR     (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
-    AutoDScalar ni =   nie(p, n, Tl);
-    AutoDScalar taun = TAUN(Tl);
-    AutoDScalar taup = TAUP(Tl);
-    return (p*n-ni*ni)/(taup*(n+ni)+taun*(p+ni));
+    return R_SHR_value(p, n, nie(p, n, Tl), TAUN(Tl), TAUP(Tl));
   }
 
   //---------------------------------------------------------------------------
@@ -812,27 +820,111 @@ public:
   // total Recombination
   PetscScalar Recomb (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
-    PetscScalar ni =   nie(p, n, Tl);
-    PetscScalar taun = TAUN(Tl);
-    PetscScalar taup = TAUP(Tl);
-    PetscScalar dn   = p*n-ni*ni;
-    PetscScalar Rshr = dn/(taup*(n+ni)+taun*(p+ni));
-    PetscScalar Rdir = C_DIRECT*dn;
-    PetscScalar Raug = (AUGN*n+AUGP*p)*dn;
-    return Rshr+Rdir+Raug;
+    return Recomb_value(p, n, nie(p, n, Tl), TAUN(Tl), TAUP(Tl));
   }
   AutoDScalar Recomb (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
-    AutoDScalar ni =   nie(p, n, Tl);
-    AutoDScalar taun = TAUN(Tl);
-    AutoDScalar taup = TAUP(Tl);
-    AutoDScalar dn   = p*n-ni*ni;
-    AutoDScalar Rshr = dn/(taup*(n+ni)+taun*(p+ni));
-    AutoDScalar Rdir = C_DIRECT*dn;
-    AutoDScalar Raug = (AUGN*n+AUGP*p)*dn;
+    return Recomb_value(p, n, nie(p, n, Tl), TAUN(Tl), TAUP(Tl));
+  }
+
+private:
+  // formulas shared by the scalar, AD and array versions
+  template <typename T>
+  T R_Auger_value (const T &p, const T &n, const T &ni)
+  {
+    return AUGN*(p*n*n-n*ni*ni)+AUGP*(n*p*p-p*ni*ni);
+  }
+  template <typename T>
+  T R_SHR_value (const T &p, const T &n, const T &ni, const T &taun, const T &taup)
+  {
+    return (p*n-ni*ni)/(taup*(n+ni)+taun*(p+ni));
+  }
+  template <typename T>
+  T Recomb_value (const T &p, const T &n, const T &ni, const T &taun, const T &taup)
+  {
+    T dn   = p*n-ni*ni;
+    T Rshr = dn/(taup*(n+ni)+taun*(p+ni));
+    T Rdir = C_DIRECT*dn;
+    T Raug = (AUGN*n+AUGP*p)*dn;
     return Rshr+Rdir+Raug;
   }
 
+
+  //---------------------------------------------------------------------------
+  // bulk terms of size nodes. the doping terms are read from the node cache
+  // without switching node context, the temperature terms are evaluated again
+  // only when Tl differs from the previous node
+public:
+  void EgNarrow (unsigned int size, const PMI_NodeContext *ctx,
+                 const PetscScalar *, const PetscScalar *, const PetscScalar *, PetscScalar *dEg)
+  {
+    for(unsigned int i=0; i<size; ++i)
+      dEg[i] = ReadNodeCache(ctx[i])[EG_NARROW];
+  }
+
+  void EgNarrowToEc (unsigned int size, const PMI_NodeContext *ctx,
+                     const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *dEc)
+  {
+    for(unsigned int i=0; i<size; ++i)
+      dEc[i] = 0.5*ReadNodeCache(ctx[i])[EG_NARROW];
+  }
+
+  void EgNarrowToEv (unsigned int size, const PMI_NodeContext *ctx,
+                     const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *dEv)
+  {
+    for(unsigned int i=0; i<size; ++i)
+      dEv[i] = 0.5*ReadNodeCache(ctx[i])[EG_NARROW];
+  }
+
+  void nie (unsigned int size, const PMI_NodeContext *ctx,
+            const PetscScalar *, const PetscScalar *, const PetscScalar *Tl, PetscScalar *ni_e)
+  {
+    PetscScalar T = -1.0, ni0 = 0.0;
+    for(unsigned int i=0; i<size; ++i)
+    {
+      if( Tl[i] != T ) { T = Tl[i]; ni0 = ni_value(T); }
+      ni_e[i] = nie_value(ni0, ReadNodeCache(ctx[i])[EG_NARROW], T);
+    }
+  }
+
+  void Recomb (unsigned int size, const PMI_NodeContext *ctx,
+               const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R)
+  {
+    PetscScalar T = -1.0, ni0 = 0.0, taun0 = 0.0, taup0 = 0.0;
+    for(unsigned int i=0; i<size; ++i)
+    {
+      if( Tl[i] != T ) { T = Tl[i]; ni0 = ni_value(T); taun0 = TAUN_T(T); taup0 = TAUP_T(T); }
+      const PetscScalar * cache = ReadNodeCache(ctx[i]);
+      PetscScalar ni = nie_value(ni0, cache[EG_NARROW], T);
+      R[i] = Recomb_value(p[i], n[i], ni, taun0*cache[TAU_N_DOP], taup0*cache[TAU_P_DOP]);
+    }
+  }
+
+  void R_SHR (unsigned int size, const PMI_NodeContext *ctx,
+              const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R)
+  {
+    PetscScalar T = -1.0, ni0 = 0.0, taun0 = 0.0, taup0 = 0.0;
+    for(unsigned int i=0; i<size; ++i)
+    {
+      if( Tl[i] != T ) { T = Tl[i]; ni0 = ni_value(T); taun0 = TAUN_T(T); taup0 = TAUP_T(T); }
+      const PetscScalar * cache = ReadNodeCache(ctx[i]);
+      PetscScalar ni = nie_value(ni0, cache[EG_NARROW], T);
+      R[i] = R_SHR_value(p[i], n[i], ni, taun0*cache[TAU_N_DOP], taup0*cache[TAU_P_DOP]);
+    }
+  }
+
+  void R_Auger (unsigned int size, const PMI_NodeContext *ctx,
+                const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *R)
+  {
+    PetscScalar T = -1.0, ni0 = 0.0;
+    for(unsigned int i=0; i<size; ++i)
+    {
+      if( Tl[i] != T ) { T = Tl[i]; ni0 = ni_value(T); }
+      PetscScalar ni = nie_value(ni0, ReadNodeCache(ctx[i])[EG_NARROW], T);
+      R[i] = R_Auger_value(p[i], n[i], ni);
+    }
+  }
+
   // End of Recombination
 
 private:
@@ -1119,6 +1211,7 @@ public:
     DG_Init();
     HCI_Init();
     BBTunneling_Init();
+    DeclareNodeCache(N_CACHE_TERM);
   }
 
   ~GSS_Si_BandStructure()
@@ -23,6 +23,7 @@
 #include <algorithm>
 
 #include "PMI.h"
+#include "PMI_table.h"
 
 
 
@@ -80,6 +81,42 @@ private:
 
   PetscScalar n_scale;
 
+  // tabulated carrier-carrier BGN
+  std::string BGN_TABLE;        // off, jacobian (AD only) or on
+  PetscScalar BGN_TABLE_NMIN;   // carrier density range of table
+  PetscScalar BGN_TABLE_NMAX;
+  PetscScalar BGN_TABLE_TMIN;   // temperature range of table
+  PetscScalar BGN_TABLE_TMAX;
+
+  enum XC_TableMode {XC_TableOff, XC_TableJacobian, XC_TableOn} xc_table_mode;
+
+  /**
+   * PMI_Info without the table summary
+   */
+  std::string Schenk_Info;
+
+  /**
+   * De_xc and Dh_xc as function of |n|, |p| and Tl
+   */
+  PMI_Table xc_table;
+
+  class XC_Function : public PMI_Table::Function
+  {
+  public:
+    XC_Function(const GSS_Si_BandStructure_Schenk *model) : _model(model) {}
+    void operator() (const PetscScalar *x, PetscScalar *f) const
+    {
+      const PetscScalar neS = x[0] / _model->n_scale;
+      const PetscScalar nhS = x[1] / _model->n_scale;
+      const PetscScalar F   = _model->kb * x[2] / _model->Ryex;
+      f[0] = _model->De_xc(neS, nhS, F);
+      f[1] = _model->Dh_xc(neS, nhS, F);
+    }
+  private:
+    const GSS_Si_BandStructure_Schenk *_model;
+  };
+  friend class XC_Function;
+
   // Init value
   void Eg_Init()
   {
@@ -130,6 +167,13 @@ private:
 
     n_scale = std::pow(aex, -3.0);
 
+    BGN_TABLE      = "off";
+    BGN_TABLE_NMIN = 1e2*std::pow(cm,-3);
+    BGN_TABLE_NMAX = 1e22*std::pow(cm,-3);
+    BGN_TABLE_TMIN = 200.0*K;
+    BGN_TABLE_TMAX = 700.0*K;
+    xc_table_mode  = XC_TableOff;
+
 #ifdef __CALIBRATE__
     parameter_map.insert(para_item("EG0",    PARA("EG0",    "The energy bandgap of the material at 0 K", "eV", eV, &EG0)) );
     parameter_map.insert(para_item("EG300",  PARA("EG300",  "The energy bandgap of the material at 300 K", "eV", eV, &EG300)) );
@@ -167,6 +211,12 @@ private:
     parameter_map.insert(para_item("BGN.KH", PARA("BGN.KH", "Third fitting parameter for holes in ionic bandgap narrowing model", "-", 1.0, &kh)));
     parameter_map.insert(para_item("BGN.QE", PARA("BGN.QE", "Forth fitting parameter for electrons in ionic bandgap narrowing model", "-", 1.0, &qe)));
     parameter_map.insert(para_item("BGN.QH", PARA("BGN.QH", "Forth fitting parameter for holes in ionic bandgap narrowing model", "-", 1.0, &qh)));
+
+    parameter_map.insert(para_item("BGN.TABLE", PARA("BGN.TABLE", "Tabulated carrier-carrier bandgap narrowing: off, jacobian or on", &BGN_TABLE)));
+    parameter_map.insert(para_item("BGN.TABLE.NMIN", PARA("BGN.TABLE.NMIN", "Lower carrier density of bandgap narrowing table", "cm^-3", std::pow(cm,-3), &BGN_TABLE_NMIN)));
+    parameter_map.insert(para_item("BGN.TABLE.NMAX", PARA("BGN.TABLE.NMAX", "Upper carrier density of bandgap narrowing table", "cm^-3", std::pow(cm,-3), &BGN_TABLE_NMAX)));
+    parameter_map.insert(para_item("BGN.TABLE.TMIN", PARA("BGN.TABLE.TMIN", "Lower temperature of bandgap narrowing table", "K", K, &BGN_TABLE_TMIN)));
+    parameter_map.insert(para_item("BGN.TABLE.TMAX", PARA("BGN.TABLE.TMAX", "Upper temperature of bandgap narrowing table", "K", K, &BGN_TABLE_TMAX)));
 #endif
 
   }
@@ -175,6 +225,50 @@ private:
   {
     alphae = mh_eff / (me_eff+mh_eff);
     alphah = me_eff / (me_eff+mh_eff);
+
+    // table of carrier-carrier BGN, 5 points per decade of carrier density and 25K step of temperature
+    PMI_Info = Schenk_Info;
+    xc_table.clear();
+    xc_table_mode = XC_TableOff;
+    if( BGN_TABLE == "jacobian" ) xc_table_mode = XC_TableJacobian;
+    if( BGN_TABLE == "on" )       xc_table_mode = XC_TableOn;
+    if( xc_table_mode == XC_TableOff ) return;
+
+    if( xc_table_mode == XC_TableJacobian )
+      _calibrate_error_info += "  BGN.TABLE=jacobian: the Jacobian takes derivatives of the interpolated table while the residual"
+                               " uses the exact model, Newton convergence degrades to linear. Use BGN.TABLE=on for a consistent Jacobian.\n";
+
+    unsigned int n_points = static_cast<unsigned int>(5*std::log10(BGN_TABLE_NMAX/BGN_TABLE_NMIN)+0.5) + 1;
+    unsigned int T_points = static_cast<unsigned int>((BGN_TABLE_TMAX-BGN_TABLE_TMIN)/(25*K)+0.5) + 1;
+    xc_table.add_axis(BGN_TABLE_NMIN, BGN_TABLE_NMAX, std::max(n_points, 4u), PMI_Table::Log);
+    xc_table.add_axis(BGN_TABLE_NMIN, BGN_TABLE_NMAX, std::max(n_points, 4u), PMI_Table::Log);
+    xc_table.add_axis(BGN_TABLE_TMIN, BGN_TABLE_TMAX, std::max(T_points, 4u));
+    xc_table.build(XC_Function(this), 2, "Si.BandStructure.Schenk.BGN_xc", PMI_TABLE_BUILD_ID, ParameterSignature());
+
+    PMI_Info += "\nCarrier-carrier bandgap narrowing by " + xc_table.info();
+  }
+
+  // BGN due to exchange-correlation (carrier-carrier)
+  PetscScalar De_xc(const PetscScalar &neS, const PetscScalar &nhS, const PetscScalar &F) const
+  {
+    const PetscScalar pi = 3.1415927;
+    PetscScalar nsigma = neS + nhS;
+    PetscScalar np = alphae * neS + alphah * nhS;
+    return -( std::pow(4.0 * pi, 3.0) * nsigma*nsigma * ( std::pow(48.0 * neS / pi / ge, 1.0/3.0) + ce * log(1.0 + de * std::pow(np, pe))  )
+              +(8.0 * pi * alphae/ge)* neS * F*F
+              +sqrt(8.0 *pi*nsigma) * std::pow(F, 5.0 / 2.0)
+            ) / (std::pow(4.0*pi, 3.0) * nsigma*nsigma + std::pow(F, 3.0) + be * sqrt(nsigma) * F*F + 40.0 * std::pow(nsigma, 3.0/2.0) * F);
+  }
+
+  PetscScalar Dh_xc(const PetscScalar &neS, const PetscScalar &nhS, const PetscScalar &F) const
+  {
+    const PetscScalar pi = 3.1415927;
+    PetscScalar nsigma = neS + nhS;
+    PetscScalar np = alphae * neS + alphah * nhS;
+    return -( std::pow(4.0 * pi, 3.0) * nsigma*nsigma * ( std::pow(48.0 * nhS / pi / gh, 1.0/3.0) + ch * log(1.0 + dh * std::pow(np, ph))  )
+              +(8.0 * pi * alphah/gh)* nhS * F*F
+              +sqrt(8.0 *pi*nsigma) * std::pow(F, 5.0 / 2.0)
+            ) / (std::pow(4.0*pi, 3.0) * nsigma*nsigma + std::pow(F,3.0) + bh * sqrt(nsigma) * F*F + 40.0 * std::pow(nsigma, 3.0/2.0) * F);
   }
 
 public:
@@ -215,7 +309,6 @@ public:
     PetscScalar F = kb * Tl / Ryex;    // [adim]
 
     PetscScalar nsigma = neS + nhS;
-    PetscScalar np = alphae * neS + alphah * nhS;
 
     PetscScalar nsigma2 = ndS + naS;                // For SCR:  nsigma = niS
     PetscScalar np2 = alphae * ndS + alphah * naS;  // For SCR: np = alphae * NDOP + alphah * PDOP
@@ -223,10 +316,12 @@ public:
     PetscScalar Ui = nsigma * nsigma / std::pow(F,3.0);
 
     // BGN due to exchange-correlation (carrier-carrier)
-    PetscScalar De_xc = -( std::pow(4.0 * pi, 3.0) * nsigma*nsigma * ( std::pow(48.0 * neS / pi / ge, 1.0/3.0) + ce * log(1.0 + de * std::pow(np, pe))  )
-                           +(8.0 * pi * alphae/ge)* neS * F*F
-                           +sqrt(8.0 *pi*nsigma) * std::pow(F, 5.0 / 2.0)
-                         ) / (std::pow(4.0*pi, 3.0) * nsigma*nsigma + std::pow(F, 3.0) + be * sqrt(nsigma) * F*F + 40.0 * std::pow(nsigma, 3.0/2.0) * F);
+    const PetscScalar x[3] = { std::abs(n), std::abs(p), Tl };
+    PetscScalar xc[2];
+    if( xc_table_mode == XC_TableOn && xc_table.in_range(x) )
+      xc_table.value(x, xc);
+    else
+      xc[0] = De_xc(neS, nhS, F);
 
     PetscScalar De_i = -( niS * (1.0 + Ui))
                        /( sqrt(F * nsigma2 / (2.0 * pi)) * (1.0 + he * log(1.0 + sqrt(nsigma2) / F) )
@@ -235,7 +330,7 @@ public:
 #if defined(HAVE_FENV_H) && defined(DEBUG)
     genius_assert( !fetestexcept(FE_INVALID) );
 #endif
-    return  - (De_xc + De_i)*Ryex;
+    return  - (xc[0] + De_i)*Ryex;
   }
 
   PetscScalar EgNarrowToEv   (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
@@ -252,23 +347,25 @@ public:
     PetscScalar F = kb * Tl / Ryex;    // [adim]
 
     PetscScalar nsigma = neS + nhS;
-    PetscScalar np = alphae * neS + alphah * nhS;
 
     PetscScalar nsigma2 = ndS + naS;                // For SCR:  nsigma = niS
     PetscScalar np2 = alphae * ndS + alphah * naS;  // For SCR: np = alphae * NDOP + alphah * PDOP
 
     PetscScalar Ui = nsigma * nsigma / std::pow(F,3.0);
 
-    PetscScalar Dh_xc = -( std::pow(4.0 * pi, 3.0) * nsigma*nsigma * ( std::pow(48.0 * nhS / pi / gh, 1.0/3.0) + ch * log(1.0 + dh * std::pow(np, ph))  )
-                           +(8.0 * pi * alphah/gh)* nhS * F*F
-                           +sqrt(8.0 *pi*nsigma) * std::pow(F, 5.0 / 2.0)
-                         ) / (std::pow(4.0*pi, 3.0) * nsigma*nsigma + std::pow(F,3.0) + bh * sqrt(nsigma) * F*F + 40.0 * std::pow(nsigma, 3.0/2.0) * F);
+    const PetscScalar x[3] = { std::abs(n), std::abs(p), Tl };
+    PetscScalar xc[2];
+    if( xc_table_mode == XC_TableOn && xc_table.in_range(x) )
+      xc_table.value(x, xc);
+    else
+      xc[1] = Dh_xc(neS, nhS, F);
+
     PetscScalar Dh_i = -( niS * (1.0 + Ui))
                        /( sqrt(F * nsigma2 / (2.0 * pi)) * (1.0 + hh * log(1.0 + sqrt(nsigma2) / F) )
                           +jh * Ui * std::pow(np2, 3.0/4.0) * (1.0 + kh * std::pow(np2, qh))
                         );
 
-    return  - (Dh_xc +  Dh_i) * Ryex;
+    return  - (xc[1] +  Dh_i) * Ryex;
   }
 
 
@@ -299,7 +396,13 @@ public:
     AutoDScalar Ui = nsigma * nsigma / adtl::pow(F,3.0);
 
     // BGN due to exchange-correlation (carrier-carrier)
-    AutoDScalar De_xc = -( std::pow(4.0 * pi, 3.0) * nsigma*nsigma * ( adtl::pow(48.0 * neS / pi / ge, 1.0/3.0) + ce * log(1.0 + de * adtl::pow(np, pe))  )
+    const AutoDScalar x[3] = { adtl::fabs(n), adtl::fabs(p), Tl };
+    const PetscScalar xv[3] = { x[0].getValue(), x[1].getValue(), x[2].getValue() };
+    AutoDScalar xc[2];
+    if( xc_table_mode != XC_TableOff && xc_table.in_range(xv) )
+      xc_table.value(x, xc);
+    else
+      xc[0] = -( std::pow(4.0 * pi, 3.0) * nsigma*nsigma * ( adtl::pow(48.0 * neS / pi / ge, 1.0/3.0) + ce * log(1.0 + de * adtl::pow(np, pe))  )
                            +(8.0 * pi * alphae/ge)* neS * F*F
                            +sqrt(8.0 *pi*nsigma) * adtl::pow(F, 5.0 / 2.0)
                          ) / (std::pow(4.0*pi, 3.0) * nsigma*nsigma + adtl::pow(F, 3.0) + be * sqrt(nsigma) * F*F + 40.0 * adtl::pow(nsigma, 3.0/2.0) * F);
@@ -308,7 +411,7 @@ public:
                        /( sqrt(F * nsigma2 / (2.0 * pi)) * (1.0 + he * log(1.0 + sqrt(nsigma2) / F) )
                           +je * Ui * std::pow(np2, 3.0/4.0) * (1.0 + ke * std::pow(np2, qe))
                         );
-    return  - (De_xc + De_i) * Ryex;
+    return  - (xc[0] + De_i) * Ryex;
   }
 
   AutoDScalar EgNarrowToEv   (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
@@ -332,7 +435,13 @@ public:
 
     AutoDScalar Ui = nsigma * nsigma / adtl::pow(F,3.0);
 
-    AutoDScalar Dh_xc = -( std::pow(4.0 * pi, 3.0) * nsigma*nsigma * ( adtl::pow(48.0 * nhS / pi / gh, 1.0/3.0) + ch * log(1.0 + dh * adtl::pow(np, ph))  )
+    const AutoDScalar x[3] = { adtl::fabs(n), adtl::fabs(p), Tl };
+    const PetscScalar xv[3] = { x[0].getValue(), x[1].getValue(), x[2].getValue() };
+    AutoDScalar xc[2];
+    if( xc_table_mode != XC_TableOff && xc_table.in_range(xv) )
+      xc_table.value(x, xc);
+    else
+      xc[1] = -( std::pow(4.0 * pi, 3.0) * nsigma*nsigma * ( adtl::pow(48.0 * nhS / pi / gh, 1.0/3.0) + ch * log(1.0 + dh * adtl::pow(np, ph))  )
                            +(8.0 * pi * alphah/gh)* nhS * F*F
                            +sqrt(8.0 *pi*nsigma) * adtl::pow(F, 5.0 / 2.0)
                          ) / (std::pow(4.0*pi, 3.0) * nsigma*nsigma + adtl::pow(F,3.0) + bh * sqrt(nsigma) * F*F + 40.0 * adtl::pow(nsigma, 3.0/2.0) * F);
@@ -341,7 +450,7 @@ public:
                           +jh * Ui * std::pow(np2, 3.0/4.0) * (1.0 + kh * std::pow(np2, qh))
                         );
 
-    return  - (Dh_xc +  Dh_i) * Ryex;
+    return  - (xc[1] +  Dh_i) * Ryex;
   }
 
 
@@ -1269,7 +1378,8 @@ public:
   GSS_Si_BandStructure_Schenk(const PMIS_Environment &env):PMIS_BandStructure(env)
   {
     T300 = 300.0*K;
-    PMI_Info = "This is the Schenk model for band structure parameters of Silicon";
+    Schenk_Info = "This is the Schenk model for band structure parameters of Silicon";
+    PMI_Info = Schenk_Info;
     Eg_Init();
     Lifetime_Init();
     Recomb_Init();
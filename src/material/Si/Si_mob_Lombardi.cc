@@ -141,85 +141,82 @@ private:
 #endif
   }
   //---------------------------------------------------------------------------
-  // Electron low field mobility
-  PetscScalar ElecMobLowField(const PetscScalar &Tl) const
+  // doping and temperature dependent terms, cached for each node
+  enum CacheTerm { MU_MAX_N, MU_MAX_P, MU_DOP_N, MU_DOP_P, MU_CS_N, MU_CS_P, MU_AC_N, MU_AC_P, MU_PC_P, VSAT_N, VSAT_P, N_CACHE_TERM };
+
+  void EvalNodeCache(const PetscScalar &Tl, PetscScalar *values) const
   {
     PetscScalar Na = ReadDopingNa();
     PetscScalar Nd = ReadDopingNd();
     PetscScalar N_total = Na+Nd+1e0*std::pow(cm,-3);
-    PetscScalar mu_max = MUN2_LSM*std::pow(Tl/T300,-EXN3_LSM);
-    return MUN0_LSM+(mu_max-MUN0_LSM)/(1+std::pow(N_total/CRN_LSM,EXN1_LSM))-MUN1_LSM/(1+std::pow(CSN_LSM/N_total,EXN2_LSM));
+
+    values[MU_MAX_N] = MUN2_LSM*std::pow(Tl/T300,-EXN3_LSM);
+    values[MU_MAX_P] = MUP2_LSM*std::pow(Tl/T300,-EXP3_LSM);
+    values[MU_DOP_N] = 1.0/(1+std::pow(N_total/CRN_LSM,EXN1_LSM));
+    values[MU_DOP_P] = 1.0/(1+std::pow(N_total/CRP_LSM,EXP1_LSM));
+    values[MU_CS_N]  = MUN1_LSM/(1+std::pow(CSN_LSM/N_total,EXN2_LSM));
+    values[MU_CS_P]  = MUP1_LSM/(1+std::pow(CSP_LSM/N_total,EXP2_LSM));
+    values[MU_AC_N]  = CN_LSM*std::pow(N_total,EXN4_LSM);
+    values[MU_AC_P]  = CP_LSM*std::pow(N_total,EXP4_LSM);
+    values[MU_PC_P]  = MUP0_LSM*exp(-PC_LSM/N_total);
+    values[VSAT_N]   = VSATN0/(1+VSATN_A*exp(Tl/(2*T300)));
+    values[VSAT_P]   = VSATP0/(1+VSATP_A*exp(Tl/(2*T300)));
   }
-  AutoDScalar ElecMobLowField(const AutoDScalar &Tl) const
+
+  //---------------------------------------------------------------------------
+  // Electron low field mobility
+  PetscScalar ElecMobLowField(const PetscScalar &Tl, const PetscScalar *c) const
+  {
+    return MUN0_LSM+(c[MU_MAX_N]-MUN0_LSM)*c[MU_DOP_N]-c[MU_CS_N];
+  }
+  AutoDScalar ElecMobLowField(const AutoDScalar &Tl, const PetscScalar *c) const
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N_total = Na+Nd+1e0*std::pow(cm,-3);
     AutoDScalar mu_max = MUN2_LSM*adtl::pow(Tl/T300,-EXN3_LSM);
-    return MUN0_LSM+(mu_max-MUN0_LSM)/(1+std::pow(N_total/CRN_LSM,EXN1_LSM))-MUN1_LSM/(1+std::pow(CSN_LSM/N_total,EXN2_LSM));
+    return MUN0_LSM+(mu_max-MUN0_LSM)*c[MU_DOP_N]-c[MU_CS_N];
   }
 
   //---------------------------------------------------------------------------
   // Hole low field mobility, Analytic model
-  PetscScalar HoleMobLowField(const PetscScalar &Tl) const
+  PetscScalar HoleMobLowField(const PetscScalar &Tl, const PetscScalar *c) const
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N_total = Na+Nd+1e0*std::pow(cm,-3);
-    PetscScalar mu_max = MUP2_LSM*std::pow(Tl/T300,-EXP3_LSM);
-    return MUP0_LSM*exp(-PC_LSM/N_total)+mu_max/(1+std::pow(N_total/CRP_LSM,EXP1_LSM))-MUP1_LSM/(1+std::pow(CSP_LSM/N_total,EXP2_LSM));
+    return c[MU_PC_P]+c[MU_MAX_P]*c[MU_DOP_P]-c[MU_CS_P];
   }
-  AutoDScalar HoleMobLowField(const AutoDScalar &Tl) const
+  AutoDScalar HoleMobLowField(const AutoDScalar &Tl, const PetscScalar *c) const
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N_total = Na+Nd+1e0*std::pow(cm,-3);
     AutoDScalar mu_max = MUP2_LSM*adtl::pow(Tl/T300,-EXP3_LSM);
-    return MUP0_LSM*exp(-PC_LSM/N_total)+mu_max/(1+std::pow(N_total/CRP_LSM,EXP1_LSM))-MUP1_LSM/(1+std::pow(CSP_LSM/N_total,EXP2_LSM));
+    return c[MU_PC_P]+mu_max*c[MU_DOP_P]-c[MU_CS_P];
   }
 
   //---------------------------------------------------------------------------
   // Electron surface mobility, acoustical phono scattering and roughness scattering
-  PetscScalar ElecMobSurface(const PetscScalar &Tl,const PetscScalar &Et) const
+  PetscScalar ElecMobSurface(const PetscScalar &Tl,const PetscScalar &Et, const PetscScalar *c) const
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N_total = Na+Nd+1e0*std::pow(cm,-3);
     PetscScalar ET = Et+1.0*V/cm;
-    PetscScalar mu_ac = BN_LSM/ET + CN_LSM*std::pow(N_total,EXN4_LSM)/Tl*std::pow(ET,PetscScalar(-1.0/3.0));
+    PetscScalar mu_ac = BN_LSM/ET + c[MU_AC_N]/Tl*std::pow(ET,PetscScalar(-1.0/3.0));
     PetscScalar mu_sr = DN_LSM*std::pow(ET,-EXN8_LSM);
     return 1.0/(1.0/mu_ac+1.0/mu_sr);
   }
-  AutoDScalar ElecMobSurface(const AutoDScalar &Tl,const AutoDScalar &Et) const
+  AutoDScalar ElecMobSurface(const AutoDScalar &Tl,const AutoDScalar &Et, const PetscScalar *c) const
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N_total = Na+Nd+1e0*std::pow(cm,-3);
     AutoDScalar ET = Et+1.0*V/cm;
-    AutoDScalar mu_ac = BN_LSM/ET + CN_LSM*std::pow(N_total,EXN4_LSM)/Tl*adtl::pow(ET,PetscScalar(-1.0/3.0));
+    AutoDScalar mu_ac = BN_LSM/ET + c[MU_AC_N]/Tl*adtl::pow(ET,PetscScalar(-1.0/3.0));
     AutoDScalar mu_sr = DN_LSM*adtl::pow(ET,-EXN8_LSM);
     return 1.0/(1.0/mu_ac+1.0/mu_sr);
   }
 
   //---------------------------------------------------------------------------
   // Hole surface mobility, acoustical phono scattering and roughness scattering
-  PetscScalar HoleMobSurface(const PetscScalar &Tl,const PetscScalar &Et) const
+  PetscScalar HoleMobSurface(const PetscScalar &Tl,const PetscScalar &Et, const PetscScalar *c) const
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N_total = Na+Nd+1e0*std::pow(cm,-3);
     PetscScalar ET = Et+1.0*V/cm;
-    PetscScalar mu_ac = BP_LSM/ET + CP_LSM*std::pow(N_total,EXP4_LSM)/Tl*std::pow(ET,PetscScalar(-1.0/3.0));
+    PetscScalar mu_ac = BP_LSM/ET + c[MU_AC_P]/Tl*std::pow(ET,PetscScalar(-1.0/3.0));
     PetscScalar mu_sr = DP_LSM*std::pow(ET,-EXP8_LSM);
     return 1.0/(1.0/mu_ac+1.0/mu_sr);
   }
-  AutoDScalar HoleMobSurface(const AutoDScalar &Tl,const AutoDScalar &Et) const
+  AutoDScalar HoleMobSurface(const AutoDScalar &Tl,const AutoDScalar &Et, const PetscScalar *c) const
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N_total = Na+Nd+1e0*std::pow(cm,-3);
     AutoDScalar ET = Et+1.0*V/cm;
-    AutoDScalar mu_ac = BP_LSM/ET + CP_LSM*std::pow(N_total,EXP4_LSM)/Tl*adtl::pow(ET+1.0*V/cm,PetscScalar(-1.0/3.0));
+    AutoDScalar mu_ac = BP_LSM/ET + c[MU_AC_P]/Tl*adtl::pow(ET+1.0*V/cm,PetscScalar(-1.0/3.0));
     AutoDScalar mu_sr = DP_LSM*adtl::pow(ET,-EXP8_LSM);
     return 1.0/(1.0/mu_ac+1.0/mu_sr);
   }
@@ -263,15 +260,18 @@ public:
   PetscScalar ElecMob(const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl,
                       const PetscScalar &Ep, const PetscScalar &Et, const PetscScalar &Tn) const
   {
-    PetscScalar vsat = VSATN0/(1+VSATN_A*exp(Tl/(2*T300)));
-    PetscScalar mu0  = 1.0/(1.0/ElecMobLowField(Tl)+1.0/ElecMobSurface(Tl,Et));
+    const PetscScalar * c = ReadNodeCache(Tl);
+    PetscScalar vsat = c[VSAT_N];
+    PetscScalar mu0  = 1.0/(1.0/ElecMobLowField(Tl,c)+1.0/ElecMobSurface(Tl,Et,c));
     return mu0/std::pow(1+std::pow(mu0*fabs(Ep)/vsat,BETAN),1.0/BETAN);
   }
   AutoDScalar ElecMob(const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl,
                       const AutoDScalar &Ep, const AutoDScalar &Et, const AutoDScalar &Tn) const
   {
+    // only the doping terms of cache are used, temperature terms need derivatives
+    const PetscScalar * c = ReadNodeCache(Tl.getValue());
     AutoDScalar vsat = VSATN0/(1+VSATN_A*exp(Tl/(2*T300)));
-    AutoDScalar mu0  = 1.0/(1.0/ElecMobLowField(Tl)+1.0/ElecMobSurface(Tl,Et));
+    AutoDScalar mu0  = 1.0/(1.0/ElecMobLowField(Tl,c)+1.0/ElecMobSurface(Tl,Et,c));
     return mu0/adtl::pow(1+adtl::pow(mu0*fabs(Ep)/vsat,BETAN),1.0/BETAN);
   }
 
@@ -280,15 +280,17 @@ public:
   PetscScalar HoleMob (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl,
                        const PetscScalar &Ep, const PetscScalar &Et, const PetscScalar &Tp) const
   {
-    PetscScalar vsat = VSATP0/(1+VSATP_A*exp(Tl/(2*T300)));
-    PetscScalar mu0  = 1.0/(1.0/HoleMobLowField(Tl)+1.0/HoleMobSurface(Tl,Et));
+    const PetscScalar * c = ReadNodeCache(Tl);
+    PetscScalar vsat = c[VSAT_P];
+    PetscScalar mu0  = 1.0/(1.0/HoleMobLowField(Tl,c)+1.0/HoleMobSurface(Tl,Et,c));
     return mu0/std::pow(1+std::pow(mu0*fabs(Ep)/vsat,BETAP),1.0/BETAP);
   }
   AutoDScalar HoleMob(const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl,
                       const AutoDScalar &Ep, const AutoDScalar &Et, const AutoDScalar &Tp) const
   {
+    const PetscScalar * c = ReadNodeCache(Tl.getValue());
     AutoDScalar vsat = VSATP0/(1+VSATP_A*exp(Tl/(2*T300)));
-    AutoDScalar mu0  = 1.0/(1.0/HoleMobLowField(Tl)+1.0/HoleMobSurface(Tl,Et));
+    AutoDScalar mu0  = 1.0/(1.0/HoleMobLowField(Tl,c)+1.0/HoleMobSurface(Tl,Et,c));
     return mu0/adtl::pow(1+adtl::pow(mu0*fabs(Ep)/vsat,BETAP),1.0/BETAP);
   }
 
@@ -298,6 +300,7 @@ public:
   {
     PMI_Info = "This is the Lombardi mobility model of Silicon";
     Mob_Lombardi_Init();
+    DeclareNodeCache(N_CACHE_TERM, true);
   }
 
   ~GSS_Si_Mob_Lombardi(){}
@@ -24,6 +24,7 @@
 #include <cstdlib>
 #include <cmath>
 #include <iomanip>
+#include <set>
 
 #include "genius_common.h"
 #include "genius_env.h"
@@ -50,6 +51,115 @@
 namespace Material
 {
 
+  namespace
+  {
+#ifdef WINDOWS
+    typedef HINSTANCE  DLL_Handle;
+#else
+    typedef void *     DLL_Handle;
+#endif
+
+    /**
+     * a material dll file opened by the registry, shared by all the regions of the material.
+     * the reference count includes the preload, the symbols already resolved are cached,
+     * and so are the parameter tables of the PMI classes created by these symbols
+     */
+    struct MaterialLibrary
+    {
+      DLL_Handle  handle;
+      unsigned int ref_count;
+      std::map<std::string, void *> symbols;
+      std::map<std::string, PMI_ParameterTable> parameter_tables;
+    };
+
+    /**
+     * process wide registry of opened material dll files, key is the formatted material name
+     */
+    std::map<std::string, MaterialLibrary> & material_library_registry()
+    {
+      static std::map<std::string, MaterialLibrary> registry;
+      return registry;
+    }
+
+    /**
+     * materials pinned by MaterialBase::preload_materials
+     */
+    std::set<std::string> & preloaded_material_libraries()
+    {
+      static std::set<std::string> preloaded;
+      return preloaded;
+    }
+
+    /**
+     * open the dll file of material or increase its reference count
+     */
+    MaterialLibrary & acquire_material_library( const std::string & _material )
+    {
+      std::map<std::string, MaterialLibrary> & registry = material_library_registry();
+      std::map<std::string, MaterialLibrary>::iterator it = registry.find(_material);
+      if( it != registry.end() )
+      {
+        it->second.ref_count++;
+        return it->second;
+      }
+
+#ifdef WINDOWS
+      std::string filename =  Genius::genius_dir() + "\\lib\\lib" + _material + ".dll";
+#else
+      std::string filename =  Genius::genius_dir() + "/lib/lib" + _material + ".so";
+#endif
+
+      DLL_Handle handle;
+#ifdef WINDOWS
+      handle = LoadLibrary(filename.c_str());
+      if(handle==NULL)
+      {
+        MESSAGE<<"Open material file lib"<< _material <<".dll error." << '\n'; RECORD();
+        MESSAGE<<"Error code: " << GetLastError() << '\n'; RECORD();
+        genius_error();
+      }
+#else
+#ifdef RTLD_DEEPBIND
+      handle = dlopen(filename.c_str(), RTLD_LAZY|RTLD_DEEPBIND);
+#else
+      handle = dlopen(filename.c_str(), RTLD_LAZY);
+#endif
+      if(handle==NULL)
+      {
+        MESSAGE<<"Open material file lib"<< _material <<".so error." << '\n'; RECORD();
+        MESSAGE<<"Error code: " << dlerror() << '\n'; RECORD();
+        genius_error();
+      }
+#endif
+
+      MaterialLibrary & library = registry[_material];
+      library.handle = handle;
+      library.ref_count = 1;
+      return library;
+    }
+
+    /**
+     * decrease the reference count of material dll file, close it when no one holds it
+     */
+    void release_material_library( const std::string & _material )
+    {
+      std::map<std::string, MaterialLibrary> & registry = material_library_registry();
+      std::map<std::string, MaterialLibrary>::iterator it = registry.find(_material);
+      if( it == registry.end() ) return;
+
+      if( --it->second.ref_count > 0 ) return;
+
+#ifdef WINDOWS
+      FreeLibrary(it->second.handle);
+#else
+      dlclose(it->second.handle);
+#endif
+      registry.erase(it);
+    }
+  }
+
+
+
   MaterialBase::MaterialBase(const SimulationRegion * reg)
   : set_ad_num(0),  region(reg) , material(reg->material()), p_point(0), p_node_data(0), dll_file(0)
   {
@@ -59,12 +169,9 @@ namespace Material
 
   MaterialBase::~MaterialBase()
   {
-#ifdef WINDOWS
-    FreeLibrary(dll_file);
-#else
+    // PMI objects are deleted by derived class, the dll file can be released now
     if ( dll_file )
-      dlclose( dll_file );
-#endif
+      release_material_library( dll_name );
   }
 
 
@@ -78,33 +185,60 @@ namespace Material
 
   void MaterialBase::load_material( const std::string & _material )
   {
-#ifdef WINDOWS
-    std::string filename =  Genius::genius_dir() + "\\lib\\lib" + _material + ".dll";
-#else
-    std::string filename =  Genius::genius_dir() + "/lib/lib" + _material + ".so";
-#endif
+    MaterialLibrary & library = acquire_material_library(_material);
+    dll_file = library.handle;
+    dll_name = _material;
+  }
 
-#ifdef WINDOWS
-    dll_file = LoadLibrary(filename.c_str());
-    if(dll_file==NULL)
+
+  void * MaterialBase::load_symbol( const std::string & name )
+  {
+    MaterialLibrary & library = material_library_registry()[dll_name];
+
+    std::map<std::string, void *>::const_iterator it = library.symbols.find(name);
+    if( it != library.symbols.end() ) return it->second;
+
+    void * symbol = (void *)LDFUN(dll_file, name.c_str());
+    library.symbols[name] = symbol;
+    return symbol;
+  }
+
+
+  void MaterialBase::share_parameter_table( PMI_Server * pmi, const std::string & model_fun_name )
+  {
+    MaterialLibrary & library = material_library_registry()[dll_name];
+
+    std::map<std::string, PMI_ParameterTable>::iterator it = library.parameter_tables.find(model_fun_name);
+    if( it == library.parameter_tables.end() )
     {
-      MESSAGE<<"Open material file lib"<< _material <<".dll error." << '\n'; RECORD();
-      MESSAGE<<"Error code: " << GetLastError() << '\n'; RECORD();
-      genius_error();
+      it = library.parameter_tables.insert( std::make_pair(model_fun_name, PMI_ParameterTable()) ).first;
+      pmi->build_parameter_table(it->second);
     }
-#else
-#ifdef RTLD_DEEPBIND
-    dll_file = dlopen(filename.c_str(), RTLD_LAZY|RTLD_DEEPBIND);
-#else
-    dll_file = dlopen(filename.c_str(), RTLD_LAZY);
-#endif
-    if(dll_file==NULL)
+
+    // a pmi whose parameters differ from the table keeps its own ones
+    pmi->share_parameter_table(it->second);
+  }
+
+
+  void MaterialBase::preload_materials( const std::vector<std::string> & materials )
+  {
+    std::set<std::string> & preloaded = preloaded_material_libraries();
+    for(unsigned int n=0; n<materials.size(); ++n)
     {
-      MESSAGE<<"Open material file lib"<< _material <<".so error." << '\n'; RECORD();
-      MESSAGE<<"Error code: " << dlerror() << '\n'; RECORD();
-      genius_error();
+      std::string _material = FormatMaterialString(materials[n]);
+      if( preloaded.insert(_material).second )
+        acquire_material_library(_material);
     }
-#endif
+  }
+
+
+  void MaterialBase::release_preloaded_materials()
+  {
+    std::set<std::string> & preloaded = preloaded_material_libraries();
+    std::set<std::string>::const_iterator it = preloaded.begin();
+    for(; it!=preloaded.end(); ++it)
+      release_material_library(*it);
+    preloaded.clear();
   }
 
 
@@ -126,54 +260,54 @@ namespace Material
     PMIS_Trap*          (*wtrap)     (const PMI_Environment& env);
 
     //init AD indepedent variable set routine
-    set_ad_num = (void* (*) (const unsigned int))LDFUN(dll_file,"set_ad_number");
+    set_ad_num = (void* (*) (const unsigned int))load_symbol("set_ad_number");
     if(!set_ad_num) { MESSAGE<<"Open PMIS AD_SET_VARIABLE function error!\n"; RECORD(); genius_error();}
 
     std::string model_fun_name;
 
     // init basic parameters for the material
     model_fun_name = "PMIS_" + _material + "_BasicParameter_Default";
-    wbasic = (PMIS_BasicParameter* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wbasic = (PMIS_BasicParameter* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wbasic) { MESSAGE<<"Open PMIS "<< material <<" BasicParameter function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Basic] = model_fun_name;
 
     // init band structure model
     model_fun_name = "PMIS_" + _material + "_BandStructure_Default";
-    wband =  (PMIS_BandStructure* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wband =  (PMIS_BandStructure* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wband) { MESSAGE<<"Open PMIS "<< material <<" BandStructure function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Band] = model_fun_name;
 
 
     // init mobility model
     model_fun_name = "PMIS_" + _material + "_Mob_Default";
-    wmob  =  (PMIS_Mobility* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wmob  =  (PMIS_Mobility* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wmob) { MESSAGE<<"Open PMIS "<< material <<" Mobility function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Mobility] = model_fun_name;
 
 
     // init Avalanche generation model
     model_fun_name = "PMIS_" + _material + "_Avalanche_Default";
-    wgen  =  (PMIS_Avalanche* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wgen  =  (PMIS_Avalanche* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wgen) { MESSAGE<<"Open PMIS "<< material <<" Avalanche function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Impact] = model_fun_name;
 
 
     // init Thermal model for lattice temperature equation
     model_fun_name = "PMIS_" + _material + "_Thermal_Default";
-    wthermal  = (PMIS_Thermal* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wthermal  = (PMIS_Thermal* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wthermal) { MESSAGE<<"Open PMIS "<< material <<" Thermal function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Thermal] = model_fun_name;
 
 
     // init optical data
     model_fun_name = "PMIS_" + _material + "_Optical_Default";
-    woptical  = (PMIS_Optical* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    woptical  = (PMIS_Optical* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!woptical) { MESSAGE<<"Open PMIS "<< material <<" Optical function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Optical] = model_fun_name;
 
     // init trap data
     model_fun_name = "PMIS_" + _material + "_Trap_Default";
-    wtrap = (PMIS_Trap* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wtrap = (PMIS_Trap* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wtrap ) { MESSAGE<<"Open PMIS "<< material <<" Trap function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Trap] = model_fun_name;
 
@@ -185,6 +319,15 @@ namespace Material
     optical  = woptical(env);
     trap  = wtrap(env);
 
+    // regions of this material and model share the parameter descriptions
+    share_parameter_table(basic, active_models[Basic]);
+    share_parameter_table(band, active_models[Band]);
+    share_parameter_table(mob, active_models[Mobility]);
+    share_parameter_table(gen, active_models[Impact]);
+    share_parameter_table(thermal, active_models[Thermal]);
+    share_parameter_table(optical, active_models[Optical]);
+    share_parameter_table(trap, active_models[Trap]);
+
   }
 
 
@@ -250,30 +393,35 @@ namespace Material
 
   }
 
-  std::string MaterialSemiconductor::get_pmi_info(const std::string& type, const int verbosity)
+  PMI_Server * MaterialSemiconductor::get_pmi(const std::string& type)
   {
-    std::string _material = FormatMaterialString(material);
-    std::stringstream output;
-
-    PMI_Server* pmi;
     switch(PMI_Type_string_to_enum(type))
     {
     case Basic:
-      pmi = basic; break;
+      return basic;
     case Band:
-      pmi = band; break;
+      return band;
     case Mobility:
-      pmi = mob; break;
+      return mob;
     case Impact:
-      pmi = gen; break;
+      return gen;
     case Thermal:
-      pmi = thermal; break;
+      return thermal;
     case Optical:
-      pmi = optical; break;
+      return optical;
     case Trap:
-      pmi = trap; break;
-    default: genius_error();
+      return trap;
+    default: return NULL;
     }
+  }
+
+  std::string MaterialSemiconductor::get_pmi_info(const std::string& type, const int verbosity)
+  {
+    std::stringstream output;
+
+    PMI_Server* pmi = get_pmi(type);
+    if(!pmi) genius_error();
+
     output << pmi->get_PMI_info() << std::endl;
     output << pmi->get_parameter_string(verbosity) ;
 
@@ -303,12 +451,13 @@ namespace Material
         std::string model_fun_name = "PMIS_" + _material + "_BasicParameter_" + model_name;
         if (active_models[Basic] != model_fun_name)
         {
-          wbasic = (PMIS_BasicParameter* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wbasic = (PMIS_BasicParameter* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wbasic) { MESSAGE<<"Open PMIS "<< material <<" BasicParameter function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete basic;
           // get a new one and do calibrate
           basic = wbasic(env);
+          share_parameter_table(basic, model_fun_name);
           active_models[Basic] = model_fun_name;
         }
         if(basic->calibrate(pmi_parameters))
@@ -325,12 +474,13 @@ namespace Material
         std::string model_fun_name = "PMIS_" + _material + "_BandStructure_" + model_name;
         if (active_models[Band] != model_fun_name)
         {
-          wband = (PMIS_BandStructure* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wband = (PMIS_BandStructure* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wband) { MESSAGE<<"Open PMIS "<< material <<" BandStructure function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete band;
           // get a new one and do calibrate
           band = wband(env);
+          share_parameter_table(band, model_fun_name);
           active_models[Band] = model_fun_name;
         }
         if(band->calibrate(pmi_parameters))
@@ -347,12 +497,13 @@ namespace Material
         std::string model_fun_name = "PMIS_" + _material + "_Mob_" + model_name;
         if (active_models[Mobility] != model_fun_name)
         {
-          wmob = (PMIS_Mobility* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wmob = (PMIS_Mobility* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wmob) { MESSAGE<<"Open PMIS "<< material <<" Mobility function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete mob;
           // get a new one and do calibrate
           mob = wmob(env);
+          share_parameter_table(mob, model_fun_name);
           active_models[Mobility] = model_fun_name;
         }
         if(mob->calibrate(pmi_parameters))
@@ -369,12 +520,13 @@ namespace Material
         std::string model_fun_name = "PMIS_" + _material + "_Avalanche_" + model_name;
         if (active_models[Impact] != model_fun_name)
         {
-          wgen = (PMIS_Avalanche* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wgen = (PMIS_Avalanche* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wgen) { MESSAGE<<"Open PMIS "<< material <<" Avalanche function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete gen;
           // get a new one and do calibrate
           gen = wgen(env);
+          share_parameter_table(gen, model_fun_name);
           active_models[Impact] = model_fun_name;
         }
         if(gen->calibrate(pmi_parameters))
@@ -391,12 +543,13 @@ namespace Material
         std::string model_fun_name = "PMIS_" + _material + "_Thermal_" + model_name;
         if (active_models[Thermal] != model_fun_name)
         {
-          wthermal = (PMIS_Thermal* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wthermal = (PMIS_Thermal* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wthermal) { MESSAGE<<"Open PMIS "<< material <<" Thermal function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete thermal;
           // get a new one and do calibrate
           thermal = wthermal(env);
+          share_parameter_table(thermal, model_fun_name);
           active_models[Thermal] = model_fun_name;
         }
         if(thermal->calibrate(pmi_parameters))
@@ -413,12 +566,13 @@ namespace Material
         std::string model_fun_name = "PMIS_" + _material + "_Optical_" + model_name;
         if (active_models[Optical] != model_fun_name)
         {
-          woptical = (PMIS_Optical* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          woptical = (PMIS_Optical* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!woptical) { MESSAGE<<"Open PMIS "<< material <<" Optical function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete optical;
           // get a new one and do calibrate
           optical = woptical(env);
+          share_parameter_table(optical, model_fun_name);
           active_models[Optical] = model_fun_name;
         }
         if(optical->calibrate(pmi_parameters))
@@ -435,12 +589,13 @@ namespace Material
         std::string model_fun_name = "PMIS_" + _material + "_Trap_" + model_name;
         if (active_models[Trap] != model_fun_name)
         {
-          wtrap = (PMIS_Trap* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wtrap = (PMIS_Trap* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wtrap) { MESSAGE<<"Open PMIS "<< material <<" Trap function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete trap;
           // get a new one and do calibrate
           trap = wtrap(env);
+          share_parameter_table(trap, model_fun_name);
           active_models[Trap] = model_fun_name;
         }
         if(trap->calibrate(pmi_parameters))
@@ -473,32 +628,32 @@ namespace Material
     PMII_Optical*       (*woptical)  (const PMI_Environment& env);
 
     //init AD indepedent variable set routine
-    set_ad_num = (void* (*) (const unsigned int))LDFUN(dll_file,"set_ad_number");
+    set_ad_num = (void* (*) (const unsigned int))load_symbol("set_ad_number");
     if(!set_ad_num) { MESSAGE<<"Open PMII AD_SET_VARIABLE function error!\n"; RECORD(); genius_error();}
 
     std::string model_fun_name;
 
     // init basic parameters for the material
     model_fun_name = "PMII_" + _material + "_BasicParameter_Default";
-    wbasic = (PMII_BasicParameter* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wbasic = (PMII_BasicParameter* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wbasic) { MESSAGE<<"Open PMII "<< material <<" BasicParameter function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Basic] = model_fun_name;
 
     // init band structure model
     model_fun_name = "PMII_" + _material + "_BandStructure_Default";
-    wband =  (PMII_BandStructure* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wband =  (PMII_BandStructure* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wband) { MESSAGE<<"Open PMII "<< material <<" BandStructure function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Band] = model_fun_name;
 
     // init Thermal model for lattice temperature equation
     model_fun_name = "PMII_" + _material + "_Thermal_Default";
-    wthermal  = (PMII_Thermal* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wthermal  = (PMII_Thermal* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wthermal) { MESSAGE<<"Open PMII "<< material <<" Thermal function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Thermal] = model_fun_name;
 
     // init optical data
     model_fun_name = "PMII_" + _material + "_Optical_Default";
-    woptical  = (PMII_Optical* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    woptical  = (PMII_Optical* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!woptical) { MESSAGE<<"Open PMII "<< material <<" Optical function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Optical] = model_fun_name;
 
@@ -506,6 +661,12 @@ namespace Material
     band  = wband(env);
     thermal  = wthermal(env);
     optical  = woptical(env);
+
+    // regions of this material and model share the parameter descriptions
+    share_parameter_table(basic, active_models[Basic]);
+    share_parameter_table(band, active_models[Band]);
+    share_parameter_table(thermal, active_models[Thermal]);
+    share_parameter_table(optical, active_models[Optical]);
   }
 
 
@@ -554,24 +715,29 @@ namespace Material
     }
   }
 
-  std::string MaterialInsulator::get_pmi_info(const std::string& type, const int verbosity)
+  PMI_Server * MaterialInsulator::get_pmi(const std::string& type)
   {
-    std::string _material = FormatMaterialString(material);
-    std::stringstream output;
-
-    PMI_Server* pmi;
     switch(PMI_Type_string_to_enum(type))
     {
     case Basic:
-      pmi = basic; break;
+      return basic;
     case Band:
-      pmi = band; break;
+      return band;
     case Thermal:
-      pmi = thermal; break;
+      return thermal;
     case Optical:
-      pmi = optical; break;
-    default: genius_error();
+      return optical;
+    default: return NULL;
     }
+  }
+
+  std::string MaterialInsulator::get_pmi_info(const std::string& type, const int verbosity)
+  {
+    std::stringstream output;
+
+    PMI_Server* pmi = get_pmi(type);
+    if(!pmi) genius_error();
+
     output << pmi->get_PMI_info() << std::endl;
     output << pmi->get_parameter_string(verbosity) ;
 
@@ -597,12 +763,13 @@ namespace Material
         std::string model_fun_name = "PMII_" + _material + "_BasicParameter_" + model_name;
         if (active_models[Basic] != model_fun_name)
         {
-          wbasic = (PMII_BasicParameter* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wbasic = (PMII_BasicParameter* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wbasic) { MESSAGE<<"Open PMII "<< material <<" BasicParameter function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete basic;
           // get a new one and do calibrate
           basic = wbasic(env);
+          share_parameter_table(basic, model_fun_name);
           active_models[Basic] = model_fun_name;
         }
         if(basic->calibrate(pmi_parameters))
@@ -619,12 +786,13 @@ namespace Material
         std::string model_fun_name = "PMII_" + _material + "_BandStructure_" + model_name;
         if (active_models[Band] != model_fun_name)
         {
-          wband = (PMII_BandStructure* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wband = (PMII_BandStructure* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wband) { MESSAGE<<"Open PMII "<< material <<" BandStructure function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete band;
           // get a new one and do calibrate
           band = wband(env);
+          share_parameter_table(band, model_fun_name);
           active_models[Band] = model_fun_name;
         }
         if(band->calibrate(pmi_parameters))
@@ -641,12 +809,13 @@ namespace Material
         std::string model_fun_name = "PMII_" + _material + "_Thermal_" + model_name;
         if (active_models[Thermal] != model_fun_name)
         {
-          wthermal = (PMII_Thermal* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wthermal = (PMII_Thermal* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wthermal) { MESSAGE<<"Open PMII "<< material <<" Thermal function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete thermal;
           // get a new one and do calibrate
           thermal = wthermal(env);
+          share_parameter_table(thermal, model_fun_name);
           active_models[Thermal] = model_fun_name;
         }
         if(thermal->calibrate(pmi_parameters))
@@ -663,12 +832,13 @@ namespace Material
         std::string model_fun_name = "PMII_" + _material + "_Optical_" + model_name;
         if (active_models[Optical] != model_fun_name)
         {
-          woptical = (PMII_Optical* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          woptical = (PMII_Optical* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!woptical) { MESSAGE<<"Open PMII "<< material <<" Optical function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete optical;
           // get a new one and do calibrate
           optical = woptical(env);
+          share_parameter_table(optical, model_fun_name);
           active_models[Optical] = model_fun_name;
         }
         if(optical->calibrate(pmi_parameters))
@@ -702,32 +872,37 @@ namespace Material
     PMIC_Optical*       (*woptical)  (const PMI_Environment& env);
 
     //init AD indepedent variable set routine
-    set_ad_num = (void* (*) (const unsigned int))LDFUN(dll_file,"set_ad_number");
+    set_ad_num = (void* (*) (const unsigned int))load_symbol("set_ad_number");
     if(!set_ad_num) { MESSAGE<<"Open PMIC AD_SET_VARIABLE function error!\n"; RECORD(); genius_error();}
 
     std::string model_fun_name;
 
     // init basic parameters for the material
     model_fun_name = "PMIC_" + _material + "_BasicParameter_Default";
-    wbasic = (PMIC_BasicParameter* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wbasic = (PMIC_BasicParameter* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wbasic) { MESSAGE<<"Open PMIC "<< material <<" BasicParameter function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Basic] = model_fun_name;
 
     // init Thermal model for lattice temperature equation
     model_fun_name = "PMIC_" + _material + "_Thermal_Default";
-    wthermal  = (PMIC_Thermal* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wthermal  = (PMIC_Thermal* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wthermal) { MESSAGE<<"Open PMIC "<< material <<" Thermal function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Thermal] = model_fun_name;
 
     // init optical data
     model_fun_name = "PMIC_" + _material + "_Optical_Default";
-    woptical  = (PMIC_Optical* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    woptical  = (PMIC_Optical* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!woptical) { MESSAGE<<"Open PMIC "<< material <<" Optical function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Optical] = model_fun_name;
 
     basic = wbasic(env);
     thermal  = wthermal(env);
     optical  = woptical(env);
+
+    // regions of this material and model share the parameter descriptions
+    share_parameter_table(basic, active_models[Basic]);
+    share_parameter_table(thermal, active_models[Thermal]);
+    share_parameter_table(optical, active_models[Optical]);
   }
 
 
@@ -772,22 +947,27 @@ namespace Material
     }
   }
 
-  std::string MaterialConductor::get_pmi_info(const std::string& type, const int verbosity)
+  PMI_Server * MaterialConductor::get_pmi(const std::string& type)
   {
-    std::string _material = FormatMaterialString(material);
-    std::stringstream output;
-
-    PMI_Server* pmi;
     switch(PMI_Type_string_to_enum(type))
     {
     case Basic:
-      pmi = basic; break;
+      return basic;
     case Thermal:
-      pmi = thermal; break;
+      return thermal;
     case Optical:
-      pmi = optical; break;
-    default: genius_error();
+      return optical;
+    default: return NULL;
     }
+  }
+
+  std::string MaterialConductor::get_pmi_info(const std::string& type, const int verbosity)
+  {
+    std::stringstream output;
+
+    PMI_Server* pmi = get_pmi(type);
+    if(!pmi) genius_error();
+
     output << pmi->get_PMI_info() << std::endl;
     output << pmi->get_parameter_string(verbosity) ;
 
@@ -814,12 +994,13 @@ namespace Material
         std::string model_fun_name = "PMIC_" + _material + "_BasicParameter_" + model_name;
         if (active_models[Basic] != model_fun_name)
         {
-          wbasic = (PMIC_BasicParameter* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wbasic = (PMIC_BasicParameter* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wbasic) { MESSAGE<<"Open PMIC "<< material <<" BasicParameter function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete basic;
           // get a new one and do calibrate
           basic = wbasic(env);
+          share_parameter_table(basic, model_fun_name);
           active_models[Basic] = model_fun_name;
         }
         if(basic->calibrate(pmi_parameters))
@@ -836,12 +1017,13 @@ namespace Material
         std::string model_fun_name = "PMIC_" + _material + "_Thermal_" + model_name;
         if (active_models[Thermal] != model_fun_name)
         {
-          wthermal = (PMIC_Thermal* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wthermal = (PMIC_Thermal* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wthermal) { MESSAGE<<"Open PMIC "<< material <<" Thermal function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete thermal;
           // get a new one and do calibrate
           thermal = wthermal(env);
+          share_parameter_table(thermal, model_fun_name);
           active_models[Thermal] = model_fun_name;
         }
         if(thermal->calibrate(pmi_parameters))
@@ -858,12 +1040,13 @@ namespace Material
         std::string model_fun_name = "PMIC_" + _material + "_Optical_" + model_name;
         if (active_models[Optical] != model_fun_name)
         {
-          woptical = (PMIC_Optical* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          woptical = (PMIC_Optical* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!woptical) { MESSAGE<<"Open PMIC "<< material <<" Optical function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete optical;
           // get a new one and do calibrate
           optical = woptical(env);
+          share_parameter_table(optical, model_fun_name);
           active_models[Optical] = model_fun_name;
         }
         if(optical->calibrate(pmi_parameters))
@@ -899,32 +1082,37 @@ namespace Material
     PMIV_Optical*       (*woptical)  (const PMI_Environment& env);
 
     //init AD indepedent variable set routine
-    set_ad_num = (void* (*) (const unsigned int))LDFUN(dll_file,"set_ad_number");
+    set_ad_num = (void* (*) (const unsigned int))load_symbol("set_ad_number");
     if(!set_ad_num) { MESSAGE<<"Open PMIV AD_SET_VARIABLE function error!\n"; RECORD(); genius_error();}
 
     std::string model_fun_name;
 
     // init basic parameters for the material
     model_fun_name = "PMIV_" + _material + "_BasicParameter_Default";
-    wbasic = (PMIV_BasicParameter* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wbasic = (PMIV_BasicParameter* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wbasic) { MESSAGE<<"Open PMIV "<< material <<" BasicParameter function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Basic] = model_fun_name;
 
     // init Thermal model for lattice temperature equation
     model_fun_name = "PMIV_" + _material + "_Thermal_Default";
-    wthermal  = (PMIV_Thermal* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wthermal  = (PMIV_Thermal* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wthermal) { MESSAGE<<"Open PMIV "<< material <<" Thermal function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Thermal] = model_fun_name;
 
     // init optical data
     model_fun_name = "PMIV_" + _material + "_Optical_Default";
-    woptical  = (PMIV_Optical* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    woptical  = (PMIV_Optical* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!woptical) { MESSAGE<<"Open PMIV "<< material <<" Optical function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Optical] = model_fun_name;
 
     basic = wbasic(env);
     thermal  = wthermal(env);
     optical  = woptical(env);
+
+    // regions of this material and model share the parameter descriptions
+    share_parameter_table(basic, active_models[Basic]);
+    share_parameter_table(thermal, active_models[Thermal]);
+    share_parameter_table(optical, active_models[Optical]);
   }
 
 
@@ -969,22 +1157,27 @@ namespace Material
     }
   }
 
-  std::string MaterialVacuum::get_pmi_info(const std::string& type, const int verbosity)
+  PMI_Server * MaterialVacuum::get_pmi(const std::string& type)
   {
-    std::string _material = FormatMaterialString(material);
-    std::stringstream output;
-
-    PMI_Server* pmi;
     switch(PMI_Type_string_to_enum(type))
     {
     case Basic:
-      pmi = basic; break;
+      return basic;
     case Thermal:
-      pmi = thermal; break;
+      return thermal;
     case Optical:
-      pmi = optical; break;
-    default: genius_error();
+      return optical;
+    default: return NULL;
     }
+  }
+
+  std::string MaterialVacuum::get_pmi_info(const std::string& type, const int verbosity)
+  {
+    std::stringstream output;
+
+    PMI_Server* pmi = get_pmi(type);
+    if(!pmi) genius_error();
+
     output << pmi->get_PMI_info() << std::endl;
     output << pmi->get_parameter_string(verbosity) ;
 
@@ -1010,12 +1203,13 @@ namespace Material
         std::string model_fun_name = "PMIV_" + _material + "_BasicParameter_" + model_name;
         if (active_models[Basic] != model_fun_name)
         {
-          wbasic = (PMIV_BasicParameter* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wbasic = (PMIV_BasicParameter* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wbasic) { MESSAGE<<"Open PMIV "<< material <<" BasicParameter function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete basic;
           // get a new one and do calibrate
           basic = wbasic(env);
+          share_parameter_table(basic, model_fun_name);
           active_models[Basic] = model_fun_name;
         }
         if(basic->calibrate(pmi_parameters))
@@ -1029,12 +1223,13 @@ namespace Material
         std::string model_fun_name = "PMIV_" + _material + "_Thermal_" + model_name;
         if (active_models[Thermal] != model_fun_name)
         {
-          wthermal = (PMIV_Thermal* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wthermal = (PMIV_Thermal* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wthermal) { MESSAGE<<"Open PMIV "<< material <<" Thermal function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete thermal;
           // get a new one and do calibrate
           thermal = wthermal(env);
+          share_parameter_table(thermal, model_fun_name);
           active_models[Thermal] = model_fun_name;
         }
         if(thermal->calibrate(pmi_parameters))
@@ -1048,12 +1243,13 @@ namespace Material
         std::string model_fun_name = "PMIV_" + _material + "_Optical_" + model_name;
         if (active_models[Optical] != model_fun_name)
         {
-          woptical = (PMIV_Optical* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          woptical = (PMIV_Optical* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!woptical) { MESSAGE<<"Open PMIV "<< material <<" Optical function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete optical;
           // get a new one and do calibrate
           optical = woptical(env);
+          share_parameter_table(optical, model_fun_name);
           active_models[Optical] = model_fun_name;
         }
         if(optical->calibrate(pmi_parameters))
@@ -1086,25 +1282,29 @@ namespace Material
     PMIP_Thermal*       (*wthermal)  (const PMI_Environment& env);
 
     //init AD indepedent variable set routine
-    set_ad_num = (void* (*) (const unsigned int))LDFUN(dll_file,"set_ad_number");
+    set_ad_num = (void* (*) (const unsigned int))load_symbol("set_ad_number");
     if(!set_ad_num) { MESSAGE<<"Open PMIP AD_SET_VARIABLE function error!\n"; RECORD(); genius_error();}
 
     std::string model_fun_name;
 
     // init basic parameters for the material
     model_fun_name = "PMIP_" + _material + "_BasicParameter_Default";
-    wbasic = (PMIP_BasicParameter* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wbasic = (PMIP_BasicParameter* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wbasic) { MESSAGE<<"Open PMIP "<< material <<" BasicParameter function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Basic] = model_fun_name;
 
     // init Thermal model for lattice temperature equation
     model_fun_name = "PMIP_" + _material + "_Thermal_Default";
-    wthermal  = (PMIP_Thermal* (*) (const PMI_Environment& env))LDFUN(dll_file, model_fun_name.c_str());
+    wthermal  = (PMIP_Thermal* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
     if(!wthermal) { MESSAGE<<"Open PMIP "<< material <<" Thermal function "<< "Default" <<" error!\n"; RECORD(); genius_error(); }
     active_models[Thermal] = model_fun_name;
 
     basic = wbasic(env);
     thermal  = wthermal(env);
+
+    // regions of this material and model share the parameter descriptions
+    share_parameter_table(basic, active_models[Basic]);
+    share_parameter_table(thermal, active_models[Thermal]);
   }
 
 
@@ -1144,20 +1344,25 @@ namespace Material
     }
   }
 
-  std::string MaterialPML::get_pmi_info(const std::string& type, const int verbosity)
+  PMI_Server * MaterialPML::get_pmi(const std::string& type)
   {
-    std::string _material = FormatMaterialString(material);
-    std::stringstream output;
-
-    PMI_Server* pmi;
     switch(PMI_Type_string_to_enum(type))
     {
     case Basic:
-      pmi = basic; break;
+      return basic;
     case Thermal:
-      pmi = thermal; break;
-    default: genius_error();
+      return thermal;
+    default: return NULL;
     }
+  }
+
+  std::string MaterialPML::get_pmi_info(const std::string& type, const int verbosity)
+  {
+    std::stringstream output;
+
+    PMI_Server* pmi = get_pmi(type);
+    if(!pmi) genius_error();
+
     output << pmi->get_PMI_info() << std::endl;
     output << pmi->get_parameter_string(verbosity) ;
 
@@ -1182,12 +1387,13 @@ namespace Material
         std::string model_fun_name = "PMIP_" + _material + "_BasicParameter_" + model_name;
         if (active_models[Basic] != model_fun_name)
         {
-          wbasic = (PMIP_BasicParameter* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wbasic = (PMIP_BasicParameter* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wbasic) { MESSAGE<<"Open PMIP "<< material <<" BasicParameter function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete basic;
           // get a new one and do calibrate
           basic = wbasic(env);
+          share_parameter_table(basic, model_fun_name);
           active_models[Basic] = model_fun_name;
         }
         if(basic->calibrate(pmi_parameters))
@@ -1201,12 +1407,13 @@ namespace Material
         std::string model_fun_name = "PMIP_" + _material + "_Thermal_" + model_name;
         if (active_models[Thermal] != model_fun_name)
         {
-          wthermal = (PMIP_Thermal* (*) (const PMI_Environment& env))LDFUN( dll_file, model_fun_name.c_str() );
+          wthermal = (PMIP_Thermal* (*) (const PMI_Environment& env))load_symbol(model_fun_name);
           if(!wthermal) { MESSAGE<<"Open PMIP "<< material <<" Thermal function "<< model_name <<" error!\n"; RECORD(); genius_error(); }
           // delete old PMI object
           delete thermal;
           // get a new one and do calibrate
           thermal = wthermal(env);
+          share_parameter_table(thermal, model_fun_name);
           active_models[Thermal] = model_fun_name;
         }
         if(thermal->calibrate(pmi_parameters))
@@ -1,6 +1,15 @@
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "genius_env.h"
 #include "expr_evaluate.h"
+#include "expr_program.h"
 #include "physical_unit.h"
 
+using namespace adtl;
+
 ConstanteExprEvalute::ConstanteExprEvalute(const std::string & expr)
 {
   // use default function set
@@ -98,6 +107,24 @@ ExprEvalute::ExprEvalute(const std::string & expr)
   e.SetValueList(&vlist);
 
   e.Parse(expr);
+
+  var[0] = vlist.GetAddress("x");
+  var[1] = vlist.GetAddress("y");
+  var[2] = vlist.GetAddress("z");
+  var[3] = vlist.GetAddress("t");
+
+#ifdef DEBUG
+  static bool checked = false;
+  if( !checked )
+  {
+    checked = true;
+    // smooth opcodes, branches of if/min/max and calls into the node tree
+    genius_assert( ExprEvalute("exp(-x*x/2)*sin(t) + atan2(y, 1+z*z) + x^3/(1+y*y)").check_derivative(0.7, 0.3, -0.4, 1.3) );
+    genius_assert( ExprEvalute("if(above(x, y), min(x*x, y+3), max(ln(1+z*z), t)) + sqrt(1+t*t)").check_derivative(0.7, 0.3, -0.4, 1.3) );
+    genius_assert( ExprEvalute("if(above(x, y), min(x*x, y+3), max(ln(1+z*z), t)) + sqrt(1+t*t)").check_derivative(0.2, 0.3, -0.4, 1.3) );
+    genius_assert( ExprEvalute("clip(x*y, -1, 1) + poly(t, 1, 2, 3) + mod(z*z, 1)").check_derivative(0.7, 0.3, -0.4, 1.3) );
+  }
+#endif
 }
 
 
@@ -105,11 +132,91 @@ ExprEvalute::ExprEvalute(const std::string & expr)
 double ExprEvalute::eval(double x, double y, double z, double t)
 {
   //assign variable value to the expr
-  *(vlist.GetAddress("x")) = x;
-  *(vlist.GetAddress("y")) = y;
-  *(vlist.GetAddress("z")) = z;
-  *(vlist.GetAddress("t")) = t;
+  *var[0] = x;
+  *var[1] = y;
+  *var[2] = z;
+  *var[3] = t;
 
   return e.Evaluate();
 }
 
+
+
+AutoDScalar ExprEvalute::eval(const AutoDScalar &x, const AutoDScalar &y, const AutoDScalar &z, const AutoDScalar &t)
+{
+  const AutoDScalar * arg[4] = {&x, &y, &z, &t};
+  const unsigned int ndir = AutoDScalar::numdir;
+
+  for(unsigned int i=0; i<4; ++i)
+    *var[i] = arg[i]->getValue();
+
+  ExprEval::Program * program = e.GetProgram();
+
+  // forward derivatives by bytecode, other variables of the expression are constant
+  if( program )
+  {
+    std::vector<double> seed(program->VariableCount()*ndir, 0.0);
+    for(unsigned int v=0; v<program->VariableCount(); ++v)
+      for(unsigned int i=0; i<4; ++i)
+        if( program->VariableAddress(v) == var[i] )
+          for(unsigned int k=0; k<ndir; ++k)
+            seed[v*ndir+k] = arg[i]->getADValue(k);
+
+    std::vector<double> tangent(ndir+1);
+    double value = program->Evaluate(ndir, seed.empty() ? 0 : &seed[0], &tangent[0]);
+    if( std::abs(value) <= std::numeric_limits<double>::max() )
+      return AutoDScalar(value, &tangent[0], ndir);
+  }
+
+  // central difference for expressions without bytecode
+  double value = e.Evaluate();
+  std::vector<double> tangent(ndir+1, 0.0);
+  for(unsigned int i=0; i<4; ++i)
+  {
+    bool active = false;
+    for(unsigned int k=0; k<ndir; ++k)
+      if( arg[i]->getADValue(k) != 0.0 ) active = true;
+    if( !active ) continue;
+
+    const double v0 = arg[i]->getValue();
+    const double h = 1e-6*std::max(std::abs(v0), 1e-6);
+    *var[i] = v0 + h;
+    const double fp = e.Evaluate();
+    *var[i] = v0 - h;
+    const double fm = e.Evaluate();
+    *var[i] = v0;
+
+    const double df = (fp-fm)/(2*h);
+    for(unsigned int k=0; k<ndir; ++k)
+      tangent[k] += df*arg[i]->getADValue(k);
+  }
+
+  return AutoDScalar(value, &tangent[0], ndir);
+}
+
+
+
+bool ExprEvalute::check_derivative(double x, double y, double z, double t, double tol)
+{
+  if( AutoDScalar::numdir < 4 ) return true;
+
+  // seed x, y, z and t in direction 0 to 3
+  AutoDScalar arg[4] = {x, y, z, t};
+  for(unsigned int i=0; i<4; ++i)
+    arg[i].setADValue(i, 1.0);
+  const AutoDScalar f = eval(arg[0], arg[1], arg[2], arg[3]);
+
+  const double v[4] = {x, y, z, t};
+  for(unsigned int i=0; i<4; ++i)
+  {
+    double vp[4] = {x, y, z, t};
+    double vm[4] = {x, y, z, t};
+    const double h = 1e-6*std::max(std::abs(v[i]), 1e-3);
+    vp[i] += h;
+    vm[i] -= h;
+    const double df = (eval(vp[0], vp[1], vp[2], vp[3]) - eval(vm[0], vm[1], vm[2], vm[3]))/(2*h);
+    if( std::abs(f.getADValue(i) - df) > tol*std::max(std::abs(df), 1.0) ) return false;
+  }
+  return std::abs(f.getValue() - eval(x, y, z, t)) <= tol*std::max(std::abs(f.getValue()), 1.0);
+}
+
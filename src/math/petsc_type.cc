@@ -130,6 +130,9 @@ namespace SolverSpecify
       PreconditionerName_to_PreconditionerType["ilut"        ]  = ILUT_PRECOND;
       PreconditionerName_to_PreconditionerType["lu"          ]  = LU_PRECOND;
       PreconditionerName_to_PreconditionerType["parms"       ]  = PARMS_PRECOND;
+      PreconditionerName_to_PreconditionerType["fieldsplit"  ]  = FIELDSPLIT_PRECOND;
+      PreconditionerName_to_PreconditionerType["fieldsplit.schur"  ]  = FIELDSPLIT_SCHUR_PRECOND;
+      PreconditionerName_to_PreconditionerType["fieldsplit.region" ]  = FIELDSPLIT_REGION_PRECOND;
     }
   }
 
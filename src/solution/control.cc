@@ -21,6 +21,8 @@
 
 //  $Id: control.cc,v 1.54 2008/07/09 12:56:23 gdiso Exp $
 
+#include <algorithm>
+
 #include "genius_common.h"
 
 #ifdef WINDOWS
@@ -53,6 +55,7 @@
 #include "electrical_source.h"
 #include "field_source.h"
 #include "enum_solution.h"
+#include "parallel.h"
 #include "spice_ckt.h"
 
 
@@ -98,6 +101,7 @@
 #include "interpolation_2d_csa.h"
 #include "interpolation_3d_qshep.h"
 #include "interpolation_3d_nbtet.h"
+#include "hierarchy_transfer.h"
 
 #include "dlhook.h"
 #ifndef DLLHOOK
@@ -105,11 +109,14 @@
  #include "rawfile_hook.h"
  #include "gnuplot_hook.h"
  #include "probe_hook.h"
+ #include "probeset_hook.h"
  #include "vtk_hook.h"
  #include "threshold_hook.h"
  #include "tunneling_hook.h"
  #include "data_hook.h"
  #include "cgns_hook.h"
+ #include "hdf5_hook.h"
+ #include "checkpoint_hook.h"
 #endif
 
 
@@ -208,74 +215,308 @@ int SolverControl::mainloop()
   // from above tow steps, maybe the simulation system has been build.
   // if not, user should use IMPORT command to get an (previous) system into memory.
 
+  // cards after BATCH are done once for each variant in the parameter table
+  bool batch_mode = false;
+  Parser::Card batch_card;
+  std::vector<Parser::Card> batch_cards;
+
   // we can begin the main loop here
   for( decks().begin(); !decks().end(); decks().next() )
   {
 
     Parser::Card c = decks().get_current_card();
 
-    if(c.key() == "MODEL")
-      this->set_model ( c );
+    if(batch_mode)
+    {
+      batch_cards.push_back(c);
+      continue;
+    }
+
+    if(c.key() == "BATCH")
+    {
+      batch_mode = true;
+      batch_card = c;
+      continue;
+    }
+
+    this->do_card( c );
+  }
+
+  if(batch_mode)
+    this->do_batch( batch_card, batch_cards );
+
+  return 0;
+}
+
+
+//------------------------------------------------------------------------------
+int SolverControl::do_card( const Parser::Card & c )
+{
+  if(c.key() == "MODEL")
+    this->set_model ( c );
+
+  if(c.key() == "METHOD")
+    this->set_method ( c );
+
+  if(c.key() == "HOOK")
+    this->do_hook( c );
+
+  if(c.key() == "SOLVE")
+    this->do_solve( c );
 
-    if(c.key() == "METHOD")
-      this->set_method ( c );
+  // all the ensemble groups hold the same solution, only the first group exports it
+  if(c.key() == "EXPORT" && Genius::is_ensemble_master())
+    this->do_export( c );
 
-    if(c.key() == "HOOK")
-      this->do_hook( c );
+  if(c.key() == "IMPORT")
+    this->do_import( c );
 
-    if(c.key() == "SOLVE")
-      this->do_solve( c );
+  if(c.key() == "NODESET")
+    this->set_initial_node_voltage( c );
 
-    if(c.key() == "EXPORT")
-      this->do_export( c );
+  if(c.key() == "REFINE.CONFORM")
+    this->do_refine_conform( c );
 
-    if(c.key() == "IMPORT")
-      this->do_import( c );
+  if(c.key() == "REFINE.HIERARCHICAL")
+    this->do_refine_hierarchical( c );
 
-    if(c.key() == "NODESET")
-      this->set_initial_node_voltage( c );
+  if(c.key() == "REFINE.UNIFORM")
+    this->do_refine_uniform( c );
+
+  if(c.key() == "REGIONSET")
+    this->do_region_set( c );
+
+  if(c.key() == "BOUNDARYSET")
+    this->do_boundary_set( c );
+
+  if(c.key() == "PMI")
+    this->set_physical_model ( c );
+
+  if(c.key() == "TID")
+    this->do_tid ( c );
+
+  if(c.key() == "SOURCEAPPLY")
+    this->apply_field_source ( c );
+
+  if(c.key() == "ATTACH")
+    this->set_electrode_source ( c );
+
+  if(c.key() == "EXTEND")
+    this->extend_to_3d( c );
+
+  if(c.key() == "ROTATE")
+    this->rotate_to_3d( c );
+
+  if(c.key() == "PLOTMESH")
+    this->plot_mesh( c );
+
+  return 0;
+}
+
+
+/**
+ * override parameter name of card c with value, the parameter keeps its type
+ * @return false if c has no such parameter or value can not be converted
+ */
+static bool batch_override_parameter(Parser::Card & c, const std::string & name, const std::string & value)
+{
+  bool found = false;
+  for(unsigned int i=0; i<c.parameter_size(); ++i)
+  {
+    Parser::Parameter p = c.get_parameter(i);
+    if(p.name() != name) continue;
+
+    switch(p.type())
+    {
+      case Parser::BOOL    :
+      {
+        std::string v = value;
+        std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+        if(v == "true" || v == "on" || v == "yes" || v == "1") p.set_bool(true);
+        else if(v == "false" || v == "off" || v == "no" || v == "0") p.set_bool(false);
+        else return false;
+        break;
+      }
+      case Parser::INTEGER : p.set_int(atoi(value.c_str())); break;
+      case Parser::REAL    : p.set_real(atof(value.c_str())); break;
+      case Parser::STRING  : p.set_string(value); break;
+      case Parser::ENUM    :
+      {
+        std::string v = value;
+        std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+        if(p.set_enum(v)) return false;
+        break;
+      }
+      default: return false;
+    }
 
-    if(c.key() == "REFINE.CONFORM")
-      this->do_refine_conform( c );
+    c.set_parameter(p, i);
+    found = true;
+  }
 
-    if(c.key() == "REFINE.HIERARCHICAL")
-      this->do_refine_hierarchical( c );
+  if(found) c.rebuild_parameter_map();
+  return found;
+}
 
-    if(c.key() == "REFINE.UNIFORM")
-      this->do_refine_uniform( c );
 
-    if(c.key() == "REGIONSET")
-      this->do_region_set( c );
+//------------------------------------------------------------------------------
+int SolverControl::do_batch( const Parser::Card & c, const std::vector<Parser::Card> & cards )
+{
+  std::string table_file = c.get_string("table", "");
 
-    if(c.key() == "BOUNDARYSET")
-      this->do_boundary_set( c );
+  // read the parameter table on processor 0 and broadcast it
+  std::string table;
+  if(Genius::processor_id() == 0)
+  {
+    std::ifstream in(table_file.c_str());
+    if(in.good())
+    {
+      std::stringstream ss;
+      ss << in.rdbuf();
+      table = ss.str();
+    }
+  }
+  Parallel::broadcast(table);
 
-    if(c.key() == "PMI")
-      this->set_physical_model ( c );
+  // the first non-comment line gives columns as KEY:parameter, each following line is a variant
+  std::vector<std::string> column_key;
+  std::vector<std::string> column_parameter;
+  std::vector< std::vector<std::string> > variants;
+  {
+    std::stringstream ss(table);
+    std::string line;
+    while( std::getline(ss, line) )
+    {
+      std::string::size_type comment = line.find('#');
+      if(comment != std::string::npos) line.erase(comment);
 
-    if(c.key() == "TID")
-      this->do_tid ( c );
+      std::stringstream ls(line);
+      std::vector<std::string> tokens;
+      std::string token;
+      while( ls >> token ) tokens.push_back(token);
+      if(tokens.empty()) continue;
 
-    if(c.key() == "SOURCEAPPLY")
-      this->apply_field_source ( c );
+      if(column_key.empty())
+      {
+        for(unsigned int n=0; n<tokens.size(); ++n)
+        {
+          std::string::size_type colon = tokens[n].find(':');
+          if(colon == std::string::npos || colon == 0 || colon+1 == tokens[n].size())
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " BATCH: column " << tokens[n] << " of table " << table_file
+                   << " should be given as KEY:parameter." << std::endl; RECORD();
+            genius_error();
+          }
+          std::string key = tokens[n].substr(0, colon);
+          std::string parameter = tokens[n].substr(colon+1);
+          std::transform(key.begin(), key.end(), key.begin(), ::toupper);
+          std::transform(parameter.begin(), parameter.end(), parameter.begin(), ::tolower);
+          column_key.push_back(key);
+          column_parameter.push_back(parameter);
+        }
+        continue;
+      }
 
-    if(c.key() == "ATTACH")
-      this->set_electrode_source ( c );
+      if(tokens.size() != column_key.size())
+      {
+        MESSAGE<<"ERROR at " <<c.get_fileline()<< " BATCH: row " << variants.size() << " of table " << table_file
+               << " has " << tokens.size() << " values, " << column_key.size() << " expected." << std::endl; RECORD();
+        genius_error();
+      }
+      variants.push_back(tokens);
+    }
+  }
 
-    if(c.key() == "EXTEND")
-      this->extend_to_3d( c );
+  if(variants.empty())
+  {
+    MESSAGE<<"ERROR at " <<c.get_fileline()<< " BATCH: no variant found in table " << table_file << "." << std::endl; RECORD();
+    genius_error();
+  }
 
-    if(c.key() == "ROTATE")
-      this->rotate_to_3d( c );
+  // mesh and device structure are shared by all the variants
+  for(unsigned int i=0; i<cards.size(); ++i)
+  {
+    const std::string & key = cards[i].key();
+    if(key == "IMPORT" || key == "EXTEND" || key == "ROTATE" || key.find("REFINE") == 0)
+    {
+      MESSAGE<<"ERROR at " <<cards[i].get_fileline()<< " BATCH: " << key << " can not be used after BATCH"
+             << " since all the variants share the same mesh." << std::endl; RECORD();
+      genius_error();
+    }
+  }
 
-    if(c.key() == "PLOTMESH")
-      this->plot_mesh( c );
+  // each column should override an existing parameter
+  for(unsigned int n=0; n<column_key.size(); ++n)
+  {
+    bool found = false;
+    for(unsigned int i=0; i<cards.size(); ++i)
+      if(cards[i].key() == column_key[n] && cards[i].is_parameter_exist(column_parameter[n]))
+        found = true;
+    if(!found)
+    {
+      MESSAGE<<"ERROR at " <<c.get_fileline()<< " BATCH: no " << column_key[n] << " card with parameter "
+             << column_parameter[n] << " after BATCH." << std::endl; RECORD();
+      genius_error();
+    }
   }
 
+  MESSAGE<<"Batch run of " << variants.size() << " variants from " << table_file << "\n" << std::endl; RECORD();
+
+  // all the variants start from the same solution
+  system().backup_solution();
+
+  for(unsigned int v=0; v<variants.size(); ++v)
+  {
+    MESSAGE<<"Batch variant " << v << ":";
+    for(unsigned int n=0; n<column_key.size(); ++n)
+      MESSAGE<<" " << column_key[n] << ":" << column_parameter[n] << "=" << variants[v][n];
+    MESSAGE<<"\n" << std::endl; RECORD();
+
+    system().restore_solution();
+
+    std::stringstream tag;
+    tag << ".v" << v;
+    _batch_tag = tag.str();
+
+    for(unsigned int i=0; i<cards.size(); ++i)
+    {
+      Parser::Card card = cards[i];
+      for(unsigned int n=0; n<column_key.size(); ++n)
+      {
+        if(card.key() != column_key[n] || !card.is_parameter_exist(column_parameter[n])) continue;
+        if(!batch_override_parameter(card, column_parameter[n], variants[v][n]))
+        {
+          MESSAGE<<"ERROR at " <<card.get_fileline()<< " BATCH: value " << variants[v][n] << " of variant " << v
+                 << " is not valid for parameter " << column_parameter[n] << "." << std::endl; RECORD();
+          genius_error();
+        }
+      }
+      this->do_card( card );
+    }
+  }
+
+  _batch_tag.clear();
+  system().restore_solution();
+  system().clear_solution_backup();
+
   return 0;
 }
 
 
+//------------------------------------------------------------------------------
+std::string SolverControl::batch_file_name( const std::string & fname ) const
+{
+  if(_batch_tag.empty()) return fname;
+
+  // insert the variant tag before file extension
+  std::string::size_type dot = fname.find_last_of('.');
+  std::string::size_type slash = fname.find_last_of("/\\");
+  if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    return fname + _batch_tag;
+  return fname.substr(0, dot) + _batch_tag + fname.substr(dot);
+}
+
+
 //------------------------------------------------------------------------------
 int  SolverControl::do_mesh()
 {
@@ -681,6 +922,81 @@ int SolverControl::do_hook( const Parser::Card & c )
 }
 
 
+/**
+ * merge IV files written by each ensemble group into one file,
+ * the data blocks are ordered by ensemble branch and separated by two blank lines if required
+ */
+static void merge_ensemble_gnuplot_file(const std::string & prefix, bool append, bool separate)
+{
+#ifdef HAVE_MPI
+  // wait for all the groups to close their files
+  MPI_Barrier(Genius::comm_ensemble());
+
+  int rank;
+  MPI_Comm_rank(Genius::comm_ensemble(), &rank);
+  if( rank == 0 )
+  {
+    std::string head;
+    std::map<int, std::string> blocks;
+    const std::string mark = "# ensemble branch ";
+
+    for(unsigned int g=0; g<Genius::n_ensembles(); ++g)
+    {
+      std::stringstream group_file;
+      group_file << prefix << ".g" << g << ".dat";
+
+      std::ifstream in(group_file.str().c_str());
+      std::string line;
+      int branch = -1;
+      while( std::getline(in, line) )
+      {
+        if( line.empty() ) continue;
+        if( line.compare(0, mark.size(), mark) == 0 )
+        {
+          branch = atoi(line.c_str() + mark.size());
+          blocks[branch] = line + '\n';
+          continue;
+        }
+        if( branch < 0 )
+        {
+          // file head, the same for all the groups
+          if( g == 0 ) head += line + '\n';
+        }
+        else
+          blocks[branch] += line + '\n';
+      }
+      in.close();
+      remove(group_file.str().c_str());
+    }
+
+    std::string gnuplot_file = prefix + ".dat";
+#ifdef WINDOWS
+    bool file_exist = ( _access( (char *) gnuplot_file.c_str(),  04 ) == 0 );
+#else
+    bool file_exist = ( access( gnuplot_file.c_str(),  R_OK ) == 0 );
+#endif
+    std::ofstream out;
+    if(file_exist && append)
+      out.open(gnuplot_file.c_str(), std::ios::app);
+    else
+    {
+      out.open(gnuplot_file.c_str(), std::ios::trunc);
+      out << head;
+    }
+
+    for(std::map<int, std::string>::const_iterator it=blocks.begin(); it!=blocks.end(); ++it)
+    {
+      if( separate && (it != blocks.begin() || (file_exist && append)) ) out << "\n\n";
+      out << it->second;
+    }
+    out.close();
+  }
+
+  MPI_Barrier(Genius::comm_ensemble());
+#endif
+}
+
+
 int SolverControl::do_solve( const Parser::Card & c )
 {
 
@@ -692,6 +1008,9 @@ int SolverControl::do_solve( const Parser::Card & c )
   if(c.is_parameter_exist("label"))
     SolverSpecify::label = c.get_string("label", "");
 
+  SolverSpecify::Ensemble = false;
+  SolverSpecify::Parareal = false;
+
   // set more detailed solution parameters
   switch (SolverSpecify::Type)
   {
@@ -885,6 +1204,47 @@ int SolverControl::do_solve( const Parser::Card & c )
           }
         }
 
+        // a family of dcsweep curves, each branch has a different bias on ensemble.electrode
+        SolverSpecify::Ensemble = c.get_bool("ensemble", false);
+        if(SolverSpecify::Ensemble)
+        {
+          if(system().get_circuit()!=NULL)
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Ensemble DC sweep does not support SPICE circuit." << std::endl; RECORD();
+            genius_error();
+          }
+
+          SolverSpecify::Ensemble_Electrode = c.get_string("ensemble.electrode", "");
+          if( !system().get_bcs()->is_electrode(SolverSpecify::Ensemble_Electrode) )
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Electrode " << SolverSpecify::Ensemble_Electrode << " can't be found in device structure." << std::endl; RECORD();
+            genius_error();
+          }
+
+          if( std::count(SolverSpecify::Electrode_VScan.begin(), SolverSpecify::Electrode_VScan.end(), SolverSpecify::Ensemble_Electrode) ||
+              std::count(SolverSpecify::Electrode_IScan.begin(), SolverSpecify::Electrode_IScan.end(), SolverSpecify::Ensemble_Electrode) )
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Ensemble electrode should not be the DC sweep electrode." << std::endl; RECORD();
+            genius_error();
+          }
+
+          SolverSpecify::Ensemble_Values = c.get_array<double>("ensemble.values");
+          for(unsigned int n=0; n<SolverSpecify::Ensemble_Values.size(); ++n)
+            SolverSpecify::Ensemble_Values[n] *= V;
+          if( SolverSpecify::Ensemble_Values.empty() )
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: You must specify at least one value for ensemble.values." << std::endl; RECORD();
+            genius_error();
+          }
+
+          SolverSpecify::Ensemble_VStep = std::abs(c.get_real("ensemble.vstep", 0.1))*V;
+          if(SolverSpecify::Ensemble_VStep == 0.0)
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: ensemble.vstep shoud not be zero."<<std::endl; RECORD();
+            genius_error();
+          }
+        }
+
         SolverSpecify::Predict       = c.get_bool("predict", true);
 
         SolverSpecify::OptG          = c.get_bool("optical.gen", false);
@@ -1008,21 +1368,47 @@ int SolverControl::do_solve( const Parser::Card & c )
       }
 
       case SolverSpecify::TRANSIENT  :
+      case SolverSpecify::PSS        :
       {
         SolverSpecify::TimeDependent = true;
         SolverSpecify::AutoStep  = c.get_bool("autostep", true);
         SolverSpecify::RejectStep= c.get_bool("rejectstep", true);
         SolverSpecify::Predict   = c.get_bool("predict", true);
         SolverSpecify::UIC       = c.get_bool("uic", false);
-        SolverSpecify::tran_op   = c.get_bool("tran.op", true);
+        // continue from checkpoint, no operating point and start from the saved time by default
+        SolverSpecify::tran_op   = c.get_bool("tran.op", !SolverSpecify::tran_restart);
 
-        SolverSpecify::TStart    = c.get_real("tstart", 0.0)*s;
-        SolverSpecify::TStep     = c.get_real("tstep", 1e-9)*s;
+        SolverSpecify::TStart    = c.get_real("tstart", SolverSpecify::tran_restart ? SolverSpecify::restart_clock/s : 0.0)*s;
+        SolverSpecify::TStep     = c.get_real("tstep", SolverSpecify::tran_restart ? SolverSpecify::restart_dt/s : 1e-9)*s;
         SolverSpecify::TStepMin  = c.get_real("tstepmin", 1e-14)*s;
         SolverSpecify::TStepMax  = c.get_real("tstepmax", 0.0)*s;
         SolverSpecify::dt        = SolverSpecify::TStep;
         SolverSpecify::TStop     = c.get_real("tstop", 1e-6)*s;
 
+        // periodic steady-state integrates one period from tstart
+        if(SolverSpecify::Type == SolverSpecify::PSS)
+        {
+          if(c.get_real("pss.period", 0.0) <= 0.0)
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: pss.period should be positive."<<std::endl; RECORD();
+            genius_error();
+          }
+
+          if( SolverSpecify::Solver != SolverSpecify::DDML1 &&
+              SolverSpecify::Solver != SolverSpecify::DDML2 &&
+              SolverSpecify::Solver != SolverSpecify::EBML3 )
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: PSS is only supported by DDML1, DDML2 and EBML3 solvers."<<std::endl; RECORD();
+            genius_error();
+          }
+
+          SolverSpecify::TStop            = SolverSpecify::TStart + c.get_real("pss.period", 0.0)*s;
+          SolverSpecify::PSS_Cycles       = c.get_int("pss.cycles", 1);
+          SolverSpecify::PSS_MaxIteration = c.get_int("pss.maxit", 10);
+          SolverSpecify::PSS_KSPMaxIteration = c.get_int("pss.gmres.maxit", 20);
+          SolverSpecify::PSS_Tol          = c.get_real("pss.tol", 1e-3);
+        }
+
         SolverSpecify::TS_rtol   = c.get_real("ts.rtol", 1e-3);
         SolverSpecify::TS_atol   = c.get_real("ts.atol", 1e-7);
 
@@ -1088,6 +1474,41 @@ int SolverControl::do_solve( const Parser::Card & c )
         if(c.is_parameter_exist("tran.histroy"))
           SolverSpecify::tran_histroy   = c.get_bool("tran.histroy", false);
 
+        // parareal, each ensemble group integrates one time slice
+        if(SolverSpecify::Type == SolverSpecify::TRANSIENT)
+          SolverSpecify::Parareal = c.get_bool("parareal", false);
+        if(SolverSpecify::Parareal)
+        {
+#ifdef HAVE_MPI
+          int world_size;
+          MPI_Comm_size(Genius::comm_ensemble(), &world_size);
+          if( Genius::n_ensembles() < 2 || world_size != static_cast<int>(Genius::n_ensembles()*Genius::n_processors()) )
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Parareal requires command line option -ensemble n with n>1,"
+                   <<" and the number of processors should be divisible by n." << std::endl; RECORD();
+            genius_error();
+          }
+#endif
+
+          if( SolverSpecify::Solver != SolverSpecify::DDML1 &&
+              SolverSpecify::Solver != SolverSpecify::DDML2 &&
+              SolverSpecify::Solver != SolverSpecify::EBML3 )
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Parareal is only supported by DDML1, DDML2 and EBML3 solvers."<<std::endl; RECORD();
+            genius_error();
+          }
+
+          SolverSpecify::Parareal_CoarseSteps  = c.get_int("parareal.coarse.steps", 4);
+          SolverSpecify::Parareal_MaxIteration = c.get_int("parareal.maxit", Genius::n_ensembles());
+          SolverSpecify::Parareal_Tol          = c.get_real("parareal.tol", 1e-3);
+
+          if( SolverSpecify::Parareal_CoarseSteps < 1 )
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: parareal.coarse.steps should be positive."<<std::endl; RECORD();
+            genius_error();
+          }
+        }
+
         break;
       }
 
@@ -1095,8 +1516,110 @@ int SolverControl::do_solve( const Parser::Card & c )
 
   }
 
-  SolverSpecify::out_prefix = c.get_string("out.prefix", "result");
+  // adjoint sensitivity of electrode current and charge to PMI parameters
+  SolverSpecify::Sensitivity_Electrode.clear();
+  SolverSpecify::Sensitivity_Parameter.clear();
+  if( c.is_parameter_exist("sens.electrode") )
+  {
+    if( SolverSpecify::Solver != SolverSpecify::DDML1 &&
+        SolverSpecify::Solver != SolverSpecify::DDML2 &&
+        SolverSpecify::Solver != SolverSpecify::EBML3 )
+    {
+      MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Sensitivity analysis is only supported by DDML1, DDML2 and EBML3 solvers."<<std::endl; RECORD();
+      genius_error();
+    }
+
+    // the adjoint of a transient step does not see the sensitivity of previous time steps,
+    // only stationary solutions are supported
+    if( SolverSpecify::Type != SolverSpecify::EQUILIBRIUM &&
+        SolverSpecify::Type != SolverSpecify::STEADYSTATE &&
+        SolverSpecify::Type != SolverSpecify::OP          &&
+        SolverSpecify::Type != SolverSpecify::DCSWEEP )
+    {
+      MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Sensitivity analysis is only supported by stationary solution types."<<std::endl; RECORD();
+      genius_error();
+    }
+
+    SolverSpecify::Sensitivity_Electrode = c.get_array<std::string>("sens.electrode");
+    SolverSpecify::Sensitivity_Parameter = c.get_array<std::string>("sens.parameter");
+    if( SolverSpecify::Sensitivity_Parameter.empty() )
+    {
+      MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Sensitivity analysis needs sens.parameter." << std::endl; RECORD();
+      genius_error();
+    }
+
+    // only electrodes with IV trace support give dI/dx
+    for(unsigned int n=0; n<SolverSpecify::Sensitivity_Electrode.size(); ++n)
+    {
+      const std::string & electrode = SolverSpecify::Sensitivity_Electrode[n];
+      std::vector<BoundaryCondition *> bcs = system().get_bcs()->get_bcs_by_electrode_label(electrode);
+      if( bcs.empty() )
+      {
+        MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Electrode " << electrode << " can't be found in device structure." << std::endl; RECORD();
+        genius_error();
+      }
+      for(unsigned int i=0; i<bcs.size(); ++i)
+        if( bcs[i]->bc_type() != OhmicContact && bcs[i]->bc_type() != SchottkyContact && bcs[i]->bc_type() != SolderPad )
+        {
+          MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Sensitivity electrode " << electrode << " should be ohmic, schottky or solder pad contact." << std::endl; RECORD();
+          genius_error();
+        }
+    }
+  }
+
+  // forward tangent of solution to PMI parameters
+  SolverSpecify::Tangent_Parameter.clear();
+  SolverSpecify::Tangent_Delta.clear();
+  if( c.is_parameter_exist("tangent.parameter") )
+  {
+    if( SolverSpecify::Solver != SolverSpecify::DDML1 &&
+        SolverSpecify::Solver != SolverSpecify::DDML2 &&
+        SolverSpecify::Solver != SolverSpecify::EBML3 )
+    {
+      MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Solution tangent is only supported by DDML1, DDML2 and EBML3 solvers."<<std::endl; RECORD();
+      genius_error();
+    }
+
+    // the tangent of transient solution depends on the tangent of previous time steps,
+    // which is not carried, only stationary solutions are supported
+    if( SolverSpecify::Type != SolverSpecify::EQUILIBRIUM &&
+        SolverSpecify::Type != SolverSpecify::STEADYSTATE &&
+        SolverSpecify::Type != SolverSpecify::OP          &&
+        SolverSpecify::Type != SolverSpecify::DCSWEEP )
+    {
+      MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Solution tangent is only supported by stationary solution types."<<std::endl; RECORD();
+      genius_error();
+    }
+
+    SolverSpecify::Tangent_Parameter = c.get_array<std::string>("tangent.parameter");
+    if( c.is_parameter_exist("tangent.delta") )
+    {
+      SolverSpecify::Tangent_Delta = c.get_array<double>("tangent.delta");
+      if( SolverSpecify::Tangent_Delta.size() != SolverSpecify::Tangent_Parameter.size() )
+      {
+        MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: tangent.delta should give one value for each tangent.parameter." << std::endl; RECORD();
+        genius_error();
+      }
+    }
+  }
+
+  SolverSpecify::out_prefix = c.get_string("out.prefix", "result") + _batch_tag;
   SolverSpecify::out_append = c.get_bool("out.append", false);
+  SolverSpecify::out_async  = c.get_bool("out.async", false);
+  SolverSpecify::out_binary = c.get_bool("out.binary", false);
+  SolverSpecify::out_async_buffer = c.get_real("out.async.buffer", 256.0);
+  SolverSpecify::out_async_policy = c.get_string("out.async.policy", "block");
+
+  // each ensemble group writes its own IV file, they are merged after solve
+  const std::string ensemble_prefix = SolverSpecify::out_prefix;
+  const bool        ensemble_append = SolverSpecify::out_append;
+  if( SolverSpecify::Ensemble || SolverSpecify::Parareal )
+  {
+    std::stringstream ss;
+    ss << SolverSpecify::out_prefix << ".g" << Genius::ensemble_id();
+    SolverSpecify::out_prefix = ss.str();
+    SolverSpecify::out_append = false;
+  }
 
   SolverBase * solver = NULL;
 
@@ -1188,6 +1711,13 @@ int SolverControl::do_solve( const Parser::Card & c )
       break;
   }
 
+  // ensemble dcsweep is implemented by DDM solvers
+  if ( solver && SolverSpecify::Ensemble && dynamic_cast<DDMSolverBase *>(solver) == NULL )
+  {
+    MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Ensemble DC sweep is not supported by this solver." << std::endl; RECORD();
+    genius_error();
+  }
+
   if (solver)
   {
     solver->set_label(SolverSpecify::label);
@@ -1205,12 +1735,18 @@ int SolverControl::do_solve( const Parser::Card & c )
 
     // init (user defined) hook functions here
 
-    if( SolverSpecify::Type == SolverSpecify::DCSWEEP     ||
+    // the other ensemble groups repeat the same solve as the first group, no output needed
+    // except for ensemble dcsweep and parareal transient.
+    const bool ensemble_output = SolverSpecify::Ensemble || SolverSpecify::Parareal || Genius::is_ensemble_master();
+
+    if( ensemble_output && (
+        SolverSpecify::Type == SolverSpecify::DCSWEEP     ||
         SolverSpecify::Type == SolverSpecify::STEADYSTATE ||
         SolverSpecify::Type == SolverSpecify::OP          ||
         SolverSpecify::Type == SolverSpecify::TRANSIENT   ||
+        SolverSpecify::Type == SolverSpecify::PSS         ||
         SolverSpecify::Type == SolverSpecify::TRACE       ||
-        SolverSpecify::Solver == SolverSpecify::DDMAC
+        SolverSpecify::Solver == SolverSpecify::DDMAC )
       )
     {
       // gnuplot hook, write electrode IV in gnuplot file format, as default hook
@@ -1226,41 +1762,56 @@ int SolverControl::do_solve( const Parser::Card & c )
 
     }
 
-#ifdef DLLHOOK
-    // dynamic load user defined hooks, stupid win32 platform does not support this function.
-    for (std::map<std::string, std::pair<std::string, std::vector<Parser::Parameter> > >::iterator it=SolverSpecify::Hooks.begin();
-         it!=SolverSpecify::Hooks.end(); it++)
+    // user defined hooks are not supported by ensemble dcsweep and parareal transient,
+    // and only the first ensemble group loads them
+    if( (SolverSpecify::Ensemble || SolverSpecify::Parareal) && !SolverSpecify::Hooks.empty() )
     {
-      const std::vector<Parser::Parameter> & parm_list = it->second.second;
-      solver->add_hook( new DllHook(*solver, (it->second.first)+"_hook", (void *)&parm_list) );
+      MESSAGE<<"Warning at " <<c.get_fileline()<< " SOLVE: User defined hooks are ignored by ensemble DC sweep and parareal transient." << std::endl; RECORD();
     }
+    if( !SolverSpecify::Ensemble && !SolverSpecify::Parareal && Genius::is_ensemble_master() )
+    {
+#ifdef DLLHOOK
+      // dynamic load user defined hooks, stupid win32 platform does not support this function.
+      for (std::map<std::string, std::pair<std::string, std::vector<Parser::Parameter> > >::iterator it=SolverSpecify::Hooks.begin();
+           it!=SolverSpecify::Hooks.end(); it++)
+      {
+        const std::vector<Parser::Parameter> & parm_list = it->second.second;
+        solver->add_hook( new DllHook(*solver, (it->second.first)+"_hook", (void *)&parm_list) );
+      }
 
 #else
-    // load static user defined hooks, only support predefined hooks, sigh
-    for (std::map<std::string, std::pair<std::string, std::vector<Parser::Parameter> > >::iterator it=SolverSpecify::Hooks.begin();
-         it!=SolverSpecify::Hooks.end(); it++)
-    {
-      Hook * hook=NULL;
-
-      if((*it).second.first=="cgns")
-        hook = new CGNSHook(*solver, "cgns_hook", (void *)(&(it->second.second)));
-      if((*it).second.first=="vtk")
-        hook = new VTKHook(*solver, "vtk_hook", (void *)(&(it->second.second)));
-      if((*it).second.first=="cv")
-        hook = new CVHook (*solver, "cv_hook",  (void *)(&(it->second.second)));
-      if((*it).second.first=="probe")
-        hook = new ProbeHook (*solver, "probe_hook",  (void *)(&(it->second.second)));
-      if((*it).second.first=="threshold")
-        hook = new ThresholdHook (*solver, "threshold_hook",  (void *)(&(it->second.second)));
-      if((*it).second.first=="data")
-        hook = new DataHook (*solver, "data_hook",  (void *)(&(it->second.second)));
-      if((*it).second.first=="tunneling")
-        hook = new TunnelingHook (*solver, "tunneling_hook",  (void *)(&(it->second.second)));
-
-      if(hook) solver->add_hook(hook);
-    }
+      // load static user defined hooks, only support predefined hooks, sigh
+      for (std::map<std::string, std::pair<std::string, std::vector<Parser::Parameter> > >::iterator it=SolverSpecify::Hooks.begin();
+           it!=SolverSpecify::Hooks.end(); it++)
+      {
+        Hook * hook=NULL;
+
+        if((*it).second.first=="cgns")
+          hook = new CGNSHook(*solver, "cgns_hook", (void *)(&(it->second.second)));
+        if((*it).second.first=="vtk")
+          hook = new VTKHook(*solver, "vtk_hook", (void *)(&(it->second.second)));
+        if((*it).second.first=="cv")
+          hook = new CVHook (*solver, "cv_hook",  (void *)(&(it->second.second)));
+        if((*it).second.first=="probe")
+          hook = new ProbeHook (*solver, "probe_hook",  (void *)(&(it->second.second)));
+        if((*it).second.first=="probeset")
+          hook = new ProbeSetHook (*solver, "probeset_hook",  (void *)(&(it->second.second)));
+        if((*it).second.first=="threshold")
+          hook = new ThresholdHook (*solver, "threshold_hook",  (void *)(&(it->second.second)));
+        if((*it).second.first=="data")
+          hook = new DataHook (*solver, "data_hook",  (void *)(&(it->second.second)));
+        if((*it).second.first=="tunneling")
+          hook = new TunnelingHook (*solver, "tunneling_hook",  (void *)(&(it->second.second)));
+        if((*it).second.first=="hdf5")
+          hook = new HDF5Hook (*solver, "hdf5_hook",  (void *)(&(it->second.second)));
+        if((*it).second.first=="checkpoint")
+          hook = new CheckpointHook (*solver, "checkpoint_hook",  (void *)(&(it->second.second)));
+
+        if(hook) solver->add_hook(hook);
+      }
 
 #endif
+    }
 
     {
       // always load the control hook. We load it last, such that it is called last
@@ -1272,6 +1823,10 @@ int SolverControl::do_solve( const Parser::Card & c )
     solver->solve();
     solver->destroy_solver(); // hooks are deleted here
 
+    // ensemble branches are separated data blocks, while parareal slices make one continuous waveform
+    if( SolverSpecify::Ensemble || SolverSpecify::Parareal )
+      merge_ensemble_gnuplot_file(ensemble_prefix, ensemble_append, SolverSpecify::Ensemble);
+
     {
       // if there is a solution in the group, add it to the solution document
       if (mxmlFindElement(eGroup, eGroup, "solution", NULL, NULL, MXML_DESCEND_FIRST)==NULL)
@@ -1476,7 +2031,7 @@ int  SolverControl::do_tid ( const Parser::Card & c )
   SolverSpecify::TID_OPStep     = c.get_real("opstep", 3e3)*rad;
   SolverSpecify::TID_FixedCharge= c.get_bool("fixedcharge", true);
 
-  SolverSpecify::out_prefix = c.get_string("out.prefix", "result");
+  SolverSpecify::out_prefix = c.get_string("out.prefix", "result") + _batch_tag;
 
   if( SolverSpecify::TID_TotalDose <= 0.0 )
   {
@@ -1542,7 +2097,7 @@ int SolverControl::do_export( const Parser::Card & c )
   // if export to VTK format is required
   if(c.is_parameter_exist("vtkfile"))
   {
-    std::string vtk_filename = c.get_string("vtkfile", "");
+    std::string vtk_filename = batch_file_name(c.get_string("vtkfile", ""));
     bool ascii = c.get_bool("ascii", false);
     system().export_vtk(vtk_filename, ascii);
   }
@@ -1550,7 +2105,7 @@ int SolverControl::do_export( const Parser::Card & c )
   // if export to VTK format is required
   if(c.is_parameter_exist("vtufile"))
   {
-    std::string vtu_filename = c.get_string("vtufile", "");
+    std::string vtu_filename = batch_file_name(c.get_string("vtufile", ""));
     std::vector<std::string> variables = c.get_array<std::string>("vtu.variables");
     system().export_vtk2(vtu_filename, variables);
   }
@@ -1558,14 +2113,14 @@ int SolverControl::do_export( const Parser::Card & c )
   // if export to CGNS format is required
   if(c.is_parameter_exist("cgnsfile"))
   {
-    std::string cgns_filename = c.get_string("cgnsfile", "");
+    std::string cgns_filename = batch_file_name(c.get_string("cgnsfile", ""));
     system().export_cgns(cgns_filename);
   }
 
   // if export to DF-ISE format is required
   if(c.is_parameter_exist("isefile"))
   {
-    std::string ise_filename = c.get_string("isefile", "");
+    std::string ise_filename = batch_file_name(c.get_string("isefile", ""));
     system().export_ise(ise_filename);
   }
 
@@ -1573,7 +2128,7 @@ int SolverControl::do_export( const Parser::Card & c )
   // if export to tif format is required
   if(c.is_parameter_exist("tiffile"))
   {
-    std::string tif_filename = c.get_string("tiffile", "");
+    std::string tif_filename = batch_file_name(c.get_string("tiffile", ""));
     system().export_tif(tif_filename);
   }
 
@@ -1624,6 +2179,13 @@ int SolverControl::do_export( const Parser::Card & c )
     system().get_circuit()->export_solution(spice_filename);
   }
 
+  // if export solver state to checkpoint is required
+  if(c.is_parameter_exist("checkpoint"))
+  {
+    std::string checkpoint_filename = batch_file_name(c.get_string("checkpoint", ""));
+    system().export_checkpoint(checkpoint_filename);
+  }
+
 
   return 0;
 }
@@ -1662,6 +2224,13 @@ int SolverControl::do_import( const Parser::Card & c )
     system().import_vtk(vtk_filename);
   }
 
+  // load solver state, the device structure should be loaded already
+  if(c.is_parameter_exist("checkpoint"))
+  {
+    std::string checkpoint_filename = c.get_string("checkpoint", "");
+    system().import_checkpoint(checkpoint_filename);
+  }
+
   if(c.is_parameter_exist("silvacofile") || c.is_parameter_exist("strfile"))
   {
     std::string silvaco_filename = c.get_string("silvacofile", "", "strfile");
@@ -1917,27 +2486,9 @@ int SolverControl::do_refine_hierarchical(const Parser::Card & c)
 
   MESSAGE<<"Hierarchical mesh refinement...\n"<<std::endl; RECORD();
 
-  // save previous solution
-  AutoPtr<InterpolationBase> interpolator;
-  if( mesh().mesh_dimension() == 2 )
-    interpolator = AutoPtr<InterpolationBase>(new Interpolation2D_CSA);
-  else
-    interpolator = AutoPtr<InterpolationBase>(new Interpolation3D_nbtet);
-
-  if( DopingSolver.get() == NULL )
-  {
-    system().fill_interpolator(interpolator.get(), "doping.na", InterpolationBase::Asinh);
-    system().fill_interpolator(interpolator.get(), "doping.nd", InterpolationBase::Asinh);
-  }
-
-  if(system().has_single_compound_semiconductor_region()  && MoleSolver.get() == NULL )
-  {
-    system().fill_interpolator(interpolator.get(), "mole.x", InterpolationBase::Linear);
-  }
-  if(system().has_complex_compound_semiconductor_region()  && MoleSolver.get() == NULL )
-  {
-    system().fill_interpolator(interpolator.get(), "mole.y", InterpolationBase::Linear);
-  }
+  // save previous solution, new nodes get their value from parent element
+  HierarchyTransfer transfer(mesh());
+  this->save_hierarchy_transfer(transfer);
 
   // fill error vector from system level
   ErrorVector error_per_cell;
@@ -1962,6 +2513,8 @@ int SolverControl::do_refine_hierarchical(const Parser::Card & c)
 
     // call MeshRefinement class to do FEM refine
     mesh_refinement.refine_and_coarsen_elements ();
+
+    transfer.prolong();
   }
 
   // clear the system(). however we should reserve mesh information
@@ -1980,26 +2533,7 @@ int SolverControl::do_refine_hierarchical(const Parser::Card & c)
   system().build_simulation_system();
   system().sync_print_info();
 
-  // set doping profile to semiconductor region
-  if( DopingSolver.get() != NULL )
-    DopingSolver->solve();
-  else
-  {
-    // no doping information?
-    system().do_interpolation(interpolator.get(), "doping.na");
-    system().do_interpolation(interpolator.get(), "doping.nd");
-  }
-
-  // set mole fraction to semiconductor region
-  if( MoleSolver.get() != NULL )
-    MoleSolver->solve();
-  else
-  {
-    if(system().has_single_compound_semiconductor_region())
-      system().do_interpolation(interpolator.get(), "mole.x");
-    if(system().has_complex_compound_semiconductor_region())
-      system().do_interpolation(interpolator.get(), "mole.y");
-  }
+  this->apply_hierarchy_transfer(transfer);
 
   // after doping profile is set, we can init system data.
   system().init_region();
@@ -2015,11 +2549,17 @@ int SolverControl::do_refine_hierarchical(const Parser::Card & c)
 int SolverControl::do_refine_uniform(const Parser::Card & c)
 {
 
+  // save previous solution, new nodes get their value from parent element
+  HierarchyTransfer transfer(mesh());
+  this->save_hierarchy_transfer(transfer);
+
   if (Genius::processor_id() == 0)
   {
     int step =  c.get_int("step", 1);
     MeshRefinement mesh_refinement(mesh());
     mesh_refinement.uniformly_refine(step);
+    // parent must be visited before flatten
+    transfer.prolong();
     MeshTools::Modification::flatten(mesh());
   }
 
@@ -2036,18 +2576,63 @@ int SolverControl::do_refine_uniform(const Parser::Card & c)
   system().build_simulation_system();
   system().sync_print_info();
 
+  this->apply_hierarchy_transfer(transfer);
+
+  // after doping profile is set, we can init system data.
+  system().init_region();
+  system().init_region_post_process();
+  return 0;
+}
+
+
+
+/*--------------------------------------------------------------------
+ * save doping and mole fraction which can not be recomputed
+ * by DopingSolver/MoleSolver before hierarchical refinement
+ */
+void SolverControl::save_hierarchy_transfer(HierarchyTransfer & transfer)
+{
+  if( DopingSolver.get() == NULL )
+  {
+    transfer.add_variable(system(), "doping.na", InterpolationBase::Asinh);
+    transfer.add_variable(system(), "doping.nd", InterpolationBase::Asinh);
+  }
+
+  if(system().has_single_compound_semiconductor_region()  && MoleSolver.get() == NULL )
+    transfer.add_variable(system(), "mole.x", InterpolationBase::Linear);
+
+  if(system().has_complex_compound_semiconductor_region()  && MoleSolver.get() == NULL )
+    transfer.add_variable(system(), "mole.y", InterpolationBase::Linear);
+}
+
+
+/*--------------------------------------------------------------------
+ * set doping and mole fraction to the refined system
+ */
+void SolverControl::apply_hierarchy_transfer(HierarchyTransfer & transfer)
+{
+  transfer.sync();
+
   // set doping profile to semiconductor region
   if( DopingSolver.get() != NULL )
     DopingSolver->solve();
+  else
+  {
+    // no doping information?
+    transfer.apply(system(), "doping.na");
+    transfer.apply(system(), "doping.nd");
+  }
 
   // set mole fraction to semiconductor region
   if( MoleSolver.get() != NULL )
     MoleSolver->solve();
-
-  // after doping profile is set, we can init system data.
-  system().init_region();
-  system().init_region_post_process();
-  return 0;
+  else
+  {
+    if(system().has_single_compound_semiconductor_region())
+      transfer.apply(system(), "mole.x");
+    if(system().has_complex_compound_semiconductor_region())
+      transfer.apply(system(), "mole.y");
+  }
 }
 
 
@@ -65,10 +65,11 @@ void DFISEIO::read (const std::string& filename)
 
   if( Genius::processor_id() == 0)
   {
-    ise_reader->parse_dfise(filename);
+    // we never write the grid back, edges and faces can be freed during parse
+    ise_reader->parse_dfise(filename, false);
 
     const DFISE::INFO & grid_info = ise_reader->get_grid_info();
-    const DFISE::GRID & grid      = ise_reader->get_grid();
+    DFISE::GRID & grid            = ise_reader->get_grid();
 
     // fill node location
     VectorValue<double> translate(grid.translate);
@@ -88,6 +89,9 @@ void DFISEIO::read (const std::string& filename)
       _set_mesh_element(grid_info, grid.Elements[n]);
     }
 
+    // datasets are already mapped to dfise nodes, the grid is no longer needed
+    grid.clear();
+
     // fill region label and region material
     mesh.set_n_subdomains() = grid_info.n_field_regions();
     for(unsigned int r=0; r<grid_info.nb_regions; ++r)
@@ -320,7 +324,7 @@ void DFISEIO::_set_boundary(const DFISE::INFO & grid_info)
   //process boundary elems
 
   typedef unsigned int                    key_type;
-  typedef std::pair<Elem*, unsigned char> val_type;
+  typedef std::pair<Elem*, unsigned int>  val_type;
   typedef std::pair<key_type, val_type>   key_val_pair;
 
 #if defined(HAVE_UNORDERED_MAP)
@@ -331,58 +335,45 @@ void DFISEIO::_set_boundary(const DFISE::INFO & grid_info)
   typedef std::multimap<key_type, val_type>  map_type;
 #endif
 
-  // A map from side keys to corresponding elements & side numbers
-  map_type side_to_elem_map;
+  // A map from side keys to the boundary elems. only boundary elems are hashed,
+  // the volume elements are visited once, this keeps the map small for large mesh
+  map_type key_to_boundary_elem_map;
+  for(unsigned int n=0; n<_boundary_elem_regions.size(); ++n)
+  {
+    key_val_pair kvp;
+    kvp.first         = _boundary_elem_regions[n].first->key();
+    kvp.second.first  = _boundary_elem_regions[n].first;
+    kvp.second.second = n;
+    key_to_boundary_elem_map.insert (kvp);
+  }
 
+  // find the elem/side pair each boundary_elem belongs to
   const MeshBase::element_iterator el_end = mesh.elements_end();
   for (MeshBase::element_iterator el = mesh.elements_begin(); el != el_end; ++el)
   {
     Elem* elem = *el;
     for (unsigned int ms=0; ms<elem->n_neighbors(); ms++)
     {
-      // Get the key for the side of this element
-      const unsigned int key = elem->key(ms);
-
-      key_val_pair kvp;
-      kvp.first         = key;
-      kvp.second.first  = elem;
-      kvp.second.second = ms;
-
-      side_to_elem_map.insert (kvp);
-    }
-  }
-
-  // find the boundary_elems belongs to which elem/side pair
-  for(unsigned int n=0; n<_boundary_elem_regions.size(); ++n)
-  {
-    Elem *boundary_elem   = _boundary_elem_regions[n].first;
-    int   boundary_region = _boundary_elem_regions[n].second; //which dfise region this boundary_elem belongs to
+      // Look for boundary elems that have an identical side key
+      std::pair<map_type::iterator, map_type::iterator>  bounds = key_to_boundary_elem_map.equal_range(elem->key(ms));
+      if(bounds.first == bounds.second) continue;
 
-    const unsigned int key = boundary_elem->key();
-
-    // Look for elements that have an identical side key
-    std::pair<map_type::iterator, map_type::iterator>  bounds = side_to_elem_map.equal_range(key);
-    assert (bounds.first != bounds.second);
-
-    // May be multiple keys, check all the possible elements which _might_ be neighbors.
-    while (bounds.first != bounds.second)
-    {
-      // Get the potential element
-      Elem* elem = bounds.first->second.first;
-      // Get the side for the neighboring element
-      const unsigned int ns = bounds.first->second.second;
-      const AutoPtr<DofObject> elem_side(elem->side(ns));
+      const AutoPtr<DofObject> elem_side(elem->side(ms));
       assert (elem_side.get() != NULL);
 
-      if(*elem_side == *boundary_elem)
+      // May be multiple keys, check all the possible boundary elems
+      for( ; bounds.first != bounds.second; ++bounds.first)
       {
-        //genius_assert(elem->on_boundary(ns) || elem->on_interface() );
-        //skip interface elem, which will be processed later
-        if(grid_info.region_to_boundaryregion(boundary_region)>=0)
-          mesh.boundary_info->add_side(elem, ns, grid_info.region_to_boundaryregion(boundary_region));
-      }
+        Elem *boundary_elem   = bounds.first->second.first;
+        int   boundary_region = _boundary_elem_regions[bounds.first->second.second].second; //which dfise region this boundary_elem belongs to
 
-      ++bounds.first;
+        if(*elem_side == *boundary_elem)
+        {
+          //skip interface elem, which will be processed later
+          if(grid_info.region_to_boundaryregion(boundary_region)>=0)
+            mesh.boundary_info->add_side(elem, ms, grid_info.region_to_boundaryregion(boundary_region));
+        }
+      }
     }
   }
 
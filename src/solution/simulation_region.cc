@@ -170,6 +170,7 @@ void SimulationRegion::clear()
 
   _cell_data_storage.clear();
   _node_data_storage.clear();
+  clear_data_block_backup();
 
   _region_edges.clear();
   _region_elem_edge_in_edges_index.clear();
@@ -189,6 +190,55 @@ void SimulationRegion::reserve_data_block(unsigned int n_cell_data, unsigned int
 }
 
 
+void SimulationRegion::backup_data_block()
+{
+  _cell_data_storage_backup = _cell_data_storage;
+  _node_data_storage_backup = _node_data_storage;
+}
+
+
+bool SimulationRegion::restore_data_block()
+{
+  // node/cell data refer to data block by offset, we can not restore
+  // if the size or variable number changed
+  if( _cell_data_storage_backup.size() != _cell_data_storage.size() ||
+      _cell_data_storage_backup.n_scalar() != _cell_data_storage.n_scalar() ||
+      _cell_data_storage_backup.n_vector() != _cell_data_storage.n_vector() )
+    return false;
+
+  if( _node_data_storage_backup.size() != _node_data_storage.size() ||
+      _node_data_storage_backup.n_scalar() != _node_data_storage.n_scalar() ||
+      _node_data_storage_backup.n_vector() != _node_data_storage.n_vector() )
+    return false;
+
+  _cell_data_storage = _cell_data_storage_backup;
+  _node_data_storage = _node_data_storage_backup;
+  return true;
+}
+
+
+void SimulationRegion::clear_data_block_backup()
+{
+  _cell_data_storage_backup = DataStorage();
+  _node_data_storage_backup = DataStorage();
+}
+
+
+void SimulationRegion::write_data_block(CheckpointWriter &out) const
+{
+  out.write(_region_name);
+  _cell_data_storage.write(out);
+  _node_data_storage.write(out);
+}
+
+
+bool SimulationRegion::read_data_block(CheckpointReader &in)
+{
+  if( in.read_string() != _region_name ) return false;
+  return _cell_data_storage.read(in) && _node_data_storage.read(in);
+}
+
+
 void SimulationRegion::rebuild_region_fvm_node_list()
 {
   _region_local_node.clear();
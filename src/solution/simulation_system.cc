@@ -60,6 +60,7 @@
 
 #include "perf_log.h"
 #include "sync_file.h"
+#include "checkpoint_file.h"
 
 
 #if defined(HAVE_TR1_UNORDERED_MAP)
@@ -236,6 +237,7 @@ SimulationSystem::~SimulationSystem()
   for (unsigned int r=0; r<n_regions(); r++)
     delete _simulation_regions[r];
   _simulation_regions.clear();
+  Material::MaterialBase::release_preloaded_materials();
 
   delete _bcs;
   delete _electrical_source;
@@ -567,6 +569,15 @@ void SimulationSystem::build_region_fvm_mesh()
   std::map<unsigned int,  SimulationRegion *> subdomain_id_to_region_map;
 
   unsigned int dim = _mesh.mesh_dimension();
+
+  // open each material library once, regions of the same material share it
+  {
+    std::vector<std::string> materials;
+    for(unsigned int r=0; r<_mesh.n_subdomains(); r++)
+      materials.push_back(_mesh.subdomain_material(r));
+    Material::MaterialBase::preload_materials(materials);
+  }
+
   // create simulation region from subdomain information
   for(unsigned int r=0; r<_mesh.n_subdomains(); r++)
   {
@@ -1349,6 +1360,187 @@ void SimulationSystem::do_interpolation(const InterpolationBase * interpolator ,
 
 
 
+void SimulationSystem::backup_solution()
+{
+  for(unsigned int n=0; n<n_regions(); n++)
+    this->region(n)->backup_data_block();
+
+  for(unsigned int n=0; n<_bcs->n_bcs(); n++)
+  {
+    BoundaryCondition * bc = _bcs->get_bc(n);
+    if( bc->is_electrode() )
+      bc->ext_circuit()->backup();
+  }
+}
+
+
+void SimulationSystem::restore_solution()
+{
+  for(unsigned int n=0; n<n_regions(); n++)
+  {
+    bool restored = this->region(n)->restore_data_block();
+    genius_assert(restored);
+  }
+
+  for(unsigned int n=0; n<_bcs->n_bcs(); n++)
+  {
+    BoundaryCondition * bc = _bcs->get_bc(n);
+    if( bc->is_electrode() )
+      bc->ext_circuit()->restore();
+  }
+}
+
+
+void SimulationSystem::clear_solution_backup()
+{
+  for(unsigned int n=0; n<n_regions(); n++)
+    this->region(n)->clear_data_block_backup();
+}
+
+
+
+static std::string checkpoint_file_name(const std::string& filename)
+{
+  std::stringstream ss;
+  ss << filename << '.' << Genius::processor_id();
+  return ss.str();
+}
+
+
+void SimulationSystem::export_checkpoint(const std::string& filename) const
+{
+  MESSAGE<<"Write checkpoint "<< filename << "...\n" << std::endl; RECORD();
+
+  CheckpointWriter out(checkpoint_file_name(filename));
+
+  // partition
+  out.write<unsigned int>(Genius::n_processors());
+  out.write<unsigned int>(Genius::processor_id());
+
+  // time integration history. it is taken between two time steps, where
+  // clock and dt are already advanced to the next step
+  out.write<unsigned char>(SolverSpecify::TimeDependent);
+  out.write<double>(SolverSpecify::clock);
+  out.write<double>(SolverSpecify::dt);
+  out.write<double>(SolverSpecify::dt_last);
+  out.write<double>(SolverSpecify::dt_last_last);
+  out.write<unsigned char>(SolverSpecify::BDF2_LowerOrder);
+
+  // solution data, including the values of previous steps
+  out.write<unsigned int>(n_regions());
+  for(unsigned int n=0; n<n_regions(); n++)
+    this->region(n)->write_data_block(out);
+
+  // external circuit of electrodes
+  std::vector<unsigned int> electrodes;
+  for(unsigned int n=0; n<_bcs->n_bcs(); n++)
+    if( _bcs->get_bc(n)->is_electrode() )
+      electrodes.push_back(n);
+
+  out.write<unsigned int>(electrodes.size());
+  for(unsigned int n=0; n<electrodes.size(); n++)
+  {
+    const BoundaryCondition * bc = _bcs->get_bc(electrodes[n]);
+    std::vector<Real> state;
+    bc->ext_circuit()->pack_state(state);
+    out.write(bc->label());
+    out.write_array(state);
+  }
+
+  // spice circuit, only the last processor holds it
+  bool has_circuit = _spice_ckt && Genius::is_last_processor();
+  out.write<unsigned char>(has_circuit);
+  if( has_circuit )
+  {
+    std::vector<double> rhs_old(_spice_ckt->n_ckt_nodes());
+    for(unsigned int n=0; n<rhs_old.size(); n++)
+      rhs_old[n] = _spice_ckt->rhs_old(n);
+    out.write_array(rhs_old);
+
+    for(int i=0; i<3; i++)
+    {
+      std::vector<double> state;
+      _spice_ckt->get_state_vector(i, state);
+      out.write_array(state);
+    }
+  }
+
+  bool ok = out.close();
+  Parallel::min(ok);
+  if( !ok )
+  {
+    MESSAGE<<"ERROR: Write checkpoint " << filename << " failed." << std::endl; RECORD();
+    genius_error();
+  }
+}
+
+
+void SimulationSystem::import_checkpoint(const std::string& filename)
+{
+  MESSAGE<<"Load checkpoint "<< filename << "...\n" << std::endl; RECORD();
+
+  CheckpointReader in(checkpoint_file_name(filename));
+
+  bool ok = in.good();
+  ok = ok && in.read<unsigned int>() == Genius::n_processors();
+  ok = ok && in.read<unsigned int>() == Genius::processor_id();
+
+  bool transient       = in.read<unsigned char>() != 0;
+  double clock         = in.read<double>();
+  double dt            = in.read<double>();
+  double dt_last       = in.read<double>();
+  double dt_last_last  = in.read<double>();
+  bool BDF2_LowerOrder = in.read<unsigned char>() != 0;
+
+  ok = ok && in.read<unsigned int>() == n_regions();
+  for(unsigned int n=0; ok && n<n_regions(); n++)
+    ok = this->region(n)->read_data_block(in);
+
+  unsigned int n_electrodes = ok ? in.read<unsigned int>() : 0;
+  for(unsigned int n=0; ok && n<n_electrodes; n++)
+  {
+    BoundaryCondition * bc = _bcs->get_bc(in.read_string());
+    std::vector<Real> state;
+    ok = in.read_array(state) && bc && bc->is_electrode() && bc->ext_circuit()->unpack_state(state);
+  }
+
+  bool has_circuit = ok && in.read<unsigned char>() != 0;
+  if( has_circuit )
+  {
+    std::vector<double> rhs_old;
+    ok = _spice_ckt && Genius::is_last_processor() && in.read_array(rhs_old) && rhs_old.size() == _spice_ckt->n_ckt_nodes();
+    if( ok )
+      _spice_ckt->update_rhs_old(rhs_old);
+
+    for(int i=0; ok && i<3; i++)
+    {
+      std::vector<double> state;
+      ok = in.read_array(state) && state.size() == _spice_ckt->n_state();
+      if( ok )
+        _spice_ckt->set_state_vector(i, state);
+    }
+  }
+
+  ok = ok && in.good();
+  Parallel::min(ok);
+  if( !ok )
+  {
+    MESSAGE<<"ERROR: Checkpoint " << filename << " can't be loaded, or it was written by a different mesh, partition or solver." << std::endl; RECORD();
+    genius_error();
+  }
+
+  // next transient continues from the checkpoint
+  SolverSpecify::tran_histroy            = transient;
+  SolverSpecify::tran_restart            = transient;
+  SolverSpecify::restart_clock           = clock - dt;
+  SolverSpecify::restart_dt              = dt;
+  SolverSpecify::restart_BDF2_LowerOrder = BDF2_LowerOrder;
+  SolverSpecify::dt_last                 = dt_last;
+  SolverSpecify::dt_last_last            = dt_last_last;
+}
+
+
+
 std::vector< std::vector<unsigned int > > SimulationSystem::build_subdomain_cluster()
 {
   std::vector<std::vector<unsigned int> > subdomain_adjncy;
@@ -1506,14 +1698,14 @@ size_t SimulationSystem::memory_size() const
 
 
 
-void SimulationSystem::export_vtk(const std::string& filename, bool ascii) const
+void SimulationSystem::export_vtk(const std::string& filename, bool ascii, AsyncWriter * writer) const
 {
   if(!ascii)
   {
 #ifdef HAVE_VTK
     std::string file_name = filename;
-    // preprocess vtk file extension to make sure it has a ".vtu" format
-    if (file_name.rfind(".vtu") > file_name.size())
+    // preprocess vtk file extension to make sure it has a ".vtu" format, ".pvtu" for parallel pieces
+    if (file_name.rfind(".vtu") > file_name.size() && file_name.rfind(".pvtu") > file_name.size())
     {
       // file name has a vtk extension, change it to vtu
       if (file_name.rfind(".vtk") < file_name.size())
@@ -1531,7 +1723,9 @@ void SimulationSystem::export_vtk(const std::string& filename, bool ascii) const
     }
 
     MESSAGE<<"Write System to XML VTK file "<< file_name << "...\n" << std::endl; RECORD();
-    VTKIO(*this).write (file_name);
+    VTKIO vtk_io(*this);
+    vtk_io.set_async_writer(writer);
+    vtk_io.write (file_name);
 #else
     MESSAGE<<"Genius is not compiled with XML VTK support, skip VTK export... "<< std::endl; RECORD();
 #endif
@@ -79,6 +79,8 @@ void TIF3DIO::read (const std::string& filename)
       Node * node = mesh.add_point( Point(tif_node_it->x*um, tif_node_it->y*um, tif_node_it->z*um) );
       node_to_tif_index_map[node] = i;
     }
+    // node location is in mesh now
+    std::vector<TIF3D::Node_t>().swap(tif3d_reader.tif_nodes());
 
     // fill region label and region material
     // at the same time. set all the remaining boundary edges as "region_neumann"
@@ -104,6 +106,7 @@ void TIF3DIO::read (const std::string& filename)
       {
         face_table.insert( std::make_pair(*tif_face_it, tif_face_it->bc_index) );
       }
+      std::vector<TIF3D::Face_t>().swap(tif3d_reader.tif_faces());
     }
 
 
@@ -138,6 +141,9 @@ void TIF3DIO::read (const std::string& filename)
         }
       }
     }
+    // tets and faces are in mesh now, free them before neighbor search
+    face_table.clear();
+    std::vector<TIF3D::Tet_t>().swap(tif3d_reader.tif_tets());
 
     // map bc_index to bc label
     std::map<std::string, std::pair<short int, bool> > bd_map;
@@ -40,6 +40,7 @@
 #include "spice_ckt.h"
 #include "material.h"
 #include "solver_specify.h"
+#include "async_writer.h"
 
 #ifdef HAVE_VTK
 
@@ -51,6 +52,7 @@
 #include "vtkConfigure.h"
 #include "vtkIntArray.h"
 #include "vtkFloatArray.h"
+#include "vtkDataArray.h"
 #include "vtkPointData.h"
 
 #endif //HAVE_VTK
@@ -93,6 +95,42 @@ public:
 private:
   std::string _header;
 };
+
+
+/**
+ * snapshot of vtk grid, written by background I/O thread
+ */
+class VTKIO::WriteJob : public AsyncWriter::Job
+{
+public:
+  WriteJob(vtkUnstructuredGrid* grid, const std::string &name, const std::string &header)
+    : _grid(grid), _name(name), _header(header)
+  {}
+
+  virtual ~WriteJob()
+  { _grid->Delete(); }
+
+  virtual void write()
+  {
+    XMLUnstructuredGridWriter* writer = XMLUnstructuredGridWriter::New();
+    writer->SetInput(_grid);
+    writer->setExtraHeader(_header);
+    writer->SetFileName(_name.c_str());
+    writer->Write();
+    writer->Delete();
+  }
+
+  virtual size_t bytes() const
+  { return static_cast<size_t>(_grid->GetActualMemorySize())*1024; }
+
+  virtual std::string name() const
+  { return _name; }
+
+private:
+  vtkUnstructuredGrid* _grid;
+  std::string _name;
+  std::string _header;
+};
 #endif
 
 // private functions
@@ -184,6 +222,32 @@ void VTKIO::nodes_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
   unsigned int region_n_nodes = 0;
   _region_node_id_map.clear();
 
+  // partition piece only holds local nodes (on processor and ghost) of each region
+  if(_partition)
+  {
+    vtkPoints* points = vtkPoints::New();
+    for( unsigned int r=0; r<system.n_regions(); r++)
+    {
+      const SimulationRegion * region = system.region(r);
+      SimulationRegion::const_local_node_iterator it = region->on_local_nodes_begin();
+      SimulationRegion::const_local_node_iterator it_end = region->on_local_nodes_end();
+      for(; it!=it_end; ++it)
+      {
+        const Node * node = (*it)->root_node();
+        _region_node_id_map.insert( std::make_pair(std::make_pair(r,node->id()), region_n_nodes) );
+
+        float tuple[3];
+        tuple[0] =  (*node)[0]/um; //scale to um
+        tuple[1] =  (*node)[1]/um; //scale to um
+        tuple[2] =  (*node)[2]/um; //scale to um
+        points->InsertPoint(region_n_nodes++, tuple);
+      }
+    }
+    _vtk_grid->SetPoints(points);
+    points->Delete();
+    return;
+  }
+
   std::vector<unsigned int> system_nodes;
   for( unsigned int r=0; r<system.n_regions(); r++)
   {
@@ -229,6 +293,54 @@ void VTKIO::nodes_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
 
 void VTKIO::cells_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
 {
+  // partition piece holds on processor elements and boundary faces, no communication
+  if(_partition)
+  {
+    _local_cell_id_map.clear();
+    _local_boundary_cell_id_map.clear();
+
+    unsigned int n_elems = 0;
+    MeshBase::const_element_iterator       it  = mesh.active_this_pid_elements_begin();
+    const MeshBase::const_element_iterator end = mesh.active_this_pid_elements_end();
+    for ( ; it != end; ++it)
+      n_elems++;
+    _vtk_grid->Allocate(n_elems + _il.size());
+
+    for ( it  = mesh.active_this_pid_elements_begin(); it != end; ++it)
+    {
+      const Elem *elem  = (*it);
+      std::vector<unsigned int> conn;
+      elem->connectivity(0,VTK,conn);
+
+      vtkIdList *pts = vtkIdList::New();
+      pts->SetNumberOfIds(conn.size());
+      for(unsigned int i=0;i<conn.size();++i)
+        pts->SetId(i, _region_node_id_map.find(std::make_pair(elem->subdomain_id(), conn[i]))->second);
+
+      _local_cell_id_map.insert( std::make_pair(elem->id(), _local_cell_id_map.size()) );
+      _vtk_grid->InsertNextCell(elem_type_vtk(elem), pts);
+      pts->Delete();
+    }
+
+    for(unsigned int n=0; n<_il.size(); ++n)
+    {
+      const Elem * elem = mesh.elem(_el[n]);
+      AutoPtr<Elem> boundary_elem =  elem->build_side(_sl[n]);
+      std::vector<unsigned int> conn;
+      boundary_elem->connectivity(0,VTK,conn);
+
+      vtkIdList *pts = vtkIdList::New();
+      pts->SetNumberOfIds(conn.size());
+      for(unsigned int i=0;i<conn.size();++i)
+        pts->SetId(i, _region_node_id_map.find(std::make_pair(elem->subdomain_id(), conn[i]))->second);
+
+      _local_boundary_cell_id_map.insert( std::make_pair(std::make_pair(_el[n], _sl[n]), n_elems+n) );
+      _vtk_grid->InsertNextCell(elem_type_vtk(boundary_elem.get()), pts);
+      pts->Delete();
+    }
+    return;
+  }
+
   // must run in parallel
   std::vector<int> vtk_cell_conns;
   std::vector<unsigned int> vtk_cell_ids;
@@ -367,6 +479,49 @@ void VTKIO::meshinfo_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
 {
   //write cell based region and partition info to vtk
 
+  if(_partition)
+  {
+    const unsigned int n_elems = _local_cell_id_map.size() + _local_boundary_cell_id_map.size();
+
+    vtkIntArray *region_info    = vtkIntArray::New();
+    vtkIntArray *boundary_info  = vtkIntArray::New();
+    vtkIntArray *partition_info  = vtkIntArray::New();
+
+    region_info->SetName("region");
+    region_info->SetNumberOfValues(n_elems);
+
+    boundary_info->SetName("boundary");
+    boundary_info->SetNumberOfValues(n_elems);
+
+    partition_info->SetName("partition");
+    partition_info->SetNumberOfValues(n_elems);
+
+    std::map<unsigned int, unsigned int>::const_iterator it = _local_cell_id_map.begin();
+    for(; it != _local_cell_id_map.end(); ++it)
+    {
+      region_info->SetValue(it->second, mesh.elem(it->first)->subdomain_id());
+      boundary_info->SetValue(it->second, 0);
+      partition_info->SetValue(it->second, Genius::processor_id());
+    }
+
+    for(unsigned int n=0; n<_il.size(); ++n)
+    {
+      int loc = _local_boundary_cell_id_map.find(std::make_pair(_el[n], _sl[n]))->second;
+      region_info->SetValue(loc, mesh.elem(_el[n])->subdomain_id());
+      boundary_info->SetValue(loc, _il[n]);
+      partition_info->SetValue(loc, Genius::processor_id());
+    }
+
+    _vtk_grid->GetCellData()->AddArray(region_info);
+    _vtk_grid->GetCellData()->AddArray(boundary_info);
+    _vtk_grid->GetCellData()->AddArray(partition_info);
+
+    region_info->Delete();
+    boundary_info->Delete();
+    partition_info->Delete();
+    return;
+  }
+
   // collect info of mesh elements
   std::vector<int> elem_ids;
   std::vector<int> elem_region;
@@ -673,11 +828,16 @@ void VTKIO::solution_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
     double concentration_scale = std::pow(cm, -3);
 
 
-    // search all the node belongs to current processor
+    // search all the node belongs to current processor, partition piece also needs ghost nodes
     for( unsigned int r=0; r<system.n_regions(); r++)
     {
       SimulationRegion::const_processor_node_iterator on_processor_nodes_it = system.region(r)->on_processor_nodes_begin();
       SimulationRegion::const_processor_node_iterator on_processor_nodes_it_end = system.region(r)->on_processor_nodes_end();
+      if(_partition)
+      {
+        on_processor_nodes_it = system.region(r)->on_local_nodes_begin();
+        on_processor_nodes_it_end = system.region(r)->on_local_nodes_end();
+      }
       for(; on_processor_nodes_it!=on_processor_nodes_it_end; ++on_processor_nodes_it)
       {
         const FVM_Node * fvm_node = *on_processor_nodes_it;
@@ -902,7 +1062,10 @@ void VTKIO::solution_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
         if( elem->processor_id() != Genius::processor_id() ) continue;
         const FVM_CellData * elem_data = region->get_region_elem_data(n);
         elem_to_elem_data_map.insert( std::make_pair(elem, elem_data) );
-        order.push_back(elem->id());
+        if(_partition)
+          order.push_back(_local_cell_id_map.find(elem->id())->second);
+        else
+          order.push_back(elem->id());
         /*
         if( region->type()==SemiconductorRegion)
         {
@@ -929,6 +1092,17 @@ void VTKIO::solution_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
     }
 
     // write solution for boundary elements, just keep the same as mesh elems
+    if(_partition)
+    {
+      for(unsigned int n=0; n<_il.size(); ++n)
+      {
+        order.push_back(_local_boundary_cell_id_map.find(std::make_pair(_el[n], _sl[n]))->second);
+        Ex.push_back(0);  Ey.push_back(0);  Ez.push_back(0);
+        Jnx.push_back(0); Jny.push_back(0); Jnz.push_back(0);
+        Jpx.push_back(0); Jpy.push_back(0); Jpz.push_back(0);
+      }
+    }
+    else
     {
       std::vector<unsigned int> boundary_elem_ids(_el);
       std::vector<unsigned short int> boundary_elem_sides(_sl);
@@ -979,7 +1153,8 @@ void VTKIO::solution_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
       }
     }
 
-    Parallel::gather(0, order);
+    if(!_partition)
+      Parallel::gather(0, order);
     //write_cell_scaler_solution(order, mos_channel_flag,  "mos channel", grid);
     write_cell_vector_solution(order, Ex,  Ey,  Ez,  "electrical_field[V/cm]", grid);
     write_cell_vector_solution(order, Jnx, Jny, Jnz, "elec_current[A/cm^2]", grid);
@@ -1000,7 +1175,15 @@ void VTKIO::write_node_scaler_solution(const std::vector< std::vector<unsigned i
   // this should run on parallel for all the processor
   std::vector<float> solution;
 
-  for(unsigned int r=0; r<region_order.size(); ++r)
+  if(_partition)
+  {
+    solution.resize(grid->GetNumberOfPoints(), 0.0);
+    for(unsigned int r=0; r<region_order.size(); ++r)
+      for(unsigned int i=0; i<region_order[r].size(); ++i)
+        solution[local_point_index(r, region_order[r][i])] = region_sol[r][i];
+  }
+
+  for(unsigned int r=0; r<region_order.size() && !_partition; ++r)
   {
     const std::vector<unsigned int> & order = region_order[r];
     const std::vector<float> & sol = region_sol[r];
@@ -1018,7 +1201,7 @@ void VTKIO::write_node_scaler_solution(const std::vector< std::vector<unsigned i
       solution.push_back(it->second);
   }
 
-  if (Genius::processor_id() == 0)
+  if (Genius::processor_id() == 0 || _partition)
   {
     //create vtk data array
     vtkFloatArray *vtk_sol_array = vtkFloatArray::New();
@@ -1050,7 +1233,20 @@ void VTKIO::write_node_complex_solution(const std::vector< std::vector<unsigned
   std::vector<float> solution_real;
   std::vector<float> solution_imag;
 
-  for(unsigned int r=0; r<region_order.size(); ++r)
+  if(_partition)
+  {
+    solution_real.resize(grid->GetNumberOfPoints(), 0.0);
+    solution_imag.resize(grid->GetNumberOfPoints(), 0.0);
+    for(unsigned int r=0; r<region_order.size(); ++r)
+      for(unsigned int i=0; i<region_order[r].size(); ++i)
+      {
+        unsigned int loc = local_point_index(r, region_order[r][i]);
+        solution_real[loc] = region_sol[r][i].real();
+        solution_imag[loc] = region_sol[r][i].imag();
+      }
+  }
+
+  for(unsigned int r=0; r<region_order.size() && !_partition; ++r)
   {
     const std::vector<unsigned int> & order = region_order[r];
     const std::vector<std::complex<float> > & sol = region_sol[r];
@@ -1077,7 +1273,7 @@ void VTKIO::write_node_complex_solution(const std::vector< std::vector<unsigned
 
   genius_assert(solution_real.size() == solution_imag.size());
 
-  if ( Genius::processor_id() == 0)
+  if ( Genius::processor_id() == 0 || _partition)
   {
     //create vtk data array
     vtkFloatArray *vtk_sol_array_magnitude = vtkFloatArray::New();
@@ -1122,7 +1318,22 @@ void VTKIO::write_node_vector_solution(const std::vector< std::vector<unsigned i
   std::vector<float> solution_y;
   std::vector<float> solution_z;
 
-  for(unsigned int r=0; r<region_order.size(); ++r)
+  if(_partition)
+  {
+    solution_x.resize(grid->GetNumberOfPoints(), 0.0);
+    solution_y.resize(grid->GetNumberOfPoints(), 0.0);
+    solution_z.resize(grid->GetNumberOfPoints(), 0.0);
+    for(unsigned int r=0; r<region_order.size(); ++r)
+      for(unsigned int i=0; i<region_order[r].size(); ++i)
+      {
+        unsigned int loc = local_point_index(r, region_order[r][i]);
+        solution_x[loc] = region_x[r][i];
+        solution_y[loc] = region_y[r][i];
+        solution_z[loc] = region_z[r][i];
+      }
+  }
+
+  for(unsigned int r=0; r<region_order.size() && !_partition; ++r)
   {
     const std::vector<unsigned int> & order = region_order[r];
     const std::vector<float> & vec_x = region_x[r];
@@ -1157,7 +1368,7 @@ void VTKIO::write_node_vector_solution(const std::vector< std::vector<unsigned i
       solution_z.push_back(z_it->second);
   }
 
-  if ( Genius::processor_id() == 0)
+  if ( Genius::processor_id() == 0 || _partition)
   {
     //create vtk data array
     vtkFloatArray *vtk_sol_array = vtkFloatArray::New();
@@ -1188,9 +1399,10 @@ void VTKIO::write_cell_scaler_solution(const std::vector<unsigned int> & order,
                                        const std::string & sol_name, vtkUnstructuredGrid* grid)
 {
   // this should run on parallel for all the processor
-  Parallel::gather(0, sol);
+  if(!_partition)
+    Parallel::gather(0, sol);
 
-  if (Genius::processor_id() == 0)
+  if (Genius::processor_id() == 0 || _partition)
   {
     //create vtk data array
     vtkFloatArray *vtk_sol_array = vtkFloatArray::New();
@@ -1225,11 +1437,14 @@ void VTKIO::write_cell_vector_solution(const std::vector<unsigned int> & order,
                                        const std::string & sol_name, vtkUnstructuredGrid* grid)
 {
   // this should run on parallel for all the processor
-  Parallel::gather(0, sol_x);
-  Parallel::gather(0, sol_y);
-  Parallel::gather(0, sol_z);
+  if(!_partition)
+  {
+    Parallel::gather(0, sol_x);
+    Parallel::gather(0, sol_y);
+    Parallel::gather(0, sol_z);
+  }
 
-  if ( Genius::processor_id() == 0)
+  if ( Genius::processor_id() == 0 || _partition)
   {
     //create vtk data array
     vtkFloatArray *vtk_sol_array = vtkFloatArray::New();
@@ -1292,6 +1507,90 @@ void VTKIO::_smooth_numerical_error(std::map<unsigned int, float> &dataset, floa
 }
 
 
+#ifdef HAVE_VTK
+
+void VTKIO::write_grid(vtkUnstructuredGrid* grid, const std::string &name, const std::string &header)
+{
+  WriteJob * job = new WriteJob(grid, name, header);
+  if(_writer)
+    _writer->enqueue(job);
+  else
+  {
+    job->write();
+    delete job;
+  }
+}
+
+
+std::string VTKIO::piece_file_name(const std::string &name, unsigned int rank)
+{
+  std::stringstream ss;
+  ss << name.substr(0, name.rfind(".pvtu")) << "_p" << rank << ".vtu";
+  return ss.str();
+}
+
+
+unsigned int VTKIO::local_point_index(unsigned int region, unsigned int node_id) const
+{
+  std::map< std::pair<unsigned int, unsigned int>, unsigned int >::const_iterator it;
+  it = _region_node_id_map.find(std::make_pair(region, node_id));
+  genius_assert(it != _region_node_id_map.end());
+  return it->second;
+}
+
+
+void VTKIO::write_pvtu(const std::string &name, vtkUnstructuredGrid* grid)
+{
+  std::ofstream out(name.c_str());
+
+  // keep the same extra header as serial vtu file
+  out << this->export_extra_info();
+
+  out << "<?xml version=\"1.0\"?>" << std::endl;
+  out << "<VTKFile type=\"PUnstructuredGrid\" version=\"0.1\" byte_order=\"LittleEndian\">" << std::endl;
+  out << "  <PUnstructuredGrid GhostLevel=\"0\">" << std::endl;
+
+  out << "    <PPointData>" << std::endl;
+  for(int n=0; n<grid->GetPointData()->GetNumberOfArrays(); ++n)
+  {
+    vtkDataArray * array = grid->GetPointData()->GetArray(n);
+    out << "      <PDataArray type=\"" << (array->GetDataType() == VTK_INT ? "Int32" : "Float32") << "\" "
+        << "Name=\"" << array->GetName() << "\" "
+        << "NumberOfComponents=\"" << array->GetNumberOfComponents() << "\"/>" << std::endl;
+  }
+  out << "    </PPointData>" << std::endl;
+
+  out << "    <PCellData>" << std::endl;
+  for(int n=0; n<grid->GetCellData()->GetNumberOfArrays(); ++n)
+  {
+    vtkDataArray * array = grid->GetCellData()->GetArray(n);
+    out << "      <PDataArray type=\"" << (array->GetDataType() == VTK_INT ? "Int32" : "Float32") << "\" "
+        << "Name=\"" << array->GetName() << "\" "
+        << "NumberOfComponents=\"" << array->GetNumberOfComponents() << "\"/>" << std::endl;
+  }
+  out << "    </PCellData>" << std::endl;
+
+  out << "    <PPoints>" << std::endl;
+  out << "      <PDataArray type=\"Float32\" NumberOfComponents=\"3\"/>" << std::endl;
+  out << "    </PPoints>" << std::endl;
+
+  // piece file is relative to the index file
+  for(unsigned int p=0; p<Genius::n_processors(); ++p)
+  {
+    std::string piece = piece_file_name(name, p);
+    if(piece.rfind('/') < piece.size())
+      piece = piece.substr(piece.rfind('/')+1);
+    out << "    <Piece Source=\"" << piece << "\"/>" << std::endl;
+  }
+
+  out << "  </PUnstructuredGrid>" << std::endl;
+  out << "</VTKFile>" << std::endl;
+  out.close();
+}
+
+#endif
+
+
 // ------------------------------------------------------------
 // vtkIO class members
 //
@@ -1307,6 +1606,27 @@ void VTKIO::write (const std::string& name)
   const MeshBase& mesh = FieldOutput<SimulationSystem>::system().mesh();
   mesh.boundary_info->build_on_processor_side_list (_el, _sl, _il);
 
+  // parallel vtk file, each processor writes its own piece and processor 0 writes the index
+  if(name.rfind(".pvtu") < name.size())
+  {
+#ifdef HAVE_VTK
+    _partition = true;
+    _vtk_grid = vtkUnstructuredGrid::New();
+
+    nodes_to_vtk(mesh, _vtk_grid);
+    cells_to_vtk(mesh, _vtk_grid);
+    meshinfo_to_vtk(mesh, _vtk_grid);
+    solution_to_vtk(mesh, _vtk_grid);
+
+    // all the pieces have the same data arrays, processor 0 describes them
+    if(Genius::processor_id() == 0)
+      write_pvtu(name, _vtk_grid);
+
+    write_grid(_vtk_grid, piece_file_name(name, Genius::processor_id()), "");
+    _partition = false;
+#endif
+  }
+
   // vtk file extension have a ".vtu" format?
   if(name.rfind(".vtu") < name.size())
   {
@@ -1322,18 +1642,9 @@ void VTKIO::write (const std::string& name)
 
     // only processor 0 write VTK file
     if(Genius::processor_id() == 0)
-    {
-      XMLUnstructuredGridWriter* writer = XMLUnstructuredGridWriter::New();
-      writer->SetInput(_vtk_grid);
-      writer->setExtraHeader(this->export_extra_info());
-
-      writer->SetFileName(name.c_str());
-      writer->Write();
-      writer->Delete();
-
-    }
-    //clean up
-    _vtk_grid->Delete();
+      write_grid(_vtk_grid, name, this->export_extra_info());
+    else
+      _vtk_grid->Delete();
 #endif
 
   }
@@ -127,6 +127,10 @@ int DDM1Solver::solve()
       ierr = solve_transient();
       break;
 
+      case SolverSpecify::PSS:
+      ierr = solve_pss();
+      break;
+
       case SolverSpecify::TRACE:
       ierr = solve_iv_trace();
       break;
@@ -87,6 +87,38 @@ void SemiconductorSimulationRegion::DDM1_Fill_Value(Vec x, Vec L)
 }
 
 
+/*---------------------------------------------------------------------
+ * select band band tunneling and impact ionization kernel of DDML1 edges
+ */
+SemiconductorSimulationRegion::DDM1_GenerationKernel SemiconductorSimulationRegion::DDM1_generation_kernel() const
+{
+  DDM1_GenerationKernel kernel;
+  const bool nonequilibrium = SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM;
+  kernel.bbt = get_advanced_model()->BandBandTunneling && nonequilibrium;
+  kernel.ii  = get_advanced_model()->ImpactIonization && nonequilibrium;
+  kernel.ii_force = get_advanced_model()->II_Force;
+
+  if( kernel.ii )
+  {
+    switch (kernel.ii_force)
+    {
+        case ModelSpecify::IIForce_EdotJ:
+        case ModelSpecify::EVector:
+        case ModelSpecify::ESide:
+        case ModelSpecify::GradQf:
+        break;
+        default:
+        {
+          MESSAGE<<"ERROR: Unsupported Impact Ionization Type."<<std::endl; RECORD();
+          genius_error();
+        }
+    }
+  }
+
+  return kernel;
+}
+
+
 /*---------------------------------------------------------------------
  * build function and its jacobian for DDML1 solver
  */
@@ -116,25 +148,17 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
   isource.reserve(3*this->n_node());
   source.reserve(3*this->n_node());
 
-  // buffer for band band tunneling
-  std::vector<PetscInt>          ibbt;
-  std::vector<PetscScalar>       bbt;
-  if (get_advanced_model()->BandBandTunneling && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM)
-  {
-    // slightly overkill -- the HEX8 element has 12 edges, each edge has 2 node
-    ibbt.reserve(3*(24*this->n_cell()));
-    bbt.reserve(3*(24*this->n_cell()));
-  }
+  // band band tunneling and impact ionization
+  const DDM1_GenerationKernel kernel = DDM1_generation_kernel();
 
-  // buffer for impact ionization
-  std::vector<PetscInt>          iii;
-  std::vector<PetscScalar>       ii;
-  if (get_advanced_model()->ImpactIonization && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM)
-  {
-    // slightly overkill -- the HEX8 element has 12 edges, each edge has 2 node
-    iii.reserve(3*(24*this->n_cell()));
-    ii.reserve(3*(24*this->n_cell()));
+  // buffer for generation, the capacity is kept from the last call
+  std::vector<PetscInt>    & igen = _ddm1_generation_index;
+  std::vector<PetscScalar> & gen  = _ddm1_generation_value;
+  igen.clear();
+  gen.clear();
 
+  if (kernel.ii)
+  {
     processor_node_iterator node_it = on_processor_nodes_begin();
     processor_node_iterator node_it_end = on_processor_nodes_end();
     for(; node_it!=node_it_end; ++node_it)
@@ -151,6 +175,46 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
   const PetscScalar Vt  = kb*T/e;
   bool  highfield_mob   = highfield_mobility() && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM;
 
+  // band gap narrowing of all the local nodes, one PMI call for the region.
+  // the result is in local node order, which is looked up by the offset of node data
+  std::vector<PMI_NodeContext> & ctx    = _ddm1_node_context;
+  std::vector<PetscScalar>     & n_node = _ddm1_node_n;
+  std::vector<PetscScalar>     & p_node = _ddm1_node_p;
+  std::vector<PetscScalar>     & T_node = _ddm1_node_T;
+  std::vector<PetscScalar>     & dEc_node = _ddm1_node_dEc;
+  std::vector<PetscScalar>     & dEv_node = _ddm1_node_dEv;
+  std::vector<unsigned int>    & node_order = _ddm1_local_node_order;
+  {
+    ctx.clear();
+    n_node.clear();
+    p_node.clear();
+    T_node.clear();
+    node_order.resize(_node_data_storage.size(), invalid_uint);
+
+    const_local_node_iterator node_it = on_local_nodes_begin();
+    const_local_node_iterator node_it_end = on_local_nodes_end();
+    for(; node_it!=node_it_end; ++node_it)
+    {
+      const FVM_Node * fvm_node = *node_it;
+      const FVM_NodeData * node_data = fvm_node->node_data();
+      const unsigned int local_offset = fvm_node->local_offset();
+
+      node_order[node_data->offset()] = ctx.size();
+      ctx.push_back( PMI_NodeContext(fvm_node->root_node(), node_data, SolverSpecify::clock) );
+      n_node.push_back( x[local_offset+1] );
+      p_node.push_back( x[local_offset+2] );
+      T_node.push_back( T );
+    }
+
+    dEc_node.resize(ctx.size());
+    dEv_node.resize(ctx.size());
+    if( ctx.size() )
+    {
+      mt->band->EgNarrowToEc(ctx.size(), &ctx[0], &p_node[0], &n_node[0], &T_node[0], &dEc_node[0]);
+      mt->band->EgNarrowToEv(ctx.size(), &ctx[0], &p_node[0], &n_node[0], &T_node[0], &dEv_node[0]);
+    }
+  }
+
   // precompute S-G current on each edge
   std::vector<PetscScalar> Jn_edge_buffer;
   std::vector<PetscScalar> Jp_edge_buffer;
@@ -193,8 +257,8 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
       // takes care of the change effective DOS.
       // Ec/Ev should not be used except when its difference between two nodes.
       // The same comment applies to Ec2/Ev2.
-      PetscScalar Ec1 =  -(e*V1 + n1_data->affinity() - n1_data->dEcStrain() + mt->band->EgNarrowToEc(p1, n1, T) + kb*T*log(n1_data->Nc()));
-      PetscScalar Ev1 =  -(e*V1 + n1_data->affinity() - n1_data->dEvStrain() - mt->band->EgNarrowToEv(p1, n1, T) - kb*T*log(n1_data->Nv()) + mt->band->Eg(T));
+      PetscScalar Ec1 =  -(e*V1 + n1_data->affinity() - n1_data->dEcStrain() + dEc_node[node_order[n1_data->offset()]] + kb*T*log(n1_data->Nc()));
+      PetscScalar Ev1 =  -(e*V1 + n1_data->affinity() - n1_data->dEvStrain() - dEv_node[node_order[n1_data->offset()]] - kb*T*log(n1_data->Nv()) + mt->band->Eg(T));
       if(get_advanced_model()->Fermi)
       {
         Ec1 = Ec1 - kb*T*log(gamma_f(fabs(n1)/n1_data->Nc()));
@@ -209,8 +273,8 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
       const PetscScalar n2   =  x[n2_local_offset+1];                   // electron density
       const PetscScalar p2   =  x[n2_local_offset+2];                   // hole density
 
-      PetscScalar Ec2 =  -(e*V2 + n2_data->affinity() - n2_data->dEcStrain() + mt->band->EgNarrowToEc(p2, n2, T) + kb*T*log(n2_data->Nc()));
-      PetscScalar Ev2 =  -(e*V2 + n2_data->affinity() - n2_data->dEvStrain() - mt->band->EgNarrowToEv(p2, n2, T) - kb*T*log(n2_data->Nv()) + mt->band->Eg(T));
+      PetscScalar Ec2 =  -(e*V2 + n2_data->affinity() - n2_data->dEcStrain() + dEc_node[node_order[n2_data->offset()]] + kb*T*log(n2_data->Nc()));
+      PetscScalar Ev2 =  -(e*V2 + n2_data->affinity() - n2_data->dEvStrain() - dEv_node[node_order[n2_data->offset()]] - kb*T*log(n2_data->Nv()) + mt->band->Eg(T));
       if(get_advanced_model()->Fermi)
       {
         Ec2 = Ec2 - kb*T*log(gamma_f(fabs(n2)/n2_data->Nc()));
@@ -404,6 +468,32 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
     }
 
 
+    // direction of carrier flow and driving force of impact ionization, they are constant in the cell.
+    // ESide force depends on edge
+    VectorValue<PetscScalar> Jn_unit, Jp_unit;
+    PetscScalar Fn_ii=0, Fp_ii=0;
+    if (kernel.ii)
+    {
+      Jn_unit = Jnv.unit(true);
+      Jp_unit = Jpv.unit(true);
+      switch (kernel.ii_force)
+      {
+          case ModelSpecify::IIForce_EdotJ:
+          Fn_ii = std::max(E.dot(Jn_unit), 0.0);
+          Fp_ii = std::max(E.dot(Jp_unit), 0.0);
+          break;
+          case ModelSpecify::EVector:
+          Fn_ii = E.size();
+          Fp_ii = Fn_ii;
+          break;
+          case ModelSpecify::GradQf:
+          Fn_ii = Jnv.size();
+          Fp_ii = Jpv.size();
+          break;
+          default: break;
+      }
+    }
+
     // process \nabla psi and S-G current along the cell's edge
     // search for all the edges this cell own
     for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
@@ -564,97 +654,76 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
           flux.push_back ( Jp*truncated_partial_area );
         }
 
-        if (get_advanced_model()->BandBandTunneling && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM)
+        if (kernel.bbt)
         {
-
-          PetscScalar GBTBT1 = mt->band->BB_Tunneling(T, E.size());
-          PetscScalar GBTBT2 = mt->band->BB_Tunneling(T, E.size());
+          // the same rate for both nodes of the edge
+          const PetscScalar GBTBT = 0.5*mt->band->BB_Tunneling(T, E.size())*truncated_partial_volume;
 
           if( fvm_n1->on_processor() )
           {
             // continuity equation
-            ibbt.push_back( n1_global_offset + 1);
-            bbt.push_back ( 0.5*GBTBT1*truncated_partial_volume );
+            igen.push_back( n1_global_offset + 1);
+            gen.push_back ( GBTBT );
 
-            ibbt.push_back( n1_global_offset + 2);
-            bbt.push_back ( 0.5*GBTBT1*truncated_partial_volume );
+            igen.push_back( n1_global_offset + 2);
+            gen.push_back ( GBTBT );
           }
 
           if( fvm_n2->on_processor() )
           {
             // continuity equation
-            ibbt.push_back( n2_global_offset + 1);
-            bbt.push_back ( 0.5*GBTBT2*truncated_partial_volume );
+            igen.push_back( n2_global_offset + 1);
+            gen.push_back ( GBTBT );
 
-            ibbt.push_back( n2_global_offset + 2);
-            bbt.push_back ( 0.5*GBTBT2*truncated_partial_volume );
+            igen.push_back( n2_global_offset + 2);
+            gen.push_back ( GBTBT );
           }
         }
 
-        if (get_advanced_model()->ImpactIonization && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM)
+        if (kernel.ii)
         {
           // consider impact-ionization
-          PetscScalar v = std::max(0.0, partial_volume);
-          PetscScalar IIn,IIp,GIIn,GIIp;
           PetscScalar Eg = 0.5* ( n1_data->Eg() + n2_data->Eg() );
 
-          VectorValue<Real> ev = (elem->point(edge_nodes.second) - elem->point(edge_nodes.first));
-          PetscScalar riin1 = 0.5 + 0.5* (ev.unit()).dot(Jnv.unit(true));
+          const VectorValue<Real> ev = (elem->point(edge_nodes.second) - elem->point(edge_nodes.first)).unit();
+          PetscScalar riin1 = 0.5 + 0.5* ev.dot(Jn_unit);
           PetscScalar riin2 = 1.0 - riin1;
-          PetscScalar riip2 = 0.5 + 0.5* (ev.unit()).dot(Jpv.unit(true));
+          PetscScalar riip2 = 0.5 + 0.5* ev.dot(Jp_unit);
           PetscScalar riip1 = 1.0 - riip2;
 
-          switch (get_advanced_model()->II_Force)
+          if (kernel.ii_force == ModelSpecify::ESide)
           {
-              case ModelSpecify::IIForce_EdotJ:
-              Epn = std::max(E.dot(Jnv.unit(true)), 0.0);
-              Epp = std::max(E.dot(Jpv.unit(true)), 0.0);
-              IIn = mt->gen->ElecGenRate(T,Epn,Eg);
-              IIp = mt->gen->HoleGenRate(T,Epp,Eg);
-              break;
-              case ModelSpecify::EVector:
-              IIn = mt->gen->ElecGenRate(T,E.size(),Eg);
-              IIp = mt->gen->HoleGenRate(T,E.size(),Eg);
-              break;
-              case ModelSpecify::ESide:
-              IIn = mt->gen->ElecGenRate(T,fabs((V2-V1)/length),Eg);
-              IIp = mt->gen->HoleGenRate(T,fabs((V2-V1)/length),Eg);
-              break;
-              case ModelSpecify::GradQf:
-              IIn = mt->gen->ElecGenRate(T,Jnv.size(),Eg);
-              IIp = mt->gen->HoleGenRate(T,Jpv.size(),Eg);
-              break;
-              default:
-              {
-                MESSAGE<<"ERROR: Unsupported Impact Ionization Type."<<std::endl; RECORD();
-                genius_error();
-              }
+            Fn_ii = fabs((V2-V1)/length);
+            Fp_ii = Fn_ii;
           }
-          GIIn = IIn * fabs(Jn)/e;
-          GIIp = IIp * fabs(Jp)/e;
+
+          PetscScalar GIIn = mt->gen->ElecGenRate(T,Fn_ii,Eg) * fabs(Jn)/e;
+          PetscScalar GIIp = mt->gen->HoleGenRate(T,Fp_ii,Eg) * fabs(Jp)/e;
 
           if( fvm_n1->on_processor() )
           {
             // continuity equation
-            iii.push_back( n1_global_offset + 1);
-            ii.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
+            const PetscScalar GII = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume;
+            igen.push_back( n1_global_offset + 1);
+            gen.push_back ( GII );
 
-            iii.push_back( n1_global_offset + 2);
-            ii.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
+            igen.push_back( n1_global_offset + 2);
+            gen.push_back ( GII );
 
-            n1_data->ImpactIonization() += (riin1*GIIn+riip1*GIIp)*truncated_partial_volume/fvm_n1->volume();
+            n1_data->ImpactIonization() += GII/fvm_n1->volume();
           }
 
           if( fvm_n2->on_processor() )
           {
             // continuity equation
-            iii.push_back( n2_global_offset + 1);
-            ii.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
+            const PetscScalar GII = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume;
+            igen.push_back( n2_global_offset + 1);
+            gen.push_back ( GII );
 
-            iii.push_back( n2_global_offset + 2);
-            ii.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
+            igen.push_back( n2_global_offset + 2);
+            gen.push_back ( GII );
 
-            n2_data->ImpactIonization() += (riin2*GIIn+riip2*GIIp)*truncated_partial_volume/fvm_n2->volume();
+            n2_data->ImpactIonization() += GII/fvm_n2->volume();
           }
         }
       }
@@ -667,18 +736,50 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
 
   // add into petsc vector, we should prevent zero length vector add here.
   if(iflux.size())    VecSetValues(f, iflux.size(), &iflux[0], &flux[0], ADD_VALUES);
-  if(ibbt.size())     VecSetValues(f, ibbt.size(), &ibbt[0], &bbt[0], ADD_VALUES);
-  if(iii.size())      VecSetValues(f, iii.size(), &iii[0], &ii[0], ADD_VALUES);
+  if(igen.size())     VecSetValues(f, igen.size(), &igen[0], &gen[0], ADD_VALUES);
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
 
+  // recombination (and nie for trap) of all the on processor nodes, one PMI call for the region.
+  // the gather buffers of band gap narrowing are reused, the result is in on processor node order
+  std::vector<PetscScalar> & R_node  = _ddm1_node_R;
+  std::vector<PetscScalar> & ni_node = _ddm1_node_ni;
+  {
+    ctx.clear();
+    n_node.clear();
+    p_node.clear();
+    T_node.clear();
+
+    const_processor_node_iterator node_it = on_processor_nodes_begin();
+    const_processor_node_iterator node_it_end = on_processor_nodes_end();
+    for(; node_it!=node_it_end; ++node_it)
+    {
+      const FVM_Node * fvm_node = *node_it;
+      const unsigned int local_offset = fvm_node->local_offset();
+
+      ctx.push_back( PMI_NodeContext(fvm_node->root_node(), fvm_node->node_data(), SolverSpecify::clock) );
+      n_node.push_back( x[local_offset+1] );
+      p_node.push_back( x[local_offset+2] );
+      T_node.push_back( T );
+    }
+
+    R_node.resize(ctx.size());
+    if( ctx.size() )
+      mt->band->Recomb(ctx.size(), &ctx[0], &p_node[0], &n_node[0], &T_node[0], &R_node[0]);
+    if( ctx.size() && get_advanced_model()->Trap )
+    {
+      ni_node.resize(ctx.size());
+      mt->band->nie(ctx.size(), &ctx[0], &p_node[0], &n_node[0], &T_node[0], &ni_node[0]);
+    }
+  }
+
   // process node related terms
   // including \rho of poisson's equation and recombination term of continuation equation
   const_processor_node_iterator node_it = on_processor_nodes_begin();
   const_processor_node_iterator node_it_end = on_processor_nodes_end();
-  for(; node_it!=node_it_end; ++node_it)
+  for(unsigned int i=0; node_it!=node_it_end; ++node_it, ++i)
   {
     const FVM_Node * fvm_node = *node_it;
     const FVM_NodeData * node_data = fvm_node->node_data();
@@ -692,7 +793,7 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
 
     mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);      // map this node and its data to material database
 
-    PetscScalar R   = - mt->band->Recomb(p, n, T)*fvm_node->volume();         // the recombination term
+    PetscScalar R   = - R_node[i]*fvm_node->volume();                         // the recombination term
 
     PetscScalar doping = node_data->Net_doping();
     if(get_advanced_model()->IncompleteIonization)
@@ -716,7 +817,7 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
       // consider charge trapping in semiconductor bulk (bulk_flag=true)
 
       // call the Trap MPI to calculate trap occupancy using the local carrier densities and lattice temperature
-      PetscScalar ni = mt->band->nie(p, n, T);
+      PetscScalar ni = ni_node[i];
       mt->trap->Calculate(true,p,n,ni,T);
 
       // calculate the contribution of trapped charge to Poisson's equation
@@ -778,6 +879,9 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
   const PetscScalar Vt  = kb*T/e;
   bool  highfield_mob   = highfield_mobility() && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM;
 
+  // band band tunneling and impact ionization
+  const DDM1_GenerationKernel kernel = DDM1_generation_kernel();
+
   // precompute S-G current on each edge
   std::vector<AutoDScalar> Jn_edge_buffer;
   std::vector<AutoDScalar> Jp_edge_buffer;
@@ -1071,6 +1175,32 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
     }
 
 
+    // direction of carrier flow and driving force of impact ionization, they are constant in the cell.
+    // ESide force depends on edge
+    VectorValue<AutoDScalar> Jn_unit, Jp_unit;
+    AutoDScalar Fn_ii(0), Fp_ii(0);
+    if (kernel.ii)
+    {
+      Jn_unit = Jnv.unit(true);
+      Jp_unit = Jpv.unit(true);
+      switch (kernel.ii_force)
+      {
+          case ModelSpecify::IIForce_EdotJ:
+          Fn_ii = adtl::fmax(E.dot(Jn_unit), 0.0);
+          Fp_ii = adtl::fmax(E.dot(Jp_unit), 0.0);
+          break;
+          case ModelSpecify::EVector:
+          Fn_ii = E.size();
+          Fp_ii = Fn_ii;
+          break;
+          case ModelSpecify::GradQf:
+          Fn_ii = Jnv.size();
+          Fp_ii = Jpv.size();
+          break;
+          default: break;
+      }
+    }
+
     // process conservation terms: laplace operator of poisson's equation and div operator of continuation equation
     // search for all the Edge this cell own
     for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
@@ -1244,15 +1374,14 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
 
         // BandBandTunneling && ImpactIonization
 
-        if (get_advanced_model()->BandBandTunneling && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM)
+        if (kernel.bbt)
         {
-          AutoDScalar GBTBT1 = mt->band->BB_Tunneling(T, E.size());
-          AutoDScalar GBTBT2 = mt->band->BB_Tunneling(T, E.size());
+          // the same rate for both nodes of the edge
+          AutoDScalar continuity = 0.5*mt->band->BB_Tunneling(T, E.size())*truncated_partial_volume;
 
           if( fvm_n1->on_processor() )
           {
             // continuity equation
-            AutoDScalar continuity = 0.5*GBTBT1*truncated_partial_volume;
             jac->add_row(  row[1],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
             jac->add_row(  row[2],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
           }
@@ -1260,73 +1389,48 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
           if( fvm_n2->on_processor() )
           {
             // continuity equation
-            AutoDScalar continuity = 0.5*GBTBT2*truncated_partial_volume;
             jac->add_row(  row[4],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
             jac->add_row(  row[5],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
           }
         }
 
-        if (get_advanced_model()->ImpactIonization && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM)
+        if (kernel.ii)
         {
           // consider impact-ionization
-           AutoDScalar IIn,IIp,GIIn,GIIp;
           PetscScalar Eg = 0.5* ( n1_data->Eg() + n2_data->Eg() );
 
           // FIXME should use weighted carrier temperature.
 
-          VectorValue<Real> ev0 = (elem->point(edge_nodes.second) - elem->point(edge_nodes.first));
-          VectorValue<AutoDScalar> ev;
-          ev(0)=ev0(0); ev(1)=ev0(1); ev(2)=ev0(2);
-          AutoDScalar riin1 = 0.5 + 0.5* (ev.unit()).dot(Jnv.unit(true));
+          // edge direction is constant, only the current direction carries derivative
+          const VectorValue<Real> ev = (elem->point(edge_nodes.second) - elem->point(edge_nodes.first)).unit();
+          AutoDScalar riin1 = 0.5 + 0.5*(ev(0)*Jn_unit(0) + ev(1)*Jn_unit(1) + ev(2)*Jn_unit(2));
           AutoDScalar riin2 = 1.0 - riin1;
-          AutoDScalar riip2 = 0.5 + 0.5* (ev.unit()).dot(Jpv.unit(true));
+          AutoDScalar riip2 = 0.5 + 0.5*(ev(0)*Jp_unit(0) + ev(1)*Jp_unit(1) + ev(2)*Jp_unit(2));
           AutoDScalar riip1 = 1.0 - riip2;
 
-          switch (get_advanced_model()->II_Force)
+          if (kernel.ii_force == ModelSpecify::ESide)
           {
-              case ModelSpecify::IIForce_EdotJ:
-              Epn = adtl::fmax(E.dot(Jnv.unit(true)), 0.0);
-              Epp = adtl::fmax(E.dot(Jpv.unit(true)), 0.0);
-              IIn = mt->gen->ElecGenRate(T,Epn,Eg);
-              IIp = mt->gen->HoleGenRate(T,Epp,Eg);
-              break;
-              case ModelSpecify::EVector:
-              IIn = mt->gen->ElecGenRate(T,E.size(),Eg);
-              IIp = mt->gen->HoleGenRate(T,E.size(),Eg);
-              break;
-              case ModelSpecify::ESide:
-              IIn = mt->gen->ElecGenRate(T,fabs((V2-V1)/length),Eg);
-              IIp = mt->gen->HoleGenRate(T,fabs((V2-V1)/length),Eg);
-              break;
-              case ModelSpecify::GradQf:
-              IIn = mt->gen->ElecGenRate(T,Jnv.size(),Eg);
-              IIp = mt->gen->HoleGenRate(T,Jpv.size(),Eg);
-              break;
-              default:
-              {
-                MESSAGE<<"ERROR: Unsupported Impact Ionization Type."<<std::endl; RECORD();
-                genius_error();
-              }
+            Fn_ii = fabs((V2-V1)/length);
+            Fp_ii = Fn_ii;
           }
-          GIIn = IIn * fabs(Jn)/e;
-          GIIp = IIp * fabs(Jp)/e;
+
+          AutoDScalar GIIn = mt->gen->ElecGenRate(T,Fn_ii,Eg) * fabs(Jn)/e;
+          AutoDScalar GIIp = mt->gen->HoleGenRate(T,Fp_ii,Eg) * fabs(Jp)/e;
 
           if( fvm_n1->on_processor() )
           {
-            // continuity equation
-            AutoDScalar electron_continuity = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
-            AutoDScalar hole_continuity     = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
-            jac->add_row(  row[1],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
-            jac->add_row(  row[2],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
+            // continuity equation, the same term for electron and hole
+            AutoDScalar continuity = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
+            jac->add_row(  row[1],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac->add_row(  row[2],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
           }
 
           if( fvm_n2->on_processor() )
           {
-            // continuity equation
-            AutoDScalar electron_continuity = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
-            AutoDScalar hole_continuity     = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
-            jac->add_row(  row[4],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
-            jac->add_row(  row[5],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
+            // continuity equation, the same term for electron and hole
+            AutoDScalar continuity = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
+            jac->add_row(  row[4],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac->add_row(  row[5],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
           }
         }
 
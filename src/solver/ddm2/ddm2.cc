@@ -121,6 +121,9 @@ int DDM2Solver::solve()
       case SolverSpecify::TRANSIENT:
       ierr=solve_transient();break;
 
+      case SolverSpecify::PSS:
+      ierr=solve_pss();break;
+
       case SolverSpecify::TRACE:
       ierr=solve_iv_trace();break;
 
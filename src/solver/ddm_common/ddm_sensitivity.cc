@@ -0,0 +1,493 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <cmath>
+
+#include "solver_specify.h"
+#include "physical_unit.h"
+#include "simulation_system.h"
+#include "simulation_region.h"
+#include "boundary_condition_collector.h"
+#include "material.h"
+#include "ddm_solver.h"
+#include "parallel.h"
+#include "MXMLUtil.h"
+
+
+using PhysicalUnit::A;
+using PhysicalUnit::C;
+
+
+namespace
+{
+  /**
+   * difference step of parameter, relative to its value or to its unit when the value is zero
+   */
+  PetscScalar difference_step(PetscScalar p0, PetscScalar unit)
+  { return 1e-6*(p0 != 0.0 ? std::abs(p0) : std::abs(unit)); }
+}
+
+
+
+void DDMSolverBase::sensitivity_parameter_setup(const std::vector<std::string> & labels, std::vector<SensitivityParameter> & paras)
+{
+  paras.clear();
+  for(unsigned int n=0; n<labels.size(); ++n)
+  {
+    const std::string & label = labels[n];
+
+    // region:type:parameter, parameter name may contain ':'
+    std::string::size_type p1 = label.find(':');
+    std::string::size_type p2 = (p1 == std::string::npos) ? p1 : label.find(':', p1+1);
+    if( p2 == std::string::npos )
+    {
+      MESSAGE<<"ERROR: Sensitivity parameter "<<label<<" should be given as region:type:parameter." << std::endl; RECORD();
+      genius_error();
+    }
+    const std::string region_label = label.substr(0, p1);
+    const std::string type = label.substr(p1+1, p2-p1-1);
+    const std::string name = label.substr(p2+1);
+
+    if( !_system.has_region(region_label) )
+    {
+      MESSAGE<<"ERROR: Sensitivity parameter "<<label<<", region "<<region_label<<" can't be found in device structure." << std::endl; RECORD();
+      genius_error();
+    }
+
+    PMI_Server * pmi = _system.region(region_label)->get_material_base()->get_pmi(type);
+    if( !pmi )
+    {
+      MESSAGE<<"ERROR: Sensitivity parameter "<<label<<", region "<<region_label<<" has no PMI of type "<<type<<"." << std::endl; RECORD();
+      genius_error();
+    }
+
+    std::map<std::string, PARA> & para_map = pmi->get_parameter_info();
+    std::map<std::string, PARA>::iterator it = para_map.find(name);
+    if( it == para_map.end() || it->second.type != PARA::Real )
+    {
+      MESSAGE<<"ERROR: Sensitivity parameter "<<label<<", no real parameter "<<name<<" in the "<<type<<" PMI of region "<<region_label<<"." << std::endl; RECORD();
+      genius_error();
+    }
+
+    SensitivityParameter para;
+    para.label       = label;
+    para.pmi         = pmi;
+    para.value       = (PetscScalar *)(it->second.value);
+    para.unit        = it->second.unit_in_real;
+    para.unit_string = it->second.unit_in_string;
+    paras.push_back(para);
+  }
+}
+
+
+
+void DDMSolverBase::sensitivity_setup()
+{
+  this->sensitivity_parameter_setup(SolverSpecify::Sensitivity_Parameter, sens_parameters);
+
+  sens_electrodes.clear();
+  for(unsigned int n=0; n<SolverSpecify::Sensitivity_Electrode.size(); ++n)
+  {
+    const std::string & label = SolverSpecify::Sensitivity_Electrode[n];
+    std::vector<BoundaryCondition *> bcs = _system.get_bcs()->get_bcs_by_electrode_label(label);
+    if( bcs.empty() )
+    {
+      MESSAGE<<"ERROR: Sensitivity electrode "<<label<<" can't be found in device structure." << std::endl; RECORD();
+      genius_error();
+    }
+    sens_electrodes.push_back(bcs);
+  }
+}
+
+
+
+void DDMSolverBase::sensitivity_electrode_current(std::vector<PetscReal> & I) const
+{
+  I.assign(sens_electrodes.size(), 0.0);
+  for(unsigned int k=0; k<sens_electrodes.size(); ++k)
+    for(unsigned int i=0; i<sens_electrodes[k].size(); ++i)
+      I[k] += sens_electrodes[k][i]->ext_circuit()->current();
+}
+
+
+
+void DDMSolverBase::save_electrode_current(std::vector<PetscReal> & state) const
+{
+  state.clear();
+  for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+  {
+    const BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+    if( !bc->is_electrode() ) continue;
+    state.push_back(bc->ext_circuit()->current());
+    state.push_back(bc->ext_circuit()->current_displacement());
+    state.push_back(bc->ext_circuit()->current_electron());
+    state.push_back(bc->ext_circuit()->current_hole());
+  }
+}
+
+
+
+void DDMSolverBase::restore_electrode_current(const std::vector<PetscReal> & state)
+{
+  unsigned int i = 0;
+  for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+  {
+    BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+    if( !bc->is_electrode() ) continue;
+    bc->ext_circuit()->current()              = state[i++];
+    bc->ext_circuit()->current_displacement() = state[i++];
+    bc->ext_circuit()->current_electron()     = state[i++];
+    bc->ext_circuit()->current_hole()         = state[i++];
+  }
+}
+
+
+
+void DDMSolverBase::sensitivity_set_parameter(const SensitivityParameter & para, PetscScalar value)
+{
+  *para.value = value;
+  para.pmi->post_calibrate_process();
+  para.pmi->ClearNodeCache();
+}
+
+
+
+void DDMSolverBase::sensitivity_residual_derivative(const SensitivityParameter & para, Vec dF, std::vector<PetscReal> & dI, Vec work)
+{
+  const PetscScalar p0 = *para.value;
+  const PetscScalar h = difference_step(p0, para.unit);
+
+  // the electrode currents are evaluated together with the residual,
+  // they are local to this processor before summation
+  std::vector<PetscReal> I_plus, I_minus;
+
+  this->sensitivity_set_parameter(para, p0 + h);
+  this->build_petsc_sens_residual(x, dF);
+  this->sensitivity_electrode_current(I_plus);
+
+  this->sensitivity_set_parameter(para, p0 - h);
+  this->build_petsc_sens_residual(x, work);
+  this->sensitivity_electrode_current(I_minus);
+
+  this->sensitivity_set_parameter(para, p0);
+
+  VecAXPY(dF, -1.0, work);
+  VecScale(dF, 0.5/h);
+
+  dI.resize(I_plus.size());
+  for(unsigned int k=0; k<dI.size(); ++k)
+    dI[k] = (I_plus[k] - I_minus[k])*0.5/h;
+  Parallel::sum(dI);
+}
+
+
+
+/* ----------------------------------------------------------------------------
+ * DDMSolverBase::sensitivity_charge_jacobian:  add pQ/px of the electrode charge of bc to pQ_px.
+ * the charge is the electric flux leaving the contact into semiconductor and insulator,
+ *   Q = sum_nb eps*S*(psi - psi_nb)/d
+ * which is linear in psi. psi is the first variable of each node in DDML1, DDML2 and EBML3.
+ */
+void DDMSolverBase::sensitivity_charge_jacobian(const BoundaryCondition * bc, Vec pQ_px) const
+{
+  // for 2D mesh, z_width() is the device dimension in Z direction; for 3D mesh, z_width() is 1.0
+  const PetscScalar charge_scale = bc->z_width();
+
+  std::vector<PetscInt>    iy;
+  std::vector<PetscScalar> y;
+
+  BoundaryCondition::const_node_iterator node_it = bc->nodes_begin();
+  BoundaryCondition::const_node_iterator end_it = bc->nodes_end();
+  for(; node_it!=end_it; ++node_it )
+  {
+    // skip node not belongs to this processor
+    if( (*node_it)->processor_id()!=Genius::processor_id() ) continue;
+
+    BoundaryCondition::const_region_node_iterator rnode_it = bc->region_node_begin(*node_it);
+    BoundaryCondition::const_region_node_iterator rnode_end = bc->region_node_end(*node_it);
+    for(; rnode_it!=rnode_end; ++rnode_it )
+    {
+      if( (*rnode_it).first != SemiconductorRegion && (*rnode_it).first != InsulatorRegion ) continue;
+
+      const FVM_Node * fvm_node = (*rnode_it).second.second;
+      const PetscScalar eps = fvm_node->node_data()->eps();
+
+      FVM_Node::fvm_neighbor_node_iterator nb_it = fvm_node->neighbor_node_begin();
+      for(; nb_it != fvm_node->neighbor_node_end(); ++nb_it)
+      {
+        const FVM_Node *nb_node = (*nb_it).first;
+        PetscScalar distance = (*(fvm_node->root_node()) - *(nb_node->root_node())).size();
+        PetscScalar dQ_dV = charge_scale*eps*fvm_node->cv_surface_area(nb_node)/distance;
+
+        iy.push_back(fvm_node->global_offset());
+        y.push_back(dQ_dV);
+        iy.push_back(nb_node->global_offset());
+        y.push_back(-dQ_dV);
+      }
+    }
+  }
+
+  if(iy.size()) VecSetValues(pQ_px, iy.size(), &iy[0], &y[0], ADD_VALUES);
+  VecAssemblyBegin(pQ_px);
+  VecAssemblyEnd(pQ_px);
+}
+
+
+
+/* ----------------------------------------------------------------------------
+ * DDMSolverBase::sensitivity_analysis:  dI/dp and dQ/dp of converged solution x by adjoint method.
+ * F(x, p) = 0 gives dx/dp = -J^-1 pF/pp, so that
+ *   dI/dp = pI/pp + pI/px dx/dp = pI/pp - lambda^T pF/pp,  with J^T lambda = pI/px
+ * J is the unmodified Jacobian at x, electrode potentials stay coupled to their external
+ * circuits, so the result is taken at the applied bias, the same as the solution tangent.
+ * Q only depends on psi and eps, pQ/pp at fixed x vanishes.
+ */
+void DDMSolverBase::sensitivity_analysis(mxml_node_t *eSolution)
+{
+  START_LOG("sensitivity_analysis()", "DDMSolverBase");
+
+  if( sens_parameters.size() != SolverSpecify::Sensitivity_Parameter.size() ||
+      sens_electrodes.size() != SolverSpecify::Sensitivity_Electrode.size() )
+    this->sensitivity_setup();
+
+  const unsigned int n_electrodes = sens_electrodes.size();
+  const unsigned int n_parameters = sens_parameters.size();
+
+  // electrode state of the converged solution, overwritten by residual evaluations below
+  std::vector<PetscReal> electrode_state;
+  this->save_electrode_current(electrode_state);
+
+  VecDuplicate(x, &pdI_pdx);
+  VecDuplicate(x, &pdF_pdV);
+
+  Vec dF, work;
+  VecDuplicate(x, &dF);
+  VecDuplicate(x, &work);
+
+  this->build_petsc_sens_residual(x, f);
+  this->build_petsc_sens_jacobian(x, &J, &J);
+
+  // pI/px and pQ/px of each electrode.
+  // pI/px is taken from the circuit row by set_trace_electrode, which also overwrites that row of J
+  std::vector<Vec> lambda_I(n_electrodes), lambda_Q(n_electrodes);
+  std::vector<Vec> pI_px(n_electrodes), pQ_px(n_electrodes);
+  for(unsigned int k=0; k<n_electrodes; ++k)
+  {
+    VecDuplicate(x, &lambda_I[k]);
+    VecDuplicate(x, &lambda_Q[k]);
+    VecDuplicate(x, &pI_px[k]);
+    VecDuplicate(x, &pQ_px[k]);
+    VecZeroEntries(pI_px[k]);
+    VecZeroEntries(pQ_px[k]);
+    for(unsigned int i=0; i<sens_electrodes[k].size(); ++i)
+    {
+      this->set_trace_electrode(sens_electrodes[k][i]);
+      VecAXPY(pI_px[k], 1.0, pdI_pdx);
+      this->sensitivity_charge_jacobian(sens_electrodes[k][i], pQ_px[k]);
+    }
+  }
+
+  // restore the circuit rows, the adjoint uses the Jacobian of the nonlinear solve
+  this->build_petsc_sens_jacobian(x, &J, &J);
+
+  // one factorization, two transposed solves for each electrode
+  if( !sens_ksp )
+    create_direct_ksp(sens_ksp, sens_pc);
+#if PETSC_VERSION_GE(3,5,0)
+  KSPSetOperators(sens_ksp, J, J);
+#else
+  KSPSetOperators(sens_ksp, J, J, SAME_NONZERO_PATTERN);
+#endif
+  for(unsigned int k=0; k<n_electrodes; ++k)
+  {
+    KSPSolveTranspose(sens_ksp, pI_px[k], lambda_I[k]);
+    KSPSolveTranspose(sens_ksp, pQ_px[k], lambda_Q[k]);
+  }
+
+  sens_dI_dp.assign(n_electrodes, std::vector<PetscReal>(n_parameters, 0.0));
+  sens_dQ_dp.assign(n_electrodes, std::vector<PetscReal>(n_parameters, 0.0));
+  for(unsigned int p=0; p<n_parameters; ++p)
+  {
+    std::vector<PetscReal> dI;
+    this->sensitivity_residual_derivative(sens_parameters[p], dF, dI, work);
+
+    for(unsigned int k=0; k<n_electrodes; ++k)
+    {
+      PetscScalar lambda_dF;
+      // in A per physical unit of the parameter
+      VecDot(lambda_I[k], dF, &lambda_dF);
+      sens_dI_dp[k][p] = (dI[k] - lambda_dF)*sens_parameters[p].unit/A;
+      // in C per physical unit of the parameter
+      VecDot(lambda_Q[k], dF, &lambda_dF);
+      sens_dQ_dp[k][p] = -lambda_dF*sens_parameters[p].unit/C;
+    }
+  }
+
+  // restore electrode state and the residual of the converged solution
+  this->restore_electrode_current(electrode_state);
+  this->build_petsc_sens_residual(x, f);
+
+  for(unsigned int k=0; k<n_electrodes; ++k)
+  {
+    VecDestroy(PetscDestroyObject(lambda_I[k]));
+    VecDestroy(PetscDestroyObject(lambda_Q[k]));
+    VecDestroy(PetscDestroyObject(pI_px[k]));
+    VecDestroy(PetscDestroyObject(pQ_px[k]));
+  }
+  VecDestroy(PetscDestroyObject(dF));
+  VecDestroy(PetscDestroyObject(work));
+  VecDestroy(PetscDestroyObject(pdI_pdx));
+  VecDestroy(PetscDestroyObject(pdF_pdV));
+
+  // report
+  MESSAGE<<"Sensitivity of electrode current and charge to PMI parameters\n";
+  for(unsigned int k=0; k<n_electrodes; ++k)
+    for(unsigned int p=0; p<n_parameters; ++p)
+    {
+      const std::string unit_string = sens_parameters[p].unit_string.empty() ? std::string("1") : sens_parameters[p].unit_string;
+      MESSAGE<<"  dI(" << SolverSpecify::Sensitivity_Electrode[k] << ")/d(" << sens_parameters[p].label << ") = "
+             << std::scientific << sens_dI_dp[k][p] << " A/" << unit_string << '\n';
+      MESSAGE<<"  dQ(" << SolverSpecify::Sensitivity_Electrode[k] << ")/d(" << sens_parameters[p].label << ") = "
+             << std::scientific << sens_dQ_dp[k][p] << " C/" << unit_string << '\n';
+    }
+  MESSAGE<<'\n';
+  RECORD();
+
+  if ( Genius::processor_id() == 0 && eSolution )
+  {
+    mxml_node_t *eSens = mxmlNewElement(eSolution, "sensitivity");
+    for(unsigned int k=0; k<n_electrodes; ++k)
+    {
+      mxml_node_t *eContact = mxmlNewElement(eSens, "contact");
+      mxml_node_t *eLabel = mxmlNewElement(eContact, "label");
+      mxmlAdd(eLabel, MXML_ADD_AFTER, NULL, MXMLQVariant::makeQVString(SolverSpecify::Sensitivity_Electrode[k]));
+      for(unsigned int p=0; p<n_parameters; ++p)
+      {
+        mxml_node_t *ePara  = mxmlNewElement(eContact, "parameter");
+        mxml_node_t *eName  = mxmlNewElement(ePara, "label");
+        mxmlAdd(eName, MXML_ADD_AFTER, NULL, MXMLQVariant::makeQVString(sens_parameters[p].label));
+        mxml_node_t *eValue = mxmlNewElement(ePara, "dI_dp");
+        mxmlAdd(eValue, MXML_ADD_AFTER, NULL, MXMLQVariant::makeQVFloat(sens_dI_dp[k][p]));
+        mxml_node_t *eCharge = mxmlNewElement(ePara, "dQ_dp");
+        mxmlAdd(eCharge, MXML_ADD_AFTER, NULL, MXMLQVariant::makeQVFloat(sens_dQ_dp[k][p]));
+      }
+    }
+  }
+
+  STOP_LOG("sensitivity_analysis()", "DDMSolverBase");
+}
+
+
+
+/* ----------------------------------------------------------------------------
+ * DDMSolverBase::tangent_analysis:  dI/dp of converged solution x by forward tangent.
+ * F(x, p) = 0 gives J dx/dp = -pF/pp. the equation is solved by the KSP of the last
+ * Newton step, whose preconditioner (or factorization) of J is reused. the total
+ * derivative of electrode current, pI/pp + pI/px dx/dp, is the central difference
+ * along (dx/dp, 1) in (x, p) space.
+ */
+void DDMSolverBase::tangent_analysis()
+{
+  START_LOG("tangent_analysis()", "DDMSolverBase");
+
+  if( tangent_parameters.size() != SolverSpecify::Tangent_Parameter.size() )
+    this->sensitivity_parameter_setup(SolverSpecify::Tangent_Parameter, tangent_parameters);
+
+  const unsigned int n_parameters = tangent_parameters.size();
+
+  std::vector<BoundaryCondition *> electrodes;
+  for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+  {
+    BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+    if( bc->is_electrode() )
+      electrodes.push_back(bc);
+  }
+
+  // electrode state of the converged solution, overwritten by residual evaluations below
+  std::vector<PetscReal> electrode_state;
+  this->save_electrode_current(electrode_state);
+
+  Vec dF, dx, work;
+  VecDuplicate(x, &dF);
+  VecDuplicate(x, &dx);
+  VecDuplicate(x, &work);
+
+  // dI/dp indexed by [electrode][parameter], in current per unit of the parameter
+  std::vector< std::vector<PetscReal> > dI_dp(electrodes.size(), std::vector<PetscReal>(n_parameters, 0.0));
+
+  for(unsigned int p=0; p<n_parameters; ++p)
+  {
+    const SensitivityParameter & para = tangent_parameters[p];
+
+    std::vector<PetscReal> pI_pp;
+    this->sensitivity_residual_derivative(para, dF, pI_pp, work);
+
+    // J dx/dp = -pF/pp
+    VecScale(dF, -1.0);
+    KSPSolve(ksp, dF, dx);
+
+    KSPConvergedReason reason;
+    KSPGetConvergedReason(ksp, &reason);
+    if( reason < 0 )
+    {
+      MESSAGE<<"  Warning: linear solver of solution tangent to " << para.label << " diverged, reason " << reason << ".\n"; RECORD();
+    }
+
+    const PetscScalar p0 = *para.value;
+    const PetscScalar h = difference_step(p0, para.unit);
+
+    std::vector<PetscReal> I_plus(electrodes.size()), I_minus(electrodes.size());
+
+    VecWAXPY(work, h, dx, x);
+    this->sensitivity_set_parameter(para, p0 + h);
+    this->build_petsc_sens_residual(work, dF);
+    for(unsigned int k=0; k<electrodes.size(); ++k)
+      I_plus[k] = electrodes[k]->ext_circuit()->current();
+
+    VecWAXPY(work, -h, dx, x);
+    this->sensitivity_set_parameter(para, p0 - h);
+    this->build_petsc_sens_residual(work, dF);
+    for(unsigned int k=0; k<electrodes.size(); ++k)
+      I_minus[k] = electrodes[k]->ext_circuit()->current();
+
+    this->sensitivity_set_parameter(para, p0);
+
+    // the currents are local to this processor before summation
+    std::vector<PetscReal> dI(electrodes.size());
+    for(unsigned int k=0; k<electrodes.size(); ++k)
+      dI[k] = (I_plus[k] - I_minus[k])*0.5/h;
+    Parallel::sum(dI);
+
+    for(unsigned int k=0; k<electrodes.size(); ++k)
+      dI_dp[k][p] = dI[k]*para.unit;
+  }
+
+  this->restore_electrode_current(electrode_state);
+  for(unsigned int k=0; k<electrodes.size(); ++k)
+    electrodes[k]->ext_circuit()->current_tangent() = dI_dp[k];
+
+  VecDestroy(PetscDestroyObject(dF));
+  VecDestroy(PetscDestroyObject(dx));
+  VecDestroy(PetscDestroyObject(work));
+
+  STOP_LOG("tangent_analysis()", "DDMSolverBase");
+}
@@ -24,6 +24,7 @@
 #include <stack>
 #include <deque>
 #include <numeric>
+#include <algorithm>
 
 
 #include "solver_specify.h"
@@ -34,6 +35,7 @@
 #include "field_source.h"
 #include "ddm_solver.h"
 #include "parallel.h"
+#include "ensemble_queue.h"
 #include "MXMLUtil.h"
 
 
@@ -69,6 +71,12 @@ DDMSolverBase::DDMSolverBase(SimulationSystem & system): FVM_FlexNonlinearSolver
   function_norm             = 0.0;
   functions_norm.resize(9, 0.0);
   nonlinear_iteration       = 0;
+
+  pss_diverged              = false;
+  tran_step_record          = 0;
+  tran_step_replay          = 0;
+
+  sens_ksp                  = PETSC_NULL;
 }
 
 int DDMSolverBase::create_solver()
@@ -189,11 +197,23 @@ int DDMSolverBase::post_solve_process()
       mxmlAdd(eSolution, MXML_ADD_AFTER, NULL, eTerm);
   }
 
+  // tangent and sensitivity of this solution, skip trial solutions which are hidden from hooks.
+  // tangent goes first, it reuses the linear solver of the last Newton step
+  if( !SolverSpecify::Tangent_Parameter.empty() && !hook_list()->muted() )
+    this->tangent_analysis();
+
+  if( !SolverSpecify::Sensitivity_Electrode.empty() && !hook_list()->muted() )
+    this->sensitivity_analysis(eSolution);
+
   return FVM_FlexNonlinearSolver::post_solve_process();
 }
 
 int DDMSolverBase::destroy_solver()
 {
+  // adjoint solver of sensitivity analysis
+  if(sens_ksp)
+    KSPDestroy(PetscDestroyObject(sens_ksp));
+
   // clear nonlinear matrix/vector
   clear_nonlinear_data();
 
@@ -413,12 +433,117 @@ int DDMSolverBase::solve_steadystate()
  * time step set to inf
  */
 int DDMSolverBase::solve_dcsweep()
+{
+  if ( SolverSpecify::Ensemble )
+    return solve_dcsweep_ensemble();
+
+  return solve_dcsweep_scan();
+}
+
+
+
+/* ----------------------------------------------------------------------------
+ * compute a family of dcsweep curves. the ensemble electrode is ramped to the
+ * bias of each branch, then the dcsweep is done.
+ * all the branches start from the same solution, and each ensemble group
+ * takes branches from a shared queue until all the branches are finished.
+ */
+int DDMSolverBase::solve_dcsweep_ensemble()
+{
+  int ierr = 0;
+
+  // save the scan settings, we will use the scan loop for bias ramp
+  const std::vector<std::string> Electrode_VScan = SolverSpecify::Electrode_VScan;
+  const std::vector<std::string> Electrode_IScan = SolverSpecify::Electrode_IScan;
+  const PetscScalar VStart   = SolverSpecify::VStart;
+  const PetscScalar VStep    = SolverSpecify::VStep;
+  const PetscScalar VStepMax = SolverSpecify::VStepMax;
+  const PetscScalar VStop    = SolverSpecify::VStop;
+
+  // the bias of ensemble electrode before any branch
+  _system.get_electrical_source()->update ( 0 );
+  std::vector<BoundaryCondition *> bcs = _system.get_bcs()->get_bcs_by_electrode_label(SolverSpecify::Ensemble_Electrode);
+  genius_assert( !bcs.empty() );
+  const PetscScalar Vbase = bcs[0]->ext_circuit()->Vapp();
+
+  // all the branches start from current solution
+  _system.backup_solution();
+
+  EnsembleQueue queue( SolverSpecify::Ensemble_Values.size() );
+
+  for ( int branch=queue.next(); branch>=0; branch=queue.next() )
+  {
+    const PetscScalar Vbranch = SolverSpecify::Ensemble_Values[branch];
+
+    MESSAGE
+    <<"Ensemble branch " << branch << ": V(" << SolverSpecify::Ensemble_Electrode << ") = " << Vbranch/PhysicalUnit::V <<" V" << '\n'
+    <<"--------------------------------------------------------------------------------\n\n";
+    RECORD();
+
+    _system.restore_solution();
+
+    int branch_ierr = 0;
+
+    // ramp ensemble electrode to the bias of this branch, hooks will not record it
+    SolverSpecify::Ensemble_Branch = -1;
+    if ( std::abs ( Vbranch-Vbase ) > 1e-10*PhysicalUnit::V )
+    {
+      SolverSpecify::Electrode_VScan.assign ( 1, SolverSpecify::Ensemble_Electrode );
+      SolverSpecify::Electrode_IScan.clear();
+      SolverSpecify::VStart   = Vbase;
+      SolverSpecify::VStop    = Vbranch;
+      SolverSpecify::VStep    = Vbranch > Vbase ? SolverSpecify::Ensemble_VStep : -SolverSpecify::Ensemble_VStep;
+      SolverSpecify::VStepMax = SolverSpecify::VStep;
+
+      branch_ierr = solve_dcsweep_scan();
+
+      SolverSpecify::Electrode_VScan = Electrode_VScan;
+      SolverSpecify::Electrode_IScan = Electrode_IScan;
+      SolverSpecify::VStart   = VStart;
+      SolverSpecify::VStep    = VStep;
+      SolverSpecify::VStepMax = VStepMax;
+      SolverSpecify::VStop    = VStop;
+    }
+
+    if ( branch_ierr )
+    {
+      MESSAGE<<"Ensemble branch " << branch << ": bias ramp failed, skip this branch.\n\n\n";
+      RECORD();
+    }
+    else
+    {
+      SolverSpecify::Ensemble_Branch = branch;
+      branch_ierr = solve_dcsweep_scan();
+    }
+
+    ierr = std::max ( ierr, branch_ierr );
+  }
+
+  SolverSpecify::Ensemble_Branch = -1;
+
+  // ensemble groups should have the same state after sweep
+  _system.restore_solution();
+  _system.clear_solution_backup();
+
+  return ierr;
+}
+
+
+
+/* ----------------------------------------------------------------------------
+ * the voltage or current scan loop of dcsweep.
+ */
+int DDMSolverBase::solve_dcsweep_scan()
 {
   int ierr = 0;
 
   // set electrode with transient time 0 value of stimulate source(s)
   _system.get_electrical_source()->update ( 0 );
 
+  // keep the bias of ensemble electrode
+  if ( SolverSpecify::Ensemble && SolverSpecify::Ensemble_Branch >= 0 )
+    _system.get_electrical_source()->assign_voltage_to ( SolverSpecify::Ensemble_Electrode, SolverSpecify::Ensemble_Values[SolverSpecify::Ensemble_Branch] );
+
   // not time dependent
   SolverSpecify::TimeDependent = false;
   SolverSpecify::dt = 1e100;
@@ -998,53 +1123,60 @@ int DDMSolverBase::solve_op()
 
 
 /**
- * create ksp solver for trace mode
+ * create a direct linear solver with J as operator
  */
-void DDMSolverBase::solve_iv_trace_begin()
+void DDMSolverBase::create_direct_ksp(KSP & k, PC & pc)
 {
-  VecDuplicate(x, &pdI_pdx);
-  VecDuplicate(x, &pdF_pdV);
-  VecDuplicate(x, &pdx_pdV);
-
-  // build special linear solver contex
-  {
-    PetscErrorCode ierr;
+  PetscErrorCode ierr;
 
-    ierr = KSPCreate(PETSC_COMM_WORLD, &kspc); genius_assert(!ierr);
+  ierr = KSPCreate(PETSC_COMM_WORLD, &k); genius_assert(!ierr);
 
-    ierr = KSPGetPC(kspc, &pcc); genius_assert(!ierr);
+  ierr = KSPGetPC(k, &pc); genius_assert(!ierr);
 
-    if(Genius::n_processors()>1)
-    {
+  if(Genius::n_processors()>1)
+  {
 #if defined(PETSC_HAVE_SUPERLU_DIST) || defined(PETSC_HAVE_MUMPS)
-      ierr = KSPSetType(kspc, KSPPREONLY); genius_assert(!ierr);
-      ierr = PCSetType(pcc, PCLU); genius_assert(!ierr);
+    ierr = KSPSetType(k, KSPPREONLY); genius_assert(!ierr);
+    ierr = PCSetType(pc, PCLU); genius_assert(!ierr);
 #ifdef PETSC_HAVE_MUMPS
-      ierr = PCFactorSetMatSolverPackage (pcc, "mumps"); genius_assert(!ierr);
+    ierr = PCFactorSetMatSolverPackage (pc, "mumps"); genius_assert(!ierr);
 #else
-      ierr = PCFactorSetMatSolverPackage (pcc, "superlu_dist"); genius_assert(!ierr);
+    ierr = PCFactorSetMatSolverPackage (pc, "superlu_dist"); genius_assert(!ierr);
 #endif
 #else
-      // no parallel LU solver? we have to use krylov method for parallel!
-      ierr = KSPSetType(kspc, KSPBCGS); genius_assert(!ierr);
-      ierr = PCSetType(pcc, PCASM); genius_assert(!ierr);
+    // no parallel LU solver? we have to use krylov method for parallel!
+    ierr = KSPSetType(k, KSPBCGS); genius_assert(!ierr);
+    ierr = PCSetType(pc, PCASM); genius_assert(!ierr);
 #endif
-    }
-    else
-    {
-      ierr = KSPSetType(kspc, KSPPREONLY); genius_assert(!ierr);
-      ierr = PCSetType(pcc, PCLU); genius_assert(!ierr);
+  }
+  else
+  {
+    ierr = KSPSetType(k, KSPPREONLY); genius_assert(!ierr);
+    ierr = PCSetType(pc, PCLU); genius_assert(!ierr);
 #ifdef PETSC_HAVE_MUMPS
-      ierr = PCFactorSetMatSolverPackage (pcc, "mumps"); genius_assert(!ierr);
+    ierr = PCFactorSetMatSolverPackage (pc, "mumps"); genius_assert(!ierr);
 #endif
-    }
+  }
 
 #if PETSC_VERSION_GE(3,5,0)
-      ierr = KSPSetOperators(kspc, J, J);genius_assert(!ierr);
+  ierr = KSPSetOperators(k, J, J);genius_assert(!ierr);
 #else
-      ierr = KSPSetOperators(kspc, J, J, SAME_NONZERO_PATTERN);genius_assert(!ierr);
+  ierr = KSPSetOperators(k, J, J, SAME_NONZERO_PATTERN);genius_assert(!ierr);
 #endif
-  }
+}
+
+
+/**
+ * create ksp solver for trace mode
+ */
+void DDMSolverBase::solve_iv_trace_begin()
+{
+  VecDuplicate(x, &pdI_pdx);
+  VecDuplicate(x, &pdF_pdV);
+  VecDuplicate(x, &pdx_pdV);
+
+  // build special linear solver contex
+  create_direct_ksp(kspc, pcc);
 }
 
 
@@ -1347,6 +1479,15 @@ trace_end:
  * transient simulation!
  */
 int DDMSolverBase::solve_transient()
+{
+  if( SolverSpecify::Parareal )
+    return solve_transient_parareal();
+
+  return solve_transient_march();
+}
+
+
+int DDMSolverBase::solve_transient_march()
 {
   int ierr = 0;
 
@@ -1361,11 +1502,12 @@ int DDMSolverBase::solve_transient()
   SolverSpecify::TimeDependent = true;
 
   // if BDF2 scheme is used, we should set SolverSpecify::BDF2_LowerOrder flag to true
+  // unless the time history is loaded from checkpoint
   if ( SolverSpecify::TS_type==SolverSpecify::BDF2 )
-    SolverSpecify::BDF2_LowerOrder = true;
+    SolverSpecify::BDF2_LowerOrder = SolverSpecify::tran_restart ? SolverSpecify::restart_BDF2_LowerOrder : true;
 
   // we have a previous dc solution
-  if(!SolverSpecify::tran_histroy)
+  if(!SolverSpecify::tran_histroy && !SolverSpecify::tran_restart)
   {
     _system.get_electrical_source()->update ( SolverSpecify::TStart );
     for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
@@ -1382,6 +1524,13 @@ int DDMSolverBase::solve_transient()
   // for the first step, dt equals TStep
   SolverSpecify::dt = SolverSpecify::TStep;
 
+  // or the first recorded step
+  if( tran_step_replay && !tran_step_replay->empty() )
+  {
+    SolverSpecify::clock = tran_step_replay->front();
+    SolverSpecify::dt = SolverSpecify::clock - SolverSpecify::TStart;
+  }
+
   MESSAGE<<"Transient compute from "<<SolverSpecify::TStart/s*1e12
       <<" ps step "<<SolverSpecify::TStep/s*1e12
       <<" ps to "  <<SolverSpecify::TStop/s*1e12<<" ps"
@@ -1401,6 +1550,8 @@ int DDMSolverBase::solve_transient()
 
   std::deque<double> time_step_success;
   double average_time_step = SolverSpecify::dt;
+  // clock of the last accepted step
+  PetscReal clock_accepted = SolverSpecify::TStart;
   // the main loop of transient solver.
   do
   {
@@ -1566,6 +1717,10 @@ int DDMSolverBase::solve_transient()
     SolverSpecify::dt_last_last = SolverSpecify::dt_last;
     SolverSpecify::dt_last = SolverSpecify::dt;
 
+    clock_accepted = SolverSpecify::clock;
+    if( tran_step_record )
+      tran_step_record->push_back(clock_accepted);
+
     // prepare for next time step
     SolverSpecify::dt *= dt_dynamic_factor;
 
@@ -1594,6 +1749,18 @@ int DDMSolverBase::solve_transient()
       SolverSpecify::clock = SolverSpecify::TStop;
     }
 
+    // step to the next recorded clock
+    if( tran_step_replay )
+    {
+      std::vector<PetscReal>::const_iterator next =
+        std::upper_bound(tran_step_replay->begin(), tran_step_replay->end(), clock_accepted + 1e-10*SolverSpecify::dt_last);
+      if( next != tran_step_replay->end() )
+      {
+        SolverSpecify::dt = *next - clock_accepted;
+        SolverSpecify::clock = *next;
+      }
+    }
+
 
     //check if BDF2 can be used?
     if ( SolverSpecify::TS_type==SolverSpecify::BDF2 )
@@ -1662,11 +1829,519 @@ int DDMSolverBase::solve_transient()
 
 
   SolverSpecify::tran_histroy = true;
+  SolverSpecify::tran_restart = false;
+
+  return ierr;
+}
+
+
+
+int DDMSolverBase::transient_integrate(Vec xT)
+{
+  int ierr = this->solve_transient_march();
+
+  // x holds the prediction of next step, load the last solution from system
+  this->diverged_recovery();
+  VecCopy(x, xT);
+
+  return ierr;
+}
+
+
+void DDMSolverBase::transient_load_state(Vec v)
+{
+  // history of external circuit comes from the solution backup
+  _system.restore_solution();
+
+  VecCopy(v, x);
+  this->post_solve_process();
+}
+
+
+#ifdef HAVE_MPI
+/**
+ * exchange the local part of solution vector between processors with the same rank in ensemble groups
+ */
+static void parareal_send(Vec v, int dest, MPI_Comm comm)
+{
+  PetscInt     n;
+  PetscScalar *a;
+  VecGetLocalSize(v, &n);
+  VecGetArray(v, &a);
+  MPI_Send(a, n, MPIU_SCALAR, dest, 0, comm);
+  VecRestoreArray(v, &a);
+}
+
+static void parareal_recv(Vec v, int source, MPI_Comm comm)
+{
+  PetscInt     n;
+  PetscScalar *a;
+  VecGetLocalSize(v, &n);
+  VecGetArray(v, &a);
+  MPI_Recv(a, n, MPIU_SCALAR, source, 0, comm, MPI_STATUS_IGNORE);
+  VecRestoreArray(v, &a);
+}
+
+static void parareal_bcast(Vec v, int root, MPI_Comm comm)
+{
+  PetscInt     n;
+  PetscScalar *a;
+  VecGetLocalSize(v, &n);
+  VecGetArray(v, &a);
+  MPI_Bcast(a, n, MPIU_SCALAR, root, comm);
+  VecRestoreArray(v, &a);
+}
+#endif
+
+
+int DDMSolverBase::solve_transient_parareal()
+{
+  int ierr = 0;
+
+#ifdef HAVE_MPI
+  const int n_slices = Genius::n_ensembles();
+  const int slice    = Genius::ensemble_id();
+
+  const PetscReal t_start = SolverSpecify::TStart;
+  const PetscReal t_stop  = SolverSpecify::TStop;
+  const PetscReal t_slice = (t_stop - t_start)/n_slices;
+  const PetscReal t0 = t_start + slice*t_slice;
+  const PetscReal t1 = slice == n_slices-1 ? t_stop : t0 + t_slice;
+
+  // processors with the same rank in each ensemble group, the rank in this communicator is the slice index
+  MPI_Comm comm_slice;
+  MPI_Comm_split(Genius::comm_ensemble(), Genius::processor_id(), slice, &comm_slice);
+
+  // solution vector should have the same partition in all the groups
+  {
+    PetscInt n_local;
+    VecGetLocalSize(x, &n_local);
+    int n_min, n_max, n = n_local;
+    MPI_Allreduce(&n, &n_min, 1, MPI_INT, MPI_MIN, comm_slice);
+    MPI_Allreduce(&n, &n_max, 1, MPI_INT, MPI_MAX, comm_slice);
+    genius_assert(n_min == n_max);
+  }
+
+  MESSAGE<<"Parareal transient compute from "<<t_start/s*1e12<<" ps to "<<t_stop/s*1e12<<" ps in "
+         <<n_slices<<" time slices, slice "<<slice<<" from "<<t0/s*1e12<<" ps to "<<t1/s*1e12<<" ps"<<'\n';
+  RECORD();
+
+  Vec U, F, G, G_new, U_next;
+  VecDuplicate ( x, &U );
+  VecDuplicate ( x, &F );
+  VecDuplicate ( x, &G );
+  VecDuplicate ( x, &G_new );
+  VecDuplicate ( x, &U_next );
+
+  // trial integrations are neither passed to hooks nor recorded in solution dom
+  mxml_node_t * dom_root = this->solution_dom_root();
+  mxml_node_t * dom_trial = mxmlNewElement(MXML_NO_PARENT, "parareal");
+  this->set_solution_dom_root(dom_trial);
+  hook_list()->mute(true);
+
+  // the initial state, all the slices take external circuit history from it
+  _system.backup_solution();
+  this->diverged_recovery();
+  VecCopy(x, U);
+
+  // coarse sweep to the beginning of this slice
+  for(int k=0; k<slice && !ierr; ++k)
+  {
+    ierr = this->parareal_propagate(U, t_start + k*t_slice, t_start + (k+1)*t_slice, true, U);
+  }
+  if(!ierr)
+    ierr = this->parareal_propagate(U, t0, t1, true, G);
+
+  std::vector<PetscReal> I_old, I_new;
+  for(int it=0; it<SolverSpecify::Parareal_MaxIteration && !ierr; ++it)
+  {
+    // fine propagator, all the slices run concurrently.
+    // slices before the iteration count are exact and do not change any more
+    if( slice >= it )
+    {
+      ierr = this->parareal_propagate(U, t0, t1, false, F);
+      this->parareal_terminal_current(I_new);
+    }
+
+    PetscReal change = it ? 0.0 : 1.0;
+    for(unsigned int n=0; n<I_new.size() && n<I_old.size(); ++n)
+    {
+      const PetscReal I_ref = std::max(std::max(std::abs(I_new[n]), std::abs(I_old[n])), 1e-12*A);
+      change = std::max(change, std::abs(I_new[n]-I_old[n])/I_ref);
+    }
+    I_old = I_new;
+
+    // sequential correction U(k+1) = G(U(k)) + F(U(k)) - G(U(k))_old
+    if( slice > 0 )
+    {
+      parareal_recv(U, slice-1, comm_slice);
+      if( !ierr )
+        ierr = this->parareal_propagate(U, t0, t1, true, G_new);
+    }
+    else
+      VecCopy(G, G_new);
+
+    VecWAXPY(U_next, -1.0, G, F);
+    VecAXPY(U_next, 1.0, G_new);
+    this->projection_positive_density_check(U_next, F);
+    VecCopy(G_new, G);
+
+    if( slice < n_slices-1 )
+      parareal_send(U_next, slice+1, comm_slice);
+
+    PetscReal max_change;
+    int any_ierr;
+    MPI_Allreduce(&change, &max_change, 1, MPIU_REAL, MPI_MAX, Genius::comm_ensemble());
+    MPI_Allreduce(&ierr, &any_ierr, 1, MPI_INT, MPI_MAX, Genius::comm_ensemble());
+    ierr = any_ierr;
+
+    MESSAGE<<"Parareal iteration "<<it<<", max relative change of terminal current "<<max_change<<"\n\n"; RECORD();
+
+    // all the slices are exact after n_slices-1 iterations
+    if( max_change < SolverSpecify::Parareal_Tol || it+2 >= n_slices )
+      break;
+  }
+
+  if( ierr )
+  {
+    MESSAGE<<"------> Transient solver failed in parareal iteration, give up.\n\n\n"; RECORD();
+  }
+
+  // the output run of each slice
+  this->set_solution_dom_root(dom_root);
+  hook_list()->mute(false);
+  if( !ierr )
+    ierr = this->parareal_propagate(U, t0, t1, false, F);
+
+  // all the groups take the final state of the last slice
+  {
+    int any_ierr;
+    MPI_Allreduce(&ierr, &any_ierr, 1, MPI_INT, MPI_MAX, Genius::comm_ensemble());
+    ierr = any_ierr;
+  }
+  if( !ierr )
+  {
+    this->set_solution_dom_root(dom_trial);
+    hook_list()->mute(true);
+
+    parareal_bcast(F, n_slices-1, comm_slice);
+    if( slice != n_slices-1 )
+      this->transient_load_state(F);
+
+    this->set_solution_dom_root(dom_root);
+    hook_list()->mute(false);
+  }
+  mxmlDelete(dom_trial);
+
+  _system.clear_solution_backup();
+
+  SolverSpecify::TStart = t_start;
+  SolverSpecify::TStop  = t_stop;
+  SolverSpecify::clock  = t_stop;
+
+  VecDestroy ( PetscDestroyObject(U) );
+  VecDestroy ( PetscDestroyObject(F) );
+  VecDestroy ( PetscDestroyObject(G) );
+  VecDestroy ( PetscDestroyObject(G_new) );
+  VecDestroy ( PetscDestroyObject(U_next) );
+
+  MPI_Comm_free(&comm_slice);
+#else
+  ierr = solve_transient_march();
+#endif
 
   return ierr;
 }
 
 
+int DDMSolverBase::parareal_propagate(Vec u0, PetscReal t0, PetscReal t1, bool coarse, Vec u1)
+{
+  this->transient_load_state(u0);
+
+  // save time step control of fine propagator
+  SolverSpecify::TemporalScheme TS_type = SolverSpecify::TS_type;
+  bool      AutoStep   = SolverSpecify::AutoStep;
+  bool      RejectStep = SolverSpecify::RejectStep;
+  bool      Predict    = SolverSpecify::Predict;
+  PetscReal TStep      = SolverSpecify::TStep;
+  PetscReal TStepMax   = SolverSpecify::TStepMax;
+
+  SolverSpecify::TStart = t0;
+  SolverSpecify::TStop  = t1;
+
+  // coarse propagator, BDF1 with fixed large step
+  if( coarse )
+  {
+    SolverSpecify::TS_type    = SolverSpecify::BDF1;
+    SolverSpecify::AutoStep   = false;
+    SolverSpecify::RejectStep = false;
+    SolverSpecify::Predict    = false;
+    SolverSpecify::TStep      = (t1-t0)/SolverSpecify::Parareal_CoarseSteps;
+    SolverSpecify::TStepMax   = SolverSpecify::TStep;
+  }
+
+  int ierr = this->transient_integrate(u1);
+
+  SolverSpecify::TS_type    = TS_type;
+  SolverSpecify::AutoStep   = AutoStep;
+  SolverSpecify::RejectStep = RejectStep;
+  SolverSpecify::Predict    = Predict;
+  SolverSpecify::TStep      = TStep;
+  SolverSpecify::TStepMax   = TStepMax;
+
+  return ierr;
+}
+
+
+void DDMSolverBase::parareal_terminal_current(std::vector<PetscReal> & I) const
+{
+  I.clear();
+  for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+  {
+    const BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+    if(bc->is_electrode())
+      I.push_back(bc->ext_circuit()->current());
+  }
+}
+
+
+
+//---------------------------------------------------------------
+// this function is called by PETSc shell matrix to apply the shooting operator
+static PetscErrorCode __genius_pss_shooting_operator(Mat A, Vec w, Vec y)
+{
+  void * ctx;
+  MatShellGetContext(A, &ctx);
+
+  // convert void* to DDMSolverBase*
+  DDMSolverBase * solver = (DDMSolverBase *)ctx;
+  solver->pss_shooting_operator(w, y);
+
+  return 0;
+}
+
+
+int DDMSolverBase::solve_pss()
+{
+  int ierr = 0;
+
+  VecDuplicate ( x, &pss_x0 );
+  VecDuplicate ( x, &pss_xT );
+  VecDuplicate ( x, &pss_scale );
+  VecDuplicate ( x, &pss_work );
+
+  Vec r, dy;
+  VecDuplicate ( x, &r );
+  VecDuplicate ( x, &dy );
+
+  MESSAGE<<"Periodic steady-state by shooting-Newton method, period "
+         <<(SolverSpecify::TStop-SolverSpecify::TStart)/s*1e12<<" ps"<<'\n';
+  RECORD();
+
+  // trial periods are neither passed to hooks nor recorded in solution dom
+  mxml_node_t * dom_root = this->solution_dom_root();
+  mxml_node_t * dom_trial = mxmlNewElement(MXML_NO_PARENT, "pss");
+  this->set_solution_dom_root(dom_trial);
+  hook_list()->mute(true);
+
+  // plain transient periods, let the start-up transient decay
+  for(int k=0; k<SolverSpecify::PSS_Cycles && !ierr; ++k)
+  {
+    MESSAGE<<"PSS transient period "<<k<<'\n'; RECORD();
+    ierr = this->transient_integrate(pss_xT);
+  }
+
+  // the scaled shooting operator as shell matrix, solved by GMRES without preconditioner
+  Mat A;
+  MatCreateShell(PETSC_COMM_WORLD, n_local_dofs, n_local_dofs, n_global_dofs, n_global_dofs, (void *)this, &A);
+  MatShellSetOperation(A, MATOP_MULT, (void(*)(void))__genius_pss_shooting_operator);
+
+  KSP pss_ksp;
+  PC  pss_pc;
+  KSPCreate(PETSC_COMM_WORLD, &pss_ksp);
+#if PETSC_VERSION_GE(3,5,0)
+  KSPSetOperators(pss_ksp, A, A);
+#else
+  KSPSetOperators(pss_ksp, A, A, SAME_NONZERO_PATTERN);
+#endif
+  KSPSetType(pss_ksp, KSPGMRES);
+  KSPGMRESSetRestart(pss_ksp, SolverSpecify::PSS_KSPMaxIteration);
+  KSPGetPC(pss_ksp, &pss_pc);
+  PCSetType(pss_pc, PCNONE);
+  KSPSetTolerances(pss_ksp, 1e-2, 1e-20, PETSC_DEFAULT, SolverSpecify::PSS_KSPMaxIteration);
+
+  bool converged = false;
+  for(int it=0; it<SolverSpecify::PSS_MaxIteration && !ierr; ++it)
+  {
+    // the state at the beginning of this period, perturbed periods start from it
+    _system.backup_solution();
+    this->diverged_recovery();
+    VecCopy(x, pss_x0);
+    this->pss_build_scale(pss_x0);
+
+    // the perturbed periods replay the time steps of this period
+    pss_steps.clear();
+    tran_step_record = &pss_steps;
+    ierr = this->transient_integrate(pss_xT);
+    tran_step_record = 0;
+    if(ierr) break;
+
+    // scaled periodic mismatch
+    PetscReal mismatch;
+    VecWAXPY(r, -1.0, pss_x0, pss_xT);
+    VecPointwiseDivide(r, r, pss_scale);
+    VecNorm(r, NORM_INFINITY, &mismatch);
+
+    MESSAGE<<"PSS shooting-Newton iteration "<<it<<", periodic mismatch "<<mismatch<<"\n\n"; RECORD();
+    if(mismatch < SolverSpecify::PSS_Tol)
+    {
+      converged = true;
+      break;
+    }
+
+    // Newton step (M-I) dy = -r, each GMRES iteration integrates one period
+    VecScale(r, -1.0);
+    pss_diverged = false;
+    KSPSolve(pss_ksp, r, dy);
+
+    KSPConvergedReason reason;
+    PetscInt its;
+    KSPGetConvergedReason(pss_ksp, &reason);
+    KSPGetIterationNumber(pss_ksp, &its);
+    MESSAGE<<"PSS GMRES "<<KSPConvergedReasons[reason]<<", "<<its<<" periods integrated\n\n"; RECORD();
+
+    if(pss_diverged)
+    {
+      MESSAGE<<"------> Transient solver failed in perturbed period, give up PSS.\n\n\n"; RECORD();
+      ierr = 1;
+      break;
+    }
+
+    // new initial state
+    VecPointwiseMult(dy, dy, pss_scale);
+    VecWAXPY(pss_work, 1.0, dy, pss_x0);
+    this->projection_positive_density_check(pss_work, pss_x0);
+    this->transient_load_state(pss_work);
+  }
+
+  if(!ierr && !converged)
+  {
+    MESSAGE<<"------> PSS shooting-Newton not converged after "<<SolverSpecify::PSS_MaxIteration<<" iterations.\n\n\n"; RECORD();
+    ierr = 1;
+  }
+
+  KSPDestroy(PetscDestroyObject(pss_ksp));
+  MatDestroy(PetscDestroyObject(A));
+  _system.clear_solution_backup();
+
+  this->set_solution_dom_root(dom_root);
+  mxmlDelete(dom_trial);
+  hook_list()->mute(false);
+
+  // the last period is solved again and recorded as transient result, only for a periodic steady-state
+  if(!ierr)
+  {
+    MESSAGE<<"PSS output period\n"; RECORD();
+    SolverSpecify::Type = SolverSpecify::TRANSIENT;
+    ierr = this->solve_transient();
+  }
+
+  VecDestroy ( PetscDestroyObject(r) );
+  VecDestroy ( PetscDestroyObject(dy) );
+  VecDestroy ( PetscDestroyObject(pss_x0) );
+  VecDestroy ( PetscDestroyObject(pss_xT) );
+  VecDestroy ( PetscDestroyObject(pss_scale) );
+  VecDestroy ( PetscDestroyObject(pss_work) );
+
+  return ierr;
+}
+
+
+void DDMSolverBase::pss_build_scale(Vec v)
+{
+  // carrier density and temperature are scaled by their magnitude
+  VecCopy(v, pss_scale);
+  VecAbs(pss_scale);
+  VecShift(pss_scale, 1.0*std::pow(PhysicalUnit::cm, -3));
+
+  // potential is scaled by thermal voltage, it is always the first dof of a node
+  const PetscScalar Vt = PhysicalUnit::kb*_system.T_external()/PhysicalUnit::e;
+
+  std::vector<PetscInt> ix;
+  for(unsigned int n=0; n<_system.n_regions(); n++)
+  {
+    const SimulationRegion * region = _system.region(n);
+    if(this->node_dofs(region) == 0) continue;
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+      ix.push_back((*it)->global_offset());
+  }
+
+  // electrode potential
+  if(Genius::is_last_processor())
+  {
+    for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+    {
+      BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+      if(bc->is_electrode() && this->bc_dofs(bc) > 0)
+        ix.push_back(bc->global_offset());
+    }
+  }
+
+  std::vector<PetscScalar> y(ix.size(), Vt);
+  if(!ix.empty())
+    VecSetValues(pss_scale, ix.size(), &ix[0], &y[0], INSERT_VALUES);
+
+  VecAssemblyBegin(pss_scale);
+  VecAssemblyEnd(pss_scale);
+}
+
+
+void DDMSolverBase::pss_shooting_operator(Vec w, Vec y)
+{
+  PetscReal wnorm;
+  VecNorm(w, NORM_INFINITY, &wnorm);
+  if(wnorm == 0.0)
+  {
+    VecZeroEntries(y);
+    return;
+  }
+
+  // finite difference of the period map in scaled variables. the perturbation is
+  // kept well above the nonlinear tolerance of each time step
+  const PetscReal h = 1e-5/wnorm;
+
+  VecPointwiseMult(pss_work, w, pss_scale);
+  VecAYPX(pss_work, h, pss_x0);
+  this->transient_load_state(pss_work);
+
+  // same time steps as the unperturbed period, else the difference is dominated
+  // by step selection of the LTE control instead of the period map
+  bool AutoStep   = SolverSpecify::AutoStep;
+  bool RejectStep = SolverSpecify::RejectStep;
+  bool Predict    = SolverSpecify::Predict;
+  SolverSpecify::AutoStep   = false;
+  SolverSpecify::RejectStep = false;
+  SolverSpecify::Predict    = false;
+  tran_step_replay = &pss_steps;
+
+  if( this->transient_integrate(y) )
+    pss_diverged = true;
+
+  tran_step_replay = 0;
+  SolverSpecify::AutoStep   = AutoStep;
+  SolverSpecify::RejectStep = RejectStep;
+  SolverSpecify::Predict    = Predict;
+
+  // y = D^-1 (Phi(x0 + h D w) - Phi(x0))/h - w
+  VecAXPY(y, -1.0, pss_xT);
+  VecPointwiseDivide(y, y, pss_scale);
+  VecScale(y, 1.0/h);
+  VecAXPY(y, -1.0, w);
+}
+
+
 
 int DDMSolverBase::snes_solve_pseudo_time_step()
 {
@@ -2036,3 +2711,99 @@ void DDMSolverBase::petsc_ksp_convergence_test ( PetscInt its, PetscReal rnorm,
   */
 }
 
+
+
+/*------------------------------------------------------------------
+ * split the dofs for physics block preconditioner
+ */
+void DDMSolverBase::build_field_split(SolverSpecify::PreconditionerType type,
+                                      std::vector<std::string> & names,
+                                      std::vector< std::vector<PetscInt> > & dofs) const
+{
+  names.clear();
+  dofs.clear();
+
+  if(type == SolverSpecify::FIELDSPLIT_REGION_PRECOND)
+  {
+    names.push_back("semiconductor");
+    names.push_back("insulator");
+    names.push_back("conductor");
+  }
+  else if(type == SolverSpecify::FIELDSPLIT_SCHUR_PRECOND)
+  {
+    names.push_back("potential");
+    names.push_back("transport");
+  }
+  else
+  {
+    names.push_back("potential");
+    names.push_back("carrier");
+    names.push_back("temperature");
+  }
+  // Schur complement only accepts two splits, electrode dofs go with transport
+  if(type != SolverSpecify::FIELDSPLIT_SCHUR_PRECOND)
+    names.push_back("electrode");
+  dofs.resize(names.size());
+
+  // the last split gets all the dofs not owned by any node
+  const unsigned int electrode_split = names.size()-1;
+
+  PetscInt lo, hi;
+  VecGetOwnershipRange(x, &lo, &hi);
+  std::vector<bool> assigned(hi-lo, false);
+
+  for(unsigned int n=0; n<_system.n_regions(); n++)
+  {
+    const SimulationRegion * region = _system.region(n);
+    const unsigned int n_node_var = this->node_dofs(region);
+    if(n_node_var == 0) continue;
+
+    unsigned int region_split = electrode_split;
+    switch(region->type())
+    {
+        case SemiconductorRegion : region_split = 0; break;
+        case InsulatorRegion     : region_split = 1; break;
+        case ElectrodeRegion     :
+        case MetalRegion         : region_split = 2; break;
+        default : break;
+    }
+
+    // which split each node dof belongs to, the dof layout is the same for all the nodes of a region
+    std::vector<unsigned int> var_split(n_node_var, electrode_split);
+    for(unsigned int i=0; i<n_node_var; ++i)
+    {
+      if(type == SolverSpecify::FIELDSPLIT_REGION_PRECOND)
+      {
+        var_split[i] = region_split;
+        continue;
+      }
+
+      // psi is always at offset 0, followed by carriers. the rest are temperatures
+      bool carrier = (region->ebm_variable_offset(ELECTRON) == i || region->ebm_variable_offset(HOLE) == i);
+      if(i == 0)
+        var_split[i] = 0;
+      else if(type == SolverSpecify::FIELDSPLIT_SCHUR_PRECOND)
+        var_split[i] = 1;
+      else
+        var_split[i] = carrier ? 1 : 2;
+    }
+
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+    {
+      const PetscInt offset = (*it)->global_offset();
+      for(unsigned int i=0; i<n_node_var; ++i)
+      {
+        dofs[var_split[i]].push_back(offset+i);
+        assigned[offset+i-lo] = true;
+      }
+    }
+  }
+
+  // bc and circuit dofs are held by the last processor
+  for(PetscInt i=lo; i<hi; ++i)
+    if(!assigned[i-lo])
+      dofs[electrode_split].push_back(i);
+}
+
@@ -22,6 +22,8 @@
 //  $Id: doping_analytic.cc,v 1.10 2008/07/09 05:58:16 gdiso Exp $
 
 
+#include <limits>
+
 #include "polygon.h"
 #include "mesh_base.h"
 #include "doping_analytic/doping_fun.h"
@@ -33,6 +35,7 @@
 #include "interpolation_2d_nn.h"
 //#include "interpolation_3d_qshep.h"
 #include "interpolation_3d_nbtet.h"
+#include "interpolation_kdtree.h"
 
 using PhysicalUnit::cm;
 using PhysicalUnit::um;
@@ -263,6 +266,20 @@ void DopingAnalytic::set_doping_function_file(const Parser::Card & c)
 
   interpolator->set_interpolation_type(0, InterpolationBase::Linear);
 
+  // local kd-tree interpolation for large 2D/3D profile, done in asinh space
+  if(c.is_enum_value("interpolation", "kdtree") && axes>=AXES_XY)
+  {
+    delete interpolator;
+    interpolator = new Interpolation_KDTree(axes==AXES_XYZ ? 3 : 2);
+    interpolator->set_interpolation_type(0, InterpolationBase::Asinh);
+    std::stringstream k, threads;
+    k << "k=" << c.get_int("interpolation.k", axes==AXES_XYZ ? 12 : 8);
+    threads << "threads=" << c.get_int("interpolation.threads", 1);
+    interpolator->set_option(k.str());
+    interpolator->set_option(threads.str());
+    interpolator->set_option(c.is_enum_value("interpolation.fit", "idw") ? "idw" : "mls");
+  }
+
   Point p;
   double doping;
 
@@ -1028,16 +1045,21 @@ void DopingAnalytic::_doping_data_apply(std::pair<int, InterpolationBase * > df,
     if(region->type() != SemiconductorRegion) continue;
     if( !region_app.empty() && region->name()!=region_app) continue;
         
-    SimulationRegion::local_node_iterator node_it = region->on_local_nodes_begin();
-    SimulationRegion::local_node_iterator node_it_end = region->on_local_nodes_end();
-    for(; node_it!=node_it_end; ++node_it)
+    std::vector<FVM_Node *> fvm_nodes(region->on_local_nodes_begin(), region->on_local_nodes_end());
+    std::vector<const Node *> nodes;
+    for(unsigned int i=0; i<fvm_nodes.size(); ++i)
+      nodes.push_back(fvm_nodes[i]->root_node());
+
+    std::vector<double> values;
+    _do_data_interp(df, nodes, values);
+
+    for(unsigned int i=0; i<fvm_nodes.size(); ++i)
     {
-      FVM_Node * fvm_node = *node_it;
+      FVM_Node * fvm_node = fvm_nodes[i];
       FVM_NodeData * node_data = fvm_node->node_data();
       genius_assert(node_data!=NULL);
 
-      const Node * node = fvm_node->root_node();
-      double d = _do_data_interp(df, node);
+      double d = values[i];
       double dop_Na = std::abs(d < 0.0 ? d: 0.0);  
       double dop_Nd = std::abs(d > 0.0 ? d: 0.0);  
 
@@ -1059,16 +1081,21 @@ void DopingAnalytic::_custom_profile_data_apply(const std::string &ion, std::pai
     unsigned int ion_index = region->add_variable(SimulationVariable(ion, SCALAR, POINT_CENTER, "cm^-3", invalid_uint, true, true));
     int ion_type = semiconductor_region ? semiconductor_region->material()->band->IonType(ion) : 0;
     
-    SimulationRegion::local_node_iterator node_it = region->on_local_nodes_begin();
-    SimulationRegion::local_node_iterator node_it_end = region->on_local_nodes_end();
-    for(; node_it!=node_it_end; ++node_it)
+    std::vector<FVM_Node *> fvm_nodes(region->on_local_nodes_begin(), region->on_local_nodes_end());
+    std::vector<const Node *> nodes;
+    for(unsigned int i=0; i<fvm_nodes.size(); ++i)
+      nodes.push_back(fvm_nodes[i]->root_node());
+
+    std::vector<double> values;
+    _do_data_interp(df, nodes, values, ion);
+
+    for(unsigned int i=0; i<fvm_nodes.size(); ++i)
     {
-      FVM_Node * fvm_node = *node_it;
+      FVM_Node * fvm_node = fvm_nodes[i];
       FVM_NodeData * node_data = fvm_node->node_data();
       genius_assert(node_data!=NULL);
 
-      const Node * node = fvm_node->root_node();
-      double d = _do_data_interp(df, node);
+      double d = values[i];
       
       node_data->data<PetscScalar>(ion_index) = d;
       if(ion_type < 0 ) node_data->Na() += d;
@@ -1079,56 +1106,71 @@ void DopingAnalytic::_custom_profile_data_apply(const std::string &ion, std::pai
 }
 
 
-double DopingAnalytic::_do_data_interp(std::pair<int, InterpolationBase * > df, const Node *node, const std::string &msg)
+void DopingAnalytic::_do_data_interp(std::pair<int, InterpolationBase * > df, const std::vector<const Node *> &nodes,
+                                     std::vector<double> &values, const std::string &msg)
 {
   int axes = df.first;
   InterpolationBase * interp = df.second;
 
-  Point p;
-  switch(axes)
+  std::vector<Point> points(nodes.size());
+  for(unsigned int n=0; n<nodes.size(); ++n)
   {
-    case AXES_X:
-      p[0]=(*node)(0);
-      break;
-    case AXES_Y:
-      p[0]=(*node)(1);
-      break;
-    case AXES_Z:
-      p[0]=(*node)(2);
-      break;
-    case AXES_XY:
-      p[0]=(*node)(0);
-      p[1]=(*node)(1);
-      break;
-    case AXES_XZ:
-      p[0]=(*node)(0);
-      p[1]=(*node)(2);
-      break;
-    case AXES_YZ:
-      p[0]=(*node)(1);
-      p[1]=(*node)(2);
-      break;
-    case AXES_XYZ:
-      p[0]=(*node)(0);
-      p[1]=(*node)(1);
-      p[2]=(*node)(2);
-      break;
-  }
-
-  double d = interp->get_interpolated_value(p, 0);
-#if defined(HAVE_FENV_H) && defined(DEBUG)
-  if(fetestexcept(FE_INVALID|FE_DIVBYZERO|FE_OVERFLOW))
+    const Node * node = nodes[n];
+    Point & p = points[n];
+    switch(axes)
+    {
+      case AXES_X:
+        p[0]=(*node)(0);
+        break;
+      case AXES_Y:
+        p[0]=(*node)(1);
+        break;
+      case AXES_Z:
+        p[0]=(*node)(2);
+        break;
+      case AXES_XY:
+        p[0]=(*node)(0);
+        p[1]=(*node)(1);
+        break;
+      case AXES_XZ:
+        p[0]=(*node)(0);
+        p[1]=(*node)(2);
+        break;
+      case AXES_YZ:
+        p[0]=(*node)(1);
+        p[1]=(*node)(2);
+        break;
+      case AXES_XYZ:
+        p[0]=(*node)(0);
+        p[1]=(*node)(1);
+        p[2]=(*node)(2);
+        break;
+    }
+  }
+
+  // all the local nodes are interpolated in one batch
+  interp->get_interpolated_values(points, 0, values);
+
+  double unit = 1.0/std::pow(PhysicalUnit::cm,3.0);
+  for(unsigned int n=0; n<nodes.size(); ++n)
   {
-    MESSAGE<< "Warning: problem in interpolating " << msg << " at ";
-    MESSAGE<< (*node)(0)/um << "\t";
-    MESSAGE<< (*node)(1)/um << "\t";
-    MESSAGE<< (*node)(2)/um << " " << d << " , ignored.\n";
-    RECORD();
-    feclearexcept(FE_ALL_EXCEPT);
+#ifdef DEBUG
+    // threads have their own fenv, check the value instead
+    if(values[n] != values[n] || std::abs(values[n]) > std::numeric_limits<double>::max())
+    {
+      const Node * node = nodes[n];
+      MESSAGE<< "Warning: problem in interpolating " << msg << " at ";
+      MESSAGE<< (*node)(0)/um << "\t";
+      MESSAGE<< (*node)(1)/um << "\t";
+      MESSAGE<< (*node)(2)/um << " " << values[n] << " , ignored.\n";
+      RECORD();
+    }
+#endif
+    values[n] *= unit;
   }
+#if defined(HAVE_FENV_H) && defined(DEBUG)
+  feclearexcept(FE_ALL_EXCEPT);
 #endif
-  double unit = 1.0/std::pow(PhysicalUnit::cm,3.0);
-  return unit*d;
 }
 
 
@@ -133,6 +133,9 @@ int EBM3Solver::solve()
       case SolverSpecify::TRANSIENT:
       ierr=solve_transient();break;
 
+      case SolverSpecify::PSS:
+      ierr=solve_pss();break;
+
       case SolverSpecify::TRACE:
       ierr=solve_iv_trace();break;
 
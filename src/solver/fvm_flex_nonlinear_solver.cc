@@ -1104,6 +1104,103 @@ void FVM_FlexNonlinearSolver::set_petsc_preconditioner_type()
 
       }
 
+      // physics block preconditioner, the splits are built from dof map by derived solver
+      case SolverSpecify::FIELDSPLIT_PRECOND:
+      case SolverSpecify::FIELDSPLIT_SCHUR_PRECOND:
+      case SolverSpecify::FIELDSPLIT_REGION_PRECOND:
+      {
+        std::vector<std::string> split_names;
+        std::vector< std::vector<PetscInt> > split_dofs;
+        this->build_field_split(_preconditioner_type, split_names, split_dofs);
+
+        // remove the splits which are empty on all the processors
+        std::vector<std::string> names;
+        std::vector< std::vector<PetscInt> > dofs;
+        for(unsigned int i=0; i<split_names.size(); ++i)
+        {
+          unsigned int n_split_dofs = split_dofs[i].size();
+          Parallel::sum(n_split_dofs);
+          if(n_split_dofs == 0) continue;
+          names.push_back(split_names[i]);
+          dofs.push_back(split_dofs[i]);
+        }
+
+        bool schur = (_preconditioner_type == SolverSpecify::FIELDSPLIT_SCHUR_PRECOND);
+        if( names.size() < 2 || (schur && names.size() != 2) )
+        {
+          MESSAGE << "Warning:  field split is not available for this solver, use ASM instead!" << std::endl;
+          RECORD();
+          ierr = PCSetType (pc, (char*) PCASM);       genius_assert(!ierr);
+          ierr = set_petsc_option("-sub_pc_type","ilu"); genius_assert(!ierr);
+          ierr = set_petsc_option("-sub_pc_factor_shift_type","NONZERO"); genius_assert(!ierr);
+          return;
+        }
+
+        MESSAGE<< "Using field split preconditioner with "<< names.size() << " blocks..."<<std::endl;
+        RECORD();
+        ierr = PCSetType (pc, (char*) PCFIELDSPLIT);  genius_assert(!ierr);
+
+        for(unsigned int i=0; i<names.size(); ++i)
+        {
+          IS is;
+          PetscInt * is_dofs = dofs[i].empty() ? PETSC_NULL : &(dofs[i][0]);
+#if PETSC_VERSION_GE(3,2,0)
+          ierr = ISCreateGeneral(PETSC_COMM_WORLD, dofs[i].size(), is_dofs, PETSC_COPY_VALUES, &is); genius_assert(!ierr);
+#else
+          ierr = ISCreateGeneral(PETSC_COMM_WORLD, dofs[i].size(), is_dofs, &is); genius_assert(!ierr);
+#endif
+          ierr = PCFieldSplitSetIS(pc, names[i].c_str(), is); genius_assert(!ierr);
+          ierr = ISDestroy(PetscDestroyObject(is)); genius_assert(!ierr);
+
+          // sub block solved by one sweep of its preconditioner
+          const std::string prefix = "-fieldsplit_" + names[i];
+          ierr = set_petsc_option(prefix + "_ksp_type", "preonly"); genius_assert(!ierr);
+
+          // the Poisson block is elliptic and solved by AMG
+          if(names[i] == "potential")
+          {
+#ifdef PETSC_HAVE_LIBHYPRE
+            ierr = set_petsc_option(prefix + "_pc_type", "hypre"); genius_assert(!ierr);
+            ierr = set_petsc_option(prefix + "_pc_hypre_type", "boomeramg"); genius_assert(!ierr);
+#else
+            ierr = set_petsc_option(prefix + "_pc_type", "gamg"); genius_assert(!ierr);
+#endif
+            continue;
+          }
+
+          // others are transport blocks, ILU in serial and ASM/ILU in parallel
+          if (Genius::n_processors() > 1)
+          {
+            ierr = set_petsc_option(prefix + "_pc_type", "asm"); genius_assert(!ierr);
+            ierr = set_petsc_option(prefix + "_sub_pc_type", "ilu"); genius_assert(!ierr);
+            ierr = set_petsc_option(prefix + "_sub_pc_factor_shift_type", "NONZERO"); genius_assert(!ierr);
+          }
+          else
+          {
+            ierr = set_petsc_option(prefix + "_pc_type", "ilu"); genius_assert(!ierr);
+            ierr = set_petsc_option(prefix + "_pc_factor_shift_type", "NONZERO"); genius_assert(!ierr);
+          }
+        }
+
+        if(schur)
+        {
+          // eliminate the first block, Schur complement approximated by the second block
+          ierr = PCFieldSplitSetType(pc, PC_COMPOSITE_SCHUR); genius_assert(!ierr);
+#if PETSC_VERSION_GE(3,3,0)
+          ierr = PCFieldSplitSetSchurFactType(pc, PC_FIELDSPLIT_SCHUR_FACT_FULL); genius_assert(!ierr);
+#endif
+#if PETSC_VERSION_GE(3,5,0)
+          ierr = PCFieldSplitSetSchurPre(pc, PC_FIELDSPLIT_SCHUR_PRE_SELFP, PETSC_NULL); genius_assert(!ierr);
+#endif
+        }
+        else
+        {
+          // block Gauss-Seidel over the splits
+          ierr = PCFieldSplitSetType(pc, PC_COMPOSITE_MULTIPLICATIVE); genius_assert(!ierr);
+        }
+        return;
+      }
+
       case SolverSpecify::JACOBI_PRECOND:
       ierr = PCSetType (pc, (char*) PCJACOBI);    genius_assert(!ierr); return;
 
@@ -27,6 +27,7 @@
 #include "interpolation_2d_nn.h"
 //#include "interpolation_3d_qshep.h"
 #include "interpolation_3d_nbtet.h"
+#include "interpolation_kdtree.h"
 #include "parallel.h"
 
 using PhysicalUnit::cm;
@@ -182,6 +183,21 @@ void MoleAnalytic::set_mole_function_file(const Parser::Card & c)
     interpolatorY = new Interpolation3D_nbtet; // 3D profile
   }
 
+  // local kd-tree interpolation for large 2D/3D profile
+  if(c.is_enum_value("interpolation", "kdtree") && axes>=AXES_XY)
+  {
+    delete interpolatorX;
+    delete interpolatorY;
+    interpolatorX = new Interpolation_KDTree(axes==AXES_XYZ ? 3 : 2);
+    interpolatorY = new Interpolation_KDTree(axes==AXES_XYZ ? 3 : 2);
+    std::stringstream k;
+    k << "k=" << c.get_int("interpolation.k", axes==AXES_XYZ ? 12 : 8);
+    interpolatorX->set_option(k.str());
+    interpolatorY->set_option(k.str());
+    interpolatorX->set_option(c.is_enum_value("interpolation.fit", "idw") ? "idw" : "mls");
+    interpolatorY->set_option(c.is_enum_value("interpolation.fit", "idw") ? "idw" : "mls");
+  }
+
   interpolatorX->set_interpolation_type(0, InterpolationBase::Linear);
   interpolatorY->set_interpolation_type(0, InterpolationBase::Linear);
 
@@ -67,6 +67,7 @@ int SolverBase::post_solve_process()
 void SolverBase::set_solution_dom_root(mxml_node_t* root)
 {
   _dom_solution_root = root;
+  _dom_curr_solution = NULL;
 }
 
 mxml_node_t* SolverBase::new_dom_solution_elem() const
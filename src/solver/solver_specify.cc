@@ -70,6 +70,22 @@ namespace SolverSpecify
    */
   bool      out_append;
 
+  /**
+   * hooks write output files by background I/O thread
+   */
+  bool      out_async;
+  bool      out_binary;
+
+  /**
+   * memory limit of queued output snapshots, in MB
+   */
+  double    out_async_buffer;
+
+  /**
+   * policy when the output queue is full: block, drop or coalesce
+   */
+  std::string  out_async_policy;
+
   /**
    * hooks to be installed \<id \<hook_name, hook_parameters\> \>
    */
@@ -400,6 +416,59 @@ namespace SolverSpecify
    */
   bool      tran_histroy;
 
+  /**
+   * true when the transient state is loaded from checkpoint, the next
+   * transient solve continues from it. it is not reset by set_default_parameter()
+   */
+  bool      tran_restart = false;
+
+  /**
+   * time, time step and BDF2 order flag loaded from checkpoint
+   */
+  double    restart_clock = 0.0;
+  double    restart_dt = 0.0;
+  bool      restart_BDF2_LowerOrder = true;
+
+  /**
+   * number of plain transient periods before shooting-Newton iteration of PSS solution
+   */
+  int       PSS_Cycles;
+
+  /**
+   * max shooting-Newton iteration of PSS solution
+   */
+  int       PSS_MaxIteration;
+
+  /**
+   * max GMRES iteration on the monodromy operator in each shooting-Newton step
+   */
+  int       PSS_KSPMaxIteration;
+
+  /**
+   * tolerance of scaled periodic mismatch |x(T)-x(0)|
+   */
+  double    PSS_Tol;
+
+  /**
+   * parareal transient, each ensemble group integrates one time slice
+   */
+  bool      Parareal;
+
+  /**
+   * number of BDF1 steps of coarse propagator in each time slice
+   */
+  int       Parareal_CoarseSteps;
+
+  /**
+   * max parareal iteration
+   */
+  int       Parareal_MaxIteration;
+
+  /**
+   * relative tolerance of terminal current changes between parareal iterations
+   */
+  double    Parareal_Tol;
+
   /**
    * current time
    */
@@ -496,6 +565,54 @@ namespace SolverSpecify
    */
   int       DC_Cycles;
 
+  /**
+   * do ensemble DC sweep, each branch is distributed to an ensemble group
+   */
+  bool      Ensemble;
+
+  /**
+   * electrode which is biased differently for each ensemble branch
+   */
+  std::string     Ensemble_Electrode;
+
+  /**
+   * the bias of Ensemble_Electrode for each branch
+   */
+  std::vector<double>    Ensemble_Values;
+
+  /**
+   * voltage step used to ramp Ensemble_Electrode to the branch bias
+   */
+  double    Ensemble_VStep;
+
+  /**
+   * the branch index being solved, -1 for no branch (i.e. bias ramp)
+   */
+  int       Ensemble_Branch;
+
+  /**
+   * electrodes whose current sensitivity to PMI parameters is computed
+   * at each converged solution by adjoint method
+   */
+  std::vector<std::string>    Sensitivity_Electrode;
+
+  /**
+   * PMI parameters for sensitivity analysis, each is given as region:type:parameter
+   */
+  std::vector<std::string>    Sensitivity_Parameter;
+
+  /**
+   * PMI parameters whose solution tangent dx/dp is computed at each converged stationary
+   * solution, each is given as region:type:parameter
+   */
+  std::vector<std::string>    Tangent_Parameter;
+
+  /**
+   * parameter change of each tangent for first order extrapolation of electrode current,
+   * in the unit of the parameter
+   */
+  std::vector<double>         Tangent_Delta;
+
   /**
    * use node set, only for mixA solver
    */
@@ -716,6 +833,10 @@ namespace SolverSpecify
 #endif
 
     out_append        = false;
+    out_async         = false;
+    out_binary        = false;
+    out_async_buffer  = 256;
+    out_async_policy  = "block";
 
     Damping           = DampingPotential;
     VoronoiTruncation = VoronoiTruncationAlways;
@@ -765,6 +886,14 @@ namespace SolverSpecify
     UIC                       = false;
     tran_op                   = true;
     tran_histroy              = false;
+    PSS_Cycles                = 1;
+    PSS_MaxIteration          = 10;
+    PSS_KSPMaxIteration       = 20;
+    PSS_Tol                   = 1e-3;
+    Parareal                  = false;
+    Parareal_CoarseSteps      = 4;
+    Parareal_MaxIteration     = 10;
+    Parareal_Tol              = 1e-3;
     AutoStep                  = true;
     RejectStep                = true;
     Predict                   = true;
@@ -780,6 +909,15 @@ namespace SolverSpecify
     Electrode_VScan_Voltage = 0.0;
     Electrode_IScan_Current = 0.0;
 
+    Ensemble          = false;
+    Ensemble_VStep    = 0.1*V;
+    Ensemble_Branch   = -1;
+
+    Sensitivity_Electrode.clear();
+    Sensitivity_Parameter.clear();
+    Tangent_Parameter.clear();
+    Tangent_Delta.clear();
+
     NodeSet           = true;
     RampUpSteps       = 0;
     RampUpVStep       = std::numeric_limits<double>::infinity();
@@ -828,6 +966,7 @@ namespace SolverSpecify
     if (s == "trace" )                        return TRACE;
     if (s == "acsweep")                       return ACSWEEP;
     if (s == "transient")                     return TRANSIENT;
+    if (s == "pss")                           return PSS;
 
     return INVALID_SolutionType;
   }
@@ -501,20 +501,26 @@ Particle_Source_Track::Particle_Source_Track(SimulationSystem &system, const Par
 
 void Particle_Source_Track::_read_particle_profile_track_evt(const std::string & filename, Real lateral_char)
 {
-  std::vector<double> meta_data;
+  std::ifstream * in = 0;
   if(Genius::processor_id()==0)
   {
-    std::ifstream in(filename.c_str());
-    if(!in.good())
+    in = new std::ifstream(filename.c_str());
+    if(!in->good())
     {
       MESSAGE<<"ERROR PARTICLE: file "<<filename<<" can't be opened."<<std::endl; RECORD();
       genius_error();
     }
+  }
 
-    while(!in.eof())
+  // read and broadcast the file block by block, the whole file is never buffered
+  std::vector<double> meta_data;
+  do
+  {
+    meta_data.clear();
+    while(in && !in->eof() && meta_data.size() < 8*_track_block_size)
     {
       std::string context;
-      std::getline(in, context);
+      std::getline(*in, context);
       if(context.empty()) continue;
       if(context[0] == '#') continue;
 
@@ -545,10 +551,20 @@ void Particle_Source_Track::_read_particle_profile_track_evt(const std::string &
       meta_data.push_back(sigma*um);
     }
 
-    in.close();
+    Parallel::broadcast(meta_data);
+    _add_tracks(meta_data);
   }
+  while(!meta_data.empty());
+
+  delete in;
+
+  Parallel::verify(_tracks.size());
+
+}
+
 
-  Parallel::broadcast(meta_data);
+void Particle_Source_Track::_add_tracks(const std::vector<double> & meta_data)
+{
   for(unsigned int n=0; n<meta_data.size()/8; ++n)
   {
     track_t track;
@@ -560,11 +576,12 @@ void Particle_Source_Track::_read_particle_profile_track_evt(const std::string &
     track.end.z()      = meta_data[8*n+5];
     track.energy       = meta_data[8*n+6];
     track.lateral_char = meta_data[8*n+7];
-    _tracks.push_back(track);
-  }
 
-  Parallel::verify(_tracks.size());
+    // skip zero length track
+    if( track.energy <= 0.0 || (track.end - track.start).size() == 0.0 ) continue;
 
+    _tracks.push_back(track);
+  }
 }
 
 #ifdef HAVE_HDF5
@@ -572,6 +589,8 @@ void Particle_Source_Track::_read_particle_profile_track_evt(const std::string &
 #include "ParticleEvent.h"
 void Particle_Source_Track::_read_particle_profile_track_hdf5(const std::string & filename, const std::string & path, Real lateral_char)
 {
+  // processor 0 reads tracks and steps of the event by hyperslab in chunks and broadcasts
+  // them block by block, only one chunk of each dataset is held in memory
   std::vector<double> meta_data;
   if(Genius::processor_id()==0)
   {
@@ -584,83 +603,98 @@ void Particle_Source_Track::_read_particle_profile_track_hdf5(const std::string
       genius_error();
     }
 
-    H5G_info_t ginfo;
-    H5Gget_info(file_handle, &ginfo);
-
-    CogendaHDF5::LookupTable region_lut;
-    std::vector<std::string> material_list;
-    {
-      hid_t grp;
-      grp = H5Gopen(file_handle, "target", H5P_DEFAULT);
-      material_list = CogendaHDF5::getAttribute< std::vector<std::string> >(grp, ".", "MaterialList");
-      region_lut   = CogendaHDF5::getAttribute< CogendaHDF5::LookupTable >(grp, ".", "RegionList");
-    }
-
-    //for(unsigned int n=0; n<material_list.size(); ++n)
-    //  std::cout<<material_list[n]<<std::endl;
-
-    //std::string event_path = "./" + path;
-    CogendaHDF5::GSeat::Event evt_hdf5(region_lut, material_list);
-    bool rc = evt_hdf5.readData(file_handle, path);
-    if (!rc)
+    hid_t grp = -1;
+    if (CogendaHDF5::getAttribute<std::string>(file_handle, path, CogendaHDF5::ATTR_fullname) == CogendaHDF5::GSeat::Event::fullname)
+      grp = H5Gopen(file_handle, path.c_str(), H5P_DEFAULT);
+    if (grp<0)
     {
       MESSAGE<<"ERROR PARTICLE: file "<<filename<<" path " << path << " can not be opened." <<std::endl; RECORD();
       genius_error();
     }
 
-    for (CogendaHDF5::GSeat::Event::TrackIter iTrack = evt_hdf5.track_begin();  iTrack != evt_hdf5.track_end(); ++iTrack)
-    {
-      const CogendaHDF5::GSeat::Track & track_hdf5 = *iTrack;
-
-      std::vector<double> p = track_hdf5.StartPoint();
-      Point StartPoint(p[0], p[1], p[2]);
+    CogendaHDF5::GSeat::Track::Dataset tracks;
+    CogendaHDF5::GSeat::Step::Dataset  steps;
+    const hsize_t n_tracks = tracks.countData(grp, "Tracks");
+    const hsize_t n_steps  = steps.countData(grp, "Steps");
+    hsize_t step_window = 0; // index of steps[0] in the dataset
 
-      CogendaHDF5::GSeat::Event::StepIter iStep = evt_hdf5.step_begin(track_hdf5);
-      for (unsigned int c=0; iStep != evt_hdf5.step_end(track_hdf5); ++iStep, ++c)
+    for(hsize_t track_offset=0; track_offset<n_tracks; track_offset+=_track_block_size)
+    {
+      bool rc = tracks.readData(grp, "Tracks", track_offset, std::min<hsize_t>(_track_block_size, n_tracks-track_offset));
+      for (size_t t=0; rc && t<tracks.size(); ++t)
       {
-        const CogendaHDF5::GSeat::Step & step_hdf5 = *iStep;
-
-        std::vector<double> p = step_hdf5.EndPoint();
-        Point EndPoint(p[0], p[1], p[2]);
-        double energy = step_hdf5.EnergyDeposit();
+        CogendaHDF5::GSeat::Track track_hdf5(tracks[t]);
 
-        meta_data.push_back(StartPoint[0]*um);
-        meta_data.push_back(StartPoint[1]*um);
-        meta_data.push_back(StartPoint[2]*um);
-        meta_data.push_back(EndPoint[0]*um);
-        meta_data.push_back(EndPoint[1]*um);
-        meta_data.push_back(EndPoint[2]*um);
-        meta_data.push_back(energy*1e6*eV);
+        std::vector<double> p = track_hdf5.StartPoint();
+        Point StartPoint(p[0], p[1], p[2]);
 
-        double sigma=lateral_char;
-        meta_data.push_back(sigma*um);
+        for (hsize_t c=track_hdf5.StepOffset(); rc && c<track_hdf5.StepOffset()+track_hdf5.NumSteps(); ++c)
+        {
+          // steps of consecutive tracks are stored consecutively, read the next chunk when c leaves the window
+          if (c<step_window || c>=step_window+steps.size())
+          {
+            step_window = c;
+            rc = c<n_steps && steps.readData(grp, "Steps", c, std::min<hsize_t>(_track_block_size, n_steps-c));
+            if (!rc) break;
+          }
+          CogendaHDF5::GSeat::Step step_hdf5(steps[c-step_window]);
+
+          std::vector<double> p = step_hdf5.EndPoint();
+          Point EndPoint(p[0], p[1], p[2]);
+          double energy = step_hdf5.EnergyDeposit();
+
+          meta_data.push_back(StartPoint[0]*um);
+          meta_data.push_back(StartPoint[1]*um);
+          meta_data.push_back(StartPoint[2]*um);
+          meta_data.push_back(EndPoint[0]*um);
+          meta_data.push_back(EndPoint[1]*um);
+          meta_data.push_back(EndPoint[2]*um);
+          meta_data.push_back(energy*1e6*eV);
+
+          double sigma=lateral_char;
+          meta_data.push_back(sigma*um);
+
+          StartPoint = EndPoint;
+
+          if (meta_data.size() >= 8*_track_block_size)
+          {
+            Parallel::broadcast(meta_data);
+            _add_tracks(meta_data);
+            meta_data.clear();
+          }
+        }
+      }
 
-        StartPoint = EndPoint;
+      if (!rc)
+      {
+        MESSAGE<<"ERROR PARTICLE: file "<<filename<<" path " << path << " can not be read." <<std::endl; RECORD();
+        genius_error();
       }
     }
 
+    H5Gclose(grp);
     H5Fclose(file_handle);
-  }
 
-  //std::cout<<meta_data.size() << std::endl;
+    // the last block
+    if (!meta_data.empty())
+    {
+      Parallel::broadcast(meta_data);
+      _add_tracks(meta_data);
+      meta_data.clear();
+    }
 
-  Parallel::broadcast(meta_data);
-  for(unsigned int n=0; n<meta_data.size()/8; ++n)
+    // an empty block ends the stream
+    Parallel::broadcast(meta_data);
+  }
+  else
   {
-    track_t track;
-    track.start.x()    = meta_data[8*n+0];
-    track.start.y()    = meta_data[8*n+1];
-    track.start.z()    = meta_data[8*n+2];
-    track.end.x()      = meta_data[8*n+3];
-    track.end.y()      = meta_data[8*n+4];
-    track.end.z()      = meta_data[8*n+5];
-    track.energy       = meta_data[8*n+6];
-    track.lateral_char = meta_data[8*n+7];
-
-    // skip zero length track
-    if( track.energy <= 0.0 || (track.end - track.start).size() == 0.0 ) continue;
-
-    _tracks.push_back(track);
+    do
+    {
+      meta_data.clear();
+      Parallel::broadcast(meta_data);
+      _add_tracks(meta_data);
+    }
+    while(!meta_data.empty());
   }
 
   Parallel::verify(_tracks.size());
@@ -684,126 +718,165 @@ void Particle_Source_Track::update_source()
   std::vector<double> region_energy(_system.n_regions(), 0.0);
   double total_energy=0.0;
 
+  const double t_factor = _t_char/2.0*sqrt(pi)*(1+Erf((_t_max-_t0)/_t_char));
+
   AutoPtr<NearestNodeLocator> nn_locator( new NearestNodeLocator(_system.mesh()) );
 
-  for(unsigned int t=0; t<_tracks.size(); ++t)
+  // bounding box of on processor nodes, tracks far away from it have no local contribution
+  Point local_min( std::numeric_limits<double>::max(),  std::numeric_limits<double>::max(),  std::numeric_limits<double>::max());
+  Point local_max(-std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max());
+  for(unsigned int r=0; r<_system.n_regions(); r++)
   {
-    if( t%(1+_tracks.size()/20) ==0 )
+    const SimulationRegion * region = _system.region(r);
+    SimulationRegion::const_processor_node_iterator node_it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator node_it_end = region->on_processor_nodes_end();
+    for(; node_it!=node_it_end; ++node_it)
     {
-      MESSAGE<< ".";
-      RECORD();
+      const Node * node = (*node_it)->root_node();
+      for(unsigned int d=0; d<3; ++d)
+      {
+        local_min(d) = std::min(local_min(d), (*node)(d));
+        local_max(d) = std::max(local_max(d), (*node)(d));
+      }
     }
+  }
 
-    const track_t & track = _tracks[t];
-    genius_assert(track.energy > 0.0 && (track.end - track.start).size() > 0.0);
+  // tracks are processed in chunks, a chunk needs only one reduction of track energy
+  const unsigned int chunk_size = 4096;
+  for(unsigned int chunk_begin=0; chunk_begin<_tracks.size(); chunk_begin+=chunk_size)
+  {
+    const unsigned int chunk_end = std::min(chunk_begin+chunk_size, static_cast<unsigned int>(_tracks.size()));
+    const unsigned int n_chunk = chunk_end - chunk_begin;
 
-    /*
-    // prevent bad tracks
-    int bad_track = 0;
-    if( track.energy == 0.0 || (track.end - track.start).size() == 0.0) bad_track=1;
-    Parallel::broadcast(bad_track);
-    if(bad_track) continue;
-    */
+    MESSAGE<< ".";
+    RECORD();
 
-    double track_energy = 0.0;
-    std::map<const FVM_Node *, double> track_energy_density;
+    std::vector<double> track_energy(n_chunk, 0.0);
+    std::vector< std::vector< std::pair<const FVM_Node *, double> > > track_energy_density(n_chunk);
 
-    const Point track_dir = (track.end - track.start).unit(); // track direction
-    const double dEdx = track.energy/(track.end - track.start).size(); // linear energy density
-    const double lateral_char = track.lateral_char;
-    // find the nodes that near the track
-    for(unsigned int r=0; r<_system.n_regions(); r++)
+    for(unsigned int t=chunk_begin; t<chunk_end; ++t)
     {
-      const SimulationRegion * region = _system.region(r);
+      const track_t & track = _tracks[t];
+      genius_assert(track.energy > 0.0 && (track.end - track.start).size() > 0.0);
 
-      // fast return
-      const std::pair<Point, Real> bsphere = region->boundingsphere();
-      const Point cent = 0.5*(track.start+track.end);
-      const double diag = 0.5*(track.start-track.end).size();
-      if( (bsphere.first - cent).size() > bsphere.second + diag + 5*lateral_char ) continue;
+      const Point track_dir = (track.end - track.start).unit(); // track direction
+      const double dEdx = track.energy/(track.end - track.start).size(); // linear energy density
+      const double lateral_char = track.lateral_char;
 
+      // fast return by local bounding box
+      bool near = true;
+      for(unsigned int d=0; d<3; ++d)
+      {
+        if( std::min(track.start(d), track.end(d)) - 5*lateral_char > local_max(d) ) near = false;
+        if( std::max(track.start(d), track.end(d)) + 5*lateral_char < local_min(d) ) near = false;
+      }
+      if(!near) continue;
 
-      std::vector<const Node *> nn = nn_locator->nearest_nodes(track.start, track.end, 5*lateral_char, r);
-      for(unsigned int n=0; n<nn.size(); ++n)
+      // find the nodes that near the track
+      for(unsigned int r=0; r<_system.n_regions(); r++)
       {
-        Point loc = *nn[n];
-        const FVM_Node * fvm_node = region->region_fvm_node(nn[n]); // may be NULL, if not on local
-        if(!fvm_node || !fvm_node->on_processor()) continue;
+        const SimulationRegion * region = _system.region(r);
 
-        Point loc_pp = track.start + (loc-track.start)*track_dir*track_dir;
-        Real r = (loc-loc_pp).size();
-        double e_r = exp(-r*r/(lateral_char*lateral_char));
-        double e_z = Erf((loc_pp-track.start)*track_dir/lateral_char) - Erf((loc_pp-track.end)*track_dir/lateral_char);
-        double energy_density = dEdx/(2*pi*lateral_char*lateral_char)*e_r*e_z;
-        track_energy += energy_density*fvm_node->volume();
-        track_energy_density[fvm_node] += energy_density;
+        // fast return
+        const std::pair<Point, Real> bsphere = region->boundingsphere();
+        const Point cent = 0.5*(track.start+track.end);
+        const double diag = 0.5*(track.start-track.end).size();
+        if( (bsphere.first - cent).size() > bsphere.second + diag + 5*lateral_char ) continue;
+
+
+        std::vector<const Node *> nn = nn_locator->nearest_nodes(track.start, track.end, 5*lateral_char, r);
+        for(unsigned int n=0; n<nn.size(); ++n)
+        {
+          Point loc = *nn[n];
+          const FVM_Node * fvm_node = region->region_fvm_node(nn[n]); // may be NULL, if not on local
+          if(!fvm_node || !fvm_node->on_processor()) continue;
+
+          Point loc_pp = track.start + (loc-track.start)*track_dir*track_dir;
+          Real r = (loc-loc_pp).size();
+          double e_r = exp(-r*r/(lateral_char*lateral_char));
+          double e_z = Erf((loc_pp-track.start)*track_dir/lateral_char) - Erf((loc_pp-track.end)*track_dir/lateral_char);
+          double energy_density = dEdx/(2*pi*lateral_char*lateral_char)*e_r*e_z;
+          track_energy[t-chunk_begin] += energy_density*fvm_node->volume();
+          track_energy_density[t-chunk_begin].push_back(std::make_pair(fvm_node, energy_density));
+        }
       }
     }
 
     Parallel::sum(track_energy);
 
-    if(track_energy > 0.0)
-    {
-      double alpha = track.energy/track_energy; //used for keep energy conservation track.energy;
-      std::map<const FVM_Node *, double>::const_iterator it = track_energy_density.begin();
-      for(; it != track_energy_density.end(); ++it)
-      {
-        const FVM_Node * fvm_node = it->first;
-        if(!fvm_node) continue;
-
-        double energy_density = it->second;
+    std::vector<double> nearest_distance(n_chunk, std::numeric_limits<double>::infinity());
+    std::vector<const FVM_Node *> nearest_node(n_chunk, static_cast<const FVM_Node *>(0));
 
-        const SimulationRegion * region = _system.region(fvm_node->subdomain_id());
-        // if( region->type() != SemiconductorRegion) continue;
-        double _quan_eff = quan_eff(region);
+    for(unsigned int t=chunk_begin; t<chunk_end; ++t)
+    {
+      const track_t & track = _tracks[t];
+      const unsigned int i = t-chunk_begin;
 
-        if(fvm_node && fvm_node->on_local())
+      if(track_energy[i] > 0.0)
+      {
+        double alpha = track.energy/track_energy[i]; //used for keep energy conservation track.energy;
+        for(unsigned int n=0; n<track_energy_density[i].size(); ++n)
         {
-          _fvm_node_particle_deposit[fvm_node] += alpha*energy_density/_quan_eff/(_t_char/2.0*sqrt(pi)*(1+Erf((_t_max-_t0)/_t_char)));
-          //node_data->PatE() += alpha*energy_density;
-          total_energy += alpha*energy_density*fvm_node->volume();
-          region_energy[ fvm_node->subdomain_id() ] += alpha*energy_density*fvm_node->volume();
+          const FVM_Node * fvm_node = track_energy_density[i][n].first;
+          double energy_density = track_energy_density[i][n].second;
+
+          const SimulationRegion * region = _system.region(fvm_node->subdomain_id());
+          // if( region->type() != SemiconductorRegion) continue;
+          double _quan_eff = quan_eff(region);
+
+          if(fvm_node->on_local())
+          {
+            _fvm_node_particle_deposit[fvm_node] += alpha*energy_density/_quan_eff/t_factor;
+            //node_data->PatE() += alpha*energy_density;
+            total_energy += alpha*energy_density*fvm_node->volume();
+            region_energy[ fvm_node->subdomain_id() ] += alpha*energy_density*fvm_node->volume();
+          }
         }
       }
-    }
-    else
-    {
-      // find the nearest node of the track
-      const FVM_Node * neraset_node=0;
-      double distance=std::numeric_limits<double>::infinity();
-      for(unsigned int r=0; r<_system.n_regions(); r++)
+      else
       {
-        const SimulationRegion * region = _system.region(r);
-        double dist;
-        const Node * n = nn_locator->nearest_node(0.5*(track.start+track.end), r, dist);
-        if(n == NULL) continue;
-
-        const FVM_Node * fvm_node = region->region_fvm_node(n); // may be NULL, if not on local
-        if(!fvm_node || !fvm_node->on_processor()) continue;
-
-        if( dist < distance)
+        // find the nearest node of the track
+        for(unsigned int r=0; r<_system.n_regions(); r++)
         {
-          distance = dist;
-          neraset_node = fvm_node;
+          const SimulationRegion * region = _system.region(r);
+          double dist;
+          const Node * n = nn_locator->nearest_node(0.5*(track.start+track.end), r, dist);
+          if(n == NULL) continue;
+
+          const FVM_Node * fvm_node = region->region_fvm_node(n); // may be NULL, if not on local
+          if(!fvm_node || !fvm_node->on_processor()) continue;
+
+          if( dist < nearest_distance[i])
+          {
+            nearest_distance[i] = dist;
+            nearest_node[i] = fvm_node;
+          }
         }
       }
+    }
 
-      double min_distance=distance;
-      Parallel::min(min_distance);
+    std::vector<double> min_distance(nearest_distance);
+    Parallel::min(min_distance);
 
-      if( min_distance == distance && neraset_node)
+    for(unsigned int t=chunk_begin; t<chunk_end; ++t)
+    {
+      const track_t & track = _tracks[t];
+      const unsigned int i = t-chunk_begin;
+      if(track_energy[i] > 0.0) continue;
+
+      const FVM_Node * neraset_node = nearest_node[i];
+      if( min_distance[i] == nearest_distance[i] && neraset_node)
       {
         const SimulationRegion * region = _system.region(neraset_node->subdomain_id());
         double _quan_eff = quan_eff(region);
 
         double energy_density = track.energy/neraset_node->volume();
-        _fvm_node_particle_deposit[neraset_node] += energy_density/_quan_eff/(_t_char/2.0*sqrt(pi)*(1+Erf((_t_max-_t0)/_t_char)));
+        _fvm_node_particle_deposit[neraset_node] += energy_density/_quan_eff/t_factor;
         //node_data->PatE() += energy_density;
         total_energy += track.energy;
         region_energy[neraset_node->subdomain_id()] += track.energy;
       }
     }
-
   }
 
   MESSAGE<< "ok" <<std::endl;
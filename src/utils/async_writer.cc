@@ -0,0 +1,161 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include "async_writer.h"
+
+
+AsyncWriter::AsyncWriter(size_t max_bytes, Policy policy)
+  : _queue_bytes(0), _max_bytes(max_bytes), _policy(policy), _n_dropped(0), _busy(false), _stop(false)
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init(&_mutex, NULL);
+  pthread_cond_init(&_cond_job, NULL);
+  pthread_cond_init(&_cond_done, NULL);
+  pthread_create(&_thread, NULL, _thread_entry, this);
+#endif
+}
+
+
+AsyncWriter::~AsyncWriter()
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&_mutex);
+  _stop = true;
+  pthread_cond_signal(&_cond_job);
+  pthread_mutex_unlock(&_mutex);
+
+  // the I/O thread writes all the queued jobs before exit
+  pthread_join(_thread, NULL);
+
+  pthread_cond_destroy(&_cond_done);
+  pthread_cond_destroy(&_cond_job);
+  pthread_mutex_destroy(&_mutex);
+#endif
+}
+
+
+void AsyncWriter::enqueue(Job *job)
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&_mutex);
+
+  const size_t job_bytes = job->bytes();
+  while( (_busy || !_queue.empty()) && _queue_bytes + job_bytes > _max_bytes )
+  {
+    // keep the newest snapshot, discard the oldest one which can be discarded
+    if( _policy == COALESCE && job->droppable() )
+    {
+      std::deque<Job *>::iterator it = _queue.begin();
+      for(; it != _queue.end(); ++it)
+        if( (*it)->droppable() ) break;
+      if( it != _queue.end() )
+      {
+        _queue_bytes -= (*it)->bytes();
+        _dropped.insert((*it)->name());
+        delete *it;
+        _queue.erase(it);
+        _n_dropped++;
+        continue;
+      }
+    }
+
+    // discard the new snapshot
+    if( _policy == DROP && job->droppable() )
+    {
+      _dropped.insert(job->name());
+      _n_dropped++;
+      pthread_mutex_unlock(&_mutex);
+      delete job;
+      return;
+    }
+
+    // wait for the I/O thread
+    pthread_cond_wait(&_cond_done, &_mutex);
+  }
+
+  _queue.push_back(job);
+  _queue_bytes += job_bytes;
+  pthread_cond_signal(&_cond_job);
+  pthread_mutex_unlock(&_mutex);
+#else
+  job->write();
+  delete job;
+#endif
+}
+
+
+void AsyncWriter::flush()
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&_mutex);
+  while( !_queue.empty() || _busy )
+    pthread_cond_wait(&_cond_done, &_mutex);
+  pthread_mutex_unlock(&_mutex);
+#endif
+}
+
+
+AsyncWriter::Policy AsyncWriter::policy(const std::string &name)
+{
+  if(name == "drop")     return DROP;
+  if(name == "coalesce") return COALESCE;
+  return BLOCK;
+}
+
+
+#ifdef HAVE_PTHREAD
+
+void * AsyncWriter::_thread_entry(void * writer)
+{
+  static_cast<AsyncWriter *>(writer)->_run();
+  return NULL;
+}
+
+
+void AsyncWriter::_run()
+{
+  pthread_mutex_lock(&_mutex);
+  while(true)
+  {
+    while( _queue.empty() && !_stop )
+      pthread_cond_wait(&_cond_job, &_mutex);
+
+    if( _queue.empty() && _stop ) break;
+
+    Job * job = _queue.front();
+    _queue.pop_front();
+    _busy = true;
+
+    // write without holding the lock, the solver may queue the next snapshot
+    pthread_mutex_unlock(&_mutex);
+    job->write();
+    pthread_mutex_lock(&_mutex);
+
+    _queue_bytes -= job->bytes();
+    delete job;
+    _busy = false;
+    pthread_cond_broadcast(&_cond_done);
+  }
+  pthread_mutex_unlock(&_mutex);
+}
+
+#endif
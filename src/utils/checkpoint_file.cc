@@ -0,0 +1,112 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+
+#include "checkpoint_file.h"
+
+#ifndef WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+// file header, a magic string and format version
+static const char         checkpoint_magic[8] = {'G','E','N','I','U','S','C','K'};
+static const unsigned int checkpoint_version  = 1;
+
+
+
+CheckpointWriter::CheckpointWriter(const std::string &file)
+  : _file(file), _out((file+".tmp").c_str(), std::ofstream::binary|std::ofstream::trunc)
+{
+  _out.write(checkpoint_magic, sizeof(checkpoint_magic));
+  write<unsigned int>(checkpoint_version);
+}
+
+
+CheckpointWriter::~CheckpointWriter()
+{
+  if(_out.is_open()) _out.close();
+}
+
+
+bool CheckpointWriter::close()
+{
+  _out.flush();
+  bool ok = _out.good();
+  _out.close();
+  if(!ok) return false;
+
+  // replace the old checkpoint only when the new one is complete
+  std::remove(_file.c_str());
+  return std::rename((_file+".tmp").c_str(), _file.c_str()) == 0;
+}
+
+
+
+CheckpointReader::CheckpointReader(const std::string &file)
+  : _data(0), _size(0), _pos(0), _good(true)
+{
+#ifdef WINDOWS
+  std::ifstream in(file.c_str(), std::ifstream::binary);
+  if(!in.good()) return;
+  in.seekg(0, std::ios::end);
+  _size = static_cast<size_t>(in.tellg());
+  in.seekg(0, std::ios::beg);
+  char * buf = new char[_size];
+  in.read(buf, _size);
+  _data = buf;
+#else
+  int fd = open(file.c_str(), O_RDONLY);
+  if(fd < 0) return;
+  struct stat st;
+  if(fstat(fd, &st) == 0 && st.st_size > 0)
+  {
+    _size = static_cast<size_t>(st.st_size);
+    void * p = mmap(0, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(p != MAP_FAILED)
+    {
+      // data is read once from begin to end
+      madvise(p, _size, MADV_SEQUENTIAL);
+      _data = static_cast<const char *>(p);
+    }
+  }
+  ::close(fd);
+#endif
+
+  const char * magic = _advance(sizeof(checkpoint_magic));
+  if(!magic || std::memcmp(magic, checkpoint_magic, sizeof(checkpoint_magic)) || read<unsigned int>() != checkpoint_version)
+    _good = false;
+}
+
+
+CheckpointReader::~CheckpointReader()
+{
+#ifdef WINDOWS
+  delete [] _data;
+#else
+  if(_data) munmap(const_cast<char *>(_data), _size);
+#endif
+}
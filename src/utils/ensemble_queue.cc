@@ -0,0 +1,83 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include "ensemble_queue.h"
+#include "parallel.h"
+
+
+EnsembleQueue::EnsembleQueue(unsigned int n_tasks)
+  : _n_tasks(n_tasks), _n_taken(0)
+{
+#if defined(HAVE_MPI) && MPI_VERSION >= 3
+  _counter = NULL;
+
+  int rank;
+  MPI_Comm_rank(Genius::comm_ensemble(), &rank);
+
+  MPI_Aint size = 0;
+  if( rank == 0 )
+  {
+    MPI_Alloc_mem(sizeof(int), MPI_INFO_NULL, &_counter);
+    *_counter = 0;
+    size = sizeof(int);
+  }
+  MPI_Win_create(_counter, size, sizeof(int), MPI_INFO_NULL, Genius::comm_ensemble(), &_win);
+#endif
+}
+
+
+EnsembleQueue::~EnsembleQueue()
+{
+#if defined(HAVE_MPI) && MPI_VERSION >= 3
+  MPI_Win_free(&_win);
+  if( _counter )
+    MPI_Free_mem(_counter);
+#endif
+}
+
+
+int EnsembleQueue::next()
+{
+  int task = -1;
+
+#if defined(HAVE_MPI) && MPI_VERSION >= 3
+  // the first processor of each group takes a task from the shared counter
+  if( Genius::processor_id() == 0 )
+  {
+    const int one = 1;
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, _win);
+    MPI_Fetch_and_op(&one, &task, MPI_INT, 0, 0, MPI_SUM, _win);
+    MPI_Win_unlock(0, _win);
+  }
+  // and tells other processors in the group
+  Parallel::broadcast(task);
+#else
+  task = _n_taken*Genius::n_ensembles() + Genius::ensemble_id();
+#endif
+
+  _n_taken++;
+
+  if( task < 0 || task >= static_cast<int>(_n_tasks) )
+    return -1;
+
+  return task;
+}